@@ -0,0 +1,596 @@
+// Benchmarks for the falling object (train) controller and model kernels
+// Prints one JSON line per measurement (see common/benchutil.h):
+//   controller/<callback>            one ControllerCallback call
+//   model/<callback>                 one SystemModelCallback call
+//   update_system/<callback>+<model> one updateSystem() step (generic callback pipeline)
+//   stepper/<callback>+<model>       one step of the specialized stepper (fallingobject_stepper.c)
+//   batch/<model>                    one object-step of the SoA batch engine
+//   embedded/<callback>_<f32|q16>    one call of the firmware control law (controller_embedded.h)
+//   equivalence/<callback>_<f32|q16> closed-loop deviation of the firmware law from the double
+//                                    controller over a 40 s run (max position error, %)
+//   mpc/setup                        one initMpcController (condensed QP of main.c's --controller mpc)
+//   mpc/tick                         one closed-loop updateSystem step with mpcController
+//   scenario_scaling/full_run        one step of a fixed scenario set, per thread count
+//   trace_io/<format>                one 8-column sample through the trace writer
+//   sensitivity/<model>              one step of the PID sensitivity stepper (state + 3 gain tangents)
+//   sensitivity/<model>_gradient     forward-mode gradient of a 40 s run's IAE against central finite
+//                                    differences (max relative error) and the deviation of its
+//                                    trajectory from the PID stepper's (signal error, must be 0)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "benchutil.h"
+#include "controller.h"
+#include "controller_embedded.h"
+#include "fallingobject.h"
+#include "fallingobject_batch.h"
+#include "fallingobject_stepper.h"
+#include "jobpool.h"
+#include "mpc.h"
+#include "tracewriter.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_DT 0.02              // Same time step as main.c (50 Hz)
+#define BENCH_SCENARIO_STEPS 2000  // 40 s at dt = 0.02
+#define BENCH_SCENARIO_COUNT 64    // Scenarios in one scaling set
+#define BENCH_BATCH_SIZE 1024
+#define BENCH_TRACE_ROWS 200000
+#define BENCH_EQUIVALENCE_TOLERANCE 0.5  // Largest position deviation (%) of a firmware law from double
+#define BENCH_GRADIENT_STEP 1e-6         // Relative gain step of the finite-difference reference
+#define BENCH_GRADIENT_TOLERANCE 1e-3    // Largest relative error of the forward-mode gradient
+
+typedef struct {
+    const char *name;
+    ControllerCallback callback;
+} BenchController;
+
+typedef struct {
+    const char *name;
+    SystemModelCallback callback;
+} BenchModel;
+
+static const BenchController controllers[] = {
+    { "pController",           pController },
+    { "adaptivePController",   adaptivePController },
+    { "pdController",          pdController },
+    { "adaptivePdController",  adaptivePdController },
+    { "piController",          piController },
+    { "adaptivePiController",  adaptivePiController },
+    { "pidController",         pidController },
+    { "adaptivePidController", adaptivePidController }
+};
+#define CONTROLLER_COUNT ((int)(sizeof(controllers) / sizeof(controllers[0])))
+
+static const BenchModel models[] = {
+    { "objectModel",                      objectModel },
+    { "objectModelTrapezoidal",           objectModelTrapezoidal },
+    { "objectModelTrapezoidalSimplified", objectModelTrapezoidalSimplified },
+    { "objectModelAdaptive",              objectModelAdaptive }
+};
+#define MODEL_COUNT ((int)(sizeof(models) / sizeof(models[0])))
+
+// Same gains as main.c
+static const ControllerParams PARAMS_PID = {500.0, 50.0, 200.0};
+
+// Results are accumulated here so the compiler can't drop the benchmarked calls
+static volatile double benchSink;
+
+typedef struct {
+    FallingObject object;
+    ControllerState state;
+    ControllerParams params;
+    ControllerCallback controller;
+    ObjectStepper stepper;
+    ObjectSensitivityStepper sensitivityStepper;
+    ObjectSensitivity sensitivity;
+} ObjectBench;
+
+// Train configured like main.c: 100 kg, 3000 N, 100 m track
+static void initBenchObject(ObjectBench *bench, ControllerCallback controller, SystemModelCallback model,
+                            double angleDeg, double trainX, double targetX) {
+    memset(bench, 0, sizeof(*bench));
+    bench->params = PARAMS_PID;
+    bench->controller = controller;
+    bench->object.position = trainX;
+    bench->object.position_pct = trainX;  // max_position = 100 m
+    bench->object.setpoint = targetX;
+    bench->object.controller.params = &bench->params;
+    bench->object.controller.state = &bench->state;
+    bench->object.controller.getSetpoint = getObjectSetpoint;
+    bench->object.controller.getOutput = getObjectOutput;
+    bench->object.controller.dt = BENCH_DT;
+    bench->object.model.mass = 100.0;
+    bench->object.model.gravity = 9.81;
+    bench->object.model.incline_angle = angleDeg * M_PI / 180.0;
+    bench->object.model.drag_coeff = 0.5;
+    bench->object.model.max_force = 3000.0;
+    bench->object.model.max_position = 100.0;
+    bench->object.model.callback = model;
+    bench->object.model.netForceCallback = (model == objectModelTrapezoidalSimplified) ?
+                                           calculateObjectNetForceSimplified : calculateObjectNetForce;
+    prepareObjectModel(&bench->object.model);
+    if (selectObjectStepper(&bench->object, controller, &bench->stepper) != ERROR_SUCCESS) {
+        bench->stepper = NULL;
+    }
+    if (controller != pidController ||
+        selectObjectSensitivityStepper(&bench->object, &bench->sensitivityStepper) != ERROR_SUCCESS) {
+        bench->sensitivityStepper = NULL;
+    }
+}
+
+static void benchController(void *context, long iterations) {
+    ObjectBench *bench = (ObjectBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        double error = (double)(i & 63) - 32.0;
+        double u = 0.0;
+        bench->controller(error, &bench->object.controller, &u);
+        sum += u;
+    }
+    benchSink = sum;
+}
+
+static void benchModel(void *context, long iterations) {
+    ObjectBench *bench = (ObjectBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        // Alternate pushing forward and back so the train stays on the track
+        double force = (i & 256) ? -1500.0 : 1500.0;
+        double position = 0.0;
+        bench->object.model.callback(&bench->object, force, BENCH_DT, &position);
+        sum += position;
+    }
+    benchSink = sum;
+}
+
+static void benchUpdateSystem(void *context, long iterations) {
+    ObjectBench *bench = (ObjectBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        // Move the target every scenario length so the loop keeps working
+        bench->object.setpoint = ((i / BENCH_SCENARIO_STEPS) & 1) ? 30.0 : 70.0;
+        double position = 0.0;
+        updateSystem(&bench->object, &bench->object.controller, bench->object.model.callback, BENCH_DT,
+                     &position, bench->controller, NULL);
+        sum += position;
+    }
+    benchSink = sum;
+}
+
+static void benchStepper(void *context, long iterations) {
+    ObjectBench *bench = (ObjectBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        bench->object.setpoint = ((i / BENCH_SCENARIO_STEPS) & 1) ? 30.0 : 70.0;
+        double position = 0.0;
+        bench->stepper(&bench->object, BENCH_DT, 1, &position);
+        sum += position;
+    }
+    benchSink = sum;
+}
+
+static void benchBatch(void *context, long iterations) {
+    FallingObjectBatch *batch = (FallingObjectBatch*)context;
+    for (long i = 0; i < iterations; i++) {
+        stepFallingObjectBatch(batch, BENCH_DT);
+    }
+    benchSink = batch->position_pct[0];
+}
+
+// Firmware builds of a controller (controller_embedded.h)
+typedef struct {
+    const char *name;
+    ControllerCallback callback;  // Double reference
+    float (*f32Law)(float error, const ControllerParamsF32 *params, ControllerStateF32 *state);
+    q16_t (*q16Law)(q16_t error, const ControllerParamsQ16 *params, ControllerStateQ16 *state);
+} BenchEmbeddedController;
+
+#define X(callback, f32Law, q16Law) { #callback, callback, f32Law, q16Law },
+static const BenchEmbeddedController embeddedControllers[] = {
+    EMBEDDED_CONTROLLER_LAW_LIST(X)
+};
+#undef X
+#define EMBEDDED_CONTROLLER_COUNT ((int)(sizeof(embeddedControllers) / sizeof(embeddedControllers[0])))
+
+typedef struct {
+    const BenchEmbeddedController *law;
+    ControllerParamsF32 f32Params;
+    ControllerStateF32 f32State;
+    ControllerParamsQ16 q16Params;
+    ControllerStateQ16 q16State;
+    int q16;                      // Run the Q16.16 law (else float32)
+} EmbeddedBench;
+
+static void benchEmbeddedLaw(void *context, long iterations) {
+    EmbeddedBench *bench = (EmbeddedBench*)context;
+    double sum = 0.0;
+    if (bench->q16) {
+        for (long i = 0; i < iterations; i++) {
+            q16_t error = (q16_t)((i & 63) - 32) * Q16_ONE;
+            sum += (double)bench->law->q16Law(error, &bench->q16Params, &bench->q16State);
+        }
+    } else {
+        for (long i = 0; i < iterations; i++) {
+            float error = (float)((i & 63) - 32);
+            sum += (double)bench->law->f32Law(error, &bench->f32Params, &bench->f32State);
+        }
+    }
+    benchSink = sum;
+}
+
+// One firmware control step: the error is measured in double, converted, and the force converted back
+static double embeddedControlSignal(EmbeddedBench *bench, double error) {
+    if (bench->q16) {
+        return q16ToDouble(bench->law->q16Law(q16FromDouble(error), &bench->q16Params, &bench->q16State));
+    }
+    return (double)bench->law->f32Law((float)error, &bench->f32Params, &bench->f32State);
+}
+
+// Run one catch (10% -> 60% on a 10 degree incline) with the double controller and with the
+// firmware law and report the largest position and force deviation
+static void checkEmbeddedLaw(const BenchSettings *settings, EmbeddedBench *embedded, ControllerCallback reference,
+                             const char *name) {
+    if (!benchSelected(settings, "equivalence", name)) return;
+    ObjectBench doubleRun, firmwareRun;
+    initBenchObject(&doubleRun, reference, objectModel, 10.0, 10.0, 60.0);
+    initBenchObject(&firmwareRun, reference, objectModel, 10.0, 10.0, 60.0);
+    resetControllerStateF32(&embedded->f32State);
+    resetControllerStateQ16(&embedded->q16State);
+
+    double maxPositionError = 0.0, maxForceError = 0.0;
+    for (long i = 0; i < BENCH_SCENARIO_STEPS; i++) {
+        double doublePosition = 0.0, firmwarePosition = 0.0;
+
+        double error = doubleRun.object.setpoint - doubleRun.object.position_pct;
+        double doubleForce = 0.0;
+        reference(error, &doubleRun.object.controller, &doubleForce);
+        objectModel(&doubleRun.object, doubleForce, BENCH_DT, &doublePosition);
+
+        double firmwareForce = embeddedControlSignal(embedded, firmwareRun.object.setpoint -
+                                                               firmwareRun.object.position_pct);
+        objectModel(&firmwareRun.object, firmwareForce, BENCH_DT, &firmwarePosition);
+
+        // Forces beyond max_force are clipped by the model, so only the applied part is compared
+        maxPositionError = fmax(maxPositionError, fabs(firmwarePosition - doublePosition));
+        maxForceError = fmax(maxForceError, fabs(firmwareRun.object.applied_force - doubleRun.object.applied_force));
+    }
+    benchReportDeviation(settings, "equivalence", name, BENCH_SCENARIO_STEPS, maxPositionError, maxForceError,
+                         BENCH_EQUIVALENCE_TOLERANCE);
+}
+
+// Timing and closed-loop equivalence of every firmware law in float32 and Q16.16 (gains of main.c)
+static void benchEmbedded(const BenchSettings *settings) {
+    for (int e = 0; e < EMBEDDED_CONTROLLER_COUNT; e++) {
+        EmbeddedBench embedded;
+        memset(&embedded, 0, sizeof(embedded));
+        embedded.law = &embeddedControllers[e];
+        if (initControllerParamsF32(&embedded.f32Params, &PARAMS_PID, BENCH_DT, 0.0) != ERROR_SUCCESS ||
+            initControllerParamsQ16(&embedded.q16Params, &PARAMS_PID, BENCH_DT, 0.0) != ERROR_SUCCESS) {
+            continue;
+        }
+        for (embedded.q16 = 0; embedded.q16 <= 1; embedded.q16++) {
+            char name[128];
+            snprintf(name, sizeof(name), "%s_%s", embedded.law->name, embedded.q16 ? "q16" : "f32");
+            resetControllerStateF32(&embedded.f32State);
+            resetControllerStateQ16(&embedded.q16State);
+            benchRun(settings, "embedded", name, 1, benchEmbeddedLaw, &embedded);
+            checkEmbeddedLaw(settings, &embedded, embedded.law->callback, name);
+        }
+    }
+}
+
+static void benchSensitivityStepper(void *context, long iterations) {
+    ObjectBench *bench = (ObjectBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        bench->object.setpoint = ((i / BENCH_SCENARIO_STEPS) & 1) ? 30.0 : 70.0;
+        double position = 0.0;
+        bench->sensitivityStepper(&bench->object, &bench->sensitivity, BENCH_DT, 1, &position);
+        sum += position + bench->sensitivity.position_pct[GAIN_KP];
+    }
+    benchSink = sum;
+}
+
+// IAE (%·s) of one 40 s catch (10% -> 60% on a 10 degree incline) with the PID stepper
+static double runGradientCatch(SystemModelCallback model, const ControllerParams *params, double *trajectory) {
+    ObjectBench bench;
+    initBenchObject(&bench, pidController, model, 10.0, 10.0, 60.0);
+    bench.params = *params;
+    double iae = 0.0;
+    for (long i = 0; i < BENCH_SCENARIO_STEPS; i++) {
+        double position = 0.0;
+        bench.stepper(&bench.object, BENCH_DT, 1, &position);
+        if (trajectory != NULL) trajectory[i] = position;
+        iae += fabs(bench.object.setpoint - position) * BENCH_DT;
+    }
+    return iae;
+}
+
+// Gradient of the catch's IAE from one sensitivity run, checked against central finite
+// differences (two extra runs per gain) and the PID stepper's trajectory
+static void checkSensitivityGradient(const BenchSettings *settings, SystemModelCallback model, const char *name) {
+    if (!benchSelected(settings, "sensitivity", name)) return;
+    double *trajectory = (double*)malloc(BENCH_SCENARIO_STEPS * sizeof(double));
+    if (trajectory == NULL) return;
+    runGradientCatch(model, &PARAMS_PID, trajectory);
+
+    ObjectBench bench;
+    initBenchObject(&bench, pidController, model, 10.0, 10.0, 60.0);
+    double gradient[GAIN_COUNT] = { 0.0, 0.0, 0.0 };
+    double maxTrajectoryError = 0.0;
+    for (long i = 0; i < BENCH_SCENARIO_STEPS; i++) {
+        double position = 0.0;
+        bench.sensitivityStepper(&bench.object, &bench.sensitivity, BENCH_DT, 1, &position);
+        maxTrajectoryError = fmax(maxTrajectoryError, fabs(position - trajectory[i]));
+        // d|setpoint - position| = -sign(setpoint - position) * d(position)
+        double sign = bench.object.setpoint - position >= 0.0 ? 1.0 : -1.0;
+        for (int g = 0; g < GAIN_COUNT; g++) {
+            gradient[g] -= sign * bench.sensitivity.position_pct[g] * BENCH_DT;
+        }
+    }
+    free(trajectory);
+
+    double maxGradientError = 0.0;
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        ControllerParams up = PARAMS_PID, down = PARAMS_PID;
+        double *upGain = g == GAIN_KP ? &up.Kp : g == GAIN_KI ? &up.Ki : &up.Kd;
+        double *downGain = g == GAIN_KP ? &down.Kp : g == GAIN_KI ? &down.Ki : &down.Kd;
+        double h = *upGain * BENCH_GRADIENT_STEP;
+        *upGain += h;
+        *downGain -= h;
+        double reference = (runGradientCatch(model, &up, NULL) - runGradientCatch(model, &down, NULL)) / (2.0 * h);
+        double scale = fmax(fabs(reference), 1e-12);
+        maxGradientError = fmax(maxGradientError, fabs(gradient[g] - reference) / scale);
+    }
+    benchReportDeviation(settings, "sensitivity", name, BENCH_SCENARIO_STEPS, maxGradientError, maxTrajectoryError,
+                         BENCH_GRADIENT_TOLERANCE);
+}
+
+// MPC of main.c --controller mpc on the bench train
+typedef struct {
+    MpcModel linear;
+    MpcConfig config;
+    MpcController mpc;
+} MpcBench;
+
+static void benchMpcSetup(void *context, long iterations) {
+    MpcBench *bench = (MpcBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        initMpcController(&bench->mpc, &bench->linear, &bench->config, BENCH_DT);
+        sum += bench->mpc.hessianInverse[0][0];
+    }
+    benchSink = sum;
+}
+
+static void benchMpc(const BenchSettings *settings, ObjectBench *object) {
+    MpcBench bench;
+    initMpcConfig(&bench.config);
+    bench.config.horizon = 15;
+    bench.config.stateWeight[0] = 1.0;
+    bench.config.stateWeight[1] = 0.1;
+    bench.config.inputWeight = 0.1;
+    bench.config.rateWeight = 0.1;
+    bench.config.inputMin = -object->object.model.max_force;
+    bench.config.inputMax = object->object.model.max_force;
+    bench.config.rateLimit = 30000.0;
+    if (linearizeObjectModel(&object->object.model, BENCH_DT, &bench.linear) != ERROR_SUCCESS ||
+        initMpcController(&bench.mpc, &bench.linear, &bench.config, BENCH_DT) != ERROR_SUCCESS) {
+        return;
+    }
+    benchRun(settings, "mpc", "setup", 1, benchMpcSetup, &bench);
+
+    object->object.controller.mpc = &bench.mpc;
+    benchRun(settings, "mpc", "tick", 1, benchUpdateSystem, object);
+    object->object.controller.mpc = NULL;
+}
+
+typedef struct {
+    int modelIndex;
+    double angle;
+    double trainX;
+    double targetX;
+    double finalPosition;
+} ScenarioJob;
+
+// One full 40 s PID scenario (pool job for the scaling benchmark)
+static void runScenarioJob(void *arg) {
+    ScenarioJob *job = (ScenarioJob*)arg;
+    ObjectBench bench;
+    initBenchObject(&bench, pidController, models[job->modelIndex].callback, job->angle, job->trainX, job->targetX);
+
+    double position = 0.0;
+    if (bench.stepper) {
+        bench.stepper(&bench.object, BENCH_DT, BENCH_SCENARIO_STEPS, &position);
+    } else {
+        for (int i = 0; i < BENCH_SCENARIO_STEPS; i++) {
+            updateSystem(&bench.object, &bench.object.controller, bench.object.model.callback, BENCH_DT,
+                         &position, bench.controller, NULL);
+        }
+    }
+    job->finalPosition = position;
+}
+
+// Time `rounds` copies of the scenario set on a pool with `threads` workers
+// Returns: elapsed nanoseconds, or -1 on failure
+static long long timeScenarioSet(int threads, int rounds, ScenarioJob *jobs) {
+    JobPool *pool = NULL;
+    if (createJobPool(threads, &pool) != ERROR_SUCCESS) return -1;
+
+    int jobCount = rounds * BENCH_SCENARIO_COUNT;
+    long long start = benchNowNs();
+    for (int j = 0; j < jobCount; j++) {
+        submitJob(pool, runScenarioJob, &jobs[j]);
+    }
+    waitJobPool(pool);
+    long long elapsed = benchNowNs() - start;
+    destroyJobPool(pool);
+    return elapsed;
+}
+
+static void benchScenarioScaling(const BenchSettings *settings) {
+    if (!benchSelected(settings, "scenario_scaling", "full_run")) return;
+
+    // Deterministic grid over the main.c ranges (angle 0-45°, ball 20-100 m, train behind the ball)
+    ScenarioJob *jobs = NULL;
+    int rounds = 1;
+    long long elapsed = 0;
+    for (;;) {
+        free(jobs);
+        jobs = (ScenarioJob*)malloc((size_t)rounds * BENCH_SCENARIO_COUNT * sizeof(ScenarioJob));
+        if (jobs == NULL) return;
+        for (int j = 0; j < rounds * BENCH_SCENARIO_COUNT; j++) {
+            int s = j % BENCH_SCENARIO_COUNT;
+            jobs[j].modelIndex = s % MODEL_COUNT;
+            jobs[j].angle = 45.0 * (double)(s % 8) / 7.0;
+            jobs[j].targetX = 20.0 + 80.0 * (double)(s / 8) / 7.0;
+            jobs[j].trainX = 0.5 * (jobs[j].targetX - 20.0);
+        }
+        elapsed = timeScenarioSet(1, rounds, jobs);
+        if (elapsed < 0 || elapsed >= settings->minTimeNs || rounds >= 4096) break;
+        rounds *= 2;
+    }
+
+    long long items = (long long)rounds * BENCH_SCENARIO_COUNT * BENCH_SCENARIO_STEPS;
+    int hardware = getHardwareConcurrency();
+    for (int threads = 1; elapsed >= 0; ) {
+        long long best = timeScenarioSet(threads, rounds, jobs);
+        for (int r = 1; r < BENCH_REPETITIONS && best >= 0; r++) {
+            long long t = timeScenarioSet(threads, rounds, jobs);
+            if (t >= 0 && t < best) best = t;
+        }
+        if (best >= 0) {
+            benchReport(settings, "scenario_scaling", "full_run", threads, items, (double)best / (double)items);
+        }
+
+        // 1, 2, 4, ... and finally the hardware thread count
+        if (threads >= hardware) break;
+        threads = threads * 2 < hardware ? threads * 2 : hardware;
+    }
+    free(jobs);
+}
+
+static void benchTraceIo(const BenchSettings *settings) {
+    static const char *const columns[] = {
+        "time", "train_position", "falling_object_position", "applied_force",
+        "train_velocity", "train_acceleration", "error_derivative", "error_integral"
+    };
+    static const struct { const char *name; TraceFormat format; } formats[] = {
+        { "csv", TRACE_FORMAT_CSV }, { "f64", TRACE_FORMAT_BINARY_F64 }, { "f32", TRACE_FORMAT_BINARY_F32 },
+        { "packed", TRACE_FORMAT_PACKED }
+    };
+
+    if (startTraceWriterThread() != ERROR_SUCCESS) return;
+    for (int f = 0; f < (int)(sizeof(formats) / sizeof(formats[0])); f++) {
+        if (!benchSelected(settings, "trace_io", formats[f].name)) continue;
+
+        char path[64];
+        snprintf(path, sizeof(path), "bench_trace%s", getTraceFileExtension(formats[f].format));
+        long long best = -1;
+        for (int r = 0; r < BENCH_REPETITIONS; r++) {
+            TraceWriter *writer = NULL;
+            long long start = benchNowNs();
+            if (openTraceWriter(path, formats[f].format, 8, columns, &writer) != ERROR_SUCCESS) break;
+            if (formats[f].format == TRACE_FORMAT_PACKED) setTraceAnimationRate(writer, 30.0);
+            for (long i = 0; i < BENCH_TRACE_ROWS; i++) {
+                double row[8] = { i * BENCH_DT, 10.0 + (double)(i & 127) * 0.5, 100.0 - (double)(i & 63),
+                                  (double)(i & 31) * 90.0, 1.5, -0.25, 0.125, (double)i * 1e-3 };
+                appendTraceRow(writer, row);
+            }
+            ErrorCode err = closeTraceWriter(writer);  // Includes flushing the last chunks
+            long long t = benchNowNs() - start;
+            if (err != ERROR_SUCCESS) break;
+            if (best < 0 || t < best) best = t;
+        }
+        remove(path);
+        if (best >= 0) {
+            benchReport(settings, "trace_io", formats[f].name, 1, BENCH_TRACE_ROWS,
+                        (double)best / (double)BENCH_TRACE_ROWS);
+        }
+    }
+    stopTraceWriterThread();
+}
+
+static void printUsage(const char *program) {
+    printf("Usage: %s [--filter TEXT] [--min-time-ms N]\n", program);
+    printf("  --filter TEXT    Only run cases whose group/case contains TEXT (e.g. controller/, stepper/pid)\n");
+    printf("  --min-time-ms N  Minimum duration of one timed repetition (default %d)\n", BENCH_DEFAULT_MIN_TIME_MS);
+    printf("Results are printed as JSON lines on stdout.\n");
+}
+
+int main(int argc, char *argv[]) {
+    BenchSettings settings = { (long long)BENCH_DEFAULT_MIN_TIME_MS * 1000000LL, NULL, "freefall_object", stdout };
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--filter") == 0 && a + 1 < argc) {
+            settings.filter = argv[++a];
+        } else if (strcmp(argv[a], "--min-time-ms") == 0 && a + 1 < argc) {
+            settings.minTimeNs = (long long)atoi(argv[++a]) * 1000000LL;
+        } else if (strcmp(argv[a], "--help") == 0 || strcmp(argv[a], "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            printf("Unknown option: %s\n", argv[a]);
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    ObjectBench bench;
+    for (int c = 0; c < CONTROLLER_COUNT; c++) {
+        initBenchObject(&bench, controllers[c].callback, objectModel, 30.0, 10.0, 60.0);
+        benchRun(&settings, "controller", controllers[c].name, 1, benchController, &bench);
+    }
+
+    benchEmbedded(&settings);
+
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        initBenchObject(&bench, pidController, models[m].callback, 30.0, 50.0, 60.0);
+        benchRun(&settings, "model", models[m].name, 1, benchModel, &bench);
+    }
+
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        for (int c = 0; c < CONTROLLER_COUNT; c++) {
+            char name[128];
+            snprintf(name, sizeof(name), "%s+%s", controllers[c].name, models[m].name);
+            initBenchObject(&bench, controllers[c].callback, models[m].callback, 30.0, 10.0, 60.0);
+            benchRun(&settings, "update_system", name, 1, benchUpdateSystem, &bench);
+            initBenchObject(&bench, controllers[c].callback, models[m].callback, 30.0, 10.0, 60.0);
+            if (bench.stepper) {
+                benchRun(&settings, "stepper", name, 1, benchStepper, &bench);
+            }
+        }
+    }
+
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        initBenchObject(&bench, pidController, models[m].callback, 30.0, 10.0, 60.0);
+        if (bench.sensitivityStepper == NULL) continue;
+        benchRun(&settings, "sensitivity", models[m].name, 1, benchSensitivityStepper, &bench);
+        char name[128];
+        snprintf(name, sizeof(name), "%s_gradient", models[m].name);
+        checkSensitivityGradient(&settings, models[m].callback, name);
+    }
+
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        initBenchObject(&bench, pidController, models[m].callback, 0.0, 10.0, 60.0);
+        FallingObjectBatch batch;
+        if (initFallingObjectBatch(&batch, BENCH_BATCH_SIZE, &bench.object.model) != ERROR_SUCCESS) continue;
+        for (int i = 0; i < BENCH_BATCH_SIZE; i++) {
+            double angle = 45.0 * (double)(i % 16) / 15.0 * M_PI / 180.0;
+            setFallingObjectBatchPlant(&batch, i, 10.0, 60.0, angle, &PARAMS_PID);
+        }
+        benchRun(&settings, "batch", models[m].name, BENCH_BATCH_SIZE, benchBatch, &batch);
+        freeFallingObjectBatch(&batch);
+    }
+
+    initBenchObject(&bench, mpcController, objectModel, 10.0, 10.0, 60.0);
+    benchMpc(&settings, &bench);
+
+    benchScenarioScaling(&settings);
+    benchTraceIo(&settings);
+    return 0;
+}
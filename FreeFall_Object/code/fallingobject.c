@@ -1,5 +1,39 @@
 #include "fallingobject.h"
+#include "fallingobject_kernels.h"
+#include <stddef.h>
 #include <math.h>
+#include <string.h>
+
+// Derive the run-invariant coefficients once per run instead of once per step
+ErrorCode prepareObjectModel(ObjectModelConfig *model) {
+    if (model == NULL) return ERROR_NULL_POINTER;
+    if (model->mass <= 0.0 || model->max_position <= 0.0) return ERROR_INVALID_PARAMETER;
+    
+    // Gravity component tangential to motion: F_g_t = m*g*sin(θ)
+    // For vertical free fall: sin(90°) = 1, so F_g_t = m*g
+    model->prepared.gravity_force = model->mass * model->gravity * sin(model->incline_angle);
+    model->prepared.inverse_mass = 1.0 / model->mass;
+    model->prepared.percent_per_meter = 100.0 / model->max_position;
+    return ERROR_SUCCESS;
+}
+
+// Semi-implicit Euler of the error: ė+ = ė - dt*k*(F - w), e+ = e + dt*ė+ with k = (100/x_max)/m
+ErrorCode linearizeObjectModel(const ObjectModelConfig *model, double dt, MpcModel *linear) {
+    if (model == NULL || linear == NULL) return ERROR_NULL_POINTER;
+    if (dt <= 0.0 || model->prepared.inverse_mass <= 0.0 || model->prepared.percent_per_meter <= 0.0) {
+        return ERROR_INVALID_PARAMETER;
+    }
+    
+    double gain = model->prepared.percent_per_meter * model->prepared.inverse_mass;  // %/s² per N
+    memset(linear, 0, sizeof(*linear));
+    linear->states = 2;
+    linear->A[0][0] = 1.0;
+    linear->A[0][1] = dt;
+    linear->A[1][1] = 1.0;
+    linear->B[0] = -dt * dt * gain;
+    linear->B[1] = -dt * gain;
+    return ERROR_SUCCESS;
+}
 
 // Get desired position from object
 ErrorCode getObjectSetpoint(void *system, double *setpoint) {
@@ -24,31 +58,16 @@ ErrorCode getObjectOutput(void *system, double *output) {
 // From Image 2: F_g_t = Fg*sin(θ) (component along incline)
 // F_drag = drag_coeff * v²
 double calculateObjectNetForce(FallingObject *object, double velocity, double applied_force) {
-    // Gravity component tangential to motion: F_g_t = m*g*sin(θ)
-    // For vertical free fall: sin(90°) = 1, so F_g_t = m*g
-    double gravity_force = object->model.mass * object->model.gravity * sin(object->model.incline_angle);
-    
-    // Air resistance/drag: F_drag = C_d * v²
-    double drag_force = object->model.drag_coeff * velocity * velocity;
-    
-    // Net force: F_net = F_applied - F_gravity - F_drag
+    // Gravity component tangential to motion: F_g_t = m*g*sin(θ) (prepared)
     // Positive direction is upward (against gravity)
-    double net_force = applied_force - gravity_force - drag_force;
-    
-    return net_force;
+    return objectNetForceLaw(&object->model, object->model.prepared.gravity_force, velocity, applied_force);
 }
 
 // Calculate simplified net force (no drag)
 double calculateObjectNetForceSimplified(FallingObject *object, double velocity, double applied_force) {
-    (void)velocity;  // Unused in simplified model
-    
-    // Only gravity component: F_g_t = m*g*sin(θ)
-    double gravity_force = object->model.mass * object->model.gravity * sin(object->model.incline_angle);
-    
-    // Net force: F_net = F_applied - F_gravity
-    double net_force = applied_force - gravity_force;
-    
-    return net_force;
+    // Only gravity component: F_net = F_applied - m*g*sin(θ)
+    return objectNetForceSimplifiedLaw(&object->model, object->model.prepared.gravity_force,
+                                       velocity, applied_force);
 }
 
 // Falling object math model callback (Euler integration)
@@ -59,32 +78,13 @@ ErrorCode objectModel(void *system, double input, double dt, double *output) {
     FallingObject *object = (FallingObject *)system;
     
     // Set applied force from control input (limit to maximum)
-    object->applied_force = input;
-    if (object->applied_force > object->model.max_force) {
-        object->applied_force = object->model.max_force;
-    }
-    if (object->applied_force < -object->model.max_force) {
-        object->applied_force = -object->model.max_force;
-    }
+    objectApplyForce(object, input);
     
     // Calculate net force using callback
     double net_force = object->model.netForceCallback(object, object->velocity, object->applied_force);
     
-    // Calculate acceleration: a = F_net / m (from diagram: dv/dt = a)
-    double acceleration = net_force / object->model.mass;
-    
-    // Update velocity: v(t) = v_i + (1/m) * ∫F_a(t)dt (Euler integration)
-    object->velocity += acceleration * dt;
-    
-    // Update position: x(t) = x_i + ∫v(t)dt (from diagram: dx/dt = v(t))
-    object->position += object->velocity * dt;
-    
-    // Keep position within physical limits (0 to max_position)
-    if (object->position < 0.0) object->position = 0.0;
-    if (object->position > object->model.max_position) object->position = object->model.max_position;
-    
-    // Derive position percentage from position: position_pct = (position / max_position) × 100
-    object->position_pct = (object->position / object->model.max_position) * 100.0;
+    // Integrate velocity and position: dv/dt = F_net / m, dx/dt = v(t)
+    objectEulerIntegrate(object, net_force, dt);
     
     // Return the updated position percentage as output
     *output = object->position_pct;
@@ -100,44 +100,13 @@ ErrorCode objectModelTrapezoidal(void *system, double input, double dt, double *
     FallingObject *object = (FallingObject *)system;
     
     // Set applied force from control input
-    object->applied_force = input;
-    if (object->applied_force > object->model.max_force) {
-        object->applied_force = object->model.max_force;
-    }
-    if (object->applied_force < -object->model.max_force) {
-        object->applied_force = -object->model.max_force;
-    }
+    objectApplyForce(object, input);
     
     // Calculate net force at current state (this becomes F_a(t_j))
     double net_force_current = object->model.netForceCallback(object, object->velocity, object->applied_force);
     
-    // Apply trapezoidal rule: average of previous and current net forces
-    // From Image 1: (F_a(t_{j-1}) + F_a(t_j))/2
-    double net_force_avg = (object->previousNetForce + net_force_current) / 2.0;
-    
-    // Calculate average acceleration: a_avg = F_net_avg / m
-    double acceleration_avg = net_force_avg / object->model.mass;
-    
-    // Store current velocity for position update
-    double velocity_prev = object->velocity;
-    
-    // Update velocity: v(t_j) = v(t_{j-1}) + (1/m) * (F_a(t_{j-1}) + F_a(t_j))/2 * Δt
-    object->velocity += acceleration_avg * dt;
-    
-    // Update position using trapezoidal rule for velocity
-    // From Image 1: x(t_j) = x(t_{j-1}) + (v(t_{j-1}) + v(t_j))/2 * Δt
-    double velocity_avg = (velocity_prev + object->velocity) / 2.0;
-    object->position += velocity_avg * dt;
-    
-    // Keep position within physical limits
-    if (object->position < 0.0) object->position = 0.0;
-    if (object->position > object->model.max_position) object->position = object->model.max_position;
-    
-    // Derive position percentage from position
-    object->position_pct = (object->position / object->model.max_position) * 100.0;
-    
-    // Store current net force for next iteration
-    object->previousNetForce = net_force_current;
+    // Apply trapezoidal rule to force and velocity, clamp and derive position percentage
+    objectTrapezoidalIntegrate(object, net_force_current, dt);
     
     // Return the updated position percentage as output
     *output = object->position_pct;
@@ -151,42 +120,48 @@ ErrorCode objectModelTrapezoidalSimplified(void *system, double input, double dt
     FallingObject *object = (FallingObject *)system;
     
     // Set applied force from control input
-    object->applied_force = input;
-    if (object->applied_force > object->model.max_force) {
-        object->applied_force = object->model.max_force;
-    }
-    if (object->applied_force < -object->model.max_force) {
-        object->applied_force = -object->model.max_force;
-    }
+    objectApplyForce(object, input);
     
     // Calculate net force at current state (simplified - no drag)
     double net_force_current = object->model.netForceCallback(object, object->velocity, object->applied_force);
     
-    // Apply trapezoidal rule: average of previous and current net forces
-    double net_force_avg = (object->previousNetForce + net_force_current) / 2.0;
+    // Apply trapezoidal rule to force and velocity, clamp and derive position percentage
+    objectTrapezoidalIntegrate(object, net_force_current, dt);
     
-    // Calculate average acceleration
-    double acceleration_avg = net_force_avg / object->model.mass;
-    
-    // Store current velocity for position update
-    double velocity_prev = object->velocity;
+    // Return the updated position percentage as output
+    *output = object->position_pct;
+    return ERROR_SUCCESS;
+}
+
+// State derivative for the adaptive integrator: state = [x, v], d/dt = [v, F_net(v) / m]
+static ErrorCode objectStateDerivative(void *system, const double *state, double *derivative) {
+    FallingObject *object = (FallingObject *)system;
+    derivative[0] = state[1];
+    derivative[1] = object->model.netForceCallback(object, state[1], object->applied_force) *
+                    object->model.prepared.inverse_mass;
+    return ERROR_SUCCESS;
+}
+
+// Falling object model with adaptive-step integration
+// Sub-steps inside dt where drag makes the velocity change quickly (high speed, force reversals)
+ErrorCode objectModelAdaptive(void *system, double input, double dt, double *output) {
+    if (system == NULL || output == NULL) return ERROR_NULL_POINTER;
     
-    // Update velocity using trapezoidal rule
-    object->velocity += acceleration_avg * dt;
+    FallingObject *object = (FallingObject *)system;
     
-    // Update position using trapezoidal rule
-    double velocity_avg = (velocity_prev + object->velocity) / 2.0;
-    object->position += velocity_avg * dt;
+    // Set applied force from control input (limit to maximum), held constant over the tick
+    objectApplyForce(object, input);
     
-    // Keep position within physical limits
-    if (object->position < 0.0) object->position = 0.0;
-    if (object->position > object->model.max_position) object->position = object->model.max_position;
+    double state[2] = { object->position, object->velocity };
+    ErrorCode err = integrateAdaptive(&object->integrator, objectStateDerivative, object, 2, state, dt);
+    if (err != ERROR_SUCCESS) return err;
     
-    // Derive position percentage from position
-    object->position_pct = (object->position / object->model.max_position) * 100.0;
+    object->position = state[0];
+    object->velocity = state[1];
+    objectStorePosition(object);
     
-    // Store current net force for next iteration
-    object->previousNetForce = net_force_current;
+    // Net force at the end of the tick (logged as the train acceleration)
+    object->previousNetForce = object->model.netForceCallback(object, object->velocity, object->applied_force);
     
     // Return the updated position percentage as output
     *output = object->position_pct;
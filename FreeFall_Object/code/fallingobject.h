@@ -2,6 +2,8 @@
 #define FALLINGOBJECT_H
 
 #include "controller.h"
+#include "integrator.h"
+#include "mpc.h"
 
 // Forward declaration
 typedef struct FallingObject FallingObject;
@@ -12,6 +14,14 @@ typedef struct FallingObject FallingObject;
 // Returns: net force (N)
 typedef double (*NetForceCallback)(FallingObject *object, double velocity, double applied_force);
 
+// Run-invariant coefficients derived from the model parameters (prepareObjectModel)
+// The per-step code reads only these, so sin(θ) and the divisions stay out of the hot path
+typedef struct {
+    double gravity_force;      // Gravity component along the incline: m*g*sin(θ) (N)
+    double inverse_mass;       // 1/m (1/kg)
+    double percent_per_meter;  // 100/max_position (%/m)
+} ObjectModelConstants;
+
 // Model configuration structure
 typedef struct {
     double mass;               // Object mass (kg)
@@ -22,6 +32,7 @@ typedef struct {
     double max_position;       // Maximum position (m) for 100% normalization
     SystemModelCallback callback; // System model callback
     NetForceCallback netForceCallback; // Net force calculation callback
+    ObjectModelConstants prepared;     // Derived coefficients (set by prepareObjectModel)
 } ObjectModelConfig;
 
 // Falling object simulation parameters
@@ -34,8 +45,39 @@ typedef struct FallingObject {
     double previousNetForce;   // Net force from previous iteration (for trapezoidal integration)
     ControllerConfig controller; // Controller configuration with callbacks
     ObjectModelConfig model;   // Model configuration with parameters
+    AdaptiveIntegrator integrator; // Step control and statistics of objectModelAdaptive
 } FallingObject;
 
+// Derivatives of the object state with respect to the PID gains (index GAIN_KP, GAIN_KI, GAIN_KD)
+// Propagated next to the state by the sensitivity steppers (fallingobject_stepper.h);
+// zero-fill it at the start of a run, since the initial state does not depend on the gains
+typedef struct {
+    double position_pct[GAIN_COUNT];     // d(position_pct)/d(gain) - OUTPUT
+    double velocity[GAIN_COUNT];         // d(velocity)/d(gain)
+    double position[GAIN_COUNT];         // d(position)/d(gain)
+    double applied_force[GAIN_COUNT];    // d(applied_force)/d(gain)
+    double previousNetForce[GAIN_COUNT]; // d(previousNetForce)/d(gain)
+    ControllerSensitivity controller;    // Derivatives of the PID state
+} ObjectSensitivity;
+
+// Derive the run-invariant coefficients of a model (model->prepared)
+// Must be called after setting, and after every change of, mass, gravity, incline_angle or max_position
+// Parameters:
+//   model: model configuration
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (mass or max_position <= 0)
+ErrorCode prepareObjectModel(ObjectModelConfig *model);
+
+// Prediction model of mpcController in position error coordinates (e = setpoint - position, %)
+// State [e, de/dt] of the train as a double integrator discretized like objectModel
+// (velocity first, then position): gravity along the incline and drag form the input
+// disturbance w that the controller's observer tracks.
+// Parameters:
+//   model: prepared model configuration
+//   dt: controller period (seconds)
+//   linear: pointer to store the two-state model
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (dt <= 0, model not prepared)
+ErrorCode linearizeObjectModel(const ObjectModelConfig *model, double dt, MpcModel *linear);
+
 // Get desired position from object (GetSetpointCallback compatible)
 // Parameters:
 //   system: pointer to FallingObject structure (cast from void*)
@@ -102,4 +144,15 @@ ErrorCode objectModelTrapezoidal(void *system, double input, double dt, double *
 // Returns: ErrorCode
 ErrorCode objectModelTrapezoidalSimplified(void *system, double input, double dt, double *output);
 
+// Falling object model with adaptive-step Dormand–Prince integration (with drag)
+// The applied force is held over dt and position/velocity are integrated with error-controlled
+// internal steps (object->integrator: tolerances, step hint carried across ticks, step statistics)
+// Parameters:
+//   system: pointer to FallingObject structure (cast from void*)
+//   input: control input (applied force, N)
+//   dt: time step (s)
+//   output: pointer to store updated position (percentage 0-100%)
+// Returns: ErrorCode
+ErrorCode objectModelAdaptive(void *system, double input, double dt, double *output);
+
 #endif // FALLINGOBJECT_H
@@ -0,0 +1,219 @@
+#include "fallingobject_batch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Round array length up to 8 doubles so every array starts on a 64-byte boundary
+// relative to the allocation (keeps vector loads aligned across arrays)
+#define OBJECT_BATCH_STRIDE(n) ((((size_t)(n)) + 7) & ~(size_t)7)
+
+size_t getFallingObjectBatchStorageSize(int count) {
+    if (count <= 0) return 0;
+    return OBJECT_BATCH_STRIDE(count) * OBJECT_BATCH_ARRAYS;
+}
+
+// Validate and prepare the configuration and select the integration scheme once, instead of
+// dispatching through callbacks every step
+static ErrorCode getObjectBatchModelType(int count, const ObjectModelConfig *model, ObjectModelConfig *prepared,
+                                         ObjectBatchModel *modelType) {
+    if (count <= 0 || model->mass <= 0.0 || model->max_position <= 0.0) {
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (model->callback == objectModel) {
+        *modelType = OBJECT_BATCH_EULER;
+    } else if (model->callback == objectModelTrapezoidal) {
+        *modelType = OBJECT_BATCH_TRAPEZOIDAL;
+    } else if (model->callback == objectModelTrapezoidalSimplified) {
+        *modelType = OBJECT_BATCH_TRAPEZOIDAL_SIMPLIFIED;
+    } else {
+        return ERROR_INVALID_PARAMETER;
+    }
+    *prepared = *model;
+    return prepareObjectModel(prepared);  // Shared 1/m and 100/max_position (the incline is per object)
+}
+
+// Point the arrays into a zeroed block (model prepared by getObjectBatchModelType)
+static void assignObjectBatchArrays(FallingObjectBatch *batch, int count, ObjectBatchModel modelType,
+                                    const ObjectModelConfig *model, double *block) {
+    size_t stride = OBJECT_BATCH_STRIDE(count);
+    batch->count = count;
+    batch->modelType = modelType;
+    batch->model = *model;
+    batch->position         = block;
+    batch->velocity         = block + stride * 1;
+    batch->position_pct     = block + stride * 2;
+    batch->setpoint         = block + stride * 3;
+    batch->applied_force    = block + stride * 4;
+    batch->previousNetForce = block + stride * 5;
+    batch->gravityForce     = block + stride * 6;
+    batch->integral         = block + stride * 7;
+    batch->previousError    = block + stride * 8;
+    batch->Kp               = block + stride * 9;
+    batch->Ki               = block + stride * 10;
+    batch->Kd               = block + stride * 11;
+    batch->storage = block;
+}
+
+ErrorCode initFallingObjectBatch(FallingObjectBatch *batch, int count, const ObjectModelConfig *model) {
+    if (batch == NULL || model == NULL) return ERROR_NULL_POINTER;
+    ObjectModelConfig prepared;
+    ObjectBatchModel modelType;
+    ErrorCode err = getObjectBatchModelType(count, model, &prepared, &modelType);
+    if (err != ERROR_SUCCESS) return err;
+
+    double *block = (double*)calloc(getFallingObjectBatchStorageSize(count), sizeof(double));
+    if (block == NULL) return ERROR_NULL_POINTER;
+
+    assignObjectBatchArrays(batch, count, modelType, &prepared, block);
+    batch->ownsStorage = 1;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode initFallingObjectBatchStorage(FallingObjectBatch *batch, int count, const ObjectModelConfig *model,
+                                        double *storage) {
+    if (batch == NULL || model == NULL || storage == NULL) return ERROR_NULL_POINTER;
+    ObjectModelConfig prepared;
+    ObjectBatchModel modelType;
+    ErrorCode err = getObjectBatchModelType(count, model, &prepared, &modelType);
+    if (err != ERROR_SUCCESS) return err;
+
+    memset(storage, 0, getFallingObjectBatchStorageSize(count) * sizeof(double));
+    assignObjectBatchArrays(batch, count, modelType, &prepared, storage);
+    batch->ownsStorage = 0;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode setFallingObjectBatchPlant(FallingObjectBatch *batch, int index, double initial_position,
+                                     double setpoint, double incline_angle,
+                                     const ControllerParams *params) {
+    if (batch == NULL || params == NULL || batch->position == NULL) return ERROR_NULL_POINTER;
+    if (index < 0 || index >= batch->count) return ERROR_INVALID_PARAMETER;
+
+    batch->position[index] = initial_position;
+    batch->velocity[index] = 0.0;
+    batch->position_pct[index] = initial_position * batch->model.prepared.percent_per_meter;
+    batch->setpoint[index] = setpoint;
+    batch->applied_force[index] = 0.0;
+    batch->previousNetForce[index] = 0.0;
+    // The incline never changes during a run, so sin(θ) is evaluated here and not per step
+    batch->gravityForce[index] = batch->model.mass * batch->model.gravity * sin(incline_angle);
+    batch->integral[index] = 0.0;
+    batch->previousError[index] = 0.0;
+    batch->Kp[index] = params->Kp;
+    batch->Ki[index] = params->Ki;
+    batch->Kd[index] = params->Kd;
+    return ERROR_SUCCESS;
+}
+
+// Kernel parameter list: every array is a separate restrict-qualified parameter, since
+// GCC only takes restrict into account for function parameters when proving that the
+// arrays do not overlap (block-scope restrict pointers still get runtime alias checks).
+#define OBJECT_BATCH_KERNEL_PARAMS                                                     \
+    int n, double dt, double inverse_mass, double drag_coeff, double max_force,        \
+    double max_position, double percent_per_meter,                                     \
+    double *restrict position, double *restrict velocity,                              \
+    double *restrict position_pct, const double *restrict setpoint,                    \
+    double *restrict applied_force, double *restrict previousNetForce,                 \
+    const double *restrict gravityForce, double *restrict integral,                    \
+    double *restrict previousError, const double *restrict Kp,                         \
+    const double *restrict Ki, const double *restrict Kd
+
+// PID law plus force saturation shared by every scheme (same arithmetic as
+// pidController followed by the clamp in objectModel*)
+// Written as a macro so each loop below stays a single straight-line body the compiler can vectorize.
+// Clamps are written as `x < hi ? x : hi` / `x > lo ? x : lo`, the form that maps onto
+// vector min/max instructions (`x > hi ? hi : x` has different NaN semantics and does not).
+#define OBJECT_BATCH_PID(i, force)                                                \
+    do {                                                                          \
+        double error_ = setpoint[i] - position_pct[i];                            \
+        integral[i] += error_ * dt;                                               \
+        double derivative_ = (error_ - previousError[i]) / dt;                    \
+        previousError[i] = error_;                                                \
+        (force) = Kp[i] * error_ + Ki[i] * integral[i] + Kd[i] * derivative_;     \
+        (force) = (force) < max_force ? (force) : max_force;                      \
+        (force) = (force) > -max_force ? (force) : -max_force;                    \
+        applied_force[i] = (force);                                               \
+    } while (0)
+
+// Position clamp and percentage output shared by every scheme
+#define OBJECT_BATCH_STORE_POSITION(i, x)                          \
+    do {                                                           \
+        (x) = (x) > 0.0 ? (x) : 0.0;                               \
+        (x) = (x) < max_position ? (x) : max_position;             \
+        position[i] = (x);                                         \
+        position_pct[i] = (x) * percent_per_meter;                 \
+    } while (0)
+
+// objectModel: v += (F_net / m) * dt, x += v * dt
+static void stepObjectBatchEuler(OBJECT_BATCH_KERNEL_PARAMS) {
+    (void)previousNetForce;  // Euler scheme keeps no force history
+    for (int i = 0; i < n; i++) {
+        double force;
+        OBJECT_BATCH_PID(i, force);
+        double v = velocity[i];
+        double net_force = force - gravityForce[i] - drag_coeff * v * v;
+        v += (net_force * inverse_mass) * dt;
+        velocity[i] = v;
+        double x = position[i] + v * dt;
+        OBJECT_BATCH_STORE_POSITION(i, x);
+    }
+}
+
+// objectModelTrapezoidal: average of previous/current net force and velocity
+static void stepObjectBatchTrapezoidal(OBJECT_BATCH_KERNEL_PARAMS) {
+    for (int i = 0; i < n; i++) {
+        double force;
+        OBJECT_BATCH_PID(i, force);
+        double v_prev = velocity[i];
+        double net_force = force - gravityForce[i] - drag_coeff * v_prev * v_prev;
+        double net_force_avg = (previousNetForce[i] + net_force) / 2.0;
+        double v = v_prev + (net_force_avg * inverse_mass) * dt;
+        velocity[i] = v;
+        double x = position[i] + ((v_prev + v) / 2.0) * dt;
+        OBJECT_BATCH_STORE_POSITION(i, x);
+        previousNetForce[i] = net_force;
+    }
+}
+
+// objectModelTrapezoidalSimplified: no drag term
+static void stepObjectBatchTrapezoidalSimplified(OBJECT_BATCH_KERNEL_PARAMS) {
+    (void)drag_coeff;  // Simplified scheme has no drag
+    for (int i = 0; i < n; i++) {
+        double force;
+        OBJECT_BATCH_PID(i, force);
+        double v_prev = velocity[i];
+        double net_force = force - gravityForce[i];
+        double net_force_avg = (previousNetForce[i] + net_force) / 2.0;
+        double v = v_prev + (net_force_avg * inverse_mass) * dt;
+        velocity[i] = v;
+        double x = position[i] + ((v_prev + v) / 2.0) * dt;
+        OBJECT_BATCH_STORE_POSITION(i, x);
+        previousNetForce[i] = net_force;
+    }
+}
+
+ErrorCode stepFallingObjectBatch(FallingObjectBatch *batch, double dt) {
+    if (batch == NULL || batch->position == NULL) return ERROR_NULL_POINTER;
+    if (dt <= 0.0) return ERROR_INVALID_PARAMETER;
+
+    void (*kernel)(OBJECT_BATCH_KERNEL_PARAMS);
+    switch (batch->modelType) {
+    case OBJECT_BATCH_EULER:                  kernel = stepObjectBatchEuler; break;
+    case OBJECT_BATCH_TRAPEZOIDAL:            kernel = stepObjectBatchTrapezoidal; break;
+    case OBJECT_BATCH_TRAPEZOIDAL_SIMPLIFIED: kernel = stepObjectBatchTrapezoidalSimplified; break;
+    default: return ERROR_INVALID_PARAMETER;
+    }
+
+    kernel(batch->count, dt, batch->model.prepared.inverse_mass, batch->model.drag_coeff, batch->model.max_force,
+           batch->model.max_position, batch->model.prepared.percent_per_meter,
+           batch->position, batch->velocity, batch->position_pct, batch->setpoint,
+           batch->applied_force, batch->previousNetForce, batch->gravityForce,
+           batch->integral, batch->previousError, batch->Kp, batch->Ki, batch->Kd);
+    return ERROR_SUCCESS;
+}
+
+void freeFallingObjectBatch(FallingObjectBatch *batch) {
+    if (batch == NULL) return;
+    if (batch->ownsStorage) free(batch->storage);  // All arrays live in one block
+    memset(batch, 0, sizeof(*batch));
+}
@@ -0,0 +1,96 @@
+#ifndef FALLINGOBJECT_BATCH_H
+#define FALLINGOBJECT_BATCH_H
+
+#include <stddef.h>
+#include "fallingobject.h"
+
+// Integration scheme shared by every object in a batch
+typedef enum {
+    OBJECT_BATCH_EULER = 0,              // Same physics as objectModel (with drag)
+    OBJECT_BATCH_TRAPEZOIDAL,            // Same physics as objectModelTrapezoidal (with drag)
+    OBJECT_BATCH_TRAPEZOIDAL_SIMPLIFIED  // Same physics as objectModelTrapezoidalSimplified (no drag)
+} ObjectBatchModel;
+
+// Number of per-object arrays in the batch storage (position ... Kd, in struct order)
+#define OBJECT_BATCH_ARRAYS 12
+
+// Batch of N falling objects (trains) stored as structure-of-arrays
+// All objects share mass, gravity, drag, force limit and integration scheme;
+// the incline angle, initial position, setpoint and gains are per object.
+// All of them run the PID law (P, PI and PD are PID with zero gains).
+// Each array holds `count` values, index i belongs to object i.
+typedef struct {
+    int count;                   // Number of objects in the batch
+    ObjectBatchModel modelType;  // Integration scheme (derived from model.callback)
+    ObjectModelConfig model;     // Shared physical parameters (incline_angle unused)
+    double *position;            // Position (m) - INTERNAL TRACKING
+    double *velocity;            // Velocity (m/s) - INTERNAL STATE
+    double *position_pct;        // Position (0-100%) - OUTPUT
+    double *setpoint;            // Desired position (0-100%)
+    double *applied_force;       // Applied (saturated) control force (N)
+    double *previousNetForce;    // Net force from previous step (trapezoidal schemes)
+    double *gravityForce;        // m*g*sin(θ) for this object's incline
+    double *integral;            // Controller integral term
+    double *previousError;       // Controller previous error (derivative term)
+    double *Kp;                  // Proportional gain
+    double *Ki;                  // Integral gain
+    double *Kd;                  // Derivative gain
+    double *storage;             // Block holding every array above
+    int ownsStorage;             // Block allocated by initFallingObjectBatch (freed by freeFallingObjectBatch)
+} FallingObjectBatch;
+
+// Allocate a batch of objects sharing one model configuration
+// The integration scheme is derived from model->callback, which must be
+// objectModel, objectModelTrapezoidal or objectModelTrapezoidalSimplified.
+// All objects start at rest at position 0 with zero gains; use setFallingObjectBatchPlant to configure them.
+// Parameters:
+//   batch: batch to initialize
+//   count: number of objects (> 0)
+//   model: shared model configuration
+// Returns: ErrorCode
+ErrorCode initFallingObjectBatch(FallingObjectBatch *batch, int count, const ObjectModelConfig *model);
+
+// Number of doubles a batch of `count` objects keeps its arrays in
+// Parameters:
+//   count: number of objects (> 0)
+// Returns: storage size in doubles (0 for an invalid count)
+size_t getFallingObjectBatchStorageSize(int count);
+
+// Same as initFallingObjectBatch, with the arrays carved out of caller storage
+// (e.g. a NumPy buffer, so the state is readable in place between steps). The storage is
+// zeroed, must hold getFallingObjectBatchStorageSize(count) doubles and outlive the batch,
+// and is not released by freeFallingObjectBatch.
+// Parameters:
+//   batch: batch to initialize
+//   count: number of objects (> 0)
+//   model: shared model configuration
+//   storage: caller storage (8-byte aligned; 64-byte alignment keeps every array aligned)
+// Returns: ErrorCode
+ErrorCode initFallingObjectBatchStorage(FallingObjectBatch *batch, int count, const ObjectModelConfig *model,
+                                        double *storage);
+
+// Configure the initial state, incline and gains of one object in the batch
+// Parameters:
+//   batch: initialized batch
+//   index: object index (0 to count-1)
+//   initial_position: initial position (m)
+//   setpoint: desired position (0-100%)
+//   incline_angle: incline angle θ (radians)
+//   params: controller gains (Kp, Ki, Kd)
+// Returns: ErrorCode
+ErrorCode setFallingObjectBatchPlant(FallingObjectBatch *batch, int index, double initial_position,
+                                     double setpoint, double incline_angle,
+                                     const ControllerParams *params);
+
+// Advance every object in the batch by one time step (controller + model)
+// Equivalent to calling updateSystem() with pidController on each object.
+// Parameters:
+//   batch: initialized batch
+//   dt: time step (seconds)
+// Returns: ErrorCode
+ErrorCode stepFallingObjectBatch(FallingObjectBatch *batch, double dt);
+
+// Release the arrays owned by the batch (caller storage is left alone)
+void freeFallingObjectBatch(FallingObjectBatch *batch);
+
+#endif // FALLINGOBJECT_BATCH_H
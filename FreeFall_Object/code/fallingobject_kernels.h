@@ -0,0 +1,172 @@
+#ifndef FALLINGOBJECT_KERNELS_H
+#define FALLINGOBJECT_KERNELS_H
+
+#include <math.h>
+#include "fallingobject.h"
+
+// Inline building blocks of the object models in fallingobject.c
+// The SystemModelCallback functions and the specialized steppers (fallingobject_stepper.c)
+// are both assembled from these, so the two paths share one implementation of the physics.
+// No NULL checks: callers validate the object before using them.
+// Invariant coefficients come from model->prepared (prepareObjectModel).
+
+// Net force with drag: F_net = F_applied - F_gravity - C_d * v² (same as calculateObjectNetForce)
+static inline double objectNetForceLaw(const ObjectModelConfig *model, double gravity_force,
+                                       double velocity, double applied_force) {
+    // Air resistance/drag: F_drag = C_d * v²
+    double drag_force = model->drag_coeff * velocity * velocity;
+    return applied_force - gravity_force - drag_force;
+}
+
+// Net force without drag: F_net = F_applied - F_gravity (same as calculateObjectNetForceSimplified)
+static inline double objectNetForceSimplifiedLaw(const ObjectModelConfig *model, double gravity_force,
+                                                 double velocity, double applied_force) {
+    (void)model;
+    (void)velocity;  // Unused in simplified model
+    return applied_force - gravity_force;
+}
+
+// Set the applied force from the control input, limited to ±max_force
+static inline void objectApplyForce(FallingObject *object, double input) {
+    object->applied_force = input;
+    if (object->applied_force > object->model.max_force) {
+        object->applied_force = object->model.max_force;
+    }
+    if (object->applied_force < -object->model.max_force) {
+        object->applied_force = -object->model.max_force;
+    }
+}
+
+// Clamp the position to [0, max_position] and derive the percentage position
+// Returns: updated position (percentage 0-100%)
+static inline double objectStorePosition(FallingObject *object) {
+    if (object->position < 0.0) object->position = 0.0;
+    if (object->position > object->model.max_position) object->position = object->model.max_position;
+
+    // position_pct = position × (100 / max_position)
+    object->position_pct = object->position * object->model.prepared.percent_per_meter;
+    return object->position_pct;
+}
+
+// Euler integration step (objectModel): v += (F_net / m) * dt, x += v * dt
+// Parameters:
+//   object: falling object (applied force already set)
+//   net_force: net force at the current velocity (N)
+//   dt: time step (s)
+// Returns: updated position (percentage 0-100%)
+static inline double objectEulerIntegrate(FallingObject *object, double net_force, double dt) {
+    // Calculate acceleration: a = F_net / m
+    double acceleration = net_force * object->model.prepared.inverse_mass;
+
+    object->velocity += acceleration * dt;
+    object->position += object->velocity * dt;
+    return objectStorePosition(object);
+}
+
+// Trapezoidal integration step (objectModelTrapezoidal*):
+//   v(t_j) = v(t_{j-1}) + (1/m) * (F_a(t_{j-1}) + F_a(t_j))/2 * Δt
+//   x(t_j) = x(t_{j-1}) + (v(t_{j-1}) + v(t_j))/2 * Δt
+// Parameters:
+//   object: falling object (applied force already set)
+//   net_force_current: net force at the current state, F_a(t_j) (N)
+//   dt: time step (s)
+// Returns: updated position (percentage 0-100%)
+static inline double objectTrapezoidalIntegrate(FallingObject *object, double net_force_current, double dt) {
+    double net_force_avg = (object->previousNetForce + net_force_current) / 2.0;
+    double acceleration_avg = net_force_avg * object->model.prepared.inverse_mass;
+
+    double velocity_prev = object->velocity;
+    object->velocity += acceleration_avg * dt;
+
+    double velocity_avg = (velocity_prev + object->velocity) / 2.0;
+    object->position += velocity_avg * dt;
+    double position_pct = objectStorePosition(object);
+
+    // Store current net force for next iteration
+    object->previousNetForce = net_force_current;
+    return position_pct;
+}
+
+// Forward-mode sensitivity kernels: derivatives of the steps above with respect to the PID gains
+// Each one mirrors its primal kernel; the clamps are handled as the piecewise functions they are,
+// so a clipped force or a position pinned at a track end has zero sensitivity.
+
+// Derivative of objectApplyForce: the force follows the input unless it is clipped to ±max_force
+static inline void objectApplyForceSensitivity(const FallingObject *object, double input,
+                                               const double *dInput, ObjectSensitivity *sensitivity) {
+    int clipped = input > object->model.max_force || input < -object->model.max_force;
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        sensitivity->applied_force[g] = clipped ? 0.0 : dInput[g];
+    }
+}
+
+// Derivative of objectNetForceLaw: dF_net = dF_applied - 2 * C_d * v * dv
+static inline void objectNetForceSensitivityLaw(const ObjectModelConfig *model, double velocity,
+                                                const ObjectSensitivity *sensitivity, double *dNetForce) {
+    double drag_slope = 2.0 * model->drag_coeff * velocity;
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        dNetForce[g] = sensitivity->applied_force[g] - drag_slope * sensitivity->velocity[g];
+    }
+}
+
+// Derivative of objectNetForceSimplifiedLaw: dF_net = dF_applied
+static inline void objectNetForceSimplifiedSensitivityLaw(const ObjectModelConfig *model, double velocity,
+                                                          const ObjectSensitivity *sensitivity,
+                                                          double *dNetForce) {
+    (void)model;
+    (void)velocity;
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        dNetForce[g] = sensitivity->applied_force[g];
+    }
+}
+
+// Derivative of objectStorePosition (after the primal clamp): zero while the position is
+// pinned at 0 or max_position
+static inline void objectStorePositionSensitivity(const FallingObject *object, ObjectSensitivity *sensitivity) {
+    int pinned = object->position <= 0.0 || object->position >= object->model.max_position;
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        if (pinned) sensitivity->position[g] = 0.0;
+        sensitivity->position_pct[g] = sensitivity->position[g] * object->model.prepared.percent_per_meter;
+    }
+}
+
+// objectEulerIntegrate with sensitivities: dv += (dF_net / m) * dt, dx += dv * dt
+// Parameters:
+//   object: falling object (applied force already set)
+//   sensitivity: state derivatives (applied_force already set)
+//   net_force: net force at the current velocity (N)
+//   dNetForce: its derivatives
+//   dt: time step (s)
+// Returns: updated position (percentage 0-100%)
+static inline double objectEulerSensitivityIntegrate(FallingObject *object, ObjectSensitivity *sensitivity,
+                                                     double net_force, const double *dNetForce, double dt) {
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        sensitivity->velocity[g] += dNetForce[g] * object->model.prepared.inverse_mass * dt;
+        sensitivity->position[g] += sensitivity->velocity[g] * dt;
+    }
+    double position_pct = objectEulerIntegrate(object, net_force, dt);
+    objectStorePositionSensitivity(object, sensitivity);
+    return position_pct;
+}
+
+// objectTrapezoidalIntegrate with sensitivities:
+//   dv(t_j) = dv(t_{j-1}) + (1/m) * (dF_a(t_{j-1}) + dF_a(t_j))/2 * Δt
+//   dx(t_j) = dx(t_{j-1}) + (dv(t_{j-1}) + dv(t_j))/2 * Δt
+// Parameters: as objectEulerSensitivityIntegrate
+// Returns: updated position (percentage 0-100%)
+static inline double objectTrapezoidalSensitivityIntegrate(FallingObject *object, ObjectSensitivity *sensitivity,
+                                                           double net_force_current, const double *dNetForce,
+                                                           double dt) {
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        double dNetForce_avg = (sensitivity->previousNetForce[g] + dNetForce[g]) / 2.0;
+        double dVelocity_prev = sensitivity->velocity[g];
+        sensitivity->velocity[g] += dNetForce_avg * object->model.prepared.inverse_mass * dt;
+        sensitivity->position[g] += (dVelocity_prev + sensitivity->velocity[g]) / 2.0 * dt;
+        sensitivity->previousNetForce[g] = dNetForce[g];
+    }
+    double position_pct = objectTrapezoidalIntegrate(object, net_force_current, dt);
+    objectStorePositionSensitivity(object, sensitivity);
+    return position_pct;
+}
+
+#endif // FALLINGOBJECT_KERNELS_H
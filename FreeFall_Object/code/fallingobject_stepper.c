@@ -0,0 +1,166 @@
+#include "fallingobject_stepper.h"
+#include "controller_kernels.h"
+#include "fallingobject_kernels.h"
+#include <stddef.h>
+
+// Model pipelines with a specialized variant, expanded once per controller
+// X(callback, law, name, model callback, net force callback, net force law, integration step)
+#define OBJECT_STEPPER_MODEL_LIST(X, callback, law)                                                 \
+    X(callback, law, Euler, objectModel, calculateObjectNetForce,                                   \
+      objectNetForceLaw, objectEulerIntegrate)                                                      \
+    X(callback, law, EulerNoDrag, objectModel, calculateObjectNetForceSimplified,                   \
+      objectNetForceSimplifiedLaw, objectEulerIntegrate)                                            \
+    X(callback, law, Trapezoidal, objectModelTrapezoidal, calculateObjectNetForce,                  \
+      objectNetForceLaw, objectTrapezoidalIntegrate)                                                \
+    X(callback, law, TrapezoidalNoDrag, objectModelTrapezoidal, calculateObjectNetForceSimplified,  \
+      objectNetForceSimplifiedLaw, objectTrapezoidalIntegrate)                                      \
+    X(callback, law, Simplified, objectModelTrapezoidalSimplified, calculateObjectNetForceSimplified, \
+      objectNetForceSimplifiedLaw, objectTrapezoidalIntegrate)                                      \
+    X(callback, law, SimplifiedDrag, objectModelTrapezoidalSimplified, calculateObjectNetForce,     \
+      objectNetForceLaw, objectTrapezoidalIntegrate)
+
+// Stepper for one (controller, model) pair: the same sequence as updateSystem()
+// (getObjectSetpoint, getObjectOutput, calculateError, controller, model) with direct field access.
+// The invariant coefficients (m*g*sin(θ), 1/m, 100/max_position) come from model.prepared.
+#define DEFINE_OBJECT_STEPPER(callback, law, name, modelCallback, netForceCallback, netForceLaw, integrate) \
+    static ErrorCode stepObject_##callback##_##name(FallingObject *object, double dt, int steps,          \
+                                                    double *output) {                                      \
+        const ControllerParams *params = object->controller.params;                                        \
+        ControllerState *state = object->controller.state;                                                 \
+        double controllerDt = object->controller.dt;                                                       \
+        const GainSchedule *schedule = object->controller.schedule;                                        \
+        double gravity_force = object->model.prepared.gravity_force;                                       \
+        for (int k = 0; k < steps; k++) {                                                                  \
+            double error = object->setpoint - object->position_pct;                                        \
+            objectApplyForce(object, law(error, params, state, controllerDt, schedule));                   \
+            double net_force = netForceLaw(&object->model, gravity_force, object->velocity,                \
+                                           object->applied_force);                                         \
+            integrate(object, net_force, dt);                                                              \
+        }                                                                                                  \
+        *output = object->position_pct;                                                                    \
+        return ERROR_SUCCESS;                                                                              \
+    }
+
+#define DEFINE_OBJECT_STEPPERS(callback, law) OBJECT_STEPPER_MODEL_LIST(DEFINE_OBJECT_STEPPER, callback, law)
+CONTROLLER_LAW_LIST(DEFINE_OBJECT_STEPPERS)
+
+// Lookup table of the generated steppers
+typedef struct {
+    ControllerCallback controller;
+    SystemModelCallback model;
+    NetForceCallback netForce;
+    ObjectStepper stepper;
+} ObjectStepperEntry;
+
+#define OBJECT_STEPPER_ENTRY(callback, law, name, modelCallback, netForceCallback, netForceLaw, integrate) \
+    { callback, modelCallback, netForceCallback, stepObject_##callback##_##name },
+#define OBJECT_STEPPER_ENTRIES(callback, law) OBJECT_STEPPER_MODEL_LIST(OBJECT_STEPPER_ENTRY, callback, law)
+
+static const ObjectStepperEntry objectSteppers[] = {
+    CONTROLLER_LAW_LIST(OBJECT_STEPPER_ENTRIES)
+};
+
+ErrorCode selectObjectStepper(const FallingObject *object, ControllerCallback controller,
+                              ObjectStepper *stepper) {
+    if (object == NULL || controller == NULL || stepper == NULL) return ERROR_NULL_POINTER;
+    *stepper = NULL;
+
+    // Everything updateSystem() and the controllers would check on every step, checked once
+    if (object->controller.params == NULL || object->controller.state == NULL) return ERROR_NULL_POINTER;
+    if (object->controller.getSetpoint != getObjectSetpoint ||
+        object->controller.getOutput != getObjectOutput) {
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (object->controller.history != NULL) return ERROR_INVALID_PARAMETER;  // Recorded by updateSystem() only
+
+    for (size_t i = 0; i < sizeof(objectSteppers) / sizeof(objectSteppers[0]); i++) {
+        const ObjectStepperEntry *entry = &objectSteppers[i];
+        if (entry->controller == controller && entry->model == object->model.callback &&
+            entry->netForce == object->model.netForceCallback) {
+            *stepper = entry->stepper;
+            return ERROR_SUCCESS;
+        }
+    }
+    return ERROR_INVALID_PARAMETER;
+}
+
+// Model pipelines with a sensitivity variant (pidController only)
+// X(name, model callback, net force callback, net force law, net force sensitivity, integration step)
+#define OBJECT_SENSITIVITY_MODEL_LIST(X)                                                            \
+    X(Euler, objectModel, calculateObjectNetForce,                                                  \
+      objectNetForceLaw, objectNetForceSensitivityLaw, objectEulerSensitivityIntegrate)             \
+    X(EulerNoDrag, objectModel, calculateObjectNetForceSimplified,                                  \
+      objectNetForceSimplifiedLaw, objectNetForceSimplifiedSensitivityLaw,                          \
+      objectEulerSensitivityIntegrate)                                                              \
+    X(Trapezoidal, objectModelTrapezoidal, calculateObjectNetForce,                                 \
+      objectNetForceLaw, objectNetForceSensitivityLaw, objectTrapezoidalSensitivityIntegrate)       \
+    X(TrapezoidalNoDrag, objectModelTrapezoidal, calculateObjectNetForceSimplified,                 \
+      objectNetForceSimplifiedLaw, objectNetForceSimplifiedSensitivityLaw,                          \
+      objectTrapezoidalSensitivityIntegrate)                                                        \
+    X(Simplified, objectModelTrapezoidalSimplified, calculateObjectNetForceSimplified,              \
+      objectNetForceSimplifiedLaw, objectNetForceSimplifiedSensitivityLaw,                          \
+      objectTrapezoidalSensitivityIntegrate)                                                        \
+    X(SimplifiedDrag, objectModelTrapezoidalSimplified, calculateObjectNetForce,                    \
+      objectNetForceLaw, objectNetForceSensitivityLaw, objectTrapezoidalSensitivityIntegrate)
+
+// Sensitivity stepper: the PID stepper sequence with the tangent of every step alongside.
+// The error is setpoint - position_pct with a fixed setpoint, so d(error) = -d(position_pct).
+#define DEFINE_OBJECT_SENSITIVITY_STEPPER(name, modelCallback, netForceCallback, netForceLaw,          \
+                                          netForceSensitivity, integrate)                              \
+    static ErrorCode stepObjectSensitivity_##name(FallingObject *object, ObjectSensitivity *sensitivity,  \
+                                                  double dt, int steps, double *output) {              \
+        const ControllerParams *params = object->controller.params;                                   \
+        ControllerState *state = object->controller.state;                                            \
+        double controllerDt = object->controller.dt;                                                  \
+        double gravity_force = object->model.prepared.gravity_force;                                  \
+        for (int k = 0; k < steps; k++) {                                                             \
+            double error = object->setpoint - object->position_pct;                                   \
+            double dError[GAIN_COUNT], dControl[GAIN_COUNT], dNetForce[GAIN_COUNT];                   \
+            for (int g = 0; g < GAIN_COUNT; g++) dError[g] = -sensitivity->position_pct[g];           \
+            double control = pidSensitivityLaw(error, params, state, controllerDt,                    \
+                                               &sensitivity->controller, dError, dControl);           \
+            objectApplyForce(object, control);                                                        \
+            objectApplyForceSensitivity(object, control, dControl, sensitivity);                      \
+            netForceSensitivity(&object->model, object->velocity, sensitivity, dNetForce);            \
+            double net_force = netForceLaw(&object->model, gravity_force, object->velocity,           \
+                                           object->applied_force);                                    \
+            integrate(object, sensitivity, net_force, dNetForce, dt);                                 \
+        }                                                                                             \
+        *output = object->position_pct;                                                               \
+        return ERROR_SUCCESS;                                                                         \
+    }
+
+OBJECT_SENSITIVITY_MODEL_LIST(DEFINE_OBJECT_SENSITIVITY_STEPPER)
+
+typedef struct {
+    SystemModelCallback model;
+    NetForceCallback netForce;
+    ObjectSensitivityStepper stepper;
+} ObjectSensitivityStepperEntry;
+
+#define OBJECT_SENSITIVITY_STEPPER_ENTRY(name, modelCallback, netForceCallback, netForceLaw,           \
+                                         netForceSensitivity, integrate)                               \
+    { modelCallback, netForceCallback, stepObjectSensitivity_##name },
+
+static const ObjectSensitivityStepperEntry objectSensitivitySteppers[] = {
+    OBJECT_SENSITIVITY_MODEL_LIST(OBJECT_SENSITIVITY_STEPPER_ENTRY)
+};
+
+ErrorCode selectObjectSensitivityStepper(const FallingObject *object, ObjectSensitivityStepper *stepper) {
+    if (stepper == NULL) return ERROR_NULL_POINTER;
+    *stepper = NULL;
+
+    // Same preconditions as the PID stepper
+    ObjectStepper primal = NULL;
+    ErrorCode err = selectObjectStepper(object, pidController, &primal);
+    if (err != ERROR_SUCCESS) return err;
+
+    for (size_t i = 0; i < sizeof(objectSensitivitySteppers) / sizeof(objectSensitivitySteppers[0]); i++) {
+        const ObjectSensitivityStepperEntry *entry = &objectSensitivitySteppers[i];
+        if (entry->model == object->model.callback && entry->netForce == object->model.netForceCallback) {
+            *stepper = entry->stepper;
+            return ERROR_SUCCESS;
+        }
+    }
+    return ERROR_INVALID_PARAMETER;
+}
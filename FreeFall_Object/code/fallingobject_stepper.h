@@ -0,0 +1,58 @@
+#ifndef FALLINGOBJECT_STEPPER_H
+#define FALLINGOBJECT_STEPPER_H
+
+#include "fallingobject.h"
+
+// Specialized stepping function for one (controller, model) pair
+// Runs `steps` iterations of controller + model with the setpoint held constant, with
+// every callback of the generic updateSystem() pipeline inlined and no per-step checks.
+// Only call it on the object it was selected for by selectObjectStepper().
+// Parameters:
+//   object: falling object validated by selectObjectStepper
+//   dt: model time step (s)
+//   steps: number of steps to run
+//   output: pointer to store position after the last step (percentage 0-100%)
+// Returns: ErrorCode
+typedef ErrorCode (*ObjectStepper)(FallingObject *object, double dt, int steps, double *output);
+
+// Select the specialized stepper matching an object configuration
+// The generated variants cover every controller in controller.h combined with objectModel,
+// objectModelTrapezoidal and objectModelTrapezoidalSimplified (with either net force callback).
+// The object must use getObjectSetpoint/getObjectOutput and have params and state set; any other
+// configuration returns ERROR_INVALID_PARAMETER and must keep using updateSystem(),
+// whose results the steppers reproduce exactly. So does a controller with an error history
+// attached (only updateSystem() records it, so the stepper loops stay free of it).
+// Parameters:
+//   object: configured falling object (controller and model filled in)
+//   controller: controller callback the object would be driven with
+//   stepper: pointer to store the selected stepper
+// Returns: ErrorCode
+ErrorCode selectObjectStepper(const FallingObject *object, ControllerCallback controller,
+                              ObjectStepper *stepper);
+
+// Sensitivity stepper: pidController + model steps that also propagate the derivatives of the
+// state with respect to Kp, Ki and Kd (forward mode, one tangent per gain)
+// The primal trajectory is exactly that of the ObjectStepper for the same configuration, so one
+// run yields the trajectory and, through sensitivity->position_pct, the exact gradient of any
+// cost built from it. Only call it on the object it was selected for.
+// Parameters:
+//   object: falling object validated by selectObjectSensitivityStepper
+//   sensitivity: state derivatives (zero-filled at the start of the run, updated)
+//   dt: model time step (s)
+//   steps: number of steps to run
+//   output: pointer to store position after the last step (percentage 0-100%)
+// Returns: ErrorCode
+typedef ErrorCode (*ObjectSensitivityStepper)(FallingObject *object, ObjectSensitivity *sensitivity,
+                                              double dt, int steps, double *output);
+
+// Select the sensitivity stepper for an object driven by pidController
+// Covers objectModel, objectModelTrapezoidal and objectModelTrapezoidalSimplified (with either net
+// force callback) under the same conditions as selectObjectStepper; any other model returns
+// ERROR_INVALID_PARAMETER.
+// Parameters:
+//   object: configured falling object (controller and model filled in)
+//   stepper: pointer to store the selected stepper
+// Returns: ErrorCode
+ErrorCode selectObjectSensitivityStepper(const FallingObject *object, ObjectSensitivityStepper *stepper);
+
+#endif // FALLINGOBJECT_STEPPER_H
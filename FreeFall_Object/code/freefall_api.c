@@ -0,0 +1,159 @@
+#include "freefall_api.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+int freefallApiVersion(void) {
+    return FREEFALL_API_VERSION;
+}
+
+size_t freefallBatchStorageSize(int count) {
+    return getFallingObjectBatchStorageSize(count);
+}
+
+size_t freefallBatchStride(int count) {
+    return count > 0 ? getFallingObjectBatchStorageSize(count) / OBJECT_BATCH_ARRAYS : 0;
+}
+
+// Train plant of a record, exactly as the simulation sets it up (initScenarioObject)
+static ErrorCode initRecordObject(const ScenarioRecord *record, SystemModelCallback model, FallingObject *object,
+                                  ControllerParams *params, ControllerState *state) {
+    FallScenario scenario;
+    getScenarioFromRecord(record, &scenario, params);
+    return initScenarioObject(object, &scenario, params, state, model, 0.02);  // Controller dt unused by the batch
+}
+
+int freefallBatchCreate(const ScenarioRecord *records, int count, uint32_t model, double *storage,
+                        FallingObjectBatch **batch) {
+    if (records == NULL || storage == NULL || batch == NULL) return ERROR_NULL_POINTER;
+    *batch = NULL;
+    if (count <= 0 || model == SCENARIO_MODEL_ADAPTIVE) return ERROR_INVALID_PARAMETER;
+    SystemModelCallback callback = getScenarioModelCallback(model);
+    if (callback == NULL) return ERROR_INVALID_PARAMETER;
+
+    FallingObject object;
+    ControllerParams params;
+    ControllerState state;
+    ErrorCode err = initRecordObject(&records[0], callback, &object, &params, &state);
+    if (err != ERROR_SUCCESS) return err;
+
+    FallingObjectBatch *created = (FallingObjectBatch*)malloc(sizeof(FallingObjectBatch));
+    if (created == NULL) return ERROR_NULL_POINTER;
+    err = initFallingObjectBatchStorage(created, count, &object.model, storage);
+
+    // Per-scenario start, target and incline (the shared model parameters do not depend on the record)
+    for (int i = 0; err == ERROR_SUCCESS && i < count; i++) {
+        err = initRecordObject(&records[i], callback, &object, &params, &state);
+        if (err == ERROR_SUCCESS) {
+            err = setFallingObjectBatchPlant(created, i, object.position, object.setpoint,
+                                             object.model.incline_angle, &params);
+        }
+    }
+    if (err != ERROR_SUCCESS) {
+        free(created);
+        return err;
+    }
+    *batch = created;
+    return ERROR_SUCCESS;
+}
+
+// Copy the state after a step into row `step` of the requested traces
+static void recordTraces(const FallingObjectBatch *batch, int step, const FreefallTraces *traces) {
+    size_t count = (size_t)batch->count;
+    size_t row = (size_t)step * count;
+    if (traces->position != NULL) memcpy(traces->position + row, batch->position, count * sizeof(double));
+    if (traces->velocity != NULL) memcpy(traces->velocity + row, batch->velocity, count * sizeof(double));
+    if (traces->force != NULL) memcpy(traces->force + row, batch->applied_force, count * sizeof(double));
+    if (traces->integral != NULL) memcpy(traces->integral + row, batch->integral, count * sizeof(double));
+    if (traces->error != NULL) {
+        double *error = traces->error + row;
+        for (size_t i = 0; i < count; i++) {
+            error[i] = batch->setpoint[i] - batch->position_pct[i];
+        }
+    }
+}
+
+int freefallBatchStep(FallingObjectBatch *batch, double dt, int steps, const FreefallTraces *traces) {
+    if (batch == NULL) return ERROR_NULL_POINTER;
+    if (steps < 0) return ERROR_INVALID_PARAMETER;
+
+    for (int k = 0; k < steps; k++) {
+        ErrorCode err = stepFallingObjectBatch(batch, dt);
+        if (err != ERROR_SUCCESS) return err;
+        if (traces != NULL) recordTraces(batch, k, traces);
+    }
+    return ERROR_SUCCESS;
+}
+
+void freefallBatchDestroy(FallingObjectBatch *batch) {
+    if (batch == NULL) return;
+    freeFallingObjectBatch(batch);
+    free(batch);
+}
+
+int freefallRunScenarios(const ScenarioRecord *records, int count, uint32_t model, double *storage,
+                         double dt, int steps, const FreefallTraces *traces, double *landingError) {
+    if (!(dt > 0.0) || steps < 0) return ERROR_INVALID_PARAMETER;
+    FallingObjectBatch *batch = NULL;
+    ErrorCode err = freefallBatchCreate(records, count, model, storage, &batch);
+    if (err != ERROR_SUCCESS) return err;
+    if (landingError == NULL) {
+        err = freefallBatchStep(batch, dt, steps, traces);
+        freefallBatchDestroy(batch);
+        return err;
+    }
+
+    // Bucket the scenarios by landing step (counting sort), so each step only visits its landings
+    int *landingStart = (int*)calloc((size_t)steps + 2, sizeof(int));
+    int *landingOrder = (int*)malloc((size_t)count * sizeof(int));
+    int *landingStep = (int*)malloc((size_t)count * sizeof(int));
+    double *landingTime = (double*)malloc((size_t)count * sizeof(double));
+    if (landingStart == NULL || landingOrder == NULL || landingStep == NULL || landingTime == NULL) {
+        free(landingStart);
+        free(landingOrder);
+        free(landingStep);
+        free(landingTime);
+        freefallBatchDestroy(batch);
+        return ERROR_NULL_POINTER;
+    }
+    for (int i = 0; i < count; i++) {
+        FallScenario scenario;
+        ControllerParams params;
+        getScenarioFromRecord(&records[i], &scenario, &params);
+        landingTime[i] = getScenarioLandingTime(&scenario, batch->model.gravity);
+        landingStep[i] = getScenarioLandingStep(landingTime[i], dt, steps);
+        landingStart[landingStep[i] + 1]++;
+        landingError[i] = NAN;
+    }
+    for (int k = 0; k <= steps; k++) {
+        landingStart[k + 1] += landingStart[k];
+    }
+    for (int i = 0; i < count; i++) {
+        landingOrder[landingStart[landingStep[i]]++] = i;
+    }
+    // landingStart[k] is now the end of bucket k, i.e. the start of bucket k + 1
+
+    int next = 0;
+    for (int k = 0; k < steps; k++) {
+        // Error at the start of the landing step, interpolated to the landing time after it
+        for (int b = next; b < landingStart[k]; b++) {
+            int i = landingOrder[b];
+            landingError[i] = batch->setpoint[i] - batch->position_pct[i];
+        }
+        err = stepFallingObjectBatch(batch, dt);
+        if (err != ERROR_SUCCESS) break;
+        if (traces != NULL) recordTraces(batch, k, traces);
+        for (; next < landingStart[k]; next++) {
+            int i = landingOrder[next];
+            landingError[i] = getScenarioLandingError(landingTime[i], k * dt, dt, landingError[i],
+                                                      batch->setpoint[i] - batch->position_pct[i]);
+        }
+    }
+
+    free(landingStart);
+    free(landingOrder);
+    free(landingStep);
+    free(landingTime);
+    freefallBatchDestroy(batch);
+    return err;
+}
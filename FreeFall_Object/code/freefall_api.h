@@ -0,0 +1,91 @@
+#ifndef FREEFALL_API_H
+#define FREEFALL_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fallingobject_batch.h"
+#include "scenario.h"
+
+// Flat C interface of the batch engine, exported by the freefall shared library for Python
+// (scripts/freefall_native.py loads it with ctypes). Every buffer is owned by the caller,
+// typically a NumPy array: scenarios are read from ScenarioRecord arrays (the layout of
+// scenario tables, so a memory-mapped table can be passed as is), the batch state lives in
+// caller storage and traces are written straight into caller arrays. Nothing is copied back.
+// Functions return an ErrorCode as int.
+
+#if defined(_WIN32)
+#ifdef FREEFALL_API_EXPORTS
+#define FREEFALL_API __declspec(dllexport)
+#else
+#define FREEFALL_API __declspec(dllimport)
+#endif
+#else
+#define FREEFALL_API __attribute__((visibility("default")))
+#endif
+
+// Bumped whenever a signature or a structure below changes
+#define FREEFALL_API_VERSION 1
+
+// Per-step traces, each NULL (not recorded) or a steps x count row-major array:
+// value [k * count + i] belongs to scenario i after step k
+typedef struct {
+    double *position;  // Train position (m)
+    double *velocity;  // Train velocity (m/s)
+    double *force;     // Applied (saturated) control force (N)
+    double *error;     // Controller error, setpoint - position (% of the track)
+    double *integral;  // Controller integral term (%·s)
+} FreefallTraces;
+
+// Interface version the library was built with (compare against FREEFALL_API_VERSION)
+FREEFALL_API int freefallApiVersion(void);
+
+// Number of doubles of batch storage for `count` scenarios (0 for an invalid count)
+FREEFALL_API size_t freefallBatchStorageSize(int count);
+
+// Distance in doubles between consecutive state arrays in the storage
+// Array a (0 position, 1 velocity, 2 position %, 3 setpoint %, 4 applied force,
+// 5 previous net force, 6 gravity force, 7 integral, 8 previous error, 9 Kp, 10 Ki, 11 Kd)
+// of scenario i is storage[a * stride + i].
+FREEFALL_API size_t freefallBatchStride(int count);
+
+// Set up a batch of scenarios on the train plant of initScenarioObject (100 kg, 3000 N, 100 m)
+// All scenarios run one integration scheme with the gains of their record (the record's model
+// field is ignored); the adaptive model has no batch kernel.
+// Parameters:
+//   records: `count` scenarios
+//   count: number of scenarios (> 0)
+//   model: SCENARIO_MODEL_EULER, SCENARIO_MODEL_TRAPEZOIDAL or SCENARIO_MODEL_SIMPLIFIED
+//   storage: freefallBatchStorageSize(count) doubles, must outlive the batch
+//   batch: receives the batch (release with freefallBatchDestroy)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER (also on allocation failure) or ERROR_INVALID_PARAMETER
+FREEFALL_API int freefallBatchCreate(const ScenarioRecord *records, int count, uint32_t model, double *storage,
+                                     FallingObjectBatch **batch);
+
+// Advance every scenario by `steps` time steps, recording the traces requested
+// Parameters:
+//   batch: batch from freefallBatchCreate
+//   dt: time step (s)
+//   steps: number of steps (the trace arrays hold steps rows)
+//   traces: arrays to fill (NULL: none)
+// Returns: ErrorCode
+FREEFALL_API int freefallBatchStep(FallingObjectBatch *batch, double dt, int steps, const FreefallTraces *traces);
+
+// Release a batch (the caller storage is left alone)
+FREEFALL_API void freefallBatchDestroy(FallingObjectBatch *batch);
+
+// Run scenarios from rest for `steps` steps and report the error at landing
+// The landing error is setpoint - position (% of the track) at the ball's landing time,
+// interpolated within the landing step like the catch error of the simulation and the gain
+// tuner (getScenarioLandingError; caught: |error| <= SCENARIO_CATCH_TOLERANCE), or NAN if the
+// ball lands after the last step.
+// Parameters:
+//   records, count, model, storage: as freefallBatchCreate (the storage holds the final state)
+//   dt: time step (s)
+//   steps: number of steps
+//   traces: arrays to fill (NULL: none)
+//   landingError: optional, `count` values
+// Returns: ErrorCode
+FREEFALL_API int freefallRunScenarios(const ScenarioRecord *records, int count, uint32_t model, double *storage,
+                                      double dt, int steps, const FreefallTraces *traces, double *landingError);
+
+#endif // FREEFALL_API_H
@@ -3,22 +3,75 @@
 #include <string.h>
 #include <signal.h>
 #include <math.h>
+#include <limits.h>
 #include <time.h>
 #include "fallingobject.h"
+#include "mpc.h"
+#include "fallingobject_stepper.h"
+#include "scenario.h"
+#include "scenario_stats.h"
+#include "scenario_dist.h"
 #include "plot.h"
+#include "jobpool.h"
+#include "stopcriteria.h"
+#include "profile.h"
 
 #ifdef _WIN32
-    #include <windows.h>
-    #include <process.h>
     #define M_PI 3.14159265358979323846
-#else
-    #include <pthread.h>
-    #include <unistd.h>
 #endif
 
 // Global flag for graceful shutdown
 volatile int keep_running = 1;
 
+// Run every simulation through the generic updateSystem() callbacks (--generic)
+static int use_generic_pipeline = 0;
+
+// Stop criteria (--early-stop): end a run once the ball landed and the train settled (the
+// KPIs are final up to the residual error inside the settle band), or after a max_force
+// saturation streak / divergence, which truncates the run (counted in the batch summary)
+static int early_stop = 0;
+static StopCriteria stop_criteria = {
+    .settleTolerance = 0.25,  // --settle-tol: within 0.25% (25 cm) of the ball X position
+    .settleTime = 1.0,        // --settle-time: for 1 s
+    .restRate = 0.1,          // Train moving by at most 0.1%/s (10 cm/s)
+    .divergenceLimit = 0.0,   // --divergence-limit: off (the train is bounded to 0-100%)
+    .saturationTime = 5.0     // --saturation-time: 5 s at max_force (limit set per object)
+};
+
+// Which runs write a full trace: every run (default), only flagged runs (missed catches,
+// re-run with tracing since runs are deterministic), or none; --trace-sample N also traces
+// every N-th scenario. KPIs of every run always go into csv_data/batch_summary.json.
+typedef enum {
+    TRACE_RUNS_ALL = 0,
+    TRACE_RUNS_FLAGGED,
+    TRACE_RUNS_NONE
+} TraceRunPolicy;
+
+static TraceRunPolicy trace_policy = TRACE_RUNS_ALL;
+static size_t trace_sample = 0;
+static TraceFormat trace_format = TRACE_FORMAT_BINARY_F64;  // --trace-format (setPlotTraceFormat)
+static double animation_rate = PLOT_ANIMATION_FPS;          // --animation-fps (setPlotAnimationRate)
+
+// Worker placement of the job pools (--pin-threads: one CPU per worker, spread over the NUMA nodes)
+static JobPoolPlacement worker_placement = JOB_POOL_FLOATING;
+
+// Error tolerance of the adaptive-step model (--model adaptive, --adaptive-tol; 0 = default)
+static double adaptive_tolerance = 0.0;
+
+// Controller of every scenario (--controller): the PID gains of the batch, or a
+// model-predictive controller on the linearized train (--mpc-horizon) whose force limit is
+// each train's max_force
+static ControllerCallback scenario_controller = pidController;
+static MpcConfig train_mpc_config = {
+    .horizon = 15,               // 0.3 s preview at dt = 0.02 s (LQR terminal weight beyond)
+    .stateWeight = {1.0, 0.1},   // Position error (%), error rate (%/s)
+    .inputWeight = 0.1,
+    .rateWeight = 0.1,
+    .rateLimit = 30000.0         // The force ramps from 0 to max_force in 0.1 s
+};
+
+#define BATCH_SUMMARY_PATH "csv_data/batch_summary.json"
+
 // Signal handler for Ctrl+C
 void signal_handler(int signum) {
     (void)signum;
@@ -29,9 +82,6 @@ void signal_handler(int signum) {
 // Simulation configuration
 typedef struct {
     void *realtimePlot;
-    void *simulationMutex;
-    void *simulationThread;
-    void *simulationComplete;
     const char *name;
     ControllerCallback controller;
     ControllerParams params;
@@ -45,115 +95,148 @@ typedef struct {
     double sim_time;
     int windowIndex;
     SystemModelCallback modelCallback;  // Model callback (Euler or Trapezoidal)
-    double landing_angle;  // Landing surface angle in degrees
-    double ball_x_position;  // Ball X position (where ball lands)
-    double train_x_initial;  // Train initial X position
-    double ball_y_initial;   // Ball initial Y height (random)
+    FallScenario scenario;   // Landing angle, ball X/Y, train initial X (random)
+    int stepsRun;            // Steps actually computed (--early-stop skips the rest)
+    int traced;              // Write a full trace of this run
+    int failed;              // The run could not start (no KPIs to record)
+    ScenarioKpis kpis;       // KPIs of the finished run
+    AdaptiveIntegrator integrator;  // Step statistics of the run (objectModelAdaptive only)
 } ThreadData;
 
-// Thread function to run a single simulation
-#ifdef _WIN32
-unsigned __stdcall runSimulation(void *arg) {
-#else
-void* runSimulation(void *arg) {
-#endif
-    ThreadData *data = (ThreadData*)arg;
+// Contiguous range of a scenario batch, run by one JobPool job
+typedef struct {
+    const ScenarioRecord *records;  // Records of the range (NULL: generate them from the seed)
+    uint64_t seed;                // Batch seed for generated scenarios
+    ControllerParams params;      // Gains of generated scenarios
+    ScenarioModel model;          // Model of generated scenarios
+    size_t first;                 // First scenario index
+    size_t count;                 // Scenarios in the range
+    size_t total;                 // Scenarios in the batch
+    double dt;
+    double sim_time;
+    long stepsRun;                // Steps computed by all runs of the range
+    AdaptiveIntegrator integrator;  // Adaptive-step statistics summed over the range
+    ScenarioBatchStats stats;     // KPIs of the range (merged into the batch after the pool drains)
+    int collectTraces;            // List the traces written (--worker uploads them)
+    DistTraceList traces;
+} ScenarioChunk;
+
+// Range of a scenario table filled by one JobPool job (--write-scenarios)
+typedef struct {
+    ScenarioTable *table;
+    size_t first;
+    size_t count;
+    ControllerParams params;
+    ScenarioModel model;
+} ScenarioFillChunk;
+
+#define SCENARIO_NAME_SIZE 96
+#define SCENARIO_CHUNKS_PER_WORKER 8   // Chunks per worker, so work stealing can balance the batch
+
+// Run a single simulation (called by runScenarioChunk on a JobPool worker)
+static void runSimulation(ThreadData *data) {
     SimulationConfig *sim = data->config;
     double dt = data->dt;
-    int n = data->n;
-    
-    printf("[Thread %s] Starting simulation (Kp=%.2f, Ki=%.2f, Kd=%.2f)...\n", 
-           sim->name,
-           sim->params.Kp,
-           sim->params.Ki,
-           sim->params.Kd);
+    beginProfileRun();
     
-    // Initialize data collection (no real-time plotting)
+    // Initialize data collection (no real-time plotting); untraced runs only produce KPIs
     void *realtimePlot = NULL;
-    ErrorCode plotErr = initRealtimePlot(sim->name, data->windowIndex, &realtimePlot);
-    if (plotErr == ERROR_SUCCESS && realtimePlot != NULL) {
-        printf("[Thread %s] Data collection initialized\n", sim->name);
-    } else if (plotErr != ERROR_SUCCESS) {
-        printf("[Thread %s] Warning: Data collection failed with error code %d\n", sim->name, plotErr);
-    }
-    
-    // Controller state (reset for each simulation)
-    ControllerState controllerState = {
-        .integral = 0.0,
-        .previousError = 0.0,
-        .adaptiveKp = 0.0,
-        .historyIndex = 0,
-        .cumulativeError = 0.0
-    };
+    if (data->traced) {
+        printf("[Thread %s] Starting simulation (Kp=%.2f, Ki=%.2f, Kd=%.2f)...\n", 
+               sim->name,
+               sim->params.Kp,
+               sim->params.Ki,
+               sim->params.Kd);
+        
+        ErrorCode plotErr = initRealtimePlot(sim->name, data->windowIndex, &realtimePlot);
+        if (plotErr == ERROR_SUCCESS && realtimePlot != NULL) {
+            printf("[Thread %s] Data collection initialized\n", sim->name);
+        } else if (plotErr != ERROR_SUCCESS) {
+            printf("[Thread %s] Warning: Data collection failed with error code %d\n", sim->name, plotErr);
+        }
+    }
     
     // Initialize falling object with controller configuration
     // ===== NEW PHYSICS MODEL: Train catching falling ball =====
-    // Ball falls at fixed X position: ball_x_position from ThreadData
+    // Ball falls at fixed X position: ball_x_position from the scenario
     // Train moves horizontally from train_x_initial to reach ball_x_position
     // Landing surface has inclination angle
+    ControllerState controllerState;
+    FallingObject object;
+    ErrorCode initErr = initScenarioObject(&object, &data->scenario, &sim->params, &controllerState,
+                                           data->modelCallback, dt);
+    if (initErr != ERROR_SUCCESS) {
+        printf("[Thread %s] Error: Invalid scenario or train model: Error code %d\n", sim->name, initErr);
+        if (realtimePlot) closeRealtimePlot(realtimePlot, sim->name);
+        data->failed = 1;
+        endProfileRun(sim->name);
+        return;
+    }
+    initAdaptiveIntegrator(&object.integrator, adaptive_tolerance, adaptive_tolerance);
     
-    double ball_landing_x = data->ball_x_position;  // Ball X position from parameter sweep
-    double train_start_x = data->train_x_initial;   // Train initial X from parameter sweep
-    double max_position = 100.0;   // Maximum X position (m) for normalization
-    double falling_object_initial_height = data->ball_y_initial;  // Ball starts at random Y height
-    double landing_surface_angle = data->landing_angle * M_PI / 180.0;  // Convert degrees to radians
-    
-    // Train horizontal position (X coordinate)
-    double initial_train_x_pct = (train_start_x / max_position) * 100.0;  // Train position as percentage
-    double initial_train_x = train_start_x;  // Initial X position from parameter
-    double initial_train_velocity = 0.0;  // Train starts from rest
-    
-    FallingObject object = {
-        .position_pct = initial_train_x_pct, // Output: TRAIN horizontal position (percentage)
-        .velocity = initial_train_velocity,  // Internal state: TRAIN horizontal velocity (0 m/s)
-        .position = initial_train_x,         // Internal tracking: TRAIN horizontal X position
-        .setpoint = (ball_landing_x / max_position) * 100.0, // Target: Ball landing X position (percentage)
-        .applied_force = 0.0,        // Will be controlled
-        .previousNetForce = 0.0,     // Initialize for trapezoidal integration
-        .controller = {
-            .params = &sim->params,
-            .state = &controllerState,
-            .getSetpoint = getObjectSetpoint,
-            .getOutput = getObjectOutput,
-            .dt = dt
-        },
-        .model = {
-            .mass = 100.0,          // 100 kg train (realistic mass)
-            .gravity = 9.81,        // Earth gravity (m/s²)
-            .incline_angle = landing_surface_angle, // Landing surface inclination (0° = flat)
-            .drag_coeff = 0.5,      // Friction/air resistance (increased)
-            .max_force = 3000.0,    // Maximum control force (3000 N, a_max = 30 m/s²)
-            .max_position = max_position, // 100 m maximum X position
-            .callback = data->modelCallback,  // System model callback (Euler/Trapezoidal/Simplified)
-            .netForceCallback = (data->modelCallback == objectModelTrapezoidalSimplified) ? 
-                               calculateObjectNetForceSimplified : calculateObjectNetForce
+    // MPC runs: condensed QP of this train's linearized model
+    MpcController mpc;
+    if (sim->controller == mpcController) {
+        MpcModel linear;
+        MpcConfig mpcConfig = train_mpc_config;
+        mpcConfig.inputMin = -object.model.max_force;
+        mpcConfig.inputMax = object.model.max_force;
+        if (linearizeObjectModel(&object.model, dt, &linear) != ERROR_SUCCESS ||
+            initMpcController(&mpc, &linear, &mpcConfig, dt) != ERROR_SUCCESS) {
+            printf("[Thread %s] Error: Invalid MPC configuration (horizon 1-%d, limits)\n", sim->name,
+                   MPC_MAX_HORIZON);
+            if (realtimePlot) closeRealtimePlot(realtimePlot, sim->name);
+            data->failed = 1;
+            endProfileRun(sim->name);
+            return;
         }
-    };
+        object.controller.mpc = &mpc;
+    }
+    double falling_object_initial_height = data->scenario.ball_y_initial;  // Ball starts at random Y height
+    double g = object.model.gravity;  // 9.81 m/s²
+    
+    // Pick the specialized (inlined) stepper for this controller/model pair when one exists
+    ObjectStepper fastStep = NULL;
+    if (!use_generic_pipeline && selectObjectStepper(&object, sim->controller, &fastStep) != ERROR_SUCCESS) {
+        fastStep = NULL;
+    }
+    
+    // Stop criteria: saturation is measured against this train's force limit
+    StopCriteria criteria = stop_criteria;
+    criteria.saturationLimit = object.model.max_force;
+    StopMonitor stopMonitor;
+    resetStopMonitor(&stopMonitor);
+    
+    // Landing event, scheduled in closed form: t = sqrt(2 * y0 / g) falls into landing_step
+    // (the catch is decided inside that step; INT_MAX: the run has no step limit of its own)
+    double landing_time = getScenarioLandingTime(&data->scenario, g);
+    int landing_step = getScenarioLandingStep(landing_time, dt, INT_MAX);
+    int landed = 0;
+    int truncated = 0;  // Stopped early by saturation/divergence instead of settling
+    
+    ScenarioKpiTracker kpiTracker;
+    initScenarioKpiTracker(&kpiTracker, object.setpoint - object.position_pct, landing_time);
+    double last_error = object.setpoint - object.position_pct;
     
     // Run simulation
     int i = 0;
+    data->stepsRun = 0;
     double max_time = data->sim_time;  // Use sim_time from thread data
     while (keep_running && (i * dt < max_time)) {
         double current_time = i * dt;
         
-        // Calculate falling ball's Y position using free-fall physics: y(t) = y₀ - ½gt²
-        // Ball falls vertically at fixed X position (ball_landing_x)
-        double g = object.model.gravity;  // 9.81 m/s²
-        double ball_height_y = falling_object_initial_height - 0.5 * g * current_time * current_time;
-        
-        // Keep ball above ground (0m minimum)
-        if (ball_height_y < 0.0) {
-            ball_height_y = 0.0;  // Ball hits ground
-        }
-        
         // Setpoint remains constant: Train must reach ball_landing_x position
         // object.setpoint is already set to ball_landing_x (60m = 60%)
         // Train's control objective: move horizontally to match this X position
         
         // Update object using specified controller
         double current_position_pct;
-        ErrorCode err = updateSystem(&object, dt, &current_position_pct, 
-                                    sim->controller, NULL);
+        ErrorCode err;
+        PROFILE_SECTION(PROFILE_STEP, err = fastStep ? fastStep(&object, dt, 1, &current_position_pct)
+                                          : updateSystem(&object, &object.controller, object.model.callback, dt,
+                                                         &current_position_pct, sim->controller, NULL));
+        PROFILE_COUNT(PROFILE_STEP_ERRORS, err != ERROR_SUCCESS);
+        PROFILE_COUNT(PROFILE_SATURATIONS, fabs(object.applied_force) >= object.model.max_force);
         if (err != ERROR_SUCCESS) {
             printf("[Thread %s] Error during system update at t=%.2f: Error code %d\n", 
                    sim->name, current_time, err);
@@ -172,11 +255,13 @@ void* runSimulation(void *arg) {
             // Store: time, train_x_position, ball_y_height, applied_force,
             //        velocity, acceleration, error_derivative, error_integral
             // For CSV: train position is current_position_pct, ball height is ball_height_y
+            // Ball falls vertically at fixed X position (ball_landing_x): y(t) = y₀ - ½gt², 0 once landed
+            double ball_height_y = getScenarioBallHeight(&data->scenario, g, current_time, landing_time);
             double ball_height_pct = (ball_height_y / falling_object_initial_height) * 100.0;
             
             // Calculate acceleration: a = F_net / m
             // Get net force from object's previous net force (stored after physics update)
-            double train_acceleration = object.previousNetForce / object.model.mass;
+            double train_acceleration = object.previousNetForce * object.model.prepared.inverse_mass;
             
             // Calculate error and error derivative for logging
             double error = object.setpoint - current_position_pct;
@@ -194,23 +279,601 @@ void* runSimulation(void *arg) {
         }
         
         i++;
+        data->stepsRun++;
+        
+        last_error = object.setpoint - current_position_pct;
+        updateScenarioKpiTracker(&kpiTracker, current_time, last_error, object.applied_force, dt);
+        
+        // Landing event (step i - 1, just counted): catch error at exactly landing_time
+        if (i - 1 == landing_step) {
+            double catch_error = markScenarioLanding(&kpiTracker, current_time, dt);
+            landed = 1;
+            if (data->traced) {
+                printf("[Thread %s] Ball landed at t=%.3f s: %s (error %.3f%%)\n", sim->name, landing_time,
+                       fabs(catch_error) <= SCENARIO_CATCH_TOLERANCE ? "caught" : "missed", catch_error);
+            }
+        }
+        
+        if (early_stop) {
+            double error = last_error;
+            StopReason reason = updateStopMonitor(&stopMonitor, &criteria, error, current_position_pct,
+                                                  object.applied_force, dt);
+            if (reason == STOP_SETTLED && !landed) {
+                reason = STOP_NONE;  // Settled before the landing: the catch is not decided yet
+            }
+            if (reason != STOP_NONE) {
+                truncated = reason != STOP_SETTLED;
+                if (data->traced) {
+                    printf("[Thread %s] Stopping early at t=%.2f (%s, %s)\n", sim->name, current_time,
+                           reason == STOP_SETTLED ? "ball landed, settled" : getStopReasonName(reason),
+                           fabs(error) <= SCENARIO_CATCH_TOLERANCE ? "under the ball" : "off target");
+                }
+                break;
+            }
+        }
+    }
+    
+    finishScenarioKpiTracker(&kpiTracker, last_error, &data->kpis);
+    data->kpis.truncated = truncated;
+    data->integrator = object.integrator;
+    if (data->traced && object.model.callback == objectModelAdaptive) {
+        printf("[Thread %s] Adaptive steps: %lu accepted, %lu rejected, %lu evaluations in %d ticks\n",
+               sim->name, object.integrator.accepted, object.integrator.rejected,
+               object.integrator.evaluations, data->stepsRun);
+    }
+    if (data->traced && object.controller.mpc != NULL) {
+        printf("[Thread %s] MPC: %lu solves, %.2f ADMM iterations per tick, %lu at the iteration cap\n",
+               sim->name, mpc.solves, mpc.solves > 0 ? (double)mpc.iterations / (double)mpc.solves : 0.0,
+               mpc.capped);
     }
     
     // Save plot at the end
     if (realtimePlot) {
         printf("[Thread %s] Saving plot to PNG...\n", sim->name);
-        closeRealtimePlot(realtimePlot, sim->name);
+        PROFILE_SECTION(PROFILE_TRACE_CLOSE, closeRealtimePlot(realtimePlot, sim->name));
         printf("[Thread %s] Completed!\n", sim->name);
     }
+    endProfileRun(sim->name);
+}
+
+// Parameters are encoded in the trace name (scenario number, angle, ball X/Y, train start)
+static void formatScenarioName(size_t k, const FallScenario *scenario, char *name, size_t size) {
+    snprintf(name, size, "Random_S%02lu_A%02.0f_BallX%03.0fY%03.0f_TrainX%03.0f",
+             (unsigned long)(k + 1), scenario->landing_angle, scenario->ball_x_position,
+             scenario->ball_y_initial, scenario->train_x_initial);
+}
+
+// Job function: run every scenario of a ScenarioChunk in order (executed on a JobPool worker)
+static void runScenarioChunk(void *arg) {
+    ScenarioChunk *chunk = (ScenarioChunk*)arg;
     
-#ifdef _WIN32
+    for (size_t k = chunk->first; k < chunk->first + chunk->count && keep_running; k++) {
+        ScenarioRecord record;
+        if (chunk->records != NULL) {
+            record = chunk->records[k - chunk->first];
+        } else {
+            FallScenario generated;
+            generateScenario(chunk->seed, (uint64_t)k, &generated);
+            makeScenarioRecord(&generated, &chunk->params, chunk->model, &record);
+        }
+        
+        FallScenario fallScenario;
+        SimulationConfig simulation;
+        memset(&simulation, 0, sizeof(simulation));
+        getScenarioFromRecord(&record, &fallScenario, &simulation.params);
+        simulation.controller = scenario_controller;
+        
+        char name[SCENARIO_NAME_SIZE];
+        formatScenarioName(k, &fallScenario, name, sizeof(name));
+        simulation.name = name;
+        
+        ThreadData data;
+        memset(&data, 0, sizeof(data));
+        data.config = &simulation;
+        data.dt = chunk->dt;
+        data.n = (int)(chunk->sim_time / chunk->dt);
+        data.sim_time = chunk->sim_time;
+        data.windowIndex = (int)k;
+        data.modelCallback = getScenarioModelCallback(record.model);
+        data.scenario = fallScenario;
+        if (data.modelCallback == NULL) {
+            printf("  Skipped: unknown model %u in scenario %lu\n", record.model, (unsigned long)(k + 1));
+            continue;
+        }
+        
+        // Missed catches are flagged: with TRACE_RUNS_FLAGGED they run again, this time traced
+        data.traced = trace_policy == TRACE_RUNS_ALL || (trace_sample > 0 && k % trace_sample == 0);
+        for (int pass = 0; pass < 2; pass++) {
+            if (data.traced) {
+                printf("\n[Scenario %lu/%lu]\n  Angle: %.1f°\n  Ball: (%.1fm, %.1fm)\n  Train start: %.1fm\n",
+                       (unsigned long)(k + 1), (unsigned long)chunk->total, fallScenario.landing_angle,
+                       fallScenario.ball_x_position, fallScenario.ball_y_initial, fallScenario.train_x_initial);
+            }
+            runSimulation(&data);
+            chunk->stepsRun += data.stepsRun;
+            chunk->integrator.accepted += data.integrator.accepted;
+            chunk->integrator.rejected += data.integrator.rejected;
+            chunk->integrator.evaluations += data.integrator.evaluations;
+            if (data.failed || data.traced || data.kpis.caught || trace_policy != TRACE_RUNS_FLAGGED) break;
+            data.traced = 1;
+        }
+        if (data.failed) {
+            printf("  Skipped: scenario %lu could not be run\n", (unsigned long)(k + 1));
+            continue;
+        }
+        addScenarioBatchStats(&chunk->stats, k + 1, &data.kpis, data.traced);
+        if (data.traced && chunk->collectTraces) {
+            char fileName[DIST_TRACE_NAME_SIZE];
+            if (getPlotTraceFileName(name, fileName, sizeof(fileName)) == ERROR_SUCCESS) {
+                addDistTrace(&chunk->traces, fileName);
+            }
+        }
+    }
+}
+
+// Job function: generate the records of a ScenarioFillChunk into the mapped table
+static void fillScenarioChunk(void *arg) {
+    ScenarioFillChunk *chunk = (ScenarioFillChunk*)arg;
+    fillScenarioTable(chunk->table, chunk->first, chunk->count, &chunk->params, chunk->model);
+}
+
+// Scenarios per job for a batch: a few chunks per worker, at least one scenario each
+static size_t getScenarioChunkSize(size_t total, int workers) {
+    size_t chunks = (size_t)(workers > 0 ? workers : 1) * SCENARIO_CHUNKS_PER_WORKER;
+    size_t size = (total + chunks - 1) / chunks;
+    return size > 0 ? size : 1;
+}
+
+// Print command line usage
+static void printUsage(const char *program) {
+    printf("Usage: %s [--scenarios N] [--seed S] [--scenario-file PATH] [--write-scenarios PATH] [--model M]\n", program);
+    printf("       [--threads N] [--pin-threads] [--trace-format csv|f64|f32|packed [--animation-fps F]] [--traces all|flagged|none] [--trace-sample N] [--generic]\n");
+    printf("       [--early-stop [--settle-tol PCT] [--settle-time S] [--saturation-time S] [--divergence-limit PCT]]\n");
+    printf("       [--adaptive-tol TOL] [--controller pid|mpc [--mpc-horizon N]]\n");
+    printf("       [--coordinator PORT [--chunk-size N] [--chunk-timeout S] [--max-attempts N]]\n");
+    printf("       [--worker HOST:PORT [--connect-timeout S]]\n");
+    printf("  --scenarios N  Number of random scenarios to generate (default 10)\n");
+    printf("  --seed S       Seed of the scenario batch (default: current time); same seed, same scenarios\n");
+    printf("  --scenario-file PATH  Run the scenarios (gains, model) of a binary scenario table\n");
+    printf("  --write-scenarios PATH  Write the generated batch to a scenario table and exit\n");
+    printf("  --model M      Model of generated scenarios: euler (default), trapezoidal, simplified or adaptive\n");
+    printf("  --adaptive-tol TOL  Relative and absolute error tolerance of the adaptive model (default: 1e-6)\n");
+    printf("  --controller C Controller of every scenario: pid (default, gains of the batch) or mpc\n");
+    printf("  --mpc-horizon N  Prediction horizon of the MPC controller in steps (default: 15, at most %d)\n",
+           MPC_MAX_HORIZON);
+    printf("  --threads N    Worker threads (default: all hardware threads)\n");
+    printf("  --pin-threads  Pin every worker to one CPU, spreading the workers over the NUMA nodes\n");
+    printf("  --trace-format Trace file format: binary float64 .trc (f64, default), float32 .trc (f32), csv\n");
+    printf("                 or compressed float32 .trz (packed)\n");
+    printf("  --animation-fps F  Frames per second of the animation stream of packed traces (default: %.0f, 0: none)\n",
+           PLOT_ANIMATION_FPS);
+    printf("  --traces P     Runs with a full trace: all (default), flagged (missed catches) or none;\n");
+    printf("                 KPIs of every run go to %s\n", BATCH_SUMMARY_PATH);
+    printf("  --trace-sample N  Also trace every N-th scenario\n");
+    printf("  --generic      Use the generic callback pipeline instead of the specialized steppers\n");
+    printf("  --early-stop   End a run once the ball landed and the train settled, or the force saturates\n");
+    printf("  --settle-tol PCT      Settled band around the ball X position in %% (default: 0.25)\n");
+    printf("  --settle-time S       Time the train must stay settled in s (default: 1)\n");
+    printf("  --saturation-time S   Stop after S seconds at max_force (default: 5)\n");
+    printf("  --divergence-limit PCT  Stop once |error| exceeds PCT %% (default: off)\n");
+    printf("  --coordinator PORT  Serve the batch to --worker processes on this TCP port; they send back\n");
+    printf("                 KPIs and the traces of their --traces policy, merged into %s\n", BATCH_SUMMARY_PATH);
+    printf("  --chunk-size N Scenarios per chunk (default: shrinking chunks sized by worker threads)\n");
+    printf("  --chunk-timeout S  Drop a busy worker silent for S seconds, longer than a chunk takes (default: %d)\n",
+           DIST_DEFAULT_CHUNK_TIMEOUT);
+    printf("  --max-attempts N   Give a chunk up after N failed workers (default: %d)\n", DIST_DEFAULT_MAX_ATTEMPTS);
+    printf("  --worker HOST:PORT  Run chunks for a coordinator on --threads threads (options come from it)\n");
+    printf("  --connect-timeout S  Keep trying to reach the coordinator for S seconds (default: 60)\n");
+}
+
+// Generate a batch in parallel into a new scenario table (--write-scenarios)
+static int writeScenarioBatch(const char *path, size_t count, uint64_t seed, const ControllerParams *params,
+                              ScenarioModel model, int num_threads) {
+    ScenarioTable table;
+    if (createScenarioTable(path, count, seed, &table) != ERROR_SUCCESS) {
+        printf("Could not create scenario table %s\n", path);
+        return 1;
+    }
+    
+    JobPool *pool = NULL;
+    if (createPlacedJobPool(num_threads, worker_placement, &pool) != ERROR_SUCCESS) {
+        printf("Failed to create worker pool\n");
+        closeScenarioTable(&table);
+        return 1;
+    }
+    
+    // Every job fills its own record range of the shared mapping
+    size_t chunkSize = getScenarioChunkSize(count, getJobPoolWorkerCount(pool));
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    ScenarioFillChunk *chunks = (ScenarioFillChunk*)calloc(chunkCount > 0 ? chunkCount : 1, sizeof(ScenarioFillChunk));
+    if (chunks == NULL) {
+        printf("Failed to allocate %lu chunks\n", (unsigned long)chunkCount);
+        destroyJobPool(pool);
+        closeScenarioTable(&table);
+        return 1;
+    }
+    for (size_t c = 0; c < chunkCount; c++) {
+        chunks[c].table = &table;
+        chunks[c].first = c * chunkSize;
+        chunks[c].count = (c + 1 == chunkCount) ? count - chunks[c].first : chunkSize;
+        chunks[c].params = *params;
+        chunks[c].model = model;
+        if (submitJob(pool, fillScenarioChunk, &chunks[c]) != ERROR_SUCCESS) {
+            fillScenarioChunk(&chunks[c]);  // Fill inline rather than leave a hole
+        }
+    }
+    waitJobPool(pool);
+    destroyJobPool(pool);
+    free(chunks);
+    closeScenarioTable(&table);
+    
+    printf("Wrote %lu scenarios (seed %llu) to %s\n", (unsigned long)count, (unsigned long long)seed, path);
     return 0;
-#else
-    return NULL;
-#endif
 }
 
-int main(void) {
+// ===== Distributed sweeps (--coordinator / --worker) =====
+
+// Everything a worker needs to run the coordinator's batch as a local run would
+typedef struct {
+    uint64_t seed;                // Batch seed of generated scenarios
+    uint64_t total;               // Scenarios in the batch
+    ControllerParams params;      // Gains of generated scenarios
+    uint32_t model;               // ScenarioModel of generated scenarios
+    uint32_t mpc;                 // --controller mpc
+    double dt;
+    double sim_time;
+    uint32_t tracePolicy;
+    uint32_t traceFormat;
+    double animationRate;         // --animation-fps
+    uint64_t traceSample;
+    uint32_t earlyStop;
+    uint32_t generic;
+    StopCriteria stopCriteria;
+    MpcConfig mpcConfig;
+    double adaptiveTolerance;
+} DistRunSettings;
+
+// Worker side: the coordinator's settings and the local pool every chunk is split over
+typedef struct {
+    DistRunSettings settings;
+    JobPool *pool;
+} DistWorkerContext;
+
+static void getDistRunSettings(uint64_t seed, size_t total, const ControllerParams *params, ScenarioModel model,
+                               double dt, double sim_time, DistRunSettings *settings) {
+    memset(settings, 0, sizeof(*settings));
+    settings->seed = seed;
+    settings->total = total;
+    settings->params = *params;
+    settings->model = (uint32_t)model;
+    settings->mpc = scenario_controller == mpcController;
+    settings->dt = dt;
+    settings->sim_time = sim_time;
+    settings->tracePolicy = (uint32_t)trace_policy;
+    settings->traceFormat = (uint32_t)trace_format;
+    settings->animationRate = animation_rate;
+    settings->traceSample = trace_sample;
+    settings->earlyStop = (uint32_t)early_stop;
+    settings->generic = (uint32_t)use_generic_pipeline;
+    settings->stopCriteria = stop_criteria;
+    settings->mpcConfig = train_mpc_config;
+    settings->adaptiveTolerance = adaptive_tolerance;
+}
+
+// DistSettingsHandler: take over the coordinator's run options
+static ErrorCode applyDistRunSettings(void *context, const void *blob, size_t size) {
+    DistWorkerContext *worker = (DistWorkerContext*)context;
+    if (size != sizeof(DistRunSettings)) return ERROR_INVALID_PARAMETER;
+    DistRunSettings settings;
+    memcpy(&settings, blob, sizeof(settings));
+    if (settings.total == 0 || !(settings.dt > 0.0) || settings.tracePolicy > TRACE_RUNS_NONE ||
+        settings.traceFormat > TRACE_FORMAT_PACKED ||
+        !(settings.animationRate >= 0.0) || getScenarioModelCallback(settings.model) == NULL) {
+        return ERROR_INVALID_PARAMETER;
+    }
+    worker->settings = settings;
+    scenario_controller = settings.mpc ? mpcController : pidController;
+    trace_policy = (TraceRunPolicy)settings.tracePolicy;
+    trace_format = (TraceFormat)settings.traceFormat;
+    setPlotTraceFormat(trace_format);
+    animation_rate = settings.animationRate;
+    setPlotAnimationRate(animation_rate);
+    trace_sample = (size_t)settings.traceSample;
+    early_stop = (int)settings.earlyStop;
+    use_generic_pipeline = (int)settings.generic;
+    stop_criteria = settings.stopCriteria;
+    train_mpc_config = settings.mpcConfig;
+    adaptive_tolerance = settings.adaptiveTolerance;
+    printf("Batch of %llu scenarios (seed %llu), dt %.3f s, %.1f s per run\n",
+           (unsigned long long)settings.total, (unsigned long long)settings.seed, settings.dt, settings.sim_time);
+    return ERROR_SUCCESS;
+}
+
+// DistChunkRunner: split the chunk over the local pool like a local batch, merge in order
+static ErrorCode runDistScenarioChunk(void *context, const DistChunk *dist, DistChunkResult *result,
+                                      DistTraceList *traces) {
+    DistWorkerContext *worker = (DistWorkerContext*)context;
+    const DistRunSettings *settings = &worker->settings;
+    size_t chunkSize = getScenarioChunkSize(dist->count, getJobPoolWorkerCount(worker->pool));
+    size_t chunkCount = (dist->count + chunkSize - 1) / chunkSize;
+    ScenarioChunk *chunks = (ScenarioChunk*)calloc(chunkCount, sizeof(ScenarioChunk));
+    if (chunks == NULL) return ERROR_NULL_POINTER;
+
+    // Wait for the jobs of this chunk only (the pool serves every chunk of the worker)
+    JobGroup group;
+    initJobGroup(&group);
+    for (size_t c = 0; c < chunkCount; c++) {
+        ScenarioChunk *chunk = &chunks[c];
+        chunk->records = (dist->records != NULL) ? dist->records + c * chunkSize : NULL;
+        chunk->seed = settings->seed;
+        chunk->params = settings->params;
+        chunk->model = (ScenarioModel)settings->model;
+        chunk->first = dist->first + c * chunkSize;
+        chunk->count = (c + 1 == chunkCount) ? dist->count - c * chunkSize : chunkSize;
+        chunk->total = (size_t)settings->total;
+        chunk->dt = settings->dt;
+        chunk->sim_time = settings->sim_time;
+        chunk->collectTraces = 1;
+        initScenarioBatchStats(&chunk->stats);
+        if (submitGroupJob(worker->pool, &group, runScenarioChunk, chunk) != ERROR_SUCCESS) {
+            runScenarioChunk(chunk);  // Run inline rather than report a partial chunk
+        }
+    }
+    waitJobGroup(&group);
+    destroyJobGroup(&group);
+
+    ErrorCode err = ERROR_SUCCESS;
+    for (size_t c = 0; c < chunkCount; c++) {
+        mergeScenarioBatchStats(&result->stats, &chunks[c].stats);
+        result->stepsRun += chunks[c].stepsRun;
+        result->accepted += chunks[c].integrator.accepted;
+        result->rejected += chunks[c].integrator.rejected;
+        result->evaluations += chunks[c].integrator.evaluations;
+        for (size_t t = 0; t < chunks[c].traces.count && err == ERROR_SUCCESS; t++) {
+            err = addDistTrace(traces, chunks[c].traces.names[t]);
+        }
+        freeDistTraceList(&chunks[c].traces);
+    }
+    free(chunks);
+    return err;
+}
+
+// Serve a coordinator (--worker HOST:PORT) until its batch is finished
+static int runScenarioWorker(const char *address, int num_threads, int connect_timeout) {
+    char host[256];
+    int port = 0;
+    if (parseDistAddress(address, host, sizeof(host), &port) != ERROR_SUCCESS) {
+        printf("Invalid coordinator address %s (expected HOST:PORT)\n", address);
+        return 1;
+    }
+    
+    DistWorkerContext context;
+    memset(&context, 0, sizeof(context));
+    if (createPlacedJobPool(num_threads, worker_placement, &context.pool) != ERROR_SUCCESS) {
+        printf("Failed to create worker pool\n");
+        return 1;
+    }
+    initPlot();
+    printf("Worker with %d threads for coordinator %s:%d\n", getJobPoolWorkerCount(context.pool), host, port);
+    if (worker_placement == JOB_POOL_PINNED) {
+        printf("Pinned %d of %d workers over %d NUMA node(s)\n", getJobPoolPinnedCount(context.pool),
+               getJobPoolWorkerCount(context.pool), getNumaNodeCount());
+    }
+    
+    DistWorkerConfig config;
+    memset(&config, 0, sizeof(config));
+    config.host = host;
+    config.port = port;
+    config.threads = getJobPoolWorkerCount(context.pool);
+    config.connectTimeout = connect_timeout;
+    config.settingsSize = sizeof(DistRunSettings);
+    config.applySettings = applyDistRunSettings;
+    config.runChunk = runDistScenarioChunk;
+    config.context = &context;
+    config.traceDirectory = PLOT_TRACE_DIRECTORY;
+    config.keepRunning = &keep_running;
+    
+    size_t chunksRun = 0;
+    ErrorCode err = runDistWorker(&config, &chunksRun);
+    destroyJobPool(context.pool);
+    closePlot();
+    printf("Worker finished: %lu chunks run%s\n", (unsigned long)chunksRun,
+           err == ERROR_SUCCESS ? "" : " (left the batch early)");
+    return err == ERROR_SUCCESS ? 0 : 1;
+}
+
+// Summary file and console report of a finished batch (local or distributed)
+static void reportScenarioBatch(const ScenarioBatchStats *batch, size_t total_scenarios, uint64_t seed,
+                                const char *source, long steps_run, const AdaptiveIntegrator *adaptive,
+                                double dt, double t_end) {
+    if (batch != NULL && writeScenarioBatchSummary(BATCH_SUMMARY_PATH, batch, (unsigned long long)seed,
+                                                   source, early_stop) != ERROR_SUCCESS) {
+        printf("Warning: Could not write %s\n", BATCH_SUMMARY_PATH);
+    }
+    
+    long steps_full = 0;
+    if (early_stop) {
+        int steps_per_run = 0;
+        while (steps_per_run * dt < t_end) steps_per_run++;  // Same step count as the run loop
+        steps_full = (long)steps_per_run * (long)total_scenarios;
+    }
+    
+    printf("\n\n=================================================================\n");
+    printf("All random scenarios completed!\n\n");
+    printf("Total trace files generated: %lu\n", (unsigned long)(batch != NULL ? batch->traced : total_scenarios));
+    printf("  - Random angles: 0-45°\n");
+    printf("  - Random ball positions: 20-100m (X), 30-100m (Y)\n");
+    printf("  - Random train initial X: 0 to (ball_x - 20m)\n");
+    if (early_stop) {
+        printf("Stop criteria: computed %ld of %ld steps (%.1f%% skipped)\n", steps_run, steps_full,
+               steps_full > 0 ? 100.0 * (double)(steps_full - steps_run) / (double)steps_full : 0.0);
+    }
+    if (adaptive->accepted > 0) {
+        printf("Adaptive model: %lu steps accepted, %lu rejected, %lu evaluations\n", adaptive->accepted,
+               adaptive->rejected, adaptive->evaluations);
+    }
+    if (batch != NULL) {
+        printf("\n");
+        printScenarioBatchSummary(stdout, batch);
+        printf("Batch summary: %s\n", BATCH_SUMMARY_PATH);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int num_scenarios = 10;
+    int num_threads = 0;  // 0 = one worker per hardware thread
+    uint64_t seed = (uint64_t)time(NULL);  // Overridden by --seed for reproducible batches
+    const char *scenario_file = NULL;
+    const char *write_scenarios = NULL;
+    ScenarioModel model = SCENARIO_MODEL_EULER;
+    int coordinator_port = 0;                 // --coordinator: serve the batch to workers
+    const char *worker_address = NULL;        // --worker: run chunks for a coordinator
+    DistCoordinatorConfig coordinator;
+    memset(&coordinator, 0, sizeof(coordinator));
+    int connect_timeout = 60;
+    
+    // Parse command line options
+    for (int a = 1; a < argc; a++) {
+        if ((strcmp(argv[a], "--scenarios") == 0 || strcmp(argv[a], "-n") == 0) && a + 1 < argc) {
+            num_scenarios = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) {
+            seed = (uint64_t)strtoull(argv[++a], NULL, 10);
+        } else if (strcmp(argv[a], "--scenario-file") == 0 && a + 1 < argc) {
+            scenario_file = argv[++a];
+        } else if (strcmp(argv[a], "--write-scenarios") == 0 && a + 1 < argc) {
+            write_scenarios = argv[++a];
+        } else if (strcmp(argv[a], "--model") == 0 && a + 1 < argc) {
+            if (parseScenarioModel(argv[++a], &model) != ERROR_SUCCESS) {
+                printf("Unknown model: %s\n", argv[a]);
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--adaptive-tol") == 0 && a + 1 < argc) {
+            adaptive_tolerance = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--controller") == 0 && a + 1 < argc) {
+            const char *name = argv[++a];
+            if (strcmp(name, "pid") == 0) {
+                scenario_controller = pidController;
+            } else if (strcmp(name, "mpc") == 0) {
+                scenario_controller = mpcController;
+            } else {
+                printf("Unknown controller: %s\n", name);
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--mpc-horizon") == 0 && a + 1 < argc) {
+            train_mpc_config.horizon = atoi(argv[++a]);
+            if (train_mpc_config.horizon < 1 || train_mpc_config.horizon > MPC_MAX_HORIZON) {
+                printf("MPC horizon must be 1-%d: %s\n", MPC_MAX_HORIZON, argv[a]);
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if ((strcmp(argv[a], "--threads") == 0 || strcmp(argv[a], "-j") == 0) && a + 1 < argc) {
+            num_threads = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--pin-threads") == 0) {
+            worker_placement = JOB_POOL_PINNED;
+        } else if (strcmp(argv[a], "--trace-format") == 0 && a + 1 < argc) {
+            TraceFormat format;
+            if (parseTraceFormat(argv[++a], &format) != ERROR_SUCCESS) {
+                printf("Unknown trace format: %s\n", argv[a]);
+                printUsage(argv[0]);
+                return 1;
+            }
+            trace_format = format;
+            setPlotTraceFormat(format);
+        } else if (strcmp(argv[a], "--animation-fps") == 0 && a + 1 < argc) {
+            animation_rate = atof(argv[++a]);
+            if (!(animation_rate >= 0.0)) {
+                printf("Invalid animation frame rate: %s\n", argv[a]);
+                return 1;
+            }
+            setPlotAnimationRate(animation_rate);
+        } else if (strcmp(argv[a], "--generic") == 0) {
+            use_generic_pipeline = 1;
+        } else if (strcmp(argv[a], "--traces") == 0 && a + 1 < argc) {
+            const char *policy = argv[++a];
+            if (strcmp(policy, "all") == 0) {
+                trace_policy = TRACE_RUNS_ALL;
+            } else if (strcmp(policy, "flagged") == 0) {
+                trace_policy = TRACE_RUNS_FLAGGED;
+            } else if (strcmp(policy, "none") == 0) {
+                trace_policy = TRACE_RUNS_NONE;
+            } else {
+                printf("Unknown trace policy: %s\n", policy);
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--trace-sample") == 0 && a + 1 < argc) {
+            trace_sample = (size_t)strtoul(argv[++a], NULL, 10);
+        } else if (strcmp(argv[a], "--early-stop") == 0) {
+            early_stop = 1;
+        } else if (strcmp(argv[a], "--settle-tol") == 0 && a + 1 < argc) {
+            stop_criteria.settleTolerance = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--settle-time") == 0 && a + 1 < argc) {
+            stop_criteria.settleTime = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--saturation-time") == 0 && a + 1 < argc) {
+            stop_criteria.saturationTime = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--divergence-limit") == 0 && a + 1 < argc) {
+            stop_criteria.divergenceLimit = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--coordinator") == 0 && a + 1 < argc) {
+            coordinator_port = atoi(argv[++a]);
+            if (coordinator_port < 1 || coordinator_port > 65535) {
+                printf("Invalid coordinator port: %s\n", argv[a]);
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--chunk-size") == 0 && a + 1 < argc) {
+            coordinator.chunkSize = (size_t)strtoul(argv[++a], NULL, 10);
+        } else if (strcmp(argv[a], "--chunk-timeout") == 0 && a + 1 < argc) {
+            coordinator.chunkTimeout = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--max-attempts") == 0 && a + 1 < argc) {
+            coordinator.maxAttempts = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--worker") == 0 && a + 1 < argc) {
+            worker_address = argv[++a];
+        } else if (strcmp(argv[a], "--connect-timeout") == 0 && a + 1 < argc) {
+            connect_timeout = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--help") == 0 || strcmp(argv[a], "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            printf("Unknown option: %s\n", argv[a]);
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (num_scenarios <= 0) {
+        printf("Scenario count must be positive\n");
+        return 1;
+    }
+    
+    // Controller parameter definitions - TUNED for 100kg train with proper physics
+    // With m=100kg, F_max=3000N → a_max = 30 m/s²
+    // Higher Kp = faster response to position error (scaled for 100kg mass)
+    // Higher Ki = eliminate steady-state error faster
+    // Higher Kd = better damping at high speeds
+    ControllerParams PARAMS_PID = {500.0, 50.0, 200.0};  // Aggressive tuning scaled for 100kg train
+    
+    if (write_scenarios != NULL) {
+        return writeScenarioBatch(write_scenarios, (size_t)num_scenarios, seed, &PARAMS_PID, model, num_threads);
+    }
+    
+    // Workers take every run option from the coordinator
+    if (worker_address != NULL) {
+        signal(SIGINT, signal_handler);
+        return runScenarioWorker(worker_address, num_threads, connect_timeout);
+    }
+    
+    // Scenario table: mapped read-only and shared by every worker
+    ScenarioTable table;
+    size_t total_scenarios = (size_t)num_scenarios;
+    if (scenario_file != NULL) {
+        if (openScenarioTable(scenario_file, &table) != ERROR_SUCCESS) {
+            printf("Could not read scenario table %s\n", scenario_file);
+            return 1;
+        }
+        total_scenarios = table.recordCount;
+        seed = table.seed;
+    }
+    
     // Set up signal handler for graceful shutdown
 #ifdef _WIN32
     signal(SIGINT, signal_handler);
@@ -219,12 +882,18 @@ int main(void) {
     signal(SIGINT, signal_handler);
 #endif
     
-    // Initialize plotting system (creates CSV directory)
+    // Initialize plotting system (creates trace directory, starts the trace writer)
     initPlot();
     
     printf("Train Catching Falling Ball - Random Scenario Generation\n");
     printf("==============================================================================\n");
-    printf("Generating 10 random scenarios with varied parameters:\n");
+    if (scenario_file != NULL) {
+        printf("Running %lu scenarios from %s (generated with seed %llu)\n",
+               (unsigned long)total_scenarios, scenario_file, (unsigned long long)seed);
+    } else {
+        printf("Generating %d random scenarios (seed %llu, rerun with --seed) with varied parameters:\n",
+               num_scenarios, (unsigned long long)seed);
+    }
     printf("  - Angles: Random 0° to 45°\n");
     printf("  - Ball X positions: Random 20m to 100m\n");
     printf("  - Ball Y heights: Random 30m to 100m\n");
@@ -235,109 +904,128 @@ int main(void) {
     
     // Simulation parameters
     double dt = 0.02;             // Time step (s) - 50 Hz control rate
-    double sim_time = 0.0;        // Infinite simulation
     double t_end = 40.0;          // Simulation end time (s)
     
-    // Seed random number generator
-    srand((unsigned int)time(NULL));
+    const char *source = scenario_file != NULL ? scenario_file : "generated";
     
-    int num_scenarios = 10;
-    int total_simulations = 0;
-    
-// Controller parameter definitions - TUNED for 100kg train with proper physics
-// With m=100kg, F_max=3000N → a_max = 30 m/s²
-// Higher Kp = faster response to position error (scaled for 100kg mass)
-// Higher Ki = eliminate steady-state error faster
-// Higher Kd = better damping at high speeds
-ControllerParams PARAMS_PID = {500.0, 50.0, 200.0};  // Aggressive tuning scaled for 100kg train
-    
-    // Generate 10 random scenarios
-    for (int scenario = 1; scenario <= num_scenarios; scenario++) {
-        // Random angle: 0° to 45°
-        double current_angle = ((double)rand() / RAND_MAX) * 45.0;
-        
-        // Random ball X position: 20m to 100m
-        double ball_x = 20.0 + ((double)rand() / RAND_MAX) * 80.0;
-        
-        // Random ball initial Y height: 30m to 100m
-        double ball_y_initial = 30.0 + ((double)rand() / RAND_MAX) * 70.0;
-        
-        // Random train initial X: 0m to (ball_x - 20m) to ensure some distance
-        double max_train_x = (ball_x > 20.0) ? (ball_x - 20.0) : 0.0;
-        double train_x = ((double)rand() / RAND_MAX) * max_train_x;
-        
-        total_simulations++;
-        
-        printf("\n[Scenario %d/%d]\n", scenario, num_scenarios);
-        printf("  Angle: %.1f°\n", current_angle);
-        printf("  Ball: (%.1fm, %.1fm)\n", ball_x, ball_y_initial);
-        printf("  Train start: %.1fm\n", train_x);
-        printf("  Generating...");
-        fflush(stdout);
-        
-        // Create simulation configuration for PID controller
-        SimulationConfig simulation = {
-            .realtimePlot = NULL,
-            .simulationMutex = NULL,
-            .simulationThread = NULL,
-            .simulationComplete = NULL,
-            .name = NULL,
-            .controller = pidController,
-            .params = PARAMS_PID
-        };
-        
-        // Allocate memory for simulation name with all parameters including Y height
-        char *name_buffer = (char*)malloc(150 * sizeof(char));
-        if (name_buffer) {
-            sprintf(name_buffer, "Random_S%02d_A%02.0f_BallX%03.0fY%03.0f_TrainX%03.0f", 
-                   scenario, current_angle, ball_x, ball_y_initial, train_x);
-            simulation.name = name_buffer;
+    // Distributed batch: workers run the chunks, only their KPIs and selected traces come back
+    if (coordinator_port > 0) {
+        DistRunSettings settings;
+        getDistRunSettings(seed, total_scenarios, &PARAMS_PID, model, dt, t_end, &settings);
+        ScenarioBatchStats *batch = (ScenarioBatchStats*)malloc(sizeof(ScenarioBatchStats));
+        if (batch == NULL) {
+            printf("Failed to allocate the batch statistics\n");
+            if (scenario_file != NULL) closeScenarioTable(&table);
+            closePlot();
+            return 1;
         }
+        initScenarioBatchStats(batch);
         
-        // Run simulation with current parameters
-        ThreadData threadData = {
-            .config = &simulation,
-            .dt = dt,
-            .n = (int)(t_end / dt),
-            .sim_time = t_end,
-            .windowIndex = total_simulations - 1,
-            .modelCallback = objectModel,
-            .landing_angle = current_angle,
-            .ball_x_position = ball_x,
-            .train_x_initial = train_x,
-            .ball_y_initial = ball_y_initial
-        };
-        
-#ifdef _WIN32
-        HANDLE thread = (HANDLE)_beginthreadex(NULL, 0, runSimulation, &threadData, 0, NULL);
-        WaitForSingleObject(thread, INFINITE);
-        CloseHandle(thread);
-#else
-        pthread_t thread;
-        pthread_create(&thread, NULL, runSimulation, &threadData);
-        pthread_join(thread, NULL);
-#endif
-        
-        printf(" Done!\n");
+        coordinator.port = coordinator_port;
+        coordinator.total = total_scenarios;
+        coordinator.records = (scenario_file != NULL) ? table.records : NULL;
+        coordinator.settings = &settings;
+        coordinator.settingsSize = sizeof(settings);
+        coordinator.traceDirectory = PLOT_TRACE_DIRECTORY;
+        coordinator.keepRunning = &keep_running;
+        DistCoordinatorReport report;
+        memset(&report, 0, sizeof(report));
+        report.totals = batch;
+        ErrorCode err = runDistCoordinator(&coordinator, &report);
+        if (scenario_file != NULL) closeScenarioTable(&table);
         
-        // Free simulation name
-        if (simulation.name) {
-            free((void*)simulation.name);
+        printf("\nDistributed batch: %lu chunks on %lu workers, %lu retried, %lu traces received\n",
+               (unsigned long)report.chunks, (unsigned long)report.workers, (unsigned long)report.retries,
+               (unsigned long)report.traceFiles);
+        if (err != ERROR_SUCCESS) {
+            printf("Warning: %lu of %lu scenarios have no results (%lu given up)\n",
+                   (unsigned long)(total_scenarios - report.completed), (unsigned long)total_scenarios,
+                   (unsigned long)report.failed);
         }
+        AdaptiveIntegrator adaptive;
+        initAdaptiveIntegrator(&adaptive, 0.0, 0.0);
+        adaptive.accepted = (unsigned long)report.accepted;
+        adaptive.rejected = (unsigned long)report.rejected;
+        adaptive.evaluations = (unsigned long)report.evaluations;
+        reportScenarioBatch(batch, total_scenarios, seed, source, (long)report.stepsRun, &adaptive, dt, t_end);
+        free(batch);
+        closePlot();
+        return err == ERROR_SUCCESS ? 0 : 1;
     }
     
-    printf("\n\n=================================================================\n");
-    printf("All random scenarios completed!\n\n");
-    printf("Total CSV files generated: %d\n", total_simulations);
-    printf("  - Random angles: 0-45°\n");
-    printf("  - Random ball positions: 20-100m (X), 30-100m (Y)\n");
-    printf("  - Random train initial X: 0 to (ball_x - 20m)\n");
+    JobPool *pool = NULL;
+    if (createPlacedJobPool(num_threads, worker_placement, &pool) != ERROR_SUCCESS) {
+        printf("Failed to create worker pool\n");
+        if (scenario_file != NULL) closeScenarioTable(&table);
+        closePlot();
+        return 1;
+    }
+    printf("Running scenarios on %d worker threads\n", getJobPoolWorkerCount(pool));
+    if (worker_placement == JOB_POOL_PINNED) {
+        printf("Pinned %d of %d workers over %d NUMA node(s)\n", getJobPoolPinnedCount(pool),
+               getJobPoolWorkerCount(pool), getNumaNodeCount());
+    }
+    
+    // Partition the batch into contiguous ranges; each job generates (or reads) and runs its range
+    size_t chunkSize = getScenarioChunkSize(total_scenarios, getJobPoolWorkerCount(pool));
+    size_t chunkCount = (total_scenarios + chunkSize - 1) / chunkSize;
+    ScenarioChunk *chunks = (ScenarioChunk*)calloc(chunkCount > 0 ? chunkCount : 1, sizeof(ScenarioChunk));
+    if (chunks == NULL) {
+        printf("Failed to allocate %lu scenario chunks\n", (unsigned long)chunkCount);
+        destroyJobPool(pool);
+        if (scenario_file != NULL) closeScenarioTable(&table);
+        closePlot();
+        return 1;
+    }
+    for (size_t c = 0; c < chunkCount; c++) {
+        ScenarioChunk *chunk = &chunks[c];
+        chunk->records = (scenario_file != NULL) ? table.records + c * chunkSize : NULL;
+        chunk->seed = seed;
+        chunk->params = PARAMS_PID;
+        chunk->model = model;
+        chunk->first = c * chunkSize;
+        chunk->count = (c + 1 == chunkCount) ? total_scenarios - chunk->first : chunkSize;
+        chunk->total = total_scenarios;
+        chunk->dt = dt;
+        chunk->sim_time = t_end;
+        initScenarioBatchStats(&chunk->stats);
+        if (submitJob(pool, runScenarioChunk, chunk) != ERROR_SUCCESS) {
+            printf("  Failed to queue scenarios %lu-%lu\n", (unsigned long)(chunk->first + 1),
+                   (unsigned long)(chunk->first + chunk->count));
+        }
+    }
+    
+    // Wait for every queued scenario, then release the workers
+    waitJobPool(pool);
+    destroyJobPool(pool);
+    
+    // Every chunk kept its own KPIs: combine them now that no worker touches them
+    ScenarioBatchStats *batch = (ScenarioBatchStats*)malloc(sizeof(ScenarioBatchStats));
+    if (batch != NULL) {
+        initScenarioBatchStats(batch);
+        for (size_t c = 0; c < chunkCount; c++) {
+            mergeScenarioBatchStats(batch, &chunks[c].stats);
+        }
+    }
+    
+    AdaptiveIntegrator adaptive;
+    initAdaptiveIntegrator(&adaptive, 0.0, 0.0);
+    long steps_run = 0;
+    for (size_t c = 0; c < chunkCount; c++) {
+        adaptive.accepted += chunks[c].integrator.accepted;
+        adaptive.rejected += chunks[c].integrator.rejected;
+        adaptive.evaluations += chunks[c].integrator.evaluations;
+        steps_run += chunks[c].stepsRun;
+    }
+    free(chunks);
+    if (scenario_file != NULL) closeScenarioTable(&table);
+    
+    reportScenarioBatch(batch, total_scenarios, seed, source, steps_run, &adaptive, dt, t_end);
+    free(batch);
     
     // Finalize plotting system
     closePlot();
     
-    printf("\nAll simulation data saved to CSV files in 'csv_data/' directory.\n");
-    printf("Run 'python visualize_simulation.py' to generate plots and animations.\n");
     printf("\nPress Enter to close...\n");
     getchar();
     
@@ -0,0 +1,448 @@
+// PID gain auto-tuner for the train-catches-ball system
+// Evaluates every candidate gain set over a batch of random scenarios (the same generator as
+// the simulation) and searches with a log-spaced grid followed by refinement rounds around the
+// best candidate. Every candidate is one job on the shared worker pool, so a round spreads over
+// all cores.
+// Optional gradient rounds then descend from the best candidate in log-gain space. The gradient
+// of the cost comes from the sensitivity stepper (forward-mode derivatives of the trajectory with
+// respect to Kp, Ki, Kd), so each candidate is still one simulation per scenario instead of the
+// 4-7 a finite-difference gradient takes; a round line-searches TUNER_LINE_POINTS step lengths.
+//
+// Cost of one scenario (lower is better):
+//   IAE (or ITAE) of the position error in %·s over [0, landing time + TUNER_SETTLE_TIME]
+//   + TUNER_OVERSHOOT_WEIGHT * overshoot past the target (%)
+//   + TUNER_MISS_PENALTY if the train is not within SCENARIO_CATCH_TOLERANCE of the ball at landing
+// The cost of a gain set is the mean over all scenarios. Its gradient covers the IAE/ITAE and
+// overshoot terms; the miss penalty is piecewise constant and contributes nothing.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "controller.h"
+#include "fallingobject.h"
+#include "fallingobject_stepper.h"
+#include "jobpool.h"
+#include "scenario.h"
+
+#define TUNER_DT 0.02                  // Same control rate as the simulation (50 Hz)
+#define TUNER_MAX_TIME 40.0            // Simulation end time (s)
+#define TUNER_SETTLE_TIME 5.0          // Error is still integrated this long after landing (s)
+#define TUNER_OVERSHOOT_WEIGHT 10.0    // Cost per % of overshoot
+#define TUNER_MISS_PENALTY 100.0       // Cost of a missed catch
+#define TUNER_GRID_POINTS 6            // Initial grid points per gain
+#define TUNER_REFINE_POINTS 5          // Refinement grid points per gain
+#define TUNER_LINE_POINTS 4            // Step lengths tried per gradient round
+#define TUNER_MIN_STEP 1e-3            // Gradient rounds stop below this log-gain step
+
+// Search bounds (log-spaced)
+static const double gainMin[3] = { 10.0, 0.5, 5.0 };      // Kp, Ki, Kd
+static const double gainMax[3] = { 5000.0, 500.0, 2000.0 };
+
+// Current hand-picked gains in main.c (reported for comparison)
+static const ControllerParams PARAMS_PID = {500.0, 50.0, 200.0};
+
+typedef enum {
+    TUNER_METRIC_IAE = 0,
+    TUNER_METRIC_ITAE
+} TunerMetric;
+
+// Scenario batch and settings shared (read-only) by all evaluation jobs
+static struct {
+    FallScenario *scenarios;
+    int scenarioCount;
+    TunerMetric metric;
+    SystemModelCallback model;
+} tuner;
+
+// One candidate gain set and its evaluation
+typedef struct {
+    ControllerParams params;
+    double cost;         // Mean scenario cost
+    double iae;          // Mean IAE (%·s)
+    double itae;         // Mean ITAE (%·s²)
+    double overshoot;    // Mean overshoot (%)
+    double catchRate;    // Fraction of scenarios caught
+    int withGradient;    // Also compute the gradient (sensitivity stepper)
+    double gradient[GAIN_COUNT]; // d(cost)/d(Kp, Ki, Kd)
+} Candidate;
+
+// Simulate one scenario and accumulate its metrics into the candidate
+static void evaluateScenario(Candidate *candidate, const FallScenario *scenario) {
+    ControllerParams params = candidate->params;
+    ControllerState state;
+    FallingObject object;
+    initScenarioObject(&object, scenario, &params, &state, tuner.model, TUNER_DT);
+
+    ObjectStepper fastStep = NULL;
+    if (selectObjectStepper(&object, pidController, &fastStep) != ERROR_SUCCESS) {
+        fastStep = NULL;
+    }
+    ObjectSensitivityStepper sensitivityStep = NULL;
+    if (candidate->withGradient &&
+        selectObjectSensitivityStepper(&object, &sensitivityStep) != ERROR_SUCCESS) {
+        sensitivityStep = NULL;
+    }
+    ObjectSensitivity sensitivity;
+    memset(&sensitivity, 0, sizeof(sensitivity));
+    double dIae[GAIN_COUNT] = { 0.0, 0.0, 0.0 };
+    double dItae[GAIN_COUNT] = { 0.0, 0.0, 0.0 };
+    double dOvershoot[GAIN_COUNT] = { 0.0, 0.0, 0.0 };
+
+    double landingTime = getScenarioLandingTime(scenario, object.model.gravity);
+    double horizon = landingTime + TUNER_SETTLE_TIME;
+    if (horizon > TUNER_MAX_TIME) horizon = TUNER_MAX_TIME;
+    int steps = (int)ceil(horizon / TUNER_DT);
+    int landingStep = getScenarioLandingStep(landingTime, TUNER_DT, steps);
+    double direction = object.setpoint >= object.position_pct ? 1.0 : -1.0;
+
+    double iae = 0.0, itae = 0.0, overshoot = 0.0;
+    int caught = 0;
+    double previousError = object.setpoint - object.position_pct;  // Signed error at the step start
+    for (int i = 0; i < steps; i++) {
+        double position = 0.0;
+        ErrorCode err = sensitivityStep ? sensitivityStep(&object, &sensitivity, TUNER_DT, 1, &position)
+                      : fastStep ? fastStep(&object, TUNER_DT, 1, &position)
+                                 : updateSystem(&object, &object.controller, object.model.callback, TUNER_DT,
+                                                &position, pidController, NULL);
+        if (err != ERROR_SUCCESS) break;
+
+        double time = (i + 1) * TUNER_DT;  // Time at the end of the step
+        double error = fabs(object.setpoint - position);
+        iae += error * TUNER_DT;
+        itae += time * error * TUNER_DT;
+
+        double past = (position - object.setpoint) * direction;
+        if (past > overshoot) overshoot = past;
+
+        if (sensitivityStep) {
+            // d|setpoint - position| = -sign(setpoint - position) * d(position)
+            double sign = object.setpoint - position >= 0.0 ? 1.0 : -1.0;
+            for (int g = 0; g < GAIN_COUNT; g++) {
+                double dError = -sign * sensitivity.position_pct[g];
+                dIae[g] += dError * TUNER_DT;
+                dItae[g] += time * dError * TUNER_DT;
+                // The overshoot is the position at its peak step
+                if (past == overshoot && past > 0.0) dOvershoot[g] = direction * sensitivity.position_pct[g];
+            }
+        }
+
+        // Landing event: catch error at exactly landingTime, as in the simulation
+        double signedError = object.setpoint - position;
+        if (i == landingStep) {
+            double catchError = getScenarioLandingError(landingTime, i * TUNER_DT, TUNER_DT, previousError,
+                                                        signedError);
+            caught = fabs(catchError) <= SCENARIO_CATCH_TOLERANCE;
+        }
+        previousError = signedError;
+    }
+
+    candidate->iae += iae;
+    candidate->itae += itae;
+    candidate->overshoot += overshoot;
+    candidate->catchRate += caught;
+    candidate->cost += (tuner.metric == TUNER_METRIC_ITAE ? itae : iae) +
+                       TUNER_OVERSHOOT_WEIGHT * overshoot + (caught ? 0.0 : TUNER_MISS_PENALTY);
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        candidate->gradient[g] += (tuner.metric == TUNER_METRIC_ITAE ? dItae[g] : dIae[g]) +
+                                  TUNER_OVERSHOOT_WEIGHT * dOvershoot[g];
+    }
+}
+
+// Job: evaluate one candidate over every scenario
+static void evaluateCandidate(void *arg) {
+    Candidate *candidate = (Candidate*)arg;
+    candidate->cost = candidate->iae = candidate->itae = candidate->overshoot = candidate->catchRate = 0.0;
+    for (int g = 0; g < GAIN_COUNT; g++) candidate->gradient[g] = 0.0;
+    for (int s = 0; s < tuner.scenarioCount; s++) {
+        evaluateScenario(candidate, &tuner.scenarios[s]);
+    }
+    double n = (double)tuner.scenarioCount;
+    for (int g = 0; g < GAIN_COUNT; g++) candidate->gradient[g] /= n;
+    candidate->cost /= n;
+    candidate->iae /= n;
+    candidate->itae /= n;
+    candidate->overshoot /= n;
+    candidate->catchRate /= n;
+}
+
+// Evaluate a round of candidates in parallel
+// Returns: index of the best candidate, or -1 on failure
+static int evaluateRound(JobPool *pool, Candidate *candidates, int count) {
+    for (int c = 0; c < count; c++) {
+        if (submitJob(pool, evaluateCandidate, &candidates[c]) != ERROR_SUCCESS) {
+            evaluateCandidate(&candidates[c]);  // Queue full: evaluate on this thread
+        }
+    }
+    if (waitJobPool(pool) != ERROR_SUCCESS) return -1;
+
+    int best = 0;
+    for (int c = 1; c < count; c++) {
+        if (candidates[c].cost < candidates[best].cost) best = c;
+    }
+    return best;
+}
+
+// Fill a points^3 grid spanning [low, high] per gain in log space
+static void fillGrid(Candidate *candidates, int points, const double low[3], const double high[3]) {
+    int c = 0;
+    for (int i = 0; i < points; i++) {
+        for (int j = 0; j < points; j++) {
+            for (int k = 0; k < points; k++) {
+                int index[3] = { i, j, k };
+                double gain[3];
+                for (int g = 0; g < 3; g++) {
+                    double f = points > 1 ? (double)index[g] / (double)(points - 1) : 0.5;
+                    gain[g] = exp(low[g] + f * (high[g] - low[g]));
+                }
+                candidates[c].params.Kp = gain[0];
+                candidates[c].params.Ki = gain[1];
+                candidates[c].params.Kd = gain[2];
+                c++;
+            }
+        }
+    }
+}
+
+// Fill a line search from a candidate along its steepest descent in log-gain space
+// (d(cost)/d(log θ) = θ * d(cost)/dθ), with step lengths step * 2^(k - 2)
+// Returns: 0 if the gradient vanishes (no direction to search)
+static int fillLineSearch(Candidate *candidates, const Candidate *from, double step) {
+    double gain[GAIN_COUNT] = { from->params.Kp, from->params.Ki, from->params.Kd };
+    double direction[GAIN_COUNT], norm = 0.0;
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        direction[g] = -gain[g] * from->gradient[g];
+        norm += direction[g] * direction[g];
+    }
+    norm = sqrt(norm);
+    if (!(norm > 0.0)) return 0;
+
+    for (int c = 0; c < TUNER_LINE_POINTS; c++) {
+        double length = step * ldexp(1.0, c - 2);
+        double moved[GAIN_COUNT];
+        for (int g = 0; g < GAIN_COUNT; g++) {
+            double logGain = log(gain[g]) + length * direction[g] / norm;
+            if (logGain < log(gainMin[g])) logGain = log(gainMin[g]);
+            if (logGain > log(gainMax[g])) logGain = log(gainMax[g]);
+            moved[g] = exp(logGain);
+        }
+        candidates[c].params.Kp = moved[0];
+        candidates[c].params.Ki = moved[1];
+        candidates[c].params.Kd = moved[2];
+        candidates[c].withGradient = 1;
+    }
+    return 1;
+}
+
+static void printCandidate(const char *label, const Candidate *candidate) {
+    printf("%-10s Kp=%9.3f Ki=%8.3f Kd=%9.3f  cost=%9.3f  IAE=%8.3f  ITAE=%9.3f  overshoot=%6.3f%%  caught=%5.1f%%\n",
+           label, candidate->params.Kp, candidate->params.Ki, candidate->params.Kd, candidate->cost,
+           candidate->iae, candidate->itae, candidate->overshoot, 100.0 * candidate->catchRate);
+}
+
+static void printUsage(const char *program) {
+    printf("Usage: %s [--scenarios N] [--seed S] [--scenario-file PATH] [--threads N] [--rounds R] [--metric iae|itae]\n", program);
+    printf("          [--model euler|trapezoidal|simplified|adaptive] [--gradient-rounds G]\n");
+    printf("  --scenarios N  Random scenarios per evaluation (default 100)\n");
+    printf("  --seed S       Random seed for the scenario batch (default 1)\n");
+    printf("  --scenario-file PATH  Tune over the scenarios of a table instead (gains/model in it are ignored)\n");
+    printf("  --threads N    Worker threads (default: all hardware threads)\n");
+    printf("  --rounds R     Refinement rounds after the initial grid (default 4)\n");
+    printf("  --metric M     Error integral in the cost: iae (default) or itae\n");
+    printf("  --model M      System model: euler (objectModel, default), trapezoidal, simplified or adaptive\n");
+    printf("  --gradient-rounds G  Gradient descent rounds after the refinement (default 0; not with adaptive)\n");
+}
+
+int main(int argc, char *argv[]) {
+    int num_scenarios = 100;
+    unsigned long long seed = 1;
+    const char *scenario_file = NULL;
+    int num_threads = 0;  // 0 = one worker per hardware thread
+    int rounds = 4;
+    int gradient_rounds = 0;
+    tuner.metric = TUNER_METRIC_IAE;
+    tuner.model = objectModel;
+
+    for (int a = 1; a < argc; a++) {
+        if ((strcmp(argv[a], "--scenarios") == 0 || strcmp(argv[a], "-n") == 0) && a + 1 < argc) {
+            num_scenarios = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--seed") == 0 && a + 1 < argc) {
+            seed = strtoull(argv[++a], NULL, 10);
+        } else if (strcmp(argv[a], "--scenario-file") == 0 && a + 1 < argc) {
+            scenario_file = argv[++a];
+        } else if ((strcmp(argv[a], "--threads") == 0 || strcmp(argv[a], "-j") == 0) && a + 1 < argc) {
+            num_threads = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--rounds") == 0 && a + 1 < argc) {
+            rounds = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--gradient-rounds") == 0 && a + 1 < argc) {
+            gradient_rounds = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--metric") == 0 && a + 1 < argc) {
+            const char *metric = argv[++a];
+            if (strcmp(metric, "iae") == 0) {
+                tuner.metric = TUNER_METRIC_IAE;
+            } else if (strcmp(metric, "itae") == 0) {
+                tuner.metric = TUNER_METRIC_ITAE;
+            } else {
+                printf("Unknown metric: %s\n", metric);
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--model") == 0 && a + 1 < argc) {
+            ScenarioModel model;
+            if (parseScenarioModel(argv[++a], &model) != ERROR_SUCCESS) {
+                printf("Unknown model: %s\n", argv[a]);
+                printUsage(argv[0]);
+                return 1;
+            }
+            tuner.model = getScenarioModelCallback(model);
+        } else if (strcmp(argv[a], "--help") == 0 || strcmp(argv[a], "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            printf("Unknown option: %s\n", argv[a]);
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (num_scenarios < 1) num_scenarios = 1;
+    if (rounds < 0) rounds = 0;
+    if (gradient_rounds < 0) gradient_rounds = 0;
+
+    ScenarioTable table;
+    if (scenario_file != NULL) {
+        if (openScenarioTable(scenario_file, &table) != ERROR_SUCCESS || table.recordCount == 0 ||
+            table.recordCount > INT_MAX) {
+            printf("Could not read scenario table %s\n", scenario_file);
+            if (table.mapping != NULL) closeScenarioTable(&table);
+            return 1;
+        }
+        num_scenarios = (int)table.recordCount;
+    }
+
+    // Scenario batch from the simulation's random generator (or the table)
+    tuner.scenarioCount = num_scenarios;
+    tuner.scenarios = (FallScenario*)malloc((size_t)num_scenarios * sizeof(FallScenario));
+    int gridCount = TUNER_GRID_POINTS * TUNER_GRID_POINTS * TUNER_GRID_POINTS;
+    Candidate *candidates = (Candidate*)calloc((size_t)gridCount, sizeof(Candidate));
+    if (tuner.scenarios == NULL || candidates == NULL) {
+        printf("Failed to allocate %d scenarios\n", num_scenarios);
+        free(tuner.scenarios);
+        free(candidates);
+        if (scenario_file != NULL) closeScenarioTable(&table);
+        return 1;
+    }
+    for (int s = 0; s < num_scenarios; s++) {
+        if (scenario_file != NULL) {
+            getScenarioFromRecord(&table.records[s], &tuner.scenarios[s], NULL);
+        } else {
+            generateScenario(seed, (uint64_t)s, &tuner.scenarios[s]);
+        }
+    }
+    if (scenario_file != NULL) {
+        seed = table.seed;
+        closeScenarioTable(&table);
+    }
+
+    JobPool *pool = NULL;
+    if (createJobPool(num_threads, &pool) != ERROR_SUCCESS) {
+        printf("Failed to create worker pool\n");
+        free(tuner.scenarios);
+        free(candidates);
+        return 1;
+    }
+    printf("PID auto-tuner: %d scenarios (seed %llu), %s cost, %d worker threads\n",
+           num_scenarios, seed, tuner.metric == TUNER_METRIC_ITAE ? "ITAE" : "IAE", getJobPoolWorkerCount(pool));
+
+    // Reference: the hand-picked gains
+    Candidate baseline;
+    memset(&baseline, 0, sizeof(baseline));
+    baseline.params = PARAMS_PID;
+    evaluateCandidate(&baseline);
+    printCandidate("baseline", &baseline);
+
+    // Round 0: log-spaced grid over the whole search range
+    double low[3], high[3], spacing[3];
+    for (int g = 0; g < 3; g++) {
+        low[g] = log(gainMin[g]);
+        high[g] = log(gainMax[g]);
+        spacing[g] = (high[g] - low[g]) / (TUNER_GRID_POINTS - 1);
+    }
+    fillGrid(candidates, TUNER_GRID_POINTS, low, high);
+    int bestIndex = evaluateRound(pool, candidates, gridCount);
+    if (bestIndex < 0) {
+        printf("Candidate evaluation failed\n");
+        destroyJobPool(pool);
+        free(tuner.scenarios);
+        free(candidates);
+        return 1;
+    }
+    Candidate best = candidates[bestIndex];
+    int evaluations = gridCount;
+    printCandidate("grid", &best);
+
+    // Refinement: a finer grid spanning one previous spacing around the best candidate
+    int refineCount = TUNER_REFINE_POINTS * TUNER_REFINE_POINTS * TUNER_REFINE_POINTS;
+    for (int r = 1; r <= rounds; r++) {
+        double center[3] = { log(best.params.Kp), log(best.params.Ki), log(best.params.Kd) };
+        for (int g = 0; g < 3; g++) {
+            low[g] = center[g] - spacing[g];
+            high[g] = center[g] + spacing[g];
+            if (low[g] < log(gainMin[g])) low[g] = log(gainMin[g]);
+            if (high[g] > log(gainMax[g])) high[g] = log(gainMax[g]);
+            spacing[g] = (high[g] - low[g]) / (TUNER_REFINE_POINTS - 1);
+        }
+        fillGrid(candidates, TUNER_REFINE_POINTS, low, high);
+        bestIndex = evaluateRound(pool, candidates, refineCount);
+        if (bestIndex < 0) break;
+        evaluations += refineCount;
+        if (candidates[bestIndex].cost < best.cost) best = candidates[bestIndex];
+
+        char label[32];
+        snprintf(label, sizeof(label), "round %d", r);
+        printCandidate(label, &best);
+    }
+
+    // Gradient rounds: line search along the steepest descent of the best candidate. The first
+    // step spans the last refinement spacing; it doubles after a gain and shrinks 4x after a miss.
+    if (gradient_rounds > 0) {
+        ObjectSensitivityStepper probe = NULL;
+        FallingObject object;
+        ControllerState state;
+        initScenarioObject(&object, &tuner.scenarios[0], &best.params, &state, tuner.model, TUNER_DT);
+        if (selectObjectSensitivityStepper(&object, &probe) != ERROR_SUCCESS) {
+            printf("Gradient rounds skipped: the model has no sensitivity stepper\n");
+            gradient_rounds = 0;
+        } else {
+            best.withGradient = 1;
+            evaluateCandidate(&best);
+            evaluations++;
+        }
+    }
+    double step = sqrt(spacing[0] * spacing[0] + spacing[1] * spacing[1] + spacing[2] * spacing[2]);
+    for (int r = 1; r <= gradient_rounds && step >= TUNER_MIN_STEP; r++) {
+        if (!fillLineSearch(candidates, &best, step)) break;
+        bestIndex = evaluateRound(pool, candidates, TUNER_LINE_POINTS);
+        if (bestIndex < 0) break;
+        evaluations += TUNER_LINE_POINTS;
+        if (candidates[bestIndex].cost < best.cost) {
+            best = candidates[bestIndex];
+            step *= ldexp(1.0, bestIndex - 1);  // The improving length, doubled
+        } else {
+            step *= 0.25;
+        }
+
+        char label[32];
+        snprintf(label, sizeof(label), "gradient %d", r);
+        printCandidate(label, &best);
+    }
+
+    destroyJobPool(pool);
+
+    printf("\n%d candidates x %d scenarios evaluated\n", evaluations, num_scenarios);
+    printCandidate("best", &best);
+    printf("\nControllerParams PARAMS_PID = {%.3f, %.3f, %.3f};\n", best.params.Kp, best.params.Ki, best.params.Kd);
+
+    free(tuner.scenarios);
+    free(candidates);
+    return 0;
+}
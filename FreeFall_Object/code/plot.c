@@ -1,4 +1,6 @@
 #include "plot.h"
+#include "objectpool.h"
+#include "profile.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,54 +12,83 @@
 #include <sys/stat.h>
 #endif
 
-// Structure to hold simulation data for CSV export
-#define MAX_PLOT_POINTS 2000  // Store all data points
+// Trace columns, in row order (same names as the former CSV header)
+static const char *const traceColumns[] = {
+    "time", "train_position", "falling_object_position", "applied_force",
+    "train_velocity", "train_acceleration", "error_derivative", "error_integral"
+};
+#define TRACE_COLUMN_COUNT ((int)(sizeof(traceColumns) / sizeof(traceColumns[0])))
 
-typedef struct {
-    double time;
-    double level;      // Train position
-    double setpoint;   // Falling object position
-    double control;    // Applied force
-    double velocity;   // Train velocity
-    double acceleration; // Train acceleration
-    double error_derivative; // Rate of change of error (de/dt)
-    double error_integral;   // Accumulated error integral
-} PlotDataPoint;
+// Output format of every trace (set with setPlotTraceFormat before initRealtimePlot)
+static TraceFormat traceFormat = TRACE_FORMAT_BINARY_F64;
+static double animationRate = PLOT_ANIMATION_FPS;  // Frames per second of packed traces
 
 typedef struct {
     char sanitizedName[256];
-    int pointCount;
-    PlotDataPoint *dataBuffer;
-    int bufferSize;
-    int bufferIndex;
+    char filename[512];
+    TraceWriter *trace;    // Streams rows to csv_data/<name>.trc (or .csv, .trz)
 } RealtimePlot;
 
+// Plot handles recycled between runs (initPlot / closePlot)
+static ObjectPool plotPool;
+
 void initPlot(void) {
-    // Create CSV data directory
+    // Create trace data directory
 #ifdef _WIN32
-    CreateDirectoryA("csv_data", NULL);
+    CreateDirectoryA(PLOT_TRACE_DIRECTORY, NULL);
 #else
-    mkdir("csv_data", 0755);
+    mkdir(PLOT_TRACE_DIRECTORY, 0755);
 #endif
-    printf("CSV data directory created. Data will be saved for Python visualization.\n");
+    initObjectPool(&plotPool, sizeof(RealtimePlot));
+    if (openProfileReport(PLOT_TRACE_DIRECTORY "/" PLOT_PROFILE_REPORT_NAME, "freefall_object") != ERROR_SUCCESS) {
+        fprintf(stderr, "Warning: Could not create %s/%s\n", PLOT_TRACE_DIRECTORY, PLOT_PROFILE_REPORT_NAME);
+    }
+    if (startTraceWriterThread() != ERROR_SUCCESS) {
+        fprintf(stderr, "Error: Could not start the trace writer thread\n");
+        return;
+    }
+    printf("Trace data directory created. Data will be saved for Python visualization.\n");
 }
 
 void closePlot(void) {
-    printf("\nAll simulation data saved to CSV files in 'csv_data/' directory.\n");
+    stopTraceWriterThread();
+    closeProfileReport();
+    releaseObjectPool(&plotPool, NULL);
+    printf("\nAll simulation data saved to trace files in 'csv_data/' directory.\n");
     printf("Run 'python visualize_simulation.py' to generate plots and animations.\n");
 }
 
 int isPlotFallbackEnabled(void) {
-    return 0;  // Always use CSV export
+    return 0;  // Always record traces
+}
+
+void setPlotTraceFormat(TraceFormat format) {
+    traceFormat = format;
+}
+
+void setPlotAnimationRate(double framesPerSecond) {
+    animationRate = framesPerSecond;
+}
+
+ErrorCode getPlotTraceFileName(const char *controllerName, char *fileName, size_t size) {
+    if (controllerName == NULL || fileName == NULL) return ERROR_NULL_POINTER;
+
+    // Sanitize controller name (replace spaces with underscores)
+    int length = snprintf(fileName, size, "%s%s", controllerName, getTraceFileExtension(traceFormat));
+    if (length < 0 || (size_t)length >= size) return ERROR_INVALID_PARAMETER;
+    for (int i = 0; fileName[i]; i++) {
+        if (fileName[i] == ' ') fileName[i] = '_';
+    }
+    return ERROR_SUCCESS;
 }
 
 ErrorCode initRealtimePlot(const char *controllerName, int windowIndex, void **plotHandle) {
     if (plotHandle == NULL || controllerName == NULL) return ERROR_NULL_POINTER;
+    (void)windowIndex;  // No plot windows, traces only
     
     *plotHandle = NULL;
     
-    // Create plot structure to store data
-    RealtimePlot *plot = (RealtimePlot*)malloc(sizeof(RealtimePlot));
+    RealtimePlot *plot = (RealtimePlot*)takePoolObject(&plotPool);
     if (!plot) return ERROR_NULL_POINTER;
     
     // Sanitize controller name (replace spaces with underscores)
@@ -66,14 +97,22 @@ ErrorCode initRealtimePlot(const char *controllerName, int windowIndex, void **p
         if (plot->sanitizedName[i] == ' ') plot->sanitizedName[i] = '_';
     }
     
-    plot->pointCount = 0;
-    plot->bufferSize = MAX_PLOT_POINTS;
-    plot->bufferIndex = 0;
-    
-    plot->dataBuffer = (PlotDataPoint*)malloc(MAX_PLOT_POINTS * sizeof(PlotDataPoint));
-    if (!plot->dataBuffer) {
-        free(plot);
-        return ERROR_NULL_POINTER;
+    char fileName[sizeof(plot->filename) - sizeof(PLOT_TRACE_DIRECTORY)];  // Room for the directory and "/"
+    ErrorCode err = getPlotTraceFileName(controllerName, fileName, sizeof(fileName));
+    if (err != ERROR_SUCCESS) {
+        returnPoolObject(&plotPool, plot);
+        return err;
+    }
+    snprintf(plot->filename, sizeof(plot->filename), "%s/%s", PLOT_TRACE_DIRECTORY, fileName);
+    err = openTraceWriter(plot->filename, traceFormat, TRACE_COLUMN_COUNT,
+                                    traceColumns, &plot->trace);
+    if (err != ERROR_SUCCESS) {
+        fprintf(stderr, "Error: Could not open trace file %s\n", plot->filename);
+        returnPoolObject(&plotPool, plot);
+        return err;
+    }
+    if (traceFormat == TRACE_FORMAT_PACKED) {
+        setTraceAnimationRate(plot->trace, animationRate);
     }
     
     *plotHandle = plot;
@@ -88,22 +127,14 @@ ErrorCode updateRealtimePlot(void *plotHandle, double time, double level,
     
     RealtimePlot *plot = (RealtimePlot*)plotHandle;
     
-    // Store data point in buffer
-    int idx = plot->bufferIndex;
-    plot->dataBuffer[idx].time = time;
-    plot->dataBuffer[idx].level = level;
-    plot->dataBuffer[idx].setpoint = setpoint;
-    plot->dataBuffer[idx].control = control_signal;
-    plot->dataBuffer[idx].velocity = velocity;
-    plot->dataBuffer[idx].acceleration = acceleration;
-    plot->dataBuffer[idx].error_derivative = error_derivative;
-    plot->dataBuffer[idx].error_integral = error_integral;
-    
-    // Update indices
-    plot->bufferIndex = (plot->bufferIndex + 1) % plot->bufferSize;
-    plot->pointCount++;
-    
-    return ERROR_SUCCESS;
+    // Stream the sample; full chunks are written by the background thread
+    const double row[TRACE_COLUMN_COUNT] = {
+        time, level, setpoint, control_signal,
+        velocity, acceleration, error_derivative, error_integral
+    };
+    ErrorCode err;
+    PROFILE_SECTION(PROFILE_TRACE_APPEND, err = appendTraceRow(plot->trace, row));
+    return err;
 }
 
 ErrorCode closeRealtimePlot(void *plotHandle, const char *controllerName) {
@@ -111,55 +142,21 @@ ErrorCode closeRealtimePlot(void *plotHandle, const char *controllerName) {
     if (controllerName == NULL) return ERROR_NULL_POINTER;
     
     RealtimePlot *plot = (RealtimePlot*)plotHandle;
+    long totalPoints = getTraceRowCount(plot->trace);
     
-    // Calculate how many points we have
-    int totalPoints = (plot->pointCount < plot->bufferSize) ? plot->pointCount : plot->bufferSize;
-    int startIdx = (plot->pointCount < plot->bufferSize) ? 0 : plot->bufferIndex;
-    
-    if (totalPoints < 1) {
+    // Flush the remaining rows and finalize the file
+    ErrorCode err = closeTraceWriter(plot->trace);
+    if (err != ERROR_SUCCESS) {
+        fprintf(stderr, "Error: Could not write trace file %s\n", plot->filename);
+    } else if (totalPoints < 1) {
         fprintf(stderr, "Warning: No data to save for %s\n", controllerName);
-        free(plot->dataBuffer);
-        free(plot);
-        return ERROR_CALLBACK_FAILED;
+        err = ERROR_CALLBACK_FAILED;
+    } else {
+        printf("Trace data saved to '%s' (%ld points)\n", plot->filename, totalPoints);
     }
     
-    // Save to CSV file
-    char csvFilename[512];
-    snprintf(csvFilename, sizeof(csvFilename), "csv_data/%s.csv", plot->sanitizedName);
-    
-    FILE *csvFile = fopen(csvFilename, "w");
-    if (!csvFile) {
-        fprintf(stderr, "Error: Could not open CSV file %s\n", csvFilename);
-        free(plot->dataBuffer);
-        free(plot);
-        return ERROR_CALLBACK_FAILED;
-    }
-    
-    // Write CSV header
-    fprintf(csvFile, "time,train_position,falling_object_position,applied_force,train_velocity,train_acceleration,error_derivative,error_integral\n");
-    
-    // Write all data points
-    for (int i = 0; i < totalPoints; i++) {
-        int idx = (startIdx + i) % plot->bufferSize;
-        fprintf(csvFile, "%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
-                plot->dataBuffer[idx].time,
-                plot->dataBuffer[idx].level,
-                plot->dataBuffer[idx].setpoint,
-                plot->dataBuffer[idx].control,
-                plot->dataBuffer[idx].velocity,
-                plot->dataBuffer[idx].acceleration,
-                plot->dataBuffer[idx].error_derivative,
-                plot->dataBuffer[idx].error_integral);
-    }
-    
-    fclose(csvFile);
-    printf("CSV data saved to '%s' (%d points)\n", csvFilename, totalPoints);
-    
-    // Cleanup
-    free(plot->dataBuffer);
-    free(plot);
-    
-    return ERROR_SUCCESS;
+    returnPoolObject(&plotPool, plot);
+    return err;
 }
 
 void generatePlot(double *time, double *level, double *setpoint, 
@@ -168,5 +165,5 @@ void generatePlot(double *time, double *level, double *setpoint,
     // Just print a message
     (void)time; (void)level; (void)setpoint; (void)control_signal; 
     (void)n; (void)Kp; (void)controllerName;
-    printf("Note: generatePlot() called but data is already saved via CSV export\n");
+    printf("Note: generatePlot() called but data is already saved via trace export\n");
 }
@@ -1,12 +1,15 @@
 #ifndef PLOT_H
 #define PLOT_H
 
+#include <stddef.h>
 #include "controller.h"
+#include "tracewriter.h"
 
-// Initialize plotting system (checks for gnuplot availability)
+// Initialize plotting system (creates csv_data/, starts the trace writer thread and, in an
+// instrumentation build, the profiling report)
 void initPlot(void);
 
-// Close plotting system (cleanup)
+// Close plotting system (stops the trace writer thread, all plots must be closed)
 void closePlot(void);
 
 // Generate plot with falling object simulation data
@@ -24,12 +27,36 @@ void generatePlot(double *time, double *level, double *setpoint,
 // Check if fallback mode is enabled (CSV output instead of plotting)
 int isPlotFallbackEnabled(void);
 
+// Select the trace file format (default TRACE_FORMAT_BINARY_F64)
+// Must be called before the first initRealtimePlot.
+void setPlotTraceFormat(TraceFormat format);
+
+// Frame rate of the animation stream of packed traces (default PLOT_ANIMATION_FPS, 0: none)
+// Must be called before the first initRealtimePlot.
+#define PLOT_ANIMATION_FPS 30.0
+void setPlotAnimationRate(double framesPerSecond);
+
+// Directory the traces are written to (relative to the working directory)
+#define PLOT_TRACE_DIRECTORY "csv_data"
+
+// Profiling report in PLOT_TRACE_DIRECTORY (instrumentation build only, common/profile.h)
+#define PLOT_PROFILE_REPORT_NAME "profile.jsonl"
+
+// File name (inside PLOT_TRACE_DIRECTORY) of the trace initRealtimePlot writes for a controller name
+// Parameters:
+//   controllerName: name passed to initRealtimePlot
+//   fileName: buffer for the file name
+//   size: size of fileName
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (buffer too small)
+ErrorCode getPlotTraceFileName(const char *controllerName, char *fileName, size_t size);
+
 // Real-time plotting functions
 // Initialize real-time plot for a specific controller
 // Returns: ErrorCode (ERROR_SUCCESS or error code), sets plotHandle to plot pointer or NULL
 ErrorCode initRealtimePlot(const char *controllerName, int windowIndex, void **plotHandle);
 
 // Update real-time plot with new data point
+// Samples are streamed to the trace file, so the run length is unbounded
 // Returns: ErrorCode
 ErrorCode updateRealtimePlot(void *plotHandle, double time, double level, 
                              double setpoint, double control_signal,
@@ -0,0 +1,310 @@
+#include "scenario.h"
+#include "philox.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// The record layout is the file format: no padding allowed
+typedef char scenarioRecordSizeCheck[(sizeof(ScenarioRecord) == 64) ? 1 : -1];
+
+void generateScenario(uint64_t seed, uint64_t index, FallScenario *scenario) {
+    if (scenario == NULL) return;
+
+    // One Philox block per scenario: four uniforms in [0, 1)
+    PhiloxBlock block = philox4x32(index, 0, seed);
+
+    // Random angle: 0° to 45°
+    scenario->landing_angle = philoxUniform(block.v[0]) * 45.0;
+
+    // Random ball X position: 20m to 100m
+    scenario->ball_x_position = 20.0 + philoxUniform(block.v[1]) * 80.0;
+
+    // Random ball initial Y height: 30m to 100m
+    scenario->ball_y_initial = 30.0 + philoxUniform(block.v[2]) * 70.0;
+
+    // Random train initial X: 0m to (ball_x - 20m) to ensure some distance
+    double max_train_x = (scenario->ball_x_position > 20.0) ? (scenario->ball_x_position - 20.0) : 0.0;
+    scenario->train_x_initial = philoxUniform(block.v[3]) * max_train_x;
+}
+
+static void putU32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void putU64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t getU32(const unsigned char *p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t getU64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+// Map a whole file (create: new file of the given size, read-write; else existing file, read-only)
+static ErrorCode mapFile(const char *path, size_t size, int create, ScenarioTable *table) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, create ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ, FILE_SHARE_READ,
+                              NULL, create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return ERROR_CALLBACK_FAILED;
+    if (!create) {
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            return ERROR_CALLBACK_FAILED;
+        }
+        size = (size_t)fileSize.QuadPart;
+    }
+    if (size < SCENARIO_TABLE_HEADER_SIZE) {
+        CloseHandle(file);
+        return ERROR_INVALID_PARAMETER;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, create ? PAGE_READWRITE : PAGE_READONLY,
+                                        (DWORD)((unsigned long long)size >> 32), (DWORD)size, NULL);
+    void *view = mapping ? MapViewOfFile(mapping, create ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size) : NULL;
+    if (view == NULL) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return ERROR_CALLBACK_FAILED;
+    }
+    table->fileHandle = file;
+    table->mappingHandle = mapping;
+#else
+    int fd = open(path, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+    if (fd < 0) return ERROR_CALLBACK_FAILED;
+    if (create) {
+        if (ftruncate(fd, (off_t)size) != 0) {
+            close(fd);
+            return ERROR_CALLBACK_FAILED;
+        }
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return ERROR_CALLBACK_FAILED;
+        }
+        size = (size_t)st.st_size;
+    }
+    if (size < SCENARIO_TABLE_HEADER_SIZE) {
+        close(fd);
+        return ERROR_INVALID_PARAMETER;
+    }
+    void *view = mmap(NULL, size, create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the file referenced
+    if (view == MAP_FAILED) return ERROR_CALLBACK_FAILED;
+#endif
+    table->mapping = view;
+    table->mappingSize = size;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode openScenarioTable(const char *path, ScenarioTable *table) {
+    if (path == NULL || table == NULL) return ERROR_NULL_POINTER;
+    memset(table, 0, sizeof(*table));
+
+    ErrorCode err = mapFile(path, 0, 0, table);
+    if (err != ERROR_SUCCESS) return err;
+
+    const unsigned char *header = (const unsigned char*)table->mapping;
+    uint32_t headerSize = getU32(header + 8);
+    uint32_t recordSize = getU32(header + 12);
+    uint64_t recordCount = getU64(header + 16);
+    if (memcmp(header, SCENARIO_TABLE_MAGIC, sizeof(SCENARIO_TABLE_MAGIC)) != 0 ||
+        headerSize < SCENARIO_TABLE_HEADER_SIZE || headerSize % 8 != 0 || recordSize != sizeof(ScenarioRecord) ||
+        recordCount > (table->mappingSize - headerSize) / recordSize) {
+        closeScenarioTable(table);
+        return ERROR_INVALID_PARAMETER;
+    }
+    table->records = (ScenarioRecord*)((unsigned char*)table->mapping + headerSize);
+    table->recordCount = (size_t)recordCount;
+    table->seed = getU64(header + 24);
+    return ERROR_SUCCESS;
+}
+
+ErrorCode createScenarioTable(const char *path, size_t recordCount, uint64_t seed, ScenarioTable *table) {
+    if (path == NULL || table == NULL) return ERROR_NULL_POINTER;
+    memset(table, 0, sizeof(*table));
+    if (recordCount > (SIZE_MAX - SCENARIO_TABLE_HEADER_SIZE) / sizeof(ScenarioRecord)) {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    ErrorCode err = mapFile(path, SCENARIO_TABLE_HEADER_SIZE + recordCount * sizeof(ScenarioRecord), 1, table);
+    if (err != ERROR_SUCCESS) return err;
+
+    unsigned char *header = (unsigned char*)table->mapping;
+    memcpy(header, SCENARIO_TABLE_MAGIC, sizeof(SCENARIO_TABLE_MAGIC));
+    putU32(header + 8, SCENARIO_TABLE_HEADER_SIZE);
+    putU32(header + 12, (uint32_t)sizeof(ScenarioRecord));
+    putU64(header + 16, (uint64_t)recordCount);
+    putU64(header + 24, seed);
+    table->records = (ScenarioRecord*)(header + SCENARIO_TABLE_HEADER_SIZE);
+    table->recordCount = recordCount;
+    table->seed = seed;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode fillScenarioTable(ScenarioTable *table, size_t first, size_t count,
+                            const ControllerParams *params, ScenarioModel model) {
+    if (table == NULL || table->records == NULL || params == NULL) return ERROR_NULL_POINTER;
+    if (first > table->recordCount || count > table->recordCount - first) return ERROR_INVALID_PARAMETER;
+
+    for (size_t k = first; k < first + count; k++) {
+        FallScenario scenario;
+        generateScenario(table->seed, (uint64_t)k, &scenario);
+        makeScenarioRecord(&scenario, params, model, &table->records[k]);
+    }
+    return ERROR_SUCCESS;
+}
+
+void closeScenarioTable(ScenarioTable *table) {
+    if (table == NULL || table->mapping == NULL) return;
+#ifdef _WIN32
+    UnmapViewOfFile(table->mapping);
+    CloseHandle((HANDLE)table->mappingHandle);
+    CloseHandle((HANDLE)table->fileHandle);
+#else
+    munmap(table->mapping, table->mappingSize);
+#endif
+    memset(table, 0, sizeof(*table));
+}
+
+void makeScenarioRecord(const FallScenario *scenario, const ControllerParams *params, ScenarioModel model,
+                        ScenarioRecord *record) {
+    if (scenario == NULL || params == NULL || record == NULL) return;
+    record->landing_angle = scenario->landing_angle;
+    record->ball_x_position = scenario->ball_x_position;
+    record->ball_y_initial = scenario->ball_y_initial;
+    record->train_x_initial = scenario->train_x_initial;
+    record->Kp = params->Kp;
+    record->Ki = params->Ki;
+    record->Kd = params->Kd;
+    record->model = (uint32_t)model;
+    record->reserved = 0;
+}
+
+void getScenarioFromRecord(const ScenarioRecord *record, FallScenario *scenario, ControllerParams *params) {
+    if (record == NULL) return;
+    if (scenario != NULL) {
+        scenario->landing_angle = record->landing_angle;
+        scenario->ball_x_position = record->ball_x_position;
+        scenario->ball_y_initial = record->ball_y_initial;
+        scenario->train_x_initial = record->train_x_initial;
+    }
+    if (params != NULL) {
+        params->Kp = record->Kp;
+        params->Ki = record->Ki;
+        params->Kd = record->Kd;
+    }
+}
+
+SystemModelCallback getScenarioModelCallback(uint32_t model) {
+    switch (model) {
+    case SCENARIO_MODEL_EULER:       return objectModel;
+    case SCENARIO_MODEL_TRAPEZOIDAL: return objectModelTrapezoidal;
+    case SCENARIO_MODEL_SIMPLIFIED:  return objectModelTrapezoidalSimplified;
+    case SCENARIO_MODEL_ADAPTIVE:    return objectModelAdaptive;
+    default:                         return NULL;
+    }
+}
+
+ErrorCode parseScenarioModel(const char *name, ScenarioModel *model) {
+    if (name == NULL || model == NULL) return ERROR_NULL_POINTER;
+    if (strcmp(name, "euler") == 0) {
+        *model = SCENARIO_MODEL_EULER;
+    } else if (strcmp(name, "trapezoidal") == 0) {
+        *model = SCENARIO_MODEL_TRAPEZOIDAL;
+    } else if (strcmp(name, "simplified") == 0) {
+        *model = SCENARIO_MODEL_SIMPLIFIED;
+    } else if (strcmp(name, "adaptive") == 0) {
+        *model = SCENARIO_MODEL_ADAPTIVE;
+    } else {
+        return ERROR_INVALID_PARAMETER;
+    }
+    return ERROR_SUCCESS;
+}
+
+ErrorCode initScenarioObject(FallingObject *object, const FallScenario *scenario, ControllerParams *params,
+                             ControllerState *state, SystemModelCallback model, double dt) {
+    if (object == NULL || scenario == NULL || params == NULL || state == NULL || model == NULL) {
+        return ERROR_NULL_POINTER;
+    }
+
+
+    double max_position = SCENARIO_MAX_POSITION;
+    double landing_surface_angle = scenario->landing_angle * M_PI / 180.0;  // Convert degrees to radians
+
+    // Train horizontal position (X coordinate), starting from rest
+    object->position_pct = (scenario->train_x_initial / max_position) * 100.0;  // Train position as percentage
+    object->velocity = 0.0;
+    object->position = scenario->train_x_initial;
+    object->setpoint = (scenario->ball_x_position / max_position) * 100.0;  // Target: ball landing X (percentage)
+    object->applied_force = 0.0;     // Will be controlled
+    object->previousNetForce = 0.0;  // Initialize for trapezoidal integration
+
+    // Controller state reset for each simulation; mpc (set by the caller for mpcController runs),
+    // schedule (built-in gain schedules) and history start cleared
+    ErrorCode err = initControllerConfig(&object->controller, params, state, dt);
+    if (err != ERROR_SUCCESS) return err;
+    object->controller.getSetpoint = getObjectSetpoint;
+    object->controller.getOutput = getObjectOutput;
+
+    object->model.mass = 100.0;          // 100 kg train (realistic mass)
+    object->model.gravity = 9.81;        // Earth gravity (m/s²)
+    object->model.incline_angle = landing_surface_angle;  // Landing surface inclination (0° = flat)
+    object->model.drag_coeff = 0.5;      // Friction/air resistance (increased)
+    object->model.max_force = 3000.0;    // Maximum control force (3000 N, a_max = 30 m/s²)
+    object->model.max_position = max_position;  // 100 m maximum X position
+    object->model.callback = model;      // System model callback (Euler/Trapezoidal/Simplified)
+    object->model.netForceCallback = (model == objectModelTrapezoidalSimplified) ?
+                                     calculateObjectNetForceSimplified : calculateObjectNetForce;
+    initAdaptiveIntegrator(&object->integrator, 0.0, 0.0);  // Default tolerances (objectModelAdaptive)
+    return prepareObjectModel(&object->model);
+}
+
+double getScenarioLandingTime(const FallScenario *scenario, double gravity) {
+    if (scenario == NULL || gravity <= 0.0) return 0.0;
+    return sqrt(2.0 * scenario->ball_y_initial / gravity);
+}
+
+int getScenarioLandingStep(double landingTime, double dt, int steps) {
+    double estimate = ceil(landingTime / dt) - 1.0;
+    if (!(estimate < (double)steps)) return steps;
+    int k = estimate > 0.0 ? (int)estimate : 0;
+    // Settle the rounding of the division against the comparison used by the steppers
+    while (k > 0 && k * dt >= landingTime) k--;
+    while (k < steps && (k + 1) * dt < landingTime) k++;
+    return k;
+}
+
+double getScenarioLandingError(double landingTime, double stepStart, double dt, double startError, double endError) {
+    double fraction = dt > 0.0 ? (landingTime - stepStart) / dt : 1.0;
+    if (fraction < 0.0) fraction = 0.0;
+    if (fraction > 1.0) fraction = 1.0;
+    return startError + fraction * (endError - startError);
+}
+
+double getScenarioBallHeight(const FallScenario *scenario, double gravity, double time, double landingTime) {
+    if (scenario == NULL || time >= landingTime) return 0.0;
+    double height = scenario->ball_y_initial - 0.5 * gravity * time * time;
+    return height > 0.0 ? height : 0.0;
+}
@@ -0,0 +1,157 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "fallingobject.h"
+
+// Train-catches-falling-ball scenario shared by the simulation (main.c) and the gain tuner
+// The ball falls vertically from (ball_x_position, ball_y_initial); the train starts at rest at
+// train_x_initial on a surface inclined by landing_angle and must be under the ball when it lands.
+
+typedef struct {
+    double landing_angle;    // Landing surface angle (degrees)
+    double ball_x_position;  // Ball X position, where the ball lands (m)
+    double ball_y_initial;   // Ball initial Y height (m)
+    double train_x_initial;  // Train initial X position (m)
+} FallScenario;
+
+#define SCENARIO_MAX_POSITION 100.0  // Track length (m), 100% position
+#define SCENARIO_CATCH_TOLERANCE 1.0 // Catch radius (% of the track, i.e. 1 m) at landing
+
+// Scenario k of a batch is drawn from Philox4x32 (common/philox.h) with counter k and the batch
+// seed as key: reproducible for a seed, and any range can be generated on any thread
+// Ranges: angle 0-45°, ball X 20-100 m, ball Y 30-100 m, train X 0 to (ball X - 20 m)
+// Parameters:
+//   seed: batch seed
+//   index: scenario index in the batch
+//   scenario: pointer to store the scenario
+void generateScenario(uint64_t seed, uint64_t index, FallScenario *scenario);
+
+// ===== Scenario table (binary batch input) =====
+// Fixed-size little-endian records behind a 32-byte header, memory-mapped by the engine:
+//   magic "ACSSCN1\0", uint32 headerSize, uint32 recordSize, uint64 recordCount, uint64 seed,
+//   recordCount x ScenarioRecord
+// scripts/generate_random_scenarios.py reads and writes the same layout.
+
+#define SCENARIO_TABLE_MAGIC "ACSSCN1"
+#define SCENARIO_TABLE_HEADER_SIZE 32
+
+// System model of a scenario record
+typedef enum {
+    SCENARIO_MODEL_EULER = 0,        // objectModel
+    SCENARIO_MODEL_TRAPEZOIDAL = 1,  // objectModelTrapezoidal
+    SCENARIO_MODEL_SIMPLIFIED = 2,   // objectModelTrapezoidalSimplified
+    SCENARIO_MODEL_ADAPTIVE = 3      // objectModelAdaptive
+} ScenarioModel;
+
+// One scenario (64 bytes on disk)
+typedef struct {
+    double landing_angle;    // Landing surface angle (degrees)
+    double ball_x_position;  // Ball X position (m)
+    double ball_y_initial;   // Ball initial Y height (m)
+    double train_x_initial;  // Train initial X position (m)
+    double Kp;               // PID gains
+    double Ki;
+    double Kd;
+    uint32_t model;          // ScenarioModel
+    uint32_t reserved;       // Zero
+} ScenarioRecord;
+
+// Memory-mapped scenario table
+typedef struct {
+    ScenarioRecord *records;  // recordCount records (read-only unless created)
+    size_t recordCount;
+    uint64_t seed;            // Seed the table was generated with (informational)
+    void *mapping;            // Start of the mapping (header)
+    size_t mappingSize;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#endif
+} ScenarioTable;
+
+// Map an existing table read-only
+// Parameters:
+//   path: table file
+//   table: table to initialize
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER, ERROR_INVALID_PARAMETER (bad header or size),
+//          ERROR_CALLBACK_FAILED (file could not be opened or mapped)
+ErrorCode openScenarioTable(const char *path, ScenarioTable *table);
+
+// Create a table of recordCount zeroed records and map it read-write
+// Parameters:
+//   path: table file (truncated)
+//   recordCount: number of records
+//   seed: seed stored in the header
+//   table: table to initialize
+// Returns: ErrorCode
+ErrorCode createScenarioTable(const char *path, size_t recordCount, uint64_t seed, ScenarioTable *table);
+
+// Fill records [first, first + count) with scenarios generateScenario(table->seed, k)
+// Distinct ranges can be filled concurrently from different threads.
+// Parameters:
+//   table: table created by createScenarioTable
+//   first, count: record range
+//   params: gains stored in every record
+//   model: model stored in every record
+// Returns: ErrorCode
+ErrorCode fillScenarioTable(ScenarioTable *table, size_t first, size_t count,
+                            const ControllerParams *params, ScenarioModel model);
+
+// Unmap a table (flushes a created table to disk)
+void closeScenarioTable(ScenarioTable *table);
+
+// Build a record from a scenario, gains and model
+void makeScenarioRecord(const FallScenario *scenario, const ControllerParams *params, ScenarioModel model,
+                        ScenarioRecord *record);
+
+// Split a record into scenario geometry and gains
+void getScenarioFromRecord(const ScenarioRecord *record, FallScenario *scenario, ControllerParams *params);
+
+// Model callback of a ScenarioModel (NULL for an unknown value)
+SystemModelCallback getScenarioModelCallback(uint32_t model);
+
+// Parse a model name: "euler", "trapezoidal", "simplified" or "adaptive"
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (unknown name)
+ErrorCode parseScenarioModel(const char *name, ScenarioModel *model);
+
+// Set up the train (100 kg, 3000 N, 100 m track) for a scenario
+// Parameters:
+//   object: falling object to initialize
+//   scenario: scenario to simulate
+//   params: controller gains (must outlive the object)
+//   state: controller state, reset by this function (must outlive the object)
+//   model: system model callback (objectModel, objectModelTrapezoidal, objectModelTrapezoidalSimplified)
+//   dt: time step (s)
+// Returns: ErrorCode
+ErrorCode initScenarioObject(FallingObject *object, const FallScenario *scenario, ControllerParams *params,
+                             ControllerState *state, SystemModelCallback model, double dt);
+
+// Time at which the ball reaches the ground: t = sqrt(2 * y0 / g)
+double getScenarioLandingTime(const FallScenario *scenario, double gravity);
+
+// Step of the landing event: the first step k ending at or after the landing time
+// ((k + 1) * dt >= landingTime), found in closed form instead of by polling the ball height
+// Parameters:
+//   landingTime: getScenarioLandingTime
+//   dt: time step (s)
+//   steps: number of steps of the run
+// Returns: the step index, or `steps` if the ball lands after the run
+int getScenarioLandingStep(double landingTime, double dt, int steps);
+
+// Error at the landing time inside the landing step, linear between the errors at the start
+// and the end of the step (the catch check of the simulation, the tuner and the batch API)
+// Parameters:
+//   landingTime: getScenarioLandingTime
+//   stepStart: time at the start of the landing step (s)
+//   dt: time step (s)
+//   startError: error at the start of the step
+//   endError: error at the end of the step
+// Returns: the interpolated error
+double getScenarioLandingError(double landingTime, double stepStart, double dt, double startError, double endError);
+
+// Ball height y0 - g t^2 / 2 at a time, 0 from the landing time on (m)
+double getScenarioBallHeight(const FallScenario *scenario, double gravity, double time, double landingTime);
+
+#endif // SCENARIO_H
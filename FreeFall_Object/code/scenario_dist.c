@@ -0,0 +1,660 @@
+#include "scenario_dist.h"
+#include "msgsocket.h"
+#include "threads.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Message types
+enum {
+    DIST_MSG_HELLO = 1,
+    DIST_MSG_SETTINGS,
+    DIST_MSG_CHUNK,
+    DIST_MSG_TRACE,
+    DIST_MSG_RESULT,
+    DIST_MSG_FAILED,
+    DIST_MSG_DONE
+};
+
+#define DIST_BYTE_ORDER_MARK 0x01020304u
+#define DIST_POLL_MS 1000                // Wake-up interval to check timeouts and keepRunning
+#define DIST_MIN_CHUNKS 16               // Guided chunks split a batch at least this finely
+
+// First message of a worker: protocol, layout and capacity
+typedef struct {
+    uint32_t version;
+    uint32_t byteOrder;        // DIST_BYTE_ORDER_MARK as written by the worker
+    uint32_t recordSize;       // sizeof(ScenarioRecord)
+    uint32_t resultSize;       // sizeof(DistChunkResult)
+    uint32_t settingsSize;     // Settings blob the worker expects
+    int32_t threads;           // Local worker threads
+} DistHello;
+
+typedef struct {
+    uint64_t id;
+    uint64_t first;
+    uint64_t count;
+    uint32_t hasRecords;       // count ScenarioRecords follow
+    uint32_t reserved;
+} DistChunkHeader;
+
+typedef struct {
+    uint64_t id;
+    DistChunkResult result;
+} DistResultMessage;
+
+// ===== Trace lists =====
+
+ErrorCode addDistTrace(DistTraceList *list, const char *name) {
+    if (list == NULL || name == NULL) return ERROR_NULL_POINTER;
+    if (strlen(name) >= DIST_TRACE_NAME_SIZE) return ERROR_INVALID_PARAMETER;
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity > 0 ? 2 * list->capacity : 16;
+        char (*grown)[DIST_TRACE_NAME_SIZE] = realloc(list->names, capacity * sizeof(*grown));
+        if (grown == NULL) return ERROR_NULL_POINTER;
+        list->names = grown;
+        list->capacity = capacity;
+    }
+    snprintf(list->names[list->count++], DIST_TRACE_NAME_SIZE, "%s", name);
+    return ERROR_SUCCESS;
+}
+
+void freeDistTraceList(DistTraceList *list) {
+    if (list == NULL) return;
+    free(list->names);
+    list->names = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+ErrorCode parseDistAddress(const char *address, char *host, size_t hostSize, int *port) {
+    if (address == NULL || host == NULL || port == NULL) return ERROR_NULL_POINTER;
+    const char *colon = strrchr(address, ':');
+    if (colon == NULL || colon == address || (size_t)(colon - address) >= hostSize) return ERROR_INVALID_PARAMETER;
+    char *end = NULL;
+    long value = strtol(colon + 1, &end, 10);
+    if (end == colon + 1 || *end != '\0' || value < 1 || value > 65535) return ERROR_INVALID_PARAMETER;
+    memcpy(host, address, (size_t)(colon - address));
+    host[colon - address] = '\0';
+    *port = (int)value;
+    return ERROR_SUCCESS;
+}
+
+static int isRunning(volatile int *keepRunning) {
+    return keepRunning == NULL || *keepRunning;
+}
+
+// A bare file name: uploaded traces cannot escape the trace directory
+static int isSafeTraceName(const char *name, size_t length) {
+    if (length == 0 || length >= DIST_TRACE_NAME_SIZE) return 0;
+    for (size_t i = 0; i < length; i++) {
+        if (name[i] == '/' || name[i] == '\\' || name[i] == ':' || name[i] == '\0') return 0;
+        if (name[i] == '.' && i + 1 < length && name[i + 1] == '.') return 0;
+    }
+    return 1;
+}
+
+// ===== Coordinator =====
+
+typedef enum {
+    CHUNK_QUEUED = 0,   // Waiting in the retry queue
+    CHUNK_RUNNING,
+    CHUNK_FINISHED,
+    CHUNK_ABANDONED     // Failed maxAttempts times
+} DistChunkStatus;
+
+typedef struct {
+    size_t first;
+    size_t count;
+    int attempts;       // Times handed out
+    DistChunkStatus status;
+} DistChunkState;
+
+typedef struct {
+    MsgSocket socket;             // MSG_SOCKET_INVALID: free slot
+    char peer[64];
+    int joined;                   // Hello accepted and settings sent
+    int threads;
+    uint64_t inFlight[DIST_CHUNKS_IN_FLIGHT];
+    int inFlightCount;
+    time_t lastProgress;          // Connection or last message
+} DistWorkerSlot;
+
+typedef struct {
+    const DistCoordinatorConfig *config;
+    DistCoordinatorReport *report;
+    DistChunkState *chunks;       // Every chunk cut so far, indexed by id
+    size_t chunkCount;
+    size_t chunkCapacity;
+    size_t next;                  // First scenario not yet in a chunk
+    uint64_t *retry;              // Ids of requeued chunks (FIFO)
+    size_t retryHead;
+    size_t retryCount;
+    size_t retryCapacity;
+    size_t settled;               // Scenarios finished or given up
+    int maxAttempts;
+    DistWorkerSlot workers[DIST_MAX_WORKERS];
+    MsgBuffer buffer;
+    DistResultMessage *message;   // Aligned copy of the last result
+} DistCoordinator;
+
+static int getJoinedThreads(const DistCoordinator *coordinator) {
+    int threads = 0;
+    for (int w = 0; w < DIST_MAX_WORKERS; w++) {
+        if (coordinator->workers[w].socket != MSG_SOCKET_INVALID && coordinator->workers[w].joined) {
+            threads += coordinator->workers[w].threads;
+        }
+    }
+    return threads > 0 ? threads : 1;
+}
+
+// Size of a new chunk for a worker: the fixed size, or its thread share of half the remaining
+// scenarios (large chunks first, small ones near the end so workers finish together), at most
+// 1/DIST_MIN_CHUNKS of the batch so workers joining late still find work
+static size_t getDistChunkSize(const DistCoordinator *coordinator, const DistWorkerSlot *worker) {
+    size_t remaining = coordinator->config->total - coordinator->next;
+    size_t size = coordinator->config->chunkSize;
+    if (size == 0) {
+        size_t threads = (size_t)worker->threads;
+        size = remaining / (2 * (size_t)getJoinedThreads(coordinator)) * threads;
+        if (size > coordinator->config->total / DIST_MIN_CHUNKS) size = coordinator->config->total / DIST_MIN_CHUNKS;
+        if (size < threads * 8) size = threads * 8;
+        if (size > threads * 4096) size = threads * 4096;
+    }
+    return size < remaining ? size : remaining;
+}
+
+// Next chunk to hand out: requeued chunks first, then a new range (returns 0 when none is left)
+static int takeDistChunk(DistCoordinator *coordinator, const DistWorkerSlot *worker, uint64_t *id) {
+    if (coordinator->retryCount > 0) {
+        *id = coordinator->retry[coordinator->retryHead];
+        coordinator->retryHead = (coordinator->retryHead + 1) % coordinator->retryCapacity;
+        coordinator->retryCount--;
+        return 1;
+    }
+    if (coordinator->next >= coordinator->config->total) return 0;
+
+    if (coordinator->chunkCount == coordinator->chunkCapacity) {
+        size_t capacity = coordinator->chunkCapacity > 0 ? 2 * coordinator->chunkCapacity : 64;
+        DistChunkState *grown = realloc(coordinator->chunks, capacity * sizeof(DistChunkState));
+        if (grown == NULL) return 0;
+        coordinator->chunks = grown;
+        coordinator->chunkCapacity = capacity;
+    }
+    DistChunkState *chunk = &coordinator->chunks[coordinator->chunkCount];
+    chunk->first = coordinator->next;
+    chunk->count = getDistChunkSize(coordinator, worker);
+    chunk->attempts = 0;
+    chunk->status = CHUNK_QUEUED;
+    coordinator->next += chunk->count;
+    *id = coordinator->chunkCount++;
+    return 1;
+}
+
+// Put a chunk of a lost worker back in the queue, or give it up after maxAttempts tries
+static void requeueDistChunk(DistCoordinator *coordinator, uint64_t id) {
+    DistChunkState *chunk = &coordinator->chunks[id];
+    if (chunk->attempts >= coordinator->maxAttempts) {
+        chunk->status = CHUNK_ABANDONED;
+        coordinator->settled += chunk->count;
+        coordinator->report->failed += chunk->count;
+        printf("  Giving up scenarios %lu-%lu after %d attempts\n", (unsigned long)(chunk->first + 1),
+               (unsigned long)(chunk->first + chunk->count), chunk->attempts);
+        return;
+    }
+    if (coordinator->retryCount == coordinator->retryCapacity) {
+        size_t capacity = coordinator->retryCapacity > 0 ? 2 * coordinator->retryCapacity : 16;
+        uint64_t *grown = malloc(capacity * sizeof(uint64_t));
+        if (grown == NULL) {
+            chunk->status = CHUNK_ABANDONED;  // Out of memory: count it as failed, keep going
+            coordinator->settled += chunk->count;
+            coordinator->report->failed += chunk->count;
+            return;
+        }
+        for (size_t i = 0; i < coordinator->retryCount; i++) {
+            grown[i] = coordinator->retry[(coordinator->retryHead + i) % coordinator->retryCapacity];
+        }
+        free(coordinator->retry);
+        coordinator->retry = grown;
+        coordinator->retryHead = 0;
+        coordinator->retryCapacity = capacity;
+    }
+    chunk->status = CHUNK_QUEUED;
+    coordinator->retry[(coordinator->retryHead + coordinator->retryCount) % coordinator->retryCapacity] = id;
+    coordinator->retryCount++;
+    coordinator->report->retries++;
+}
+
+static void dropDistWorker(DistCoordinator *coordinator, DistWorkerSlot *worker, const char *reason) {
+    printf("  Worker %s lost (%s), requeueing %d chunk(s)\n", worker->peer, reason, worker->inFlightCount);
+    for (int i = 0; i < worker->inFlightCount; i++) {
+        requeueDistChunk(coordinator, worker->inFlight[i]);
+    }
+    worker->inFlightCount = 0;
+    closeMsgSocket(worker->socket);
+    worker->socket = MSG_SOCKET_INVALID;
+    worker->joined = 0;
+}
+
+static ErrorCode sendDistChunk(DistCoordinator *coordinator, DistWorkerSlot *worker, uint64_t id) {
+    const DistChunkState *chunk = &coordinator->chunks[id];
+    DistChunkHeader header;
+    memset(&header, 0, sizeof(header));
+    header.id = id;
+    header.first = chunk->first;
+    header.count = chunk->count;
+    header.hasRecords = coordinator->config->records != NULL;
+
+    MsgPart parts[2] = {
+        { &header, sizeof(header) },
+        { header.hasRecords ? (const void*)(coordinator->config->records + chunk->first) : NULL,
+          header.hasRecords ? chunk->count * sizeof(ScenarioRecord) : 0 }
+    };
+    return sendMessageParts(worker->socket, DIST_MSG_CHUNK, parts, 2);
+}
+
+// Keep DIST_CHUNKS_IN_FLIGHT chunks queued on a worker while work is left
+static void fillDistWorker(DistCoordinator *coordinator, DistWorkerSlot *worker) {
+    uint64_t id;
+    while (worker->socket != MSG_SOCKET_INVALID && worker->inFlightCount < DIST_CHUNKS_IN_FLIGHT &&
+           takeDistChunk(coordinator, worker, &id)) {
+        DistChunkState *chunk = &coordinator->chunks[id];
+        chunk->status = CHUNK_RUNNING;
+        chunk->attempts++;
+        worker->inFlight[worker->inFlightCount++] = id;
+        if (sendDistChunk(coordinator, worker, id) != ERROR_SUCCESS) {
+            dropDistWorker(coordinator, worker, "send failed");
+        }
+    }
+}
+
+static void handleDistHello(DistCoordinator *coordinator, DistWorkerSlot *worker) {
+    DistHello hello;
+    if (coordinator->buffer.size != sizeof(hello)) {
+        dropDistWorker(coordinator, worker, "bad hello");
+        return;
+    }
+    memcpy(&hello, coordinator->buffer.data, sizeof(hello));
+    if (hello.version != DIST_PROTOCOL_VERSION || hello.byteOrder != DIST_BYTE_ORDER_MARK ||
+        hello.recordSize != sizeof(ScenarioRecord) || hello.resultSize != sizeof(DistChunkResult) ||
+        hello.settingsSize != coordinator->config->settingsSize || hello.threads < 1) {
+        dropDistWorker(coordinator, worker, "incompatible build");
+        return;
+    }
+    if (sendMessage(worker->socket, DIST_MSG_SETTINGS, coordinator->config->settings,
+                    coordinator->config->settingsSize) != ERROR_SUCCESS) {
+        dropDistWorker(coordinator, worker, "send failed");
+        return;
+    }
+    worker->joined = 1;
+    worker->threads = hello.threads;
+    coordinator->report->workers++;
+    printf("  Worker %s joined with %d threads\n", worker->peer, worker->threads);
+    fillDistWorker(coordinator, worker);
+}
+
+static void handleDistTrace(DistCoordinator *coordinator, DistWorkerSlot *worker) {
+    const unsigned char *data = coordinator->buffer.data;
+    size_t size = coordinator->buffer.size;
+    uint32_t length = 0;
+    if (size >= sizeof(length)) memcpy(&length, data, sizeof(length));
+    if (size < sizeof(length) || length > size - sizeof(length) ||
+        !isSafeTraceName((const char*)data + sizeof(length), length)) {
+        dropDistWorker(coordinator, worker, "bad trace name");
+        return;
+    }
+
+    char path[DIST_TRACE_NAME_SIZE + 512];
+    snprintf(path, sizeof(path), "%s/%.*s", coordinator->config->traceDirectory, (int)length,
+             (const char*)data + sizeof(length));
+    size_t fileSize = size - sizeof(length) - length;
+    FILE *file = fopen(path, "wb");
+    if (file == NULL || fwrite(data + sizeof(length) + length, 1, fileSize, file) != fileSize) {
+        printf("  Warning: Could not write trace %s\n", path);
+    } else {
+        coordinator->report->traceFiles++;
+    }
+    if (file != NULL) fclose(file);
+}
+
+static void handleDistResult(DistCoordinator *coordinator, DistWorkerSlot *worker) {
+    if (coordinator->buffer.size != sizeof(DistResultMessage)) {
+        dropDistWorker(coordinator, worker, "bad result");
+        return;
+    }
+    DistResultMessage *message = coordinator->message;
+    memcpy(message, coordinator->buffer.data, sizeof(*message));
+
+    // Only the worker that owns the chunk may finish it
+    int slot = -1;
+    for (int i = 0; i < worker->inFlightCount; i++) {
+        if (worker->inFlight[i] == message->id) slot = i;
+    }
+    if (slot < 0) {
+        dropDistWorker(coordinator, worker, "result for a chunk it does not own");
+        return;
+    }
+    DistChunkState *chunk = &coordinator->chunks[message->id];
+    if (message->result.stats.runs > chunk->count) {
+        dropDistWorker(coordinator, worker, "bad result");
+        return;
+    }
+    worker->inFlight[slot] = worker->inFlight[--worker->inFlightCount];
+
+    DistCoordinatorReport *report = coordinator->report;
+    mergeScenarioBatchStats(report->totals, &message->result.stats);
+    report->stepsRun += message->result.stepsRun;
+    report->accepted += message->result.accepted;
+    report->rejected += message->result.rejected;
+    report->evaluations += message->result.evaluations;
+    report->completed += chunk->count;
+    report->chunks++;
+    chunk->status = CHUNK_FINISHED;
+    coordinator->settled += chunk->count;
+    printf("  Scenarios %lu-%lu done on %s (%lu/%lu)\n", (unsigned long)(chunk->first + 1),
+           (unsigned long)(chunk->first + chunk->count), worker->peer,
+           (unsigned long)coordinator->settled, (unsigned long)coordinator->config->total);
+    fillDistWorker(coordinator, worker);
+}
+
+static void serveDistWorker(DistCoordinator *coordinator, DistWorkerSlot *worker) {
+    uint32_t type;
+    if (receiveMessage(worker->socket, &type, &coordinator->buffer) != ERROR_SUCCESS) {
+        dropDistWorker(coordinator, worker, "disconnected");
+        return;
+    }
+    worker->lastProgress = time(NULL);
+    if (!worker->joined && type != DIST_MSG_HELLO) {
+        dropDistWorker(coordinator, worker, "no hello");
+        return;
+    }
+    switch (type) {
+        case DIST_MSG_HELLO:
+            if (worker->joined) {
+                dropDistWorker(coordinator, worker, "second hello");
+            } else {
+                handleDistHello(coordinator, worker);
+            }
+            break;
+        case DIST_MSG_TRACE:
+            handleDistTrace(coordinator, worker);
+            break;
+        case DIST_MSG_RESULT:
+            handleDistResult(coordinator, worker);
+            break;
+        case DIST_MSG_FAILED:
+            dropDistWorker(coordinator, worker, "chunk failed");
+            break;
+        default:
+            dropDistWorker(coordinator, worker, "unknown message");
+            break;
+    }
+}
+
+static void acceptDistWorker(DistCoordinator *coordinator, MsgSocket listener) {
+    MsgSocket socket;
+    char peer[64];
+    if (acceptMsgSocket(listener, &socket, peer, sizeof(peer)) != ERROR_SUCCESS) return;
+    for (int w = 0; w < DIST_MAX_WORKERS; w++) {
+        DistWorkerSlot *worker = &coordinator->workers[w];
+        if (worker->socket != MSG_SOCKET_INVALID) continue;
+        memset(worker, 0, sizeof(*worker));
+        worker->socket = socket;
+        snprintf(worker->peer, sizeof(worker->peer), "%s", peer);
+        worker->lastProgress = time(NULL);
+        setMsgSocketTimeout(socket, DIST_IO_TIMEOUT_MS);
+        return;
+    }
+    printf("  Refusing worker %s: %d workers connected\n", peer, DIST_MAX_WORKERS);
+    closeMsgSocket(socket);
+}
+
+ErrorCode runDistCoordinator(const DistCoordinatorConfig *config, DistCoordinatorReport *report) {
+    if (config == NULL || report == NULL || report->totals == NULL) return ERROR_NULL_POINTER;
+    if (config->settings == NULL && config->settingsSize > 0) return ERROR_NULL_POINTER;
+    if (config->total == 0 || config->traceDirectory == NULL) return ERROR_INVALID_PARAMETER;
+
+    DistCoordinator *coordinator = calloc(1, sizeof(DistCoordinator));
+    DistResultMessage *message = malloc(sizeof(DistResultMessage));
+    if (coordinator == NULL || message == NULL) {
+        free(coordinator);
+        free(message);
+        return ERROR_NULL_POINTER;
+    }
+    coordinator->config = config;
+    coordinator->report = report;
+    coordinator->message = message;
+    coordinator->maxAttempts = config->maxAttempts > 0 ? config->maxAttempts : DIST_DEFAULT_MAX_ATTEMPTS;
+    for (int w = 0; w < DIST_MAX_WORKERS; w++) coordinator->workers[w].socket = MSG_SOCKET_INVALID;
+    int chunkTimeout = config->chunkTimeout > 0 ? config->chunkTimeout : DIST_DEFAULT_CHUNK_TIMEOUT;
+
+    MsgSocket listener;
+    ErrorCode err = initMsgSockets();
+    if (err == ERROR_SUCCESS) {
+        err = listenMsgSocket(config->port, &listener);
+        if (err != ERROR_SUCCESS) {
+            printf("Could not listen on port %d\n", config->port);
+            cleanupMsgSockets();
+        }
+    }
+    if (err != ERROR_SUCCESS) {
+        free(coordinator);
+        free(message);
+        return err;
+    }
+    printf("Coordinator listening on port %d for workers (%lu scenarios)\n", config->port,
+           (unsigned long)config->total);
+
+    // One thread serves everyone: wait for a connection or message, handle it, check timeouts
+    MsgSocket sockets[DIST_MAX_WORKERS + 1];
+    int ready[DIST_MAX_WORKERS + 1];
+    while (coordinator->settled < config->total && isRunning(config->keepRunning)) {
+        sockets[0] = listener;
+        for (int w = 0; w < DIST_MAX_WORKERS; w++) sockets[w + 1] = coordinator->workers[w].socket;
+        if (waitMsgSockets(sockets, DIST_MAX_WORKERS + 1, DIST_POLL_MS, ready) < 0) {
+            err = ERROR_CALLBACK_FAILED;
+            break;
+        }
+        if (ready[0]) acceptDistWorker(coordinator, listener);
+        for (int w = 0; w < DIST_MAX_WORKERS; w++) {
+            if (ready[w + 1] && coordinator->workers[w].socket == sockets[w + 1]) {
+                serveDistWorker(coordinator, &coordinator->workers[w]);
+            }
+        }
+
+        // A busy worker silent for chunkTimeout seconds (no result, no trace) is presumed hung
+        time_t now = time(NULL);
+        for (int w = 0; w < DIST_MAX_WORKERS; w++) {
+            DistWorkerSlot *worker = &coordinator->workers[w];
+            if (worker->socket != MSG_SOCKET_INVALID && (worker->inFlightCount > 0 || !worker->joined) &&
+                difftime(now, worker->lastProgress) > chunkTimeout) {
+                dropDistWorker(coordinator, worker, "timed out");
+            }
+        }
+
+        // Chunks requeued by a lost worker go to the others as soon as they have room
+        for (int w = 0; w < DIST_MAX_WORKERS && coordinator->retryCount > 0; w++) {
+            if (coordinator->workers[w].joined) fillDistWorker(coordinator, &coordinator->workers[w]);
+        }
+    }
+
+    for (int w = 0; w < DIST_MAX_WORKERS; w++) {
+        DistWorkerSlot *worker = &coordinator->workers[w];
+        if (worker->socket == MSG_SOCKET_INVALID) continue;
+        if (worker->joined) sendMessage(worker->socket, DIST_MSG_DONE, NULL, 0);
+        closeMsgSocket(worker->socket);
+    }
+    closeMsgSocket(listener);
+    cleanupMsgSockets();
+
+    if (err == ERROR_SUCCESS && (report->failed > 0 || report->completed < config->total)) {
+        err = ERROR_CALLBACK_FAILED;
+    }
+    freeMsgBuffer(&coordinator->buffer);
+    free(coordinator->chunks);
+    free(coordinator->retry);
+    free(coordinator);
+    free(message);
+    return err;
+}
+
+// ===== Worker =====
+
+// Send one trace file as written by the chunk runner (the local copy stays)
+// Returns: ERROR_SUCCESS, ERROR_INVALID_PARAMETER (file missing or too large),
+//          ERROR_NULL_POINTER (out of memory) or ERROR_CALLBACK_FAILED (send failed)
+static ErrorCode sendDistTrace(MsgSocket socket, const char *directory, const char *name) {
+    char path[DIST_TRACE_NAME_SIZE + 512];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return ERROR_INVALID_PARAMETER;
+
+    unsigned char *data = NULL;
+    size_t size = 0;
+    ErrorCode err = ERROR_INVALID_PARAMETER;
+    long length = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    if (length >= 0 && (size_t)length < MSG_MAX_PAYLOAD - DIST_TRACE_NAME_SIZE - 4 &&
+        fseek(file, 0, SEEK_SET) == 0) {
+        size = (size_t)length;
+        data = malloc(size > 0 ? size : 1);
+        if (data == NULL) {
+            err = ERROR_NULL_POINTER;
+        } else if (fread(data, 1, size, file) == size) {
+            err = ERROR_SUCCESS;
+        }
+    }
+    fclose(file);
+    if (err != ERROR_SUCCESS) {
+        free(data);
+        return err;
+    }
+
+    uint32_t nameLength = (uint32_t)strlen(name);
+    MsgPart parts[3] = { { &nameLength, sizeof(nameLength) }, { name, nameLength }, { data, size } };
+    err = sendMessageParts(socket, DIST_MSG_TRACE, parts, 3);
+    free(data);
+    return err;
+}
+
+// Run one CHUNK message and report it (traces first, then the result)
+static ErrorCode runDistWorkerChunk(const DistWorkerConfig *config, MsgSocket socket, const MsgBuffer *buffer,
+                                    DistResultMessage *message) {
+    DistChunkHeader header;
+    if (buffer->size < sizeof(header)) return ERROR_INVALID_PARAMETER;
+    memcpy(&header, buffer->data, sizeof(header));
+    size_t recordBytes = header.hasRecords ? (size_t)header.count * sizeof(ScenarioRecord) : 0;
+    if (header.count == 0 || buffer->size != sizeof(header) + recordBytes) return ERROR_INVALID_PARAMETER;
+
+    // Records are copied out of the receive buffer so they are aligned
+    ScenarioRecord *records = NULL;
+    if (header.hasRecords) {
+        records = malloc(recordBytes);
+        if (records == NULL) return ERROR_NULL_POINTER;
+        memcpy(records, buffer->data + sizeof(header), recordBytes);
+    }
+
+    DistChunk chunk = { header.id, (size_t)header.first, (size_t)header.count, records };
+    DistTraceList traces = { NULL, 0, 0 };
+    memset(message, 0, sizeof(*message));
+    message->id = header.id;
+    initScenarioBatchStats(&message->result.stats);
+
+    ErrorCode err = config->runChunk(config->context, &chunk, &message->result, &traces);
+    free(records);
+    if (err == ERROR_SUCCESS && !isRunning(config->keepRunning)) {
+        err = ERROR_CALLBACK_FAILED;  // Interrupted: the results are incomplete
+    }
+    if (err != ERROR_SUCCESS) {
+        freeDistTraceList(&traces);
+        ErrorCode sent = sendMessage(socket, DIST_MSG_FAILED, &header.id, sizeof(header.id));
+        return sent != ERROR_SUCCESS ? sent : err;
+    }
+
+    // A trace that cannot be read is skipped; a failed send means the connection is gone
+    for (size_t t = 0; t < traces.count && err == ERROR_SUCCESS; t++) {
+        ErrorCode traceErr = sendDistTrace(socket, config->traceDirectory, traces.names[t]);
+        if (traceErr == ERROR_CALLBACK_FAILED) {
+            err = traceErr;
+        } else if (traceErr != ERROR_SUCCESS) {
+            printf("  Warning: Could not upload trace %s\n", traces.names[t]);
+        }
+    }
+    freeDistTraceList(&traces);
+    if (err != ERROR_SUCCESS) return err;
+    return sendMessage(socket, DIST_MSG_RESULT, message, sizeof(*message));
+}
+
+ErrorCode runDistWorker(const DistWorkerConfig *config, size_t *chunksRun) {
+    if (config == NULL || config->host == NULL || config->runChunk == NULL || config->applySettings == NULL ||
+        config->traceDirectory == NULL) {
+        return ERROR_NULL_POINTER;
+    }
+    if (chunksRun != NULL) *chunksRun = 0;
+
+    ErrorCode err = initMsgSockets();
+    if (err != ERROR_SUCCESS) return err;
+
+    // The coordinator may start after its workers: keep trying for connectTimeout seconds
+    MsgSocket socket = MSG_SOCKET_INVALID;
+    time_t start = time(NULL);
+    while ((err = connectMsgSocket(config->host, config->port, &socket)) != ERROR_SUCCESS) {
+        if (err == ERROR_INVALID_PARAMETER || !isRunning(config->keepRunning) ||
+            difftime(time(NULL), start) >= config->connectTimeout) {
+            printf("Could not reach coordinator %s:%d\n", config->host, config->port);
+            cleanupMsgSockets();
+            return err;
+        }
+        threadSleepMs(1000);
+    }
+    setMsgSocketTimeout(socket, DIST_IO_TIMEOUT_MS);
+    printf("Connected to coordinator %s:%d\n", config->host, config->port);
+
+    MsgBuffer buffer = { NULL, 0, 0 };
+    DistResultMessage *message = malloc(sizeof(DistResultMessage));
+    DistHello hello = { DIST_PROTOCOL_VERSION, DIST_BYTE_ORDER_MARK, (uint32_t)sizeof(ScenarioRecord),
+                        (uint32_t)sizeof(DistChunkResult), (uint32_t)config->settingsSize,
+                        config->threads > 0 ? config->threads : 1 };
+    uint32_t type = 0;
+    err = message == NULL ? ERROR_NULL_POINTER : sendMessage(socket, DIST_MSG_HELLO, &hello, sizeof(hello));
+
+    // The coordinator answers a compatible hello with the run settings (otherwise it hangs up)
+    if (err == ERROR_SUCCESS) err = receiveMessage(socket, &type, &buffer);
+    if (err == ERROR_SUCCESS && (type != DIST_MSG_SETTINGS || buffer.size != config->settingsSize)) {
+        err = ERROR_INVALID_PARAMETER;
+    }
+    if (err == ERROR_SUCCESS) err = config->applySettings(config->context, buffer.data, buffer.size);
+    if (err != ERROR_SUCCESS) printf("Coordinator rejected this worker or sent different settings\n");
+
+    // Chunks until DONE; waiting between chunks is not bounded by the I/O timeout
+    while (err == ERROR_SUCCESS) {
+        int readable = 0;
+        int waited = waitMsgSockets(&socket, 1, DIST_POLL_MS, &readable);
+        if (waited < 0) {
+            err = ERROR_CALLBACK_FAILED;
+            break;
+        }
+        if (!readable) {
+            if (!isRunning(config->keepRunning)) err = ERROR_CALLBACK_FAILED;
+            continue;
+        }
+        err = receiveMessage(socket, &type, &buffer);
+        if (err != ERROR_SUCCESS) {
+            printf("Lost the coordinator\n");
+            break;
+        }
+        if (type == DIST_MSG_DONE) break;
+        if (type != DIST_MSG_CHUNK) {
+            err = ERROR_INVALID_PARAMETER;
+            break;
+        }
+        err = runDistWorkerChunk(config, socket, &buffer, message);
+        if (err == ERROR_SUCCESS && chunksRun != NULL) (*chunksRun)++;
+    }
+
+    closeMsgSocket(socket);
+    cleanupMsgSockets();
+    freeMsgBuffer(&buffer);
+    free(message);
+    return err;
+}
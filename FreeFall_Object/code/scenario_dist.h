@@ -0,0 +1,153 @@
+#ifndef SCENARIO_DIST_H
+#define SCENARIO_DIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "errorcode.h"
+#include "scenario.h"
+#include "scenario_stats.h"
+
+// Distributed scenario sweeps (--coordinator / --worker)
+// A coordinator owns the batch and hands contiguous scenario ranges (chunks) to worker
+// processes, one TCP connection each (common/msgsocket.h). A worker runs every chunk on its
+// local job pool and sends back only the aggregated KPIs of the chunk (ScenarioBatchStats) and
+// the traces its trace policy selected, never per-step data; the coordinator merges the results
+// as they arrive. Chunks of a worker that disconnects, reports a failure or falls silent
+// go back into the queue and are retried on another worker.
+//
+// Messages (payloads in the byte order and layout of the coordinator; the hello checks that
+// both sides agree, so nodes of one build on one architecture work together):
+//   HELLO    worker -> coordinator  DistHello
+//   SETTINGS coordinator -> worker  opaque run settings (DistWorkerConfig.applySettings)
+//   CHUNK    coordinator -> worker  DistChunkHeader, then count ScenarioRecords if hasRecords
+//   TRACE    worker -> coordinator  uint32 name length, name, trace file bytes
+//   RESULT   worker -> coordinator  uint64 chunk id, DistChunkResult
+//   FAILED   worker -> coordinator  uint64 chunk id
+//   DONE     coordinator -> worker  no payload: the batch is finished
+
+#define DIST_PROTOCOL_VERSION 1
+#define DIST_TRACE_NAME_SIZE 128        // Longest trace file name (with extension) + 1
+#define DIST_CHUNKS_IN_FLIGHT 2         // Chunks queued per worker, so the next one is already there
+#define DIST_MAX_WORKERS 256            // Connected workers a coordinator serves
+#define DIST_DEFAULT_MAX_ATTEMPTS 3     // Tries of a chunk before it is given up
+#define DIST_DEFAULT_CHUNK_TIMEOUT 600  // Seconds a busy worker may stay silent
+#define DIST_IO_TIMEOUT_MS 30000        // Longest block on a started send or receive
+
+// Scenario range handed to a worker
+typedef struct {
+    uint64_t id;                     // Chunk number (unique in the batch)
+    size_t first;                    // First scenario index
+    size_t count;                    // Scenarios in the range
+    const ScenarioRecord *records;   // Records of the range (NULL: generate them from the seed)
+} DistChunk;
+
+// What a worker reports for a chunk
+typedef struct {
+    ScenarioBatchStats stats;        // KPIs of every run of the range
+    int64_t stepsRun;                // Steps computed (--early-stop skips the rest)
+    uint64_t accepted;               // Adaptive-step statistics (objectModelAdaptive only)
+    uint64_t rejected;
+    uint64_t evaluations;
+} DistChunkResult;
+
+// Trace files (names inside the trace directory) written while running a chunk
+typedef struct {
+    char (*names)[DIST_TRACE_NAME_SIZE];
+    size_t count;
+    size_t capacity;
+} DistTraceList;
+
+// Run one chunk on the worker
+// Parameters:
+//   context: DistWorkerConfig.context
+//   chunk: range to run
+//   result: receives the KPIs and step counts (initialized by the caller)
+//   traces: receives the trace files to upload
+// Returns: ERROR_SUCCESS, or an error to report the chunk as failed (it is retried elsewhere)
+typedef ErrorCode (*DistChunkRunner)(void *context, const DistChunk *chunk, DistChunkResult *result,
+                                     DistTraceList *traces);
+
+// Apply the coordinator's run settings on the worker
+// Parameters:
+//   context: DistWorkerConfig.context
+//   settings: settings blob (DistCoordinatorConfig.settings)
+//   size: blob size (checked against DistWorkerConfig.settingsSize)
+// Returns: ERROR_SUCCESS or an error to leave the batch
+typedef ErrorCode (*DistSettingsHandler)(void *context, const void *settings, size_t size);
+
+typedef struct {
+    int port;                        // TCP port to listen on
+    size_t total;                    // Scenarios in the batch
+    const ScenarioRecord *records;   // Scenario table (NULL: workers generate the scenarios)
+    const void *settings;            // Run settings sent to every worker
+    size_t settingsSize;
+    size_t chunkSize;                // Scenarios per chunk (0: shrinking chunks sized by worker threads)
+    int maxAttempts;                 // Tries of a chunk (0: DIST_DEFAULT_MAX_ATTEMPTS)
+    int chunkTimeout;                // Seconds a worker with chunks may stay silent (no result or
+                                     // trace) before it is dropped (0: DIST_DEFAULT_CHUNK_TIMEOUT)
+    const char *traceDirectory;      // Where uploaded traces are stored
+    volatile int *keepRunning;       // Cleared to stop early (may be NULL)
+} DistCoordinatorConfig;
+
+typedef struct {
+    ScenarioBatchStats *totals;      // Merged KPIs of every finished chunk (caller-initialized)
+    int64_t stepsRun;
+    uint64_t accepted;
+    uint64_t rejected;
+    uint64_t evaluations;
+    size_t completed;                // Scenarios with merged results
+    size_t failed;                   // Scenarios of chunks given up after maxAttempts tries
+    size_t chunks;                   // Chunks finished
+    size_t retries;                  // Chunks handed out again after a worker failed
+    size_t workers;                  // Workers that joined the batch
+    size_t traceFiles;               // Traces received
+} DistCoordinatorReport;
+
+typedef struct {
+    const char *host;                // Coordinator host
+    int port;                        // Coordinator port
+    int threads;                     // Local worker threads (reported, sizes the chunks)
+    int connectTimeout;              // Seconds to keep trying to reach the coordinator
+    size_t settingsSize;             // Expected settings blob size
+    DistSettingsHandler applySettings;
+    DistChunkRunner runChunk;
+    void *context;
+    const char *traceDirectory;      // Where runChunk writes the listed traces
+    volatile int *keepRunning;       // Cleared to stop after the current chunk (may be NULL)
+} DistWorkerConfig;
+
+// Add a trace file name to a list
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER (also out of memory) or
+//          ERROR_INVALID_PARAMETER (name too long)
+ErrorCode addDistTrace(DistTraceList *list, const char *name);
+
+// Release a trace list
+void freeDistTraceList(DistTraceList *list);
+
+// Split "host:port"
+// Parameters:
+//   address: address text
+//   host: buffer for the host
+//   hostSize: size of host
+//   port: pointer to store the port
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER
+ErrorCode parseDistAddress(const char *address, char *host, size_t hostSize, int *port);
+
+// Run a batch as coordinator: serve workers until every chunk is finished or given up
+// Workers may join (and leave) at any time; progress is printed as chunks finish.
+// Parameters:
+//   config: batch and coordinator settings
+//   report: receives the merged results (report->totals must point to initialized stats)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER, ERROR_INVALID_PARAMETER,
+//          ERROR_CALLBACK_FAILED (listen failed, or chunks were given up or stopped early)
+ErrorCode runDistCoordinator(const DistCoordinatorConfig *config, DistCoordinatorReport *report);
+
+// Run chunks for a coordinator until it finishes the batch
+// Parameters:
+//   config: worker settings and callbacks
+//   chunksRun: optional pointer to store the number of chunks run
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER, ERROR_INVALID_PARAMETER (settings mismatch) or
+//          ERROR_CALLBACK_FAILED (coordinator unreachable or lost)
+ErrorCode runDistWorker(const DistWorkerConfig *config, size_t *chunksRun);
+
+#endif // SCENARIO_DIST_H
@@ -0,0 +1,235 @@
+#include "scenario_stats.h"
+#include "scenario.h"
+#include <math.h>
+#include <string.h>
+
+static const char *KPI_NAMES[SCENARIO_KPI_COUNT] = {
+    "settling_time", "overshoot", "iae", "peak_force", "catch_error"
+};
+
+static const char *KPI_UNITS[SCENARIO_KPI_COUNT] = {
+    "s", "%", "%*s", "N", "%"
+};
+
+// Part of the run each KPI covers
+static const char *KPI_WINDOWS[SCENARIO_KPI_COUNT] = {
+    "until_stop", "until_stop", "until_stop", "until_stop", "landing"
+};
+
+void initScenarioKpiTracker(ScenarioKpiTracker *tracker, double initialError, double landingTime) {
+    if (tracker == NULL) return;
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->landingTime = landingTime;
+    tracker->direction = (initialError < 0.0) ? -1.0 : 1.0;
+    tracker->stepStartError = initialError;
+    tracker->lastError = initialError;
+}
+
+void updateScenarioKpiTracker(ScenarioKpiTracker *tracker, double time, double error, double force, double dt) {
+    if (tracker == NULL) return;
+    ScenarioKpis *kpis = &tracker->kpis;
+    double absError = fabs(error);
+
+    kpis->iae += absError * dt;
+    if (fabs(force) > kpis->peak_force) kpis->peak_force = fabs(force);
+
+    // Past the ball: the error changed sign relative to the direction of travel
+    double past = -tracker->direction * error;
+    if (past > kpis->overshoot) kpis->overshoot = past;
+
+    if (absError > SCENARIO_SETTLE_BAND) tracker->lastOutside = time + dt;
+    tracker->endTime = time + dt;
+
+    tracker->stepStartError = tracker->lastError;
+    tracker->lastError = error;
+}
+
+double markScenarioLanding(ScenarioKpiTracker *tracker, double stepStart, double dt) {
+    if (tracker == NULL) return 0.0;
+    double error = getScenarioLandingError(tracker->landingTime, stepStart, dt, tracker->stepStartError,
+                                           tracker->lastError);
+    if (!tracker->landed) {
+        tracker->landed = 1;
+        tracker->kpis.catch_error = fabs(error);
+        tracker->kpis.caught = fabs(error) <= SCENARIO_CATCH_TOLERANCE;
+    }
+    return error;
+}
+
+void finishScenarioKpiTracker(ScenarioKpiTracker *tracker, double finalError, ScenarioKpis *kpis) {
+    if (tracker == NULL || kpis == NULL) return;
+    // A run stopped before the landing (settled early) is judged by where the train rests
+    if (!tracker->landed) {
+        tracker->landed = 1;
+        tracker->kpis.catch_error = fabs(finalError);
+        tracker->kpis.caught = fabs(finalError) <= SCENARIO_CATCH_TOLERANCE;
+    }
+    // Censored unless the band held for the last SCENARIO_SETTLE_HOLD s (small tolerance for
+    // the accumulated step times)
+    tracker->kpis.settled = tracker->endTime - tracker->lastOutside >= SCENARIO_SETTLE_HOLD - 1e-9;
+    tracker->kpis.settling_time = tracker->kpis.settled ? tracker->lastOutside : NAN;
+    *kpis = tracker->kpis;
+}
+
+void initScenarioBatchStats(ScenarioBatchStats *stats) {
+    if (stats == NULL) return;
+    memset(stats, 0, sizeof(*stats));
+    for (int k = 0; k < SCENARIO_KPI_COUNT; k++) {
+        initOnlineStats(&stats->stats[k]);
+        initQuantileSketch(&stats->sketches[k]);
+    }
+}
+
+void addScenarioBatchStats(ScenarioBatchStats *stats, size_t scenarioNumber, const ScenarioKpis *kpis, int traced) {
+    if (stats == NULL || kpis == NULL) return;
+    double values[SCENARIO_KPI_COUNT] = {
+        kpis->settling_time, kpis->overshoot, kpis->iae, kpis->peak_force, kpis->catch_error
+    };
+    for (int k = 0; k < SCENARIO_KPI_COUNT; k++) {
+        if (k == SCENARIO_KPI_SETTLING_TIME && !kpis->settled) continue;
+        addOnlineSample(&stats->stats[k], values[k]);
+        addSketchSample(&stats->sketches[k], values[k]);
+    }
+    if (!kpis->settled) stats->unsettled++;
+    if (kpis->truncated) stats->truncated++;
+    stats->runs++;
+    if (traced) stats->traced++;
+    if (kpis->caught) {
+        stats->caught++;
+    } else {
+        if (stats->flaggedCount < SCENARIO_SUMMARY_MAX_FLAGGED) {
+            stats->flagged[stats->flaggedCount] = scenarioNumber;
+        }
+        stats->flaggedCount++;
+    }
+}
+
+void mergeScenarioBatchStats(ScenarioBatchStats *into, const ScenarioBatchStats *from) {
+    if (into == NULL || from == NULL) return;
+    for (int k = 0; k < SCENARIO_KPI_COUNT; k++) {
+        mergeOnlineStats(&into->stats[k], &from->stats[k]);
+        mergeQuantileSketch(&into->sketches[k], &from->sketches[k]);
+    }
+    // Both lists are ascending: keep the smallest listed numbers of the two, so batches merged
+    // out of order (distributed chunks) list the same scenarios as an in-order merge
+    size_t intoListed = into->flaggedCount < SCENARIO_SUMMARY_MAX_FLAGGED ? into->flaggedCount
+                                                                          : SCENARIO_SUMMARY_MAX_FLAGGED;
+    size_t fromListed = from->flaggedCount < SCENARIO_SUMMARY_MAX_FLAGGED ? from->flaggedCount
+                                                                          : SCENARIO_SUMMARY_MAX_FLAGGED;
+    if (fromListed > 0 && intoListed > 0 && from->flagged[0] < into->flagged[intoListed - 1]) {
+        size_t merged[SCENARIO_SUMMARY_MAX_FLAGGED];
+        size_t i = 0, j = 0, n = 0;
+        while (n < SCENARIO_SUMMARY_MAX_FLAGGED && (i < intoListed || j < fromListed)) {
+            if (j >= fromListed || (i < intoListed && into->flagged[i] <= from->flagged[j])) {
+                merged[n++] = into->flagged[i++];
+            } else {
+                merged[n++] = from->flagged[j++];
+            }
+        }
+        memcpy(into->flagged, merged, n * sizeof(size_t));
+    } else {
+        for (size_t i = 0; i < fromListed && intoListed + i < SCENARIO_SUMMARY_MAX_FLAGGED; i++) {
+            into->flagged[intoListed + i] = from->flagged[i];
+        }
+    }
+    into->flaggedCount += from->flaggedCount;
+    into->runs += from->runs;
+    into->caught += from->caught;
+    into->traced += from->traced;
+    into->unsettled += from->unsettled;
+    into->truncated += from->truncated;
+}
+
+const char* getScenarioKpiName(ScenarioKpiIndex kpi) {
+    if ((int)kpi < 0 || (int)kpi >= SCENARIO_KPI_COUNT) return "unknown";
+    return KPI_NAMES[kpi];
+}
+
+// Quantile clamped to the observed range (the sketch reports bucket midpoints)
+static double getKpiQuantile(const ScenarioBatchStats *stats, int k, double q) {
+    double value = getSketchQuantile(&stats->sketches[k], q);
+    if (value < stats->stats[k].min) value = stats->stats[k].min;
+    if (value > stats->stats[k].max) value = stats->stats[k].max;
+    return value;
+}
+
+static void writeJsonString(FILE *file, const char *text) {
+    fputc('"', file);
+    for (const char *p = text; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', file);
+            fputc(*p, file);
+        } else if ((unsigned char)*p < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned char)*p);
+        } else {
+            fputc(*p, file);
+        }
+    }
+    fputc('"', file);
+}
+
+ErrorCode writeScenarioBatchSummary(const char *path, const ScenarioBatchStats *stats,
+                                    unsigned long long seed, const char *source, int earlyStop) {
+    if (path == NULL || stats == NULL || source == NULL) return ERROR_NULL_POINTER;
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return ERROR_CALLBACK_FAILED;
+
+    fprintf(file, "{\n  \"scenarios\": %lu,\n  \"seed\": %llu,\n  \"source\": ", (unsigned long)stats->runs, seed);
+    writeJsonString(file, source);
+    fprintf(file, ",\n  \"caught\": %lu,\n  \"catch_rate\": %.6f,\n  \"traced\": %lu,\n  \"early_stop\": %s,\n"
+                  "  \"unsettled\": %lu,\n  \"truncated\": %lu,\n  \"kpis\": {\n",
+            (unsigned long)stats->caught, stats->runs > 0 ? (double)stats->caught / (double)stats->runs : 0.0,
+            (unsigned long)stats->traced, earlyStop ? "true" : "false", (unsigned long)stats->unsettled,
+            (unsigned long)stats->truncated);
+    for (int k = 0; k < SCENARIO_KPI_COUNT; k++) {
+        const OnlineStats *s = &stats->stats[k];
+        int empty = s->count == 0;
+        fprintf(file, "    \"%s\": {\"unit\": \"%s\", \"window\": \"%s\", \"count\": %llu, \"mean\": %.9g, "
+                      "\"stddev\": %.9g, \"min\": %.9g, \"p50\": %.9g, \"p90\": %.9g, \"p99\": %.9g, \"max\": %.9g}%s\n",
+                KPI_NAMES[k], KPI_UNITS[k], KPI_WINDOWS[k], (unsigned long long)s->count, s->mean,
+                sqrt(getOnlineVariance(s)),
+                empty ? 0.0 : s->min, empty ? 0.0 : getKpiQuantile(stats, k, 0.50),
+                empty ? 0.0 : getKpiQuantile(stats, k, 0.90), empty ? 0.0 : getKpiQuantile(stats, k, 0.99),
+                empty ? 0.0 : s->max, (k + 1 < SCENARIO_KPI_COUNT) ? "," : "");
+    }
+    fprintf(file, "  },\n  \"flagged\": {\"reason\": \"missed catch\", \"count\": %lu, \"scenarios\": [",
+            (unsigned long)stats->flaggedCount);
+    size_t listed = stats->flaggedCount < SCENARIO_SUMMARY_MAX_FLAGGED ? stats->flaggedCount
+                                                                       : SCENARIO_SUMMARY_MAX_FLAGGED;
+    for (size_t i = 0; i < listed; i++) {
+        fprintf(file, "%s%lu", i > 0 ? ", " : "", (unsigned long)stats->flagged[i]);
+    }
+    fprintf(file, "]}\n}\n");
+
+    int failed = ferror(file);
+    if (fclose(file) != 0 || failed) return ERROR_CALLBACK_FAILED;
+    return ERROR_SUCCESS;
+}
+
+void printScenarioBatchSummary(FILE *out, const ScenarioBatchStats *stats) {
+    if (out == NULL || stats == NULL) return;
+    fprintf(out, "Batch KPIs: %lu runs, %lu caught (%.1f%%), %lu traced\n", (unsigned long)stats->runs,
+            (unsigned long)stats->caught,
+            stats->runs > 0 ? 100.0 * (double)stats->caught / (double)stats->runs : 0.0,
+            (unsigned long)stats->traced);
+    if (stats->runs == 0) return;
+    if (stats->unsettled > 0) {
+        fprintf(out, "  %lu runs did not settle before they stopped (settling_time covers the other %lu)\n",
+                (unsigned long)stats->unsettled, (unsigned long)(stats->runs - stats->unsettled));
+    }
+    if (stats->truncated > 0) {
+        fprintf(out, "  %lu runs truncated by early stop (saturation/divergence): their KPIs end at the stop\n",
+                (unsigned long)stats->truncated);
+    }
+    fprintf(out, "  %-14s %12s %12s %12s %12s\n", "KPI", "mean", "stddev", "p50", "p99");
+    for (int k = 0; k < SCENARIO_KPI_COUNT; k++) {
+        const OnlineStats *s = &stats->stats[k];
+        if (s->count == 0) {
+            fprintf(out, "  %-14s %12s  %s\n", KPI_NAMES[k], "-", KPI_UNITS[k]);
+            continue;
+        }
+        fprintf(out, "  %-14s %12.4g %12.4g %12.4g %12.4g  %s\n", KPI_NAMES[k], s->mean,
+                sqrt(getOnlineVariance(s)), getKpiQuantile(stats, k, 0.50), getKpiQuantile(stats, k, 0.99),
+                KPI_UNITS[k]);
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef SCENARIO_STATS_H
+#define SCENARIO_STATS_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "onlinestats.h"
+#include "errorcode.h"
+
+// Per-scenario KPIs and their batch aggregation
+// Each run feeds a ScenarioKpiTracker step by step; the finished ScenarioKpis go into the
+// ScenarioBatchStats of the job that ran it. Jobs own their batch stats, so nothing is
+// shared while the batch runs: mergeScenarioBatchStats() combines them afterwards and
+// writeScenarioBatchSummary() writes one JSON summary for the whole batch.
+
+#define SCENARIO_SETTLE_BAND 2.0        // Settled when |error| stays within 2% (2 m) of the ball X
+#define SCENARIO_SETTLE_HOLD 1.0        // ... for at least the last 1 s of the run
+#define SCENARIO_SUMMARY_MAX_FLAGGED 1000  // Flagged scenario numbers listed in the summary
+
+// KPIs of one run
+// settling_time is censored (NAN, settled = 0) when the band was not held for the last
+// SCENARIO_SETTLE_HOLD seconds of the run: the run stopped before it settled. overshoot, iae
+// and peak_force accumulate until the run stops, so they depend on when it stops.
+typedef struct {
+    double settling_time;   // Time after which |error| stays within SCENARIO_SETTLE_BAND (s), or NAN
+    double overshoot;       // Largest travel past the ball X position (% of the track)
+    double iae;             // Integral of |error| (%·s)
+    double peak_force;      // Largest |applied force| (N)
+    double catch_error;     // |error| at the landing time, interpolated within the step (%)
+    int caught;             // catch_error within SCENARIO_CATCH_TOLERANCE
+    int settled;            // settling_time is known (the band held until the run stopped)
+    int truncated;          // Stopped early without settling (saturation/divergence streak)
+} ScenarioKpis;
+
+// Running KPI state of one run
+// The catch is evaluated by the landing event the runner schedules (markScenarioLanding).
+typedef struct {
+    double landingTime;     // Ball landing time (s)
+    double direction;       // Sign of the initial error (direction of travel)
+    double lastOutside;     // End of the last step outside the settle band (s)
+    double endTime;         // End of the latest step (s)
+    double stepStartError;  // Error at the start of the latest step
+    double lastError;       // Error after the latest step
+    int landed;             // Catch already evaluated
+    ScenarioKpis kpis;
+} ScenarioKpiTracker;
+
+// KPIs aggregated over a batch (mean/variance/min/max and quantiles of each KPI)
+typedef enum {
+    SCENARIO_KPI_SETTLING_TIME = 0,
+    SCENARIO_KPI_OVERSHOOT,
+    SCENARIO_KPI_IAE,
+    SCENARIO_KPI_PEAK_FORCE,
+    SCENARIO_KPI_CATCH_ERROR,
+    SCENARIO_KPI_COUNT
+} ScenarioKpiIndex;
+
+typedef struct {
+    size_t runs;
+    size_t caught;
+    size_t traced;                              // Runs with a full trace on disk
+    size_t unsettled;                           // Runs with a censored settling time (not in its stats)
+    size_t truncated;                           // Runs stopped early without settling
+    OnlineStats stats[SCENARIO_KPI_COUNT];
+    QuantileSketch sketches[SCENARIO_KPI_COUNT];
+    size_t flaggedCount;                        // Missed catches
+    size_t flagged[SCENARIO_SUMMARY_MAX_FLAGGED];  // First flagged scenario numbers (1-based)
+} ScenarioBatchStats;
+
+// Start tracking a run
+// Parameters:
+//   tracker: tracker to reset
+//   initialError: setpoint - output before the first step (%)
+//   landingTime: ball landing time (s)
+void initScenarioKpiTracker(ScenarioKpiTracker *tracker, double initialError, double landingTime);
+
+// Add one step
+// Parameters:
+//   tracker: tracker
+//   time: time at the start of the step (s)
+//   error: setpoint - output after the step (%)
+//   force: applied force in the step (N)
+//   dt: time step (s)
+void updateScenarioKpiTracker(ScenarioKpiTracker *tracker, double time, double error, double force, double dt);
+
+// Landing event: evaluate the catch at the landing time inside the latest step
+// The error is interpolated linearly between the start and the end of the step
+// (getScenarioLandingError).
+// Parameters:
+//   tracker: tracker (after updateScenarioKpiTracker for the landing step)
+//   stepStart: time at the start of that step (s)
+//   dt: time step (s)
+// Returns: the interpolated error at the landing time (%)
+double markScenarioLanding(ScenarioKpiTracker *tracker, double stepStart, double dt);
+
+// Finish a run: settle and catch results as of the last step
+// A run that ended before the landing event is judged by where the train rests; a run that
+// did not hold the settle band for SCENARIO_SETTLE_HOLD s at its end is not settled.
+// Parameters:
+//   tracker: tracker
+//   finalError: error after the last step (%)
+//   kpis: pointer to store the KPIs
+void finishScenarioKpiTracker(ScenarioKpiTracker *tracker, double finalError, ScenarioKpis *kpis);
+
+// Reset batch stats to an empty batch
+void initScenarioBatchStats(ScenarioBatchStats *stats);
+
+// Add the KPIs of one run (the settling time of an unsettled run is only counted)
+// Parameters:
+//   stats: batch stats
+//   scenarioNumber: 1-based scenario number (listed if flagged)
+//   kpis: KPIs of the run
+//   traced: the run has a full trace on disk
+void addScenarioBatchStats(ScenarioBatchStats *stats, size_t scenarioNumber, const ScenarioKpis *kpis, int traced);
+
+// Add the runs of another batch (the flagged lists are merged in ascending order, keeping the
+// first SCENARIO_SUMMARY_MAX_FLAGGED, so the batches may be merged in any order)
+void mergeScenarioBatchStats(ScenarioBatchStats *into, const ScenarioBatchStats *from);
+
+// Name of a KPI ("settling_time", "overshoot", "iae", "peak_force", "catch_error")
+const char* getScenarioKpiName(ScenarioKpiIndex kpi);
+
+// Write the batch summary as JSON
+// Every KPI lists its window: "until_stop" KPIs accumulate until each run stops (shorter
+// with early_stop), catch_error is taken at the landing.
+// Parameters:
+//   path: output file
+//   stats: merged batch stats
+//   seed: batch seed
+//   source: "generated" or the scenario table path
+//   earlyStop: the runs used --early-stop
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_CALLBACK_FAILED (file could not be written)
+ErrorCode writeScenarioBatchSummary(const char *path, const ScenarioBatchStats *stats,
+                                    unsigned long long seed, const char *source, int earlyStop);
+
+// Print the batch summary (runs, catch rate, mean/p50/p99 of every KPI)
+void printScenarioBatchSummary(FILE *out, const ScenarioBatchStats *stats);
+
+#endif // SCENARIO_STATS_H
@@ -1,4 +1,4 @@
-C"""
+"""
 Comprehensive analysis and visualization of random PID control scenarios
 Creates plots showing all parameters and performance metrics
 """
@@ -9,6 +9,8 @@ import matplotlib.gridspec as gridspec
 from pathlib import Path
 import re
 
+from trace_io import load_trace_frame, find_traces, load_batch_summary
+
 def parse_filename(filename):
     """Extract parameters from Random scenario filename"""
     match = re.search(r'Random_S(\d+)_A(\d+)_BallX(\d+)Y(\d+)_TrainX(\d+)', filename)
@@ -23,8 +25,8 @@ def parse_filename(filename):
     return None
 
 def load_scenario_data(csv_file):
-    """Load and parse a single scenario CSV file"""
-    df = pd.read_csv(csv_file)
+    """Load and parse a single scenario trace file (.trc, .trz or .csv)"""
+    df = load_trace_frame(csv_file)
     params = parse_filename(csv_file.name)
     
     return {
@@ -411,6 +413,25 @@ def create_trajectory_overlay(scenarios, output_dir):
     
     print(f"✓ Created trajectory overlay: {output_file.name}")
 
+def print_batch_summary(summary):
+    """Print the batch KPIs aggregated by the simulation (every run, traced or not)"""
+    print(f"Batch summary: {summary['scenarios']} scenarios (seed {summary['seed']}, {summary['source']}), "
+          f"{summary['caught']} caught ({100.0 * summary['catch_rate']:.1f}%), {summary['traced']} traced")
+    if summary.get('unsettled'):
+        print(f"  {summary['unsettled']} runs did not settle before they stopped (left out of settling_time)")
+    if summary.get('truncated'):
+        print(f"  {summary['truncated']} runs truncated by early stop (their KPIs end at the stop)")
+    print(f"  {'KPI':<14} {'mean':>10} {'stddev':>10} {'p50':>10} {'p90':>10} {'p99':>10} {'max':>10}")
+    for name, kpi in summary['kpis'].items():
+        print(f"  {name:<14} {kpi['mean']:10.4g} {kpi['stddev']:10.4g} {kpi['p50']:10.4g} "
+              f"{kpi['p90']:10.4g} {kpi['p99']:10.4g} {kpi['max']:10.4g}  {kpi['unit']}")
+    flagged = summary['flagged']
+    if flagged['count']:
+        listed = ', '.join(str(s) for s in flagged['scenarios'][:20])
+        more = ' ...' if flagged['count'] > 20 else ''
+        print(f"  Flagged ({flagged['reason']}): {flagged['count']} - scenarios {listed}{more}")
+    print()
+
 def main():
     """Main analysis workflow"""
     print("="*80)
@@ -418,12 +439,18 @@ def main():
     print("="*80)
     print()
     
-    # Find all random scenario CSV files
     csv_dir = Path('csv_data')
-    csv_files = sorted(csv_dir.glob('Random_*.csv'))
+    
+    # Batch KPIs come precomputed with the run: no need to parse every trace for them
+    summary = load_batch_summary(csv_dir)
+    if summary is not None:
+        print_batch_summary(summary)
+    
+    # Find the random scenario trace files (all runs, or only flagged/sampled ones)
+    csv_files = find_traces(csv_dir, 'Random_*')
     
     if not csv_files:
-        print("❌ No random scenario CSV files found!")
+        print("❌ No random scenario trace files found!")
         return
     
     print(f"Found {len(csv_files)} random scenario files\n")
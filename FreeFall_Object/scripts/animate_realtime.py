@@ -13,6 +13,8 @@ from pathlib import Path
 import argparse
 import os
 
+from trace_io import load_trace_frame, find_traces
+
 class RealtimeSimulationAnimation:
     def __init__(self, csv_file):
         self.csv_file = csv_file
@@ -87,8 +89,9 @@ class RealtimeSimulationAnimation:
             except:
                 print("Could not parse angle from filename, using 0°")
         
-        # Load data
-        df = pd.read_csv(csv_file)
+        # Load data (binary .trc traces are memory-mapped; packed .trz traces load only
+        # their pre-decimated animation stream when they have one)
+        df = load_trace_frame(csv_file, animation=True)
         self.time = df['time'].values
         self.train_pos = df['train_position'].values
         self.obj_pos = df['falling_object_position'].values
@@ -574,9 +577,9 @@ class RealtimeSimulationAnimation:
 def main():
     parser = argparse.ArgumentParser(description='Real-time animation for train tracking simulation')
     parser.add_argument('--file', type=str, default=None,
-                       help='Specific CSV file to animate')
+                       help='Specific trace file (.trc, .trz or .csv) to animate')
     parser.add_argument('--csv-dir', type=str, default='csv_data',
-                       help='Directory containing CSV files')
+                       help='Directory containing trace files')
     parser.add_argument('--output-dir', type=str, default='animations',
                        help='Output directory for animations')
     parser.add_argument('--speed', type=float, default=1.0,
@@ -596,13 +599,12 @@ def main():
     if args.file:
         csv_files = [args.file]
     else:
-        import glob
-        csv_files = glob.glob(os.path.join(args.csv_dir, '*.csv'))
+        csv_files = [str(f) for f in find_traces(args.csv_dir)]
         if not csv_files:
-            print(f"No CSV files found in {args.csv_dir}/")
+            print(f"No trace files found in {args.csv_dir}/")
             return
     
-    print(f"\nFound {len(csv_files)} CSV file(s) to animate\n")
+    print(f"\nFound {len(csv_files)} trace file(s) to animate\n")
     
     for csv_file in sorted(csv_files):
         print(f"\n{'='*70}")
@@ -0,0 +1,252 @@
+"""
+Python bindings of the C batch engine (FreeFall_Object/code/freefall_api.h)
+
+Loads the freefall shared library with ctypes and runs scenarios on NumPy buffers owned by
+Python: scenario records are read in place (a memory-mapped scenario table can be passed as
+is), the batch state lives in a NumPy array and the engine writes traces straight into NumPy
+arrays. Nothing is copied and nothing goes through CSV files, and the physics and PID are the
+ones of the C simulation (100 kg train, 3000 N force limit, 100 m track).
+
+Build the library first (from FreeFall_Object/):
+  cmake -S code -B build && cmake --build build       # build/lib/libfreefall.so
+Set FREEFALL_LIB to load it from another path.
+
+Usage:
+  import freefall_native as ff
+  records = ff.make_records(angle, ball_x, ball_y, train_x)      # one structured array
+  result = ff.run_scenarios(records, steps=2000, traces=('position', 'force'))
+  result.landing_error                                           # (count,) % of the track
+  result.traces['position']                                      # (steps, count) m
+
+  with ff.Batch(records, model='trapezoidal') as batch:          # step by step
+      batch.state['setpoint'][:] = 50.0                          # state arrays are views
+      position = batch.step(100, traces=('position',))['position']
+"""
+import ctypes
+import os
+import sys
+from collections import namedtuple
+from pathlib import Path
+
+import numpy as np
+
+# Must match FREEFALL_API_VERSION in freefall_api.h
+API_VERSION = 1
+
+# Engine constants (main.c, scenario.h)
+DT = 0.02                       # Time step (s) - 50 Hz control rate
+GRAVITY = 9.81                  # m/s²
+MAX_POSITION = 100.0            # Track length (m), 100%
+CATCH_TOLERANCE = 1.0           # Catch radius at landing (% of the track)
+ENGINE_GAINS = (500.0, 50.0, 200.0)  # PARAMS_PID: Kp, Ki, Kd
+
+# ScenarioRecord (scenario.h), also the record layout of binary scenario tables
+SCENARIO_RECORD = np.dtype([('landing_angle', '<f8'), ('ball_x_position', '<f8'),
+                            ('ball_y_initial', '<f8'), ('train_x_initial', '<f8'),
+                            ('Kp', '<f8'), ('Ki', '<f8'), ('Kd', '<f8'),
+                            ('model', '<u4'), ('reserved', '<u4')])
+SCENARIO_MODELS = {'euler': 0, 'trapezoidal': 1, 'simplified': 2, 'adaptive': 3}
+
+# FreefallTraces fields and the batch state arrays, in C order
+TRACE_NAMES = ('position', 'velocity', 'force', 'error', 'integral')
+STATE_NAMES = ('position', 'velocity', 'position_pct', 'setpoint', 'applied_force',
+               'previous_net_force', 'gravity_force', 'integral', 'previous_error', 'Kp', 'Ki', 'Kd')
+
+ERROR_NAMES = {1: 'ERROR_NULL_POINTER', 2: 'ERROR_INVALID_PARAMETER', 3: 'ERROR_CALLBACK_FAILED'}
+
+_double_p = ctypes.POINTER(ctypes.c_double)
+
+
+class FreefallTraces(ctypes.Structure):
+    _fields_ = [(name, _double_p) for name in TRACE_NAMES]
+
+
+def _library_candidates():
+    if os.environ.get('FREEFALL_LIB'):
+        yield Path(os.environ['FREEFALL_LIB'])
+    root = Path(__file__).resolve().parent.parent
+    if sys.platform == 'win32':
+        names = [Path('bin') / 'freefall.dll', Path('bin') / 'Release' / 'freefall.dll',
+                 Path('bin') / 'Debug' / 'freefall.dll']
+    elif sys.platform == 'darwin':
+        names = [Path('lib') / 'libfreefall.dylib']
+    else:
+        names = [Path('lib') / 'libfreefall.so']
+    for build in (root / 'build', root / 'code' / 'build'):
+        for name in names:
+            yield build / name
+
+
+def _load_library():
+    for path in _library_candidates():
+        if path.exists():
+            lib = ctypes.CDLL(str(path))
+            break
+    else:
+        raise OSError("freefall shared library not found: build it with "
+                      "'cmake -S code -B build && cmake --build build' or set FREEFALL_LIB")
+
+    lib.freefallApiVersion.restype = ctypes.c_int
+    lib.freefallBatchStorageSize.argtypes = [ctypes.c_int]
+    lib.freefallBatchStorageSize.restype = ctypes.c_size_t
+    lib.freefallBatchStride.argtypes = [ctypes.c_int]
+    lib.freefallBatchStride.restype = ctypes.c_size_t
+    lib.freefallBatchCreate.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_uint32, _double_p,
+                                        ctypes.POINTER(ctypes.c_void_p)]
+    lib.freefallBatchCreate.restype = ctypes.c_int
+    lib.freefallBatchStep.argtypes = [ctypes.c_void_p, ctypes.c_double, ctypes.c_int,
+                                      ctypes.POINTER(FreefallTraces)]
+    lib.freefallBatchStep.restype = ctypes.c_int
+    lib.freefallBatchDestroy.argtypes = [ctypes.c_void_p]
+    lib.freefallBatchDestroy.restype = None
+    lib.freefallRunScenarios.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_uint32, _double_p,
+                                         ctypes.c_double, ctypes.c_int, ctypes.POINTER(FreefallTraces),
+                                         _double_p]
+    lib.freefallRunScenarios.restype = ctypes.c_int
+
+    version = lib.freefallApiVersion()
+    if version != API_VERSION:
+        raise OSError(f"{path} has API version {version}, these bindings expect {API_VERSION}")
+    return lib
+
+
+_lib = None
+
+
+def library():
+    """The loaded shared library (loaded on first use)"""
+    global _lib
+    if _lib is None:
+        _lib = _load_library()
+    return _lib
+
+
+def _check(code, what):
+    if code != 0:
+        raise RuntimeError(f"{what} failed: {ERROR_NAMES.get(code, code)}")
+
+
+def _pointer(array):
+    """double* to the data of a C-contiguous float64 array (never a copy)"""
+    if array.dtype != np.float64 or not array.flags['C_CONTIGUOUS'] or not array.flags['WRITEABLE']:
+        raise ValueError("buffers must be writeable C-contiguous float64 arrays")
+    return array.ctypes.data_as(_double_p)
+
+
+def _records_pointer(records):
+    if records.dtype != SCENARIO_RECORD or records.ndim != 1 or not records.flags['C_CONTIGUOUS']:
+        raise ValueError("records must be a contiguous 1-D array of SCENARIO_RECORD")
+    if len(records) == 0:
+        raise ValueError("records is empty")
+    return ctypes.c_void_p(records.ctypes.data)
+
+
+def _model_index(model):
+    return SCENARIO_MODELS[model] if isinstance(model, str) else int(model)
+
+
+def make_records(angle, ball_x, ball_y, train_x, gains=ENGINE_GAINS, model='euler'):
+    """Scenario records from per-scenario arrays (degrees, m); gains are one (Kp, Ki, Kd) or per scenario"""
+    angle = np.atleast_1d(np.asarray(angle, dtype=np.float64))
+    records = np.zeros(len(angle), dtype=SCENARIO_RECORD)
+    records['landing_angle'] = angle
+    records['ball_x_position'] = ball_x
+    records['ball_y_initial'] = ball_y
+    records['train_x_initial'] = train_x
+    gains = np.asarray(gains, dtype=np.float64)
+    records['Kp'], records['Ki'], records['Kd'] = gains[..., 0], gains[..., 1], gains[..., 2]
+    records['model'] = _model_index(model)
+    return records
+
+
+def aligned_empty(size, alignment=64):
+    """Uninitialized float64 array whose data starts on an `alignment`-byte boundary"""
+    raw = np.empty(size + alignment // 8, dtype=np.float64)
+    offset = (-raw.ctypes.data % alignment) // 8
+    return raw[offset:offset + size]
+
+
+def trace_buffers(names, steps, count):
+    """Preallocated (steps, count) arrays for the named traces"""
+    unknown = set(names) - set(TRACE_NAMES)
+    if unknown:
+        raise ValueError(f"unknown traces {sorted(unknown)}, expected {TRACE_NAMES}")
+    return {name: np.empty((steps, count), dtype=np.float64) for name in names}
+
+
+def _traces_struct(buffers, steps, count):
+    traces = FreefallTraces()
+    for name, array in buffers.items():
+        if array.shape != (steps, count):
+            raise ValueError(f"trace '{name}' must have shape {(steps, count)}")
+        setattr(traces, name, _pointer(array))
+    return traces
+
+
+class Batch:
+    """Scenarios stepped together by the C batch engine, state held in a NumPy array
+
+    `state[name]` are views into the batch storage (STATE_NAMES): reading them shows the live
+    state, writing them (e.g. a new setpoint) changes the next step.
+    """
+
+    def __init__(self, records, model='euler'):
+        lib = library()
+        self.records = records
+        self.count = len(records)
+        self.storage = aligned_empty(lib.freefallBatchStorageSize(self.count))
+        self._handle = ctypes.c_void_p()
+        _check(lib.freefallBatchCreate(_records_pointer(records), self.count, _model_index(model),
+                                       _pointer(self.storage), ctypes.byref(self._handle)),
+               'freefallBatchCreate')
+        stride = lib.freefallBatchStride(self.count)
+        self.state = {name: self.storage[a * stride:a * stride + self.count]
+                      for a, name in enumerate(STATE_NAMES)}
+
+    def step(self, steps, dt=DT, traces=(), out=None):
+        """Advance `steps` steps; returns the traces (new arrays, or the `out` dict of arrays)"""
+        if self._handle is None:
+            raise ValueError("batch is closed")
+        buffers = out if out is not None else trace_buffers(traces, steps, self.count)
+        struct = _traces_struct(buffers, steps, self.count)
+        _check(library().freefallBatchStep(self._handle, dt, steps, ctypes.byref(struct)), 'freefallBatchStep')
+        return buffers
+
+    def close(self):
+        if self._handle is not None:
+            library().freefallBatchDestroy(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+RunResult = namedtuple('RunResult', ['landing_error', 'traces', 'state'])
+
+
+def run_scenarios(records, steps, dt=DT, model='euler', traces=(), out=None):
+    """Run scenarios from rest for `steps` steps in one call
+
+    Returns RunResult(landing_error, traces, state): the error at the landing
+    time, interpolated within the step (% of the track, NaN if the ball lands
+    after the last step; caught if abs(error) <= CATCH_TOLERANCE), the requested
+    (steps, count) traces and the final state.
+    """
+    count = len(records)
+    lib = library()
+    storage = aligned_empty(lib.freefallBatchStorageSize(count))
+    landing_error = np.empty(count, dtype=np.float64)
+    buffers = out if out is not None else trace_buffers(traces, steps, count)
+    struct = _traces_struct(buffers, steps, count)
+    _check(lib.freefallRunScenarios(_records_pointer(records), count, _model_index(model), _pointer(storage),
+                                    dt, steps, ctypes.byref(struct), _pointer(landing_error)),
+           'freefallRunScenarios')
+    stride = lib.freefallBatchStride(count)
+    state = {name: storage[a * stride:a * stride + count] for a, name in enumerate(STATE_NAMES)}
+    return RunResult(landing_error, buffers, state)
@@ -1,182 +1,202 @@
 """
-Generate 10 random PID control scenarios with varied initial conditions
+Generate random PID control scenarios with varied initial conditions
+
+Scenarios come from the same counter-based Philox4x32-10 generator as the C engine
+(common/philox.h, scenario.c): scenario k of a batch depends only on (seed, k), so
+`--seed 42` here and `freefall_object --seed 42` describe the same scenarios. They are
+simulated by the C batch engine through freefall_native.py (same train, physics and PID as
+freefall_object), in one call for the whole batch.
+
+Binary scenario tables (freefall_object --scenario-file / --write-scenarios), little-endian:
+  magic "ACSSCN1\\0", uint32 headerSize, uint32 recordSize, uint64 recordCount, uint64 seed,
+  recordCount x {f64 angle, ball_x, ball_y, train_x, Kp, Ki, Kd, uint32 model, uint32 reserved}
+
+Usage:
+  python generate_random_scenarios.py                        # simulate 10 scenarios (seed 42)
+  python generate_random_scenarios.py --count 1000000 --write-table scenarios.scn
+  python generate_random_scenarios.py --table scenarios.scn --count 10
 """
+import argparse
+import struct
 import numpy as np
 import pandas as pd
-import random
 from pathlib import Path
 
-# Constants
-g = 9.81  # gravity (m/s^2)
-dt = 0.02  # time step (s) - 50Hz
-simulation_time = 40.0  # seconds
+import freefall_native
+from freefall_native import SCENARIO_RECORD, SCENARIO_MODELS, DT, GRAVITY, CATCH_TOLERANCE
+
+simulation_time = 40.0  # seconds (t_end in main.c)
+
+# Scenario table layout (FreeFall_Object/code/scenario.h)
+SCENARIO_TABLE_MAGIC = b'ACSSCN1\x00'
+SCENARIO_TABLE_HEADER = struct.Struct('<8sIIQQ')
+
+# Engine defaults stored in generated tables (PARAMS_PID in main.c)
+TABLE_GAINS = freefall_native.ENGINE_GAINS
+
+PHILOX_M0, PHILOX_M1 = 0xD2511F53, 0xCD9E8D57
+PHILOX_W0, PHILOX_W1 = 0x9E3779B9, 0xBB67AE85
+MASK32 = 0xFFFFFFFF
 
-# PID gains (tuned for the system)
-Kp = 45.0
-Ki = 0.5
-Kd = 25.0
 
-# System parameters
-m = 10.0  # train mass (kg)
-mu = 0.1  # friction coefficient
+def philox4x32(counter, seed):
+    """Philox4x32-10 block for counter k (stream 0) and a 64-bit key, as in common/philox.h
 
-def simulate_scenario(angle_deg, ball_x, ball_y_initial, train_x_initial, scenario_num):
+    `counter` is a Python int or a NumPy uint64 array; returns the four 32-bit outputs.
     """
-    Simulate one PID control scenario
-    
-    Args:
-        angle_deg: Landing surface angle in degrees (0-45)
-        ball_x: Ball's fixed X position where it falls (m)
-        ball_y_initial: Ball's initial height (m)
-        train_x_initial: Train's initial X position on the incline (m)
-        scenario_num: Scenario number for filename
+    if isinstance(counter, np.ndarray):
+        lift = np.uint64
+        counter = counter.astype(np.uint64)
+    else:
+        lift = int
+    mask, shift = lift(MASK32), lift(32)
+    c0, c1 = counter & mask, counter >> shift
+    c2, c3 = counter & lift(0), counter & lift(0)
+    k0, k1 = seed & MASK32, (seed >> 32) & MASK32
+    for round_index in range(10):
+        if round_index > 0:
+            k0 = (k0 + PHILOX_W0) & MASK32
+            k1 = (k1 + PHILOX_W1) & MASK32
+        p0 = lift(PHILOX_M0) * c0
+        p1 = lift(PHILOX_M1) * c2
+        c0, c1, c2, c3 = ((p1 >> shift) ^ c1 ^ lift(k0), p1 & mask,
+                          (p0 >> shift) ^ c3 ^ lift(k1), p0 & mask)
+    return c0, c1, c2, c3
+
+
+def generate_scenarios(count, seed, first=0):
+    """Scenarios [first, first + count) of a batch as arrays (angle, ball_x, ball_y, train_x)"""
+    index = np.arange(first, first + count, dtype=np.uint64)
+    u = [np.asarray(v, dtype=np.float64) * (1.0 / 4294967296.0) for v in philox4x32(index, seed)]
+    angle = u[0] * 45.0                      # 0° to 45°
+    ball_x = 20.0 + u[1] * 80.0              # 20 m to 100 m
+    ball_y = 30.0 + u[2] * 70.0              # 30 m to 100 m
+    train_x = u[3] * np.maximum(ball_x - 20.0, 0.0)  # 0 m to (ball_x - 20 m)
+    return angle, ball_x, ball_y, train_x
+
+
+def write_scenario_table(path, count, seed, gains=TABLE_GAINS, model='euler', block=1 << 20):
+    """Write a binary scenario table the C engine can run with --scenario-file"""
+    Kp, Ki, Kd = gains
+    with open(path, 'wb') as f:
+        f.write(SCENARIO_TABLE_HEADER.pack(SCENARIO_TABLE_MAGIC, SCENARIO_TABLE_HEADER.size,
+                                           SCENARIO_RECORD.itemsize, count, seed))
+        for first in range(0, count, block):
+            n = min(block, count - first)
+            records = np.zeros(n, dtype=SCENARIO_RECORD)
+            (records['landing_angle'], records['ball_x_position'],
+             records['ball_y_initial'], records['train_x_initial']) = generate_scenarios(n, seed, first)
+            records['Kp'], records['Ki'], records['Kd'] = Kp, Ki, Kd
+            records['model'] = SCENARIO_MODELS[model]
+            records.tofile(f)
+
+
+def read_scenario_table(path):
+    """Memory-map a scenario table: returns (records, seed) with records a structured array"""
+    with open(path, 'rb') as f:
+        magic, header_size, record_size, count, seed = SCENARIO_TABLE_HEADER.unpack(
+            f.read(SCENARIO_TABLE_HEADER.size))
+    if magic != SCENARIO_TABLE_MAGIC or record_size != SCENARIO_RECORD.itemsize:
+        raise ValueError(f"{path} is not a scenario table")
+    if count == 0:
+        return np.zeros(0, dtype=SCENARIO_RECORD), seed
+    return np.memmap(path, dtype=SCENARIO_RECORD, mode='r', offset=header_size, shape=(count,)), seed
+
+def simulate_scenarios(records, model='euler'):
+    """Simulate every record with the C batch engine and save one CSV per scenario
+
+    Returns the output paths and the landing errors (% of the track, NaN: the ball lands after
+    the end of the run).
     """
-    angle_rad = np.deg2rad(angle_deg)
-    
-    # Calculate train's initial Y position (on the inclined surface)
-    train_y_initial = train_x_initial * np.tan(angle_rad)
-    
-    # Time array
-    num_steps = int(simulation_time / dt)
-    time_array = np.arange(0, num_steps) * dt
-    
-    # Initialize arrays
-    train_position = np.zeros(num_steps)
-    train_velocity = np.zeros(num_steps)
-    train_acceleration = np.zeros(num_steps)
-    ball_position = np.zeros(num_steps)  # Ball Y position (height)
-    applied_force = np.zeros(num_steps)
-    error_values = np.zeros(num_steps)
-    error_derivative_values = np.zeros(num_steps)
-    error_integral_values = np.zeros(num_steps)
-    
-    # Initial conditions
-    train_position[0] = train_x_initial
-    train_velocity[0] = 0.0
-    ball_position[0] = ball_y_initial
-    
-    # PID state
-    error_integral = 0.0
-    previous_error = ball_x - train_position[0]
-    
-    # Simulation loop
-    for i in range(num_steps):
-        # Ball falls with gravity
-        ball_position[i] = ball_y_initial - 0.5 * g * (time_array[i] ** 2)
-        
-        # Stop ball if it reaches the ground at its X position
-        ball_landing_y = ball_x * np.tan(angle_rad)
-        if ball_position[i] <= ball_landing_y:
-            ball_position[i] = ball_landing_y
-        
-        # Calculate error (horizontal distance)
-        current_error = ball_x - train_position[i]
-        error_values[i] = current_error
-        
-        # PID control
-        error_integral += current_error * dt
-        error_derivative = (current_error - previous_error) / dt
-        
-        error_derivative_values[i] = error_derivative
-        error_integral_values[i] = error_integral
-        
-        # Control force
-        F_control = Kp * current_error + Ki * error_integral + Kd * error_derivative
-        
-        # Physics: Forces on incline
-        # Normal force: N = m*g*cos(angle)
-        N = m * g * np.cos(angle_rad)
-        
-        # Friction force (opposes motion)
-        if train_velocity[i] > 0.01:
-            F_friction = -mu * N
-        elif train_velocity[i] < -0.01:
-            F_friction = mu * N
-        else:
-            F_friction = 0.0
-        
-        # Gravity component along incline (down the slope)
-        F_gravity = -m * g * np.sin(angle_rad)
-        
-        # Net force
-        F_net = F_control + F_friction + F_gravity
-        applied_force[i] = F_control
-        
-        # Acceleration
-        acceleration = F_net / m
-        train_acceleration[i] = acceleration
-        
-        # Update velocity and position for next step
-        if i < num_steps - 1:
-            train_velocity[i + 1] = train_velocity[i] + acceleration * dt
-            train_position[i + 1] = train_position[i] + train_velocity[i + 1] * dt
-            
-            # Keep train on the surface (X >= 0)
-            if train_position[i + 1] < 0:
-                train_position[i + 1] = 0
-                train_velocity[i + 1] = 0
-        
-        previous_error = current_error
-    
-    # Create DataFrame
-    df = pd.DataFrame({
-        'time': time_array,
-        'train_position': train_position,
-        'falling_object_position': ball_position,
-        'applied_force': applied_force,
-        'train_velocity': train_velocity,
-        'train_acceleration': train_acceleration,
-        'error_derivative': error_derivative_values,
-        'error_integral': error_integral_values
-    })
-    
-    # Save to CSV
+    steps = int(round(simulation_time / DT))
+    result = freefall_native.run_scenarios(records, steps, DT, model,
+                                           traces=('position', 'velocity', 'force', 'error', 'integral'))
+    traces = result.traces
+    time_array = np.arange(1, steps + 1) * DT  # Trace row k is the state after step k
+
+    # Ball free fall at its fixed X, stopped on the landing surface
+    angle_rad = np.deg2rad(records['landing_angle'])
+    ball_landing_y = records['ball_x_position'] * np.tan(angle_rad)
+    ball_position = records['ball_y_initial'] - 0.5 * GRAVITY * time_array[:, None] ** 2
+    ball_position = np.maximum(ball_position, ball_landing_y)
+
+    # Rates of the traced state (the initial state is at rest, error = setpoint - start)
+    initial_error = records['ball_x_position'] - records['train_x_initial']
+    train_acceleration = np.diff(traces['velocity'], axis=0, prepend=0.0) / DT
+    error_derivative = np.diff(traces['error'], axis=0, prepend=initial_error[None, :]) / DT
+
     output_dir = Path('csv_data')
     output_dir.mkdir(exist_ok=True)
-    
-    filename = f'Random_S{scenario_num:02d}_A{int(angle_deg):02d}_BallX{int(ball_x):03d}Y{int(ball_y_initial):03d}_TrainX{int(train_x_initial):03d}.csv'
-    output_path = output_dir / filename
-    
-    df.to_csv(output_path, index=False)
-    
-    print(f"✓ Generated: {filename}")
-    print(f"  Angle: {angle_deg:.1f}°, Ball: ({ball_x:.1f}m, {ball_y_initial:.1f}m), Train start: {train_x_initial:.1f}m")
-    
-    return output_path
+    paths = []
+    for i, record in enumerate(records):
+        angle_deg, ball_x = record['landing_angle'], record['ball_x_position']
+        ball_y_initial, train_x_initial = record['ball_y_initial'], record['train_x_initial']
+        df = pd.DataFrame({
+            'time': time_array,
+            'train_position': traces['position'][:, i],
+            'falling_object_position': ball_position[:, i],
+            'applied_force': traces['force'][:, i],
+            'train_velocity': traces['velocity'][:, i],
+            'train_acceleration': train_acceleration[:, i],
+            'error_derivative': error_derivative[:, i],
+            'error_integral': traces['integral'][:, i]
+        })
+
+        filename = (f'Random_S{i + 1:02d}_A{int(angle_deg):02d}_BallX{int(ball_x):03d}Y{int(ball_y_initial):03d}'
+                    f'_TrainX{int(train_x_initial):03d}.csv')
+        output_path = output_dir / filename
+        df.to_csv(output_path, index=False)
+        paths.append(output_path)
+
+        error = result.landing_error[i]
+        outcome = 'caught' if abs(error) <= CATCH_TOLERANCE else 'missed'
+        print(f"\n[Scenario {i + 1}/{len(records)}]")
+        print(f"✓ Generated: {filename}")
+        print(f"  Angle: {angle_deg:.1f}°, Ball: ({ball_x:.1f}m, {ball_y_initial:.1f}m), "
+              f"Train start: {train_x_initial:.1f}m, landing error {error:+.2f}% ({outcome})")
+
+    return paths, result.landing_error
 
 def main():
-    """Generate 10 random scenarios"""
+    """Generate random scenarios (or a scenario table) and simulate them"""
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('--count', type=int, default=10, help='number of scenarios (default 10)')
+    parser.add_argument('--seed', type=int, default=42, help='batch seed (default 42)')
+    parser.add_argument('--write-table', metavar='PATH', help='write a binary scenario table and exit')
+    parser.add_argument('--model', choices=sorted(SCENARIO_MODELS), default='euler',
+                        help='model of generated scenarios (default euler; adaptive: tables only, '
+                             'the batch engine has no adaptive kernel)')
+    parser.add_argument('--table', metavar='PATH', help='simulate the first --count scenarios of a table')
+    args = parser.parse_args()
+
+    if args.write_table:
+        write_scenario_table(args.write_table, args.count, args.seed, model=args.model)
+        print(f"✓ Wrote {args.count} scenarios (seed {args.seed}) to {args.write_table}")
+        return
+
+    if args.table:
+        table, seed = read_scenario_table(args.table)
+        records = np.ascontiguousarray(table[:args.count])
+        source = f"{args.table} (seed {seed})"
+    else:
+        angle, ball_x, ball_y, train_x = generate_scenarios(args.count, args.seed)
+        records = freefall_native.make_records(angle, ball_x, ball_y, train_x, gains=TABLE_GAINS,
+                                               model=args.model)
+        source = f"seed {args.seed}"
+    count = len(records)
+    model = int(records['model'][0]) if count else SCENARIO_MODELS[args.model]
+    if model == SCENARIO_MODELS['adaptive']:
+        parser.error("the adaptive model cannot be simulated by the batch engine (use freefall_object)")
+
     print("="*70)
-    print("Generating 10 Random PID Control Scenarios")
+    print(f"Generating {count} Random PID Control Scenarios ({source})")
     print("="*70)
-    print()
-    
-    random.seed(42)  # For reproducibility
-    np.random.seed(42)
-    
-    scenarios = []
-    
-    for i in range(10):
-        # Random angle: 0° to 45°
-        angle = random.uniform(0, 45)
-        
-        # Random ball X position: 20m to 100m
-        ball_x = random.uniform(20, 100)
-        
-        # Random ball initial height: 30m to 100m
-        ball_y_initial = random.uniform(30, 100)
-        
-        # Random train initial X: 0m to (ball_x - 20m) to ensure some distance
-        max_train_x = max(0, ball_x - 20)
-        train_x_initial = random.uniform(0, max_train_x)
-        
-        print(f"\n[Scenario {i+1}/10]")
-        output_path = simulate_scenario(angle, ball_x, ball_y_initial, train_x_initial, i+1)
-        scenarios.append(output_path)
-    
+
+    scenarios, landing_error = simulate_scenarios(records, model=model)
+    caught = int(np.sum(np.abs(landing_error) <= CATCH_TOLERANCE))
     print()
     print("="*70)
-    print(f"✓ Successfully generated {len(scenarios)} scenario files")
+    print(f"✓ Successfully generated {len(scenarios)} scenario files ({caught} caught)")
     print(f"  Output directory: csv_data/")
     print("="*70)
 
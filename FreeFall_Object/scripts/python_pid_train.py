@@ -16,6 +16,12 @@ import matplotlib.animation as animation
 import numpy as np
 import random
 
+import freefall_native as ff
+
+# The train is simulated by the C batch engine (freefall_native.py, build FreeFall_Object/code
+# first): the same 100 kg train, 3000 N force limit, 100 m track and PID as freefall_object.
+# Positions are horizontal X coordinates on the track; the rail rises with the incline.
+
 ###############################################################################
 
 # ONLY CHANGE THESE INPUTS FOR THE CODE TO WORK PROPERLY
@@ -23,8 +29,7 @@ import random
 # Initialize input values
 trials=3
 incl_angle=np.pi/6*1 # Keep the angle between 0 and +pi/6 radians
-g=10
-mass_cart=100 # [kg]
+g=ff.GRAVITY
 
 # Tune the constants
 K_p=300
@@ -33,20 +38,19 @@ K_i=10
 ###############################################################################
 
 trials_global=trials
+track=ff.MAX_POSITION
 
 # Generate random x-positions for a falling cube
 def set_x_ref(incl_angle):
-    rand_h=random.uniform(0,120)
-    rand_v=random.uniform(20+120*np.tan(incl_angle)+6.5,40+120*np.tan(incl_angle)+6.5)
+    rand_h=random.uniform(0,track)
+    rand_v=random.uniform(20+track*np.tan(incl_angle)+6.5,40+track*np.tan(incl_angle)+6.5)
     return rand_h,rand_v
 
-dt=0.02
+dt=ff.DT
 t0=0
 t_end=5
 t=np.arange(t0,t_end+dt,dt)
 
-F_g=-mass_cart*g
-
 displ_rail=np.zeros((trials,len(t)))
 v_rail=np.zeros((trials,len(t)))
 a_rail=np.zeros((trials,len(t)))
@@ -59,15 +63,13 @@ e_int=np.zeros((trials,len(t)))
 pos_x_cube=np.zeros((trials,len(t)))
 pos_y_cube=np.zeros((trials,len(t)))
 
-F_ga_t=F_g*np.sin(incl_angle) # Tangential component of the gravity force
-init_pos_x=120
-init_pos_y=120*np.tan(incl_angle)+6.5
-init_displ_rail=(init_pos_x**2+init_pos_y**2)**(0.5)
-init_vel_rail=0
-init_a_rail=0
-
+init_pos_x=track
 init_pos_x_global=init_pos_x # Used for determining the dimensions of the animation window.
 
+# One train, kept running from trial to trial: each new cube only moves the setpoint
+train=ff.Batch(ff.make_records(np.rad2deg(incl_angle),init_pos_x,0.0,init_pos_x,
+                               gains=(K_p,K_i,K_d),model='trapezoidal'),model='trapezoidal')
+
 trials_magn=trials
 history=np.ones(trials)
 while(trials>0): # Determines how many times cube falls down
@@ -79,35 +81,25 @@ while(trials>0): # Determines how many times cube falls down
     win=False
     delta=1
 
-    # Implement PID for the train position
-    for i in range(1,len(t)):
-        # Insert the initial values into the beginning of the predefined arrays.
-        if i==1:
-            displ_rail[times][0]=init_displ_rail
-            pos_x_train[times][0]=init_pos_x
-            pos_y_train[times][0]=init_pos_y
-            v_rail[times][0]=init_vel_rail
-            a_rail[times][0]=init_a_rail
-
-        # Compute the horizontal error
-        e[times][i-1]=pos_x_cube_ref-pos_x_train[times][i-1]
-
-        if i>1:
-            e_dot[times][i-1]=(e[times][i-1]-e[times][i-2])/dt
-            e_int[times][i-1]=e_int[times][i-2]+(e[times][i-2]+e[times][i-1])/2*dt
-        if i==len(t)-1:
-            e[times][-1]=e[times][-2]
-            e_dot[times][-1]=e_dot[times][-2]
-            e_int[times][-1]=e_int[times][-2]
-
-        F_a=K_p*e[times][i-1]+K_d*e_dot[times][i-1]+K_i*e_int[times][i-1]
-        F_net=F_a+F_ga_t
-        a_rail[times][i]=F_net/mass_cart
-        v_rail[times][i]=v_rail[times][i-1]+(a_rail[times][i-1]+a_rail[times][i])/2*dt
-        displ_rail[times][i]=displ_rail[times][i-1]+(v_rail[times][i-1]+v_rail[times][i])/2*dt
-        pos_x_train[times][i]=displ_rail[times][i]*np.cos(incl_angle)
-        pos_y_train[times][i]=displ_rail[times][i]*np.sin(incl_angle)+6.5
+    # Initial values: where the previous trial left the train
+    displ_rail[times][0]=train.state['position'][0]
+    v_rail[times][0]=train.state['velocity'][0]
+    e[times][0]=pos_x_cube_ref-displ_rail[times][0]
+    e_int[times][0]=train.state['integral'][0]
+
+    # PID for the train position, run by the C engine
+    train.state['setpoint'][0]=pos_x_cube_ref/track*100.0
+    run=train.step(len(t)-1,dt,traces=('position','velocity','error','integral'))
+    displ_rail[times][1:]=run['position'][:,0]
+    v_rail[times][1:]=run['velocity'][:,0]
+    e[times][1:]=run['error'][:,0]*track/100.0
+    e_int[times][1:]=run['integral'][:,0]*track/100.0
+    a_rail[times][1:]=np.diff(v_rail[times])/dt
+    e_dot[times][1:]=np.diff(e[times])/dt
+    pos_x_train[times]=displ_rail[times]
+    pos_y_train[times]=displ_rail[times]*np.tan(incl_angle)+6.5
 
+    for i in range(1,len(t)):
         # Try to catch it
         if (pos_x_train[times][i]-5<pos_x_cube[times][i]+3 and pos_x_train[times][i]+5>pos_x_cube[times][i]-3) or win==True:
             if (pos_y_train[times][i]+3<pos_y_cube[times][i]-2 and pos_y_train[times][i]+8>pos_y_cube[times][i]+2) or win==True:
@@ -118,14 +110,9 @@ while(trials>0): # Determines how many times cube falls down
                 pos_x_cube[times][i]=pos_x_train[times][i]-change
                 pos_y_cube[times][i]=pos_y_train[times][i]+5
 
-
-    init_displ_rail=displ_rail[times][-1]
-    init_pos_x=pos_x_train[times][-1]+v_rail[times][-1]*np.cos(incl_angle)*dt
-    init_pos_y=pos_y_train[times][-1]+v_rail[times][-1]*np.sin(incl_angle)*dt
-    init_vel_rail=v_rail[times][-1]
-    init_a_rail=a_rail[times][-1]
     history[times]=delta
     trials=trials-1
+train.close()
 
 ############################## ANIMATION #################################
 len_t=len(t)
@@ -174,12 +161,13 @@ gs=gridspec.GridSpec(4,3)
 # Create main window
 ax_main=fig.add_subplot(gs[0:3,0:2],facecolor=(0.9,0.9,0.9))
 plt.xlim(0,init_pos_x_global)
-plt.ylim(0,init_pos_x_global)
+window_y=init_pos_x_global*np.tan(incl_angle)+50 # Highest cube start plus margin
+plt.ylim(0,window_y)
 plt.xticks(np.arange(0,init_pos_x_global+1,10))
-plt.yticks(np.arange(0,init_pos_x_global+1,10))
+plt.yticks(np.arange(0,window_y+1,10))
 plt.grid(True)
 
-copyright=ax_main.text(0,122,'© Mark Misin Engineering',size=12)
+copyright=ax_main.text(0,window_y+2,'© Mark Misin Engineering',size=12)
 
 rail=ax_main.plot([0,init_pos_x_global],[5,init_pos_x_global*np.tan(incl_angle)+5],'k',linewidth=6)
 platform,=ax_main.plot([],[],'b',linewidth=18)
@@ -193,7 +181,7 @@ again=ax_main.text(30,60,'',size='20',color='r',bbox=bbox_props_again)
 
 # Plot windows
 ax1v=fig.add_subplot(gs[0,2],facecolor=(0.9,0.9,0.9))
-displ_rail_f,=ax1v.plot([],[],'-b',linewidth=2,label='displ. on rails [m]')
+displ_rail_f,=ax1v.plot([],[],'-b',linewidth=2,label='position on the track [m]')
 plt.xlim(t0,t_end)
 plt.ylim(np.min(displ_rail)-abs(np.min(displ_rail))*0.1,np.max(displ_rail)+abs(np.max(displ_rail))*0.1)
 plt.grid(True)
@@ -0,0 +1,198 @@
+"""
+Readers for simulation trace files written by common/tracewriter.c
+
+Supports the output formats of the C simulation:
+  - .trc  binary traces (float64 or float32 rows), memory-mapped with NumPy
+  - .trz  packed float32 traces (--trace-format packed), decoded block by block,
+          with an optional memory-mapped animation stream
+  - .csv  text traces (--trace-format csv)
+and the per-batch KPI summary (csv_data/batch_summary.json).
+
+Binary layout (little-endian):
+  magic "ACSTRC1\\0", uint32 headerSize, uint32 columnCount, uint32 valueSize,
+  uint32 reserved, uint64 rowCount, columnCount x 32-byte column names, rows
+
+Packed layout (see common/tracewriter.h):
+  magic "ACSTRZ1\\0", uint32 headerSize, uint32 columnCount, uint32 blockRows,
+  uint32 blockCount, uint64 rowCount, uint64 animationOffset, uint32 animationFrames,
+  float32 animationInterval, column names, blocks (uint32 rows, uint32 payloadSize, payload),
+  animation frames (float32 rows)
+"""
+
+import json
+import struct
+from pathlib import Path
+
+import numpy as np
+import pandas as pd
+
+TRACE_MAGIC = b'ACSTRC1\x00'
+TRACE_HEADER = struct.Struct('<8sIIIIQ')
+TRACE_PACKED_MAGIC = b'ACSTRZ1\x00'
+TRACE_PACKED_HEADER = struct.Struct('<8sIIIIQQIf')
+TRACE_BLOCK_HEADER = struct.Struct('<II')
+TRACE_COLUMN_NAME_SIZE = 32
+TRACE_EXTENSIONS = ('.trc', '.trz', '.csv')
+BATCH_SUMMARY_NAME = 'batch_summary.json'
+
+
+def _column_names(names_raw, column_count):
+    return [names_raw[i * TRACE_COLUMN_NAME_SIZE:(i + 1) * TRACE_COLUMN_NAME_SIZE]
+            .split(b'\x00', 1)[0].decode('ascii') for i in range(column_count)]
+
+
+def read_trace_header(path):
+    """Return (column_names, value_dtype, header_size, row_count) of a binary trace"""
+    with open(path, 'rb') as f:
+        fixed = f.read(TRACE_HEADER.size)
+        magic, header_size, column_count, value_size, _, row_count = TRACE_HEADER.unpack(fixed)
+        if magic != TRACE_MAGIC:
+            raise ValueError(f"{path} is not a trace file (bad magic)")
+        names_raw = f.read(column_count * TRACE_COLUMN_NAME_SIZE)
+    names = _column_names(names_raw, column_count)
+    dtype = np.dtype('<f8') if value_size == 8 else np.dtype('<f4')
+
+    # A trace whose writer did not finish still has rowCount 0: use the file size instead
+    row_bytes = column_count * value_size
+    rows_on_disk = (Path(path).stat().st_size - header_size) // row_bytes
+    if row_count == 0 or row_count > rows_on_disk:
+        row_count = rows_on_disk
+    return names, dtype, header_size, row_count
+
+
+def read_packed_header(path):
+    """Return the header fields of a packed trace as a dict
+
+    Keys: names, header_size, block_count, row_count, animation_offset,
+    animation_frames, animation_interval.
+    """
+    with open(path, 'rb') as f:
+        fixed = f.read(TRACE_PACKED_HEADER.size)
+        (magic, header_size, column_count, _, block_count, row_count,
+         animation_offset, animation_frames, animation_interval) = TRACE_PACKED_HEADER.unpack(fixed)
+        if magic != TRACE_PACKED_MAGIC:
+            raise ValueError(f"{path} is not a packed trace file (bad magic)")
+        names_raw = f.read(column_count * TRACE_COLUMN_NAME_SIZE)
+    return {'names': _column_names(names_raw, column_count), 'header_size': header_size,
+            'block_count': block_count, 'row_count': row_count,
+            'animation_offset': animation_offset, 'animation_frames': animation_frames,
+            'animation_interval': animation_interval}
+
+
+def _expand_nonzero(bitmap, count, data):
+    """Undo zero-byte suppression: count bytes, nonzero where bitmap (LSB first) is set"""
+    mask = np.unpackbits(bitmap, count=count, bitorder='little').view(bool)
+    out = np.zeros(count, dtype=np.uint8)
+    out[mask] = data[:np.count_nonzero(mask)]
+    return out, np.count_nonzero(mask)
+
+
+def _decode_packed_block(payload, rows, columns):
+    """Decode one block into a (rows, columns) float32 array"""
+    plane_count = 4 * rows * columns
+    bitmap_size = (plane_count + 7) // 8
+    bitmap2_size = (bitmap_size + 7) // 8
+    bitmap, kept = _expand_nonzero(payload[:bitmap2_size], bitmap_size, payload[bitmap2_size:])
+    planes, _ = _expand_nonzero(bitmap, plane_count, payload[bitmap2_size + kept:])
+
+    # Byte planes back to zigzag codes, then two running sums (mod 2**32) down each column
+    planes = planes.reshape(columns, 4, rows).astype(np.uint32)
+    codes = planes[:, 0] | (planes[:, 1] << 8) | (planes[:, 2] << 16) | (planes[:, 3] << 24)
+    changes = (codes >> 1) ^ (np.uint32(0) - (codes & 1))
+    bits = np.cumsum(np.cumsum(changes, axis=1, dtype=np.uint32), axis=1, dtype=np.uint32)
+    return np.ascontiguousarray(bits.T).view('<f4')
+
+
+def read_packed_trace(path):
+    """Decode a packed trace into a (rows, columns) float32 array; return (names, values)
+
+    Blocks are read until the end of the blocks (or of the file, for a trace whose writer
+    did not finish and whose header still has blockCount 0).
+    """
+    header = read_packed_header(path)
+    columns = len(header['names'])
+    data = np.fromfile(path, dtype=np.uint8)
+    end = header['animation_offset'] or len(data)
+    position = header['header_size']
+    blocks = []
+    while position + TRACE_BLOCK_HEADER.size <= end:
+        rows, payload_size = TRACE_BLOCK_HEADER.unpack_from(data, position)
+        position += TRACE_BLOCK_HEADER.size
+        if rows == 0 or position + payload_size > end:
+            break
+        blocks.append(_decode_packed_block(data[position:position + payload_size], rows, columns))
+        position += payload_size
+        if header['block_count'] and len(blocks) == header['block_count']:
+            break
+    values = np.concatenate(blocks) if blocks else np.zeros((0, columns), dtype='<f4')
+    return header['names'], values
+
+
+def open_animation(path):
+    """Memory-map the animation stream of a packed trace (structured float32 array), or None
+
+    The stream holds a row every animation_interval seconds plus the last row.
+    """
+    header = read_packed_header(path)
+    if header['animation_offset'] == 0 or header['animation_frames'] == 0:
+        return None
+    record = np.dtype([(name, '<f4') for name in header['names']])
+    return np.memmap(path, dtype=record, mode='r', offset=header['animation_offset'],
+                     shape=(header['animation_frames'],))
+
+
+def open_trace(path):
+    """Memory-map a trace as a NumPy structured array (one field per column)
+
+    CSV traces are parsed and packed traces decoded into a structured array of the same shape instead.
+    """
+    path = Path(path)
+    if path.suffix == '.csv':
+        return pd.read_csv(path).to_records(index=False)
+    if path.suffix == '.trz':
+        names, values = read_packed_trace(path)
+        record = np.dtype([(name, '<f4') for name in names])
+        return np.ascontiguousarray(values).view(record).reshape(-1)
+
+    names, dtype, header_size, row_count = read_trace_header(path)
+    record = np.dtype([(name, dtype) for name in names])
+    if row_count == 0:
+        return np.zeros(0, dtype=record)
+    return np.memmap(path, dtype=record, mode='r', offset=header_size, shape=(row_count,))
+
+
+def load_trace_frame(path, animation=False):
+    """Load a trace (.trc, .trz or .csv) as a pandas DataFrame with the trace column names
+
+    With animation=True a packed trace with an animation stream loads only that stream
+    (a row per frame); every other trace loads in full.
+    """
+    path = Path(path)
+    if path.suffix == '.csv':
+        return pd.read_csv(path)
+    trace = open_animation(path) if animation and path.suffix == '.trz' else None
+    if trace is None:
+        trace = open_trace(path)
+    return pd.DataFrame({name: np.asarray(trace[name], dtype=np.float64) for name in trace.dtype.names})
+
+
+def load_batch_summary(directory):
+    """Load the batch KPI summary written by the simulation, or None if there is none
+
+    Keys: scenarios, seed, source, caught, catch_rate, traced,
+    kpis (name -> unit/count/mean/stddev/min/p50/p90/p99/max), flagged (count, scenarios).
+    """
+    path = Path(directory) / BATCH_SUMMARY_NAME
+    if not path.exists():
+        return None
+    with open(path) as f:
+        return json.load(f)
+
+
+def find_traces(directory, pattern='*'):
+    """List trace files (.trc, .trz and .csv) in a directory matching a stem pattern, sorted"""
+    directory = Path(directory)
+    files = []
+    for ext in TRACE_EXTENSIONS:
+        files.extend(directory.glob(pattern + ext))
+    return sorted(files)
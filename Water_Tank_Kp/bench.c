@@ -0,0 +1,738 @@
+// Benchmarks for the water tank controller and model kernels
+// Prints one JSON line per measurement (see common/benchutil.h):
+//   controller/<callback>           one ControllerCallback call
+//   band_edge/<callback>            one adaptive ControllerCallback call with the error jittering
+//                                   around a gain-schedule band edge (worst case for branches)
+//   model/<callback>                one SystemModelCallback call
+//   update_system/<callback>+<model> one updateSystem() step (generic callback pipeline)
+//   stepper/<callback>+<model>      one step of the specialized stepper (watertank_stepper.c)
+//   batch/<model>                   one tank-step of the SoA batch engine
+//   network/cascade_<N>             one tank-step of an N-tank coupled cascade (CSR pipes)
+//   embedded/<callback>_<f32|q16>   one call of the firmware control law (controller_embedded.h)
+//   equivalence/<callback>_<f32|q16> closed-loop deviation of the firmware law from the double
+//                                   controller over the scenario profile (max level error, %)
+//   equivalence/<callback>_<f32|q16>_schedule  the same with a retuned gain schedule passed to
+//                                   both (--gain-schedule FILE, else the built-in tables retuned)
+//   mpc/setup                       one initMpcController (condensed QP of main.c's --mpc tank)
+//   mpc/tick                        one closed-loop updateSystem step with mpcController
+//   scenario_scaling/full_run       one step of the 24-run scenario set, per thread count
+//   trace_io/<format>               one 4-column sample through the trace writer
+//   sensitivity/<model>             one step of the PID sensitivity stepper (state + 3 gain tangents)
+//   sensitivity/<model>_gradient    forward-mode gradient of the scenario profile's IAE against central
+//                                   finite differences (max relative error) and the deviation of its
+//                                   trajectory from the PID stepper's (signal error, must be 0)
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "benchutil.h"
+#include "controller.h"
+#include "controller_embedded.h"
+#include "gainschedule.h"
+#include "jobpool.h"
+#include "mpc.h"
+#include "tracewriter.h"
+#include "watertank.h"
+#include "watertank_batch.h"
+#include "watertank_network.h"
+#include "watertank_stepper.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_DT 0.04            // Same time step as main.c (25 Hz)
+#define BENCH_SCENARIO_STEPS 1250 // 50 s at dt = 0.04
+#define BENCH_BATCH_SIZE 1024
+#define BENCH_TRACE_ROWS 200000
+#define BENCH_EQUIVALENCE_TOLERANCE 0.5  // Largest level deviation (%) of a firmware law from double
+#define BENCH_GRADIENT_STEP 1e-6         // Relative gain step of the finite-difference reference
+#define BENCH_GRADIENT_TOLERANCE 1e-3    // Largest relative error of the forward-mode gradient
+
+typedef struct {
+    const char *name;
+    ControllerCallback callback;
+    ControllerParams params;
+} BenchController;
+
+typedef struct {
+    const char *name;
+    SystemModelCallback callback;
+} BenchModel;
+
+// Same controllers and gains as main.c
+static const BenchController controllers[] = {
+    { "pController",           pController,           {1.0,  0.0,  0.0}  },
+    { "adaptivePController",   adaptivePController,   {5.0,  0.0,  0.0}  },
+    { "pdController",          pdController,          {0.40, 0.0,  0.60} },
+    { "adaptivePdController",  adaptivePdController,  {2.8,  0.0,  0.45} },
+    { "piController",          piController,          {0.30, 0.08, 0.0}  },
+    { "adaptivePiController",  adaptivePiController,  {0.80, 0.08, 0.0}  },
+    { "pidController",         pidController,         {0.35, 0.08, 0.50} },
+    { "adaptivePidController", adaptivePidController, {1.0,  0.08, 0.50} }
+};
+#define CONTROLLER_COUNT ((int)(sizeof(controllers) / sizeof(controllers[0])))
+
+static const BenchModel models[] = {
+    { "tankModel",                      tankModel },
+    { "tankModelTrapezoidal",           tankModelTrapezoidal },
+    { "tankModelTrapezoidalSimplified", tankModelTrapezoidalSimplified },
+    { "tankModelAdaptive",              tankModelAdaptive }
+};
+#define MODEL_COUNT ((int)(sizeof(models) / sizeof(models[0])))
+
+// Results are accumulated here so the compiler can't drop the benchmarked calls
+static volatile double benchSink;
+
+typedef struct {
+    WaterTank tank;
+    ControllerState state;
+    ControllerParams params;
+    ControllerCallback controller;
+    TankStepper stepper;
+    TankSensitivityStepper sensitivityStepper;
+    TankSensitivity sensitivity;
+} TankBench;
+
+// Tank in the same initial state as main.c (30% full, setpoint 70%)
+static void initBenchTank(TankBench *bench, const BenchController *controller, SystemModelCallback model) {
+    double tank_area = M_PI * 5.0 * 5.0;
+    double max_level = 4.507;
+    double initial_volume = 0.30 * tank_area * max_level;
+
+    memset(bench, 0, sizeof(*bench));
+    bench->params = controller->params;
+    bench->controller = controller->callback;
+    bench->tank.level = 30.0;
+    bench->tank.volume = initial_volume;
+    bench->tank.height = initial_volume / tank_area;
+    bench->tank.setpoint = 70.0;
+    bench->tank.controller.params = &bench->params;
+    bench->tank.controller.state = &bench->state;
+    bench->tank.controller.getSetpoint = getTankSetpoint;
+    bench->tank.controller.getOutput = getTankOutput;
+    bench->tank.controller.dt = BENCH_DT;
+    bench->tank.model.outflow_coeff = 0.1;
+    bench->tank.model.area = tank_area;
+    bench->tank.model.max_inflow = 50.0;
+    bench->tank.model.density = 1000.0;
+    bench->tank.model.max_level = max_level;
+    bench->tank.model.callback = model;
+    bench->tank.model.netFlowCallback = (model == tankModelTrapezoidalSimplified) ?
+                                        calculateTankNetFlowSimplified : calculateTankNetFlow;
+    prepareTankModel(&bench->tank.model);
+    if (selectTankStepper(&bench->tank, controller->callback, &bench->stepper) != ERROR_SUCCESS) {
+        bench->stepper = NULL;
+    }
+    if (controller->callback != pidController ||
+        selectTankSensitivityStepper(&bench->tank, &bench->sensitivityStepper) != ERROR_SUCCESS) {
+        bench->sensitivityStepper = NULL;
+    }
+}
+
+// Setpoint profile of main.c (70% -> 20% -> 90% -> 50%, 12 s each)
+static double scenarioSetpoint(double time) {
+    if (time < 12.0) return 70.0;
+    if (time < 24.0) return 20.0;
+    if (time < 36.0) return 90.0;
+    return 50.0;
+}
+
+static void benchController(void *context, long iterations) {
+    TankBench *bench = (TankBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        double error = (double)(i & 63) - 32.0;
+        double u = 0.0;
+        bench->controller(error, &bench->tank.controller, &u);
+        sum += u;
+    }
+    benchSink = sum;
+}
+
+// Errors jittering by +-0.02 around the 0.3 band edge (and the rate around its 2.5 edge),
+// long enough that the branch predictor cannot learn the sequence
+#define BENCH_BAND_EDGE_ERRORS 65536
+static double bandEdgeErrors[BENCH_BAND_EDGE_ERRORS];
+
+static void initBandEdgeErrors(void) {
+    uint32_t x = 2463534242u;  // xorshift32
+    for (int i = 0; i < BENCH_BAND_EDGE_ERRORS; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        bandEdgeErrors[i] = 0.3 + ((double)(x & 0xFFFF) / 65535.0 - 0.5) * 0.04;
+    }
+}
+
+static void benchBandEdge(void *context, long iterations) {
+    TankBench *bench = (TankBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        double u = 0.0;
+        bench->controller(bandEdgeErrors[i & (BENCH_BAND_EDGE_ERRORS - 1)], &bench->tank.controller, &u);
+        sum += u;
+    }
+    benchSink = sum;
+}
+
+static void benchModel(void *context, long iterations) {
+    TankBench *bench = (TankBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        // Alternate filling and draining so the level stays inside its limits
+        double inflow = (i & 256) ? -20.0 : 20.0;
+        double level = 0.0;
+        bench->tank.model.callback(&bench->tank, inflow, BENCH_DT, &level);
+        sum += level;
+    }
+    benchSink = sum;
+}
+
+static void benchUpdateSystem(void *context, long iterations) {
+    TankBench *bench = (TankBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        bench->tank.setpoint = scenarioSetpoint((double)(i % BENCH_SCENARIO_STEPS) * BENCH_DT);
+        double level = 0.0;
+        updateSystem(&bench->tank, &bench->tank.controller, bench->tank.model.callback, BENCH_DT,
+                     &level, bench->controller, NULL);
+        sum += level;
+    }
+    benchSink = sum;
+}
+
+static void benchStepper(void *context, long iterations) {
+    TankBench *bench = (TankBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        bench->tank.setpoint = scenarioSetpoint((double)(i % BENCH_SCENARIO_STEPS) * BENCH_DT);
+        double level = 0.0;
+        bench->stepper(&bench->tank, BENCH_DT, 1, &level);
+        sum += level;
+    }
+    benchSink = sum;
+}
+
+static void benchSensitivityStepper(void *context, long iterations) {
+    TankBench *bench = (TankBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        bench->tank.setpoint = scenarioSetpoint((double)(i % BENCH_SCENARIO_STEPS) * BENCH_DT);
+        double level = 0.0;
+        bench->sensitivityStepper(&bench->tank, &bench->sensitivity, BENCH_DT, 1, &level);
+        sum += level + bench->sensitivity.level[GAIN_KP];
+    }
+    benchSink = sum;
+}
+
+// IAE (%·s) of the scenario profile with the PID stepper
+static double runGradientProfile(SystemModelCallback model, const ControllerParams *params, double *trajectory) {
+    TankBench bench;
+    initBenchTank(&bench, &controllers[6], model);
+    bench.params = *params;
+    double iae = 0.0;
+    for (long i = 0; i < BENCH_SCENARIO_STEPS; i++) {
+        bench.tank.setpoint = scenarioSetpoint((double)i * BENCH_DT);
+        double level = 0.0;
+        bench.stepper(&bench.tank, BENCH_DT, 1, &level);
+        if (trajectory != NULL) trajectory[i] = level;
+        iae += fabs(bench.tank.setpoint - level) * BENCH_DT;
+    }
+    return iae;
+}
+
+// Gradient of the profile's IAE from one sensitivity run, checked against central finite
+// differences (two extra runs per gain) and the PID stepper's trajectory
+static void checkSensitivityGradient(const BenchSettings *settings, SystemModelCallback model, const char *name) {
+    if (!benchSelected(settings, "sensitivity", name)) return;
+    double *trajectory = (double*)malloc(BENCH_SCENARIO_STEPS * sizeof(double));
+    if (trajectory == NULL) return;
+    const ControllerParams *params = &controllers[6].params;
+    runGradientProfile(model, params, trajectory);
+
+    TankBench bench;
+    initBenchTank(&bench, &controllers[6], model);
+    double gradient[GAIN_COUNT] = { 0.0, 0.0, 0.0 };
+    double maxTrajectoryError = 0.0;
+    for (long i = 0; i < BENCH_SCENARIO_STEPS; i++) {
+        bench.tank.setpoint = scenarioSetpoint((double)i * BENCH_DT);
+        double level = 0.0;
+        bench.sensitivityStepper(&bench.tank, &bench.sensitivity, BENCH_DT, 1, &level);
+        maxTrajectoryError = fmax(maxTrajectoryError, fabs(level - trajectory[i]));
+        // d|setpoint - level| = -sign(setpoint - level) * d(level)
+        double sign = bench.tank.setpoint - level >= 0.0 ? 1.0 : -1.0;
+        for (int g = 0; g < GAIN_COUNT; g++) {
+            gradient[g] -= sign * bench.sensitivity.level[g] * BENCH_DT;
+        }
+    }
+    free(trajectory);
+
+    double maxGradientError = 0.0;
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        ControllerParams up = *params, down = *params;
+        double *upGain = g == GAIN_KP ? &up.Kp : g == GAIN_KI ? &up.Ki : &up.Kd;
+        double *downGain = g == GAIN_KP ? &down.Kp : g == GAIN_KI ? &down.Ki : &down.Kd;
+        double h = *upGain * BENCH_GRADIENT_STEP;
+        *upGain += h;
+        *downGain -= h;
+        double reference = (runGradientProfile(model, &up, NULL) - runGradientProfile(model, &down, NULL)) /
+                           (2.0 * h);
+        double scale = fmax(fabs(reference), 1e-12);
+        maxGradientError = fmax(maxGradientError, fabs(gradient[g] - reference) / scale);
+    }
+    benchReportDeviation(settings, "sensitivity", name, BENCH_SCENARIO_STEPS, maxGradientError, maxTrajectoryError,
+                         BENCH_GRADIENT_TOLERANCE);
+}
+
+static void benchBatch(void *context, long iterations) {
+    WaterTankBatch *batch = (WaterTankBatch*)context;
+    for (long i = 0; i < iterations; i++) {
+        stepWaterTankBatch(batch, BENCH_DT);
+    }
+    benchSink = batch->level[0];
+}
+
+static void benchNetwork(void *context, long iterations) {
+    TankNetwork *network = (TankNetwork*)context;
+    for (long i = 0; i < iterations; i++) {
+        stepTankNetwork(network, BENCH_DT);
+    }
+    benchSink = network->level[0];
+}
+
+// Firmware builds of a controller (controller_embedded.h)
+typedef struct {
+    const char *name;
+    ControllerCallback callback;  // Double reference
+    float (*f32Law)(float error, const ControllerParamsF32 *params, ControllerStateF32 *state);
+    q16_t (*q16Law)(q16_t error, const ControllerParamsQ16 *params, ControllerStateQ16 *state);
+} BenchEmbeddedController;
+
+#define X(callback, f32Law, q16Law) { #callback, callback, f32Law, q16Law },
+static const BenchEmbeddedController embeddedControllers[] = {
+    EMBEDDED_CONTROLLER_LAW_LIST(X)
+};
+#undef X
+#define EMBEDDED_CONTROLLER_COUNT ((int)(sizeof(embeddedControllers) / sizeof(embeddedControllers[0])))
+
+typedef struct {
+    const BenchEmbeddedController *law;
+    ControllerParamsF32 f32Params;
+    ControllerStateF32 f32State;
+    ControllerParamsQ16 q16Params;
+    ControllerStateQ16 q16State;
+    GainScheduleF32 f32Schedule;  // Retuned tables of the _schedule cases
+    GainScheduleQ16 q16Schedule;
+    int q16;                      // Run the Q16.16 law (else float32)
+} EmbeddedBench;
+
+// Schedules of the _schedule equivalence cases
+static GainScheduleSet benchSchedules;
+
+// Move every table of the built-in schedules, so the _schedule cases fail whenever a firmware
+// law ignores the schedule it is given
+static void retuneBenchSchedules(GainScheduleSet *set) {
+    GainSchedule *schedules[4] = { &set->p, &set->pd, &set->pi, &set->pid };
+    for (int s = 0; s < 4; s++) {
+        GainSchedule *schedule = schedules[s];
+        for (int k = 0; k <= GAIN_SCHEDULE_MAX_EDGES; k++) {
+            schedule->error.factor[k] *= 1.2;
+            schedule->cumulative.factor[k] = 1.0 + 1.5 * (schedule->cumulative.factor[k] - 1.0);
+        }
+        for (int k = 0; k < GAIN_SCHEDULE_MAX_EDGES; k++) {
+            schedule->error.edge[k] *= 0.8;
+            schedule->rate.edge[k] *= 0.8;
+        }
+        schedule->trendBoost = 1.2;
+    }
+}
+
+static void benchEmbeddedLaw(void *context, long iterations) {
+    EmbeddedBench *bench = (EmbeddedBench*)context;
+    double sum = 0.0;
+    if (bench->q16) {
+        for (long i = 0; i < iterations; i++) {
+            q16_t error = (q16_t)((i & 63) - 32) * Q16_ONE;
+            sum += (double)bench->law->q16Law(error, &bench->q16Params, &bench->q16State);
+        }
+    } else {
+        for (long i = 0; i < iterations; i++) {
+            float error = (float)((i & 63) - 32);
+            sum += (double)bench->law->f32Law(error, &bench->f32Params, &bench->f32State);
+        }
+    }
+    benchSink = sum;
+}
+
+// One firmware control step: the error is measured in double, converted, and the signal converted back
+static double embeddedControlSignal(EmbeddedBench *bench, double error) {
+    if (bench->q16) {
+        return q16ToDouble(bench->law->q16Law(q16FromDouble(error), &bench->q16Params, &bench->q16State));
+    }
+    return (double)bench->law->f32Law((float)error, &bench->f32Params, &bench->f32State);
+}
+
+// Run the scenario profile with the double controller and with the firmware law and report the
+// largest level and inflow deviation (schedule: table of both, NULL: their built-in tables)
+static void checkEmbeddedLaw(const BenchSettings *settings, EmbeddedBench *embedded, const BenchController *reference,
+                             const GainSchedule *schedule, const char *name) {
+    if (!benchSelected(settings, "equivalence", name)) return;
+    TankBench doubleRun, firmwareRun;
+    initBenchTank(&doubleRun, reference, tankModel);
+    initBenchTank(&firmwareRun, reference, tankModel);
+    doubleRun.tank.controller.schedule = schedule;
+    embedded->f32Params.schedule = NULL;
+    embedded->q16Params.schedule = NULL;
+    if (schedule != NULL) {
+        if (initGainScheduleF32(&embedded->f32Schedule, schedule) != ERROR_SUCCESS ||
+            initGainScheduleQ16(&embedded->q16Schedule, schedule) != ERROR_SUCCESS) {
+            return;
+        }
+        embedded->f32Params.schedule = &embedded->f32Schedule;
+        embedded->q16Params.schedule = &embedded->q16Schedule;
+    }
+    resetControllerStateF32(&embedded->f32State);
+    resetControllerStateQ16(&embedded->q16State);
+
+    double maxLevelError = 0.0, maxSignalError = 0.0;
+    for (long i = 0; i < BENCH_SCENARIO_STEPS; i++) {
+        double setpoint = scenarioSetpoint((double)i * BENCH_DT);
+        double doubleLevel = 0.0, firmwareLevel = 0.0;
+
+        double error = setpoint - doubleRun.tank.level;
+        double doubleSignal = 0.0;
+        reference->callback(error, &doubleRun.tank.controller, &doubleSignal);
+        tankModel(&doubleRun.tank, doubleSignal, BENCH_DT, &doubleLevel);
+
+        double firmwareSignal = embeddedControlSignal(embedded, setpoint - firmwareRun.tank.level);
+        tankModel(&firmwareRun.tank, firmwareSignal, BENCH_DT, &firmwareLevel);
+
+        maxLevelError = fmax(maxLevelError, fabs(firmwareLevel - doubleLevel));
+        maxSignalError = fmax(maxSignalError, fabs(firmwareSignal - doubleSignal));
+    }
+    benchReportDeviation(settings, "equivalence", name, BENCH_SCENARIO_STEPS, maxLevelError, maxSignalError,
+                         BENCH_EQUIVALENCE_TOLERANCE);
+}
+
+// Timing and closed-loop equivalence of every firmware law in float32 and Q16.16
+static void benchEmbedded(const BenchSettings *settings) {
+    for (int e = 0; e < EMBEDDED_CONTROLLER_COUNT; e++) {
+        const BenchController *reference = NULL;
+        for (int c = 0; c < CONTROLLER_COUNT; c++) {
+            if (controllers[c].callback == embeddedControllers[e].callback) reference = &controllers[c];
+        }
+        if (reference == NULL) continue;
+
+        EmbeddedBench embedded;
+        memset(&embedded, 0, sizeof(embedded));
+        embedded.law = &embeddedControllers[e];
+        if (initControllerParamsF32(&embedded.f32Params, &reference->params, BENCH_DT, 0.0) != ERROR_SUCCESS ||
+            initControllerParamsQ16(&embedded.q16Params, &reference->params, BENCH_DT, 0.0) != ERROR_SUCCESS) {
+            continue;
+        }
+        for (embedded.q16 = 0; embedded.q16 <= 1; embedded.q16++) {
+            char name[128];
+            snprintf(name, sizeof(name), "%s_%s", embedded.law->name, embedded.q16 ? "q16" : "f32");
+            resetControllerStateF32(&embedded.f32State);
+            resetControllerStateQ16(&embedded.q16State);
+            benchRun(settings, "embedded", name, 1, benchEmbeddedLaw, &embedded);
+            checkEmbeddedLaw(settings, &embedded, reference, NULL, name);
+            const GainSchedule *schedule = selectGainSchedule(&benchSchedules, reference->callback);
+            if (schedule != NULL) {
+                snprintf(name, sizeof(name), "%s_%s_schedule", embedded.law->name, embedded.q16 ? "q16" : "f32");
+                checkEmbeddedLaw(settings, &embedded, reference, schedule, name);
+            }
+        }
+    }
+}
+
+// MPC of main.c --mpc on the bench tank
+typedef struct {
+    TankBench *tank;
+    MpcModel linear;
+    MpcConfig config;
+    MpcController mpc;
+} MpcBench;
+
+static void benchMpcSetup(void *context, long iterations) {
+    MpcBench *bench = (MpcBench*)context;
+    double sum = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        initMpcController(&bench->mpc, &bench->linear, &bench->config, BENCH_DT);
+        sum += bench->mpc.hessianInverse[0][0];
+    }
+    benchSink = sum;
+}
+
+static void benchMpc(const BenchSettings *settings, TankBench *tank) {
+    MpcBench bench;
+    bench.tank = tank;
+    initMpcConfig(&bench.config);
+    bench.config.horizon = 20;
+    bench.config.stateWeight[0] = 1.0;
+    bench.config.inputWeight = 0.1;
+    bench.config.rateWeight = 0.1;
+    bench.config.inputMin = 0.0;
+    bench.config.inputMax = tank->tank.model.max_inflow;
+    bench.config.rateLimit = 100.0;
+    if (linearizeTankModel(&tank->tank.model, BENCH_DT, &bench.linear) != ERROR_SUCCESS ||
+        initMpcController(&bench.mpc, &bench.linear, &bench.config, BENCH_DT) != ERROR_SUCCESS) {
+        return;
+    }
+    benchRun(settings, "mpc", "setup", 1, benchMpcSetup, &bench);
+
+    tank->tank.controller.mpc = &bench.mpc;
+    tank->controller = mpcController;
+    benchRun(settings, "mpc", "tick", 1, benchUpdateSystem, tank);
+    tank->tank.controller.mpc = NULL;
+}
+
+// Cascades of coupled tanks (same layout as main.c --network)
+static void benchNetworks(const BenchSettings *settings, const ModelConfig *model) {
+    static const int sizes[] = { 50, 500 };
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        char name[32];
+        snprintf(name, sizeof(name), "cascade_%d", sizes[s]);
+        if (!benchSelected(settings, "network", name)) continue;
+
+        TankNetwork network;
+        if (initTankNetwork(&network, sizes[s], sizes[s] - 1, model) != ERROR_SUCCESS) continue;
+        for (int i = 0; i < sizes[s]; i++) {
+            setTankNetworkPlant(&network, i, 30.0, 70.0, &controllers[6].params,
+                                (i + 1 == sizes[s]) ? model->outflow_coeff : 0.0);
+            if (i + 1 < sizes[s]) addTankNetworkPipe(&network, i, i + 1, 0.5);
+        }
+        if (finalizeTankNetwork(&network) == ERROR_SUCCESS) {
+            benchRun(settings, "network", name, sizes[s], benchNetwork, &network);
+        }
+        freeTankNetwork(&network);
+    }
+}
+
+// One full 50 s scenario (pool job for the scaling benchmark)
+typedef struct {
+    int controllerIndex;
+    int modelIndex;
+    double finalLevel;
+} ScenarioJob;
+
+static void runScenarioJob(void *arg) {
+    ScenarioJob *job = (ScenarioJob*)arg;
+    TankBench bench;
+    initBenchTank(&bench, &controllers[job->controllerIndex], models[job->modelIndex].callback);
+
+    double level = 0.0;
+    for (int i = 0; i < BENCH_SCENARIO_STEPS; i++) {
+        bench.tank.setpoint = scenarioSetpoint(i * BENCH_DT);
+        if (bench.stepper) {
+            bench.stepper(&bench.tank, BENCH_DT, 1, &level);
+        } else {
+            updateSystem(&bench.tank, &bench.tank.controller, bench.tank.model.callback, BENCH_DT,
+                         &level, bench.controller, NULL);
+        }
+    }
+    job->finalLevel = level;
+}
+
+// Time `rounds` copies of the 24 main.c scenarios on a pool with `threads` workers
+// Returns: elapsed nanoseconds, or -1 on failure
+static long long timeScenarioSet(int threads, int rounds, ScenarioJob *jobs) {
+    JobPool *pool = NULL;
+    if (createJobPool(threads, &pool) != ERROR_SUCCESS) return -1;
+
+    int jobCount = rounds * CONTROLLER_COUNT * MODEL_COUNT;
+    long long start = benchNowNs();
+    for (int j = 0; j < jobCount; j++) {
+        submitJob(pool, runScenarioJob, &jobs[j]);
+    }
+    waitJobPool(pool);
+    long long elapsed = benchNowNs() - start;
+    destroyJobPool(pool);
+    return elapsed;
+}
+
+static void benchScenarioScaling(const BenchSettings *settings) {
+    if (!benchSelected(settings, "scenario_scaling", "full_run")) return;
+
+    // Calibrate the number of scenario sets on one thread
+    int setSize = CONTROLLER_COUNT * MODEL_COUNT;
+    ScenarioJob *jobs = NULL;
+    int rounds = 1;
+    long long elapsed = 0;
+    for (;;) {
+        free(jobs);
+        jobs = (ScenarioJob*)malloc((size_t)rounds * (size_t)setSize * sizeof(ScenarioJob));
+        if (jobs == NULL) return;
+        for (int j = 0; j < rounds * setSize; j++) {
+            jobs[j].controllerIndex = (j % setSize) % CONTROLLER_COUNT;
+            jobs[j].modelIndex = (j % setSize) / CONTROLLER_COUNT;
+        }
+        elapsed = timeScenarioSet(1, rounds, jobs);
+        if (elapsed < 0 || elapsed >= settings->minTimeNs || rounds >= 4096) break;
+        rounds *= 2;
+    }
+
+    long long items = (long long)rounds * setSize * BENCH_SCENARIO_STEPS;
+    int hardware = getHardwareConcurrency();
+    for (int threads = 1; elapsed >= 0; ) {
+        long long best = timeScenarioSet(threads, rounds, jobs);
+        for (int r = 1; r < BENCH_REPETITIONS && best >= 0; r++) {
+            long long t = timeScenarioSet(threads, rounds, jobs);
+            if (t >= 0 && t < best) best = t;
+        }
+        if (best >= 0) {
+            benchReport(settings, "scenario_scaling", "full_run", threads, items, (double)best / (double)items);
+        }
+
+        // 1, 2, 4, ... and finally the hardware thread count
+        if (threads >= hardware) break;
+        threads = threads * 2 < hardware ? threads * 2 : hardware;
+    }
+    free(jobs);
+}
+
+static void benchTraceIo(const BenchSettings *settings) {
+    static const char *const columns[] = { "time", "level", "setpoint", "control" };
+    static const struct { const char *name; TraceFormat format; } formats[] = {
+        { "csv", TRACE_FORMAT_CSV }, { "f64", TRACE_FORMAT_BINARY_F64 }, { "f32", TRACE_FORMAT_BINARY_F32 },
+        { "packed", TRACE_FORMAT_PACKED }
+    };
+
+    if (startTraceWriterThread() != ERROR_SUCCESS) return;
+    for (int f = 0; f < (int)(sizeof(formats) / sizeof(formats[0])); f++) {
+        if (!benchSelected(settings, "trace_io", formats[f].name)) continue;
+
+        char path[64];
+        snprintf(path, sizeof(path), "bench_trace%s", getTraceFileExtension(formats[f].format));
+        long long best = -1;
+        for (int r = 0; r < BENCH_REPETITIONS; r++) {
+            TraceWriter *writer = NULL;
+            long long start = benchNowNs();
+            if (openTraceWriter(path, formats[f].format, 4, columns, &writer) != ERROR_SUCCESS) break;
+            if (formats[f].format == TRACE_FORMAT_PACKED) setTraceAnimationRate(writer, 30.0);
+            for (long i = 0; i < BENCH_TRACE_ROWS; i++) {
+                double row[4] = { i * BENCH_DT, 50.0 + (double)(i & 127) * 0.1, 70.0, (double)(i & 31) };
+                appendTraceRow(writer, row);
+            }
+            ErrorCode err = closeTraceWriter(writer);  // Includes flushing the last chunks
+            long long t = benchNowNs() - start;
+            if (err != ERROR_SUCCESS) break;
+            if (best < 0 || t < best) best = t;
+        }
+        remove(path);
+        if (best >= 0) {
+            benchReport(settings, "trace_io", formats[f].name, 1, BENCH_TRACE_ROWS,
+                        (double)best / (double)BENCH_TRACE_ROWS);
+        }
+    }
+    stopTraceWriterThread();
+}
+
+static void printUsage(const char *program) {
+    printf("Usage: %s [--filter TEXT] [--min-time-ms N] [--gain-schedule FILE]\n", program);
+    printf("  --filter TEXT    Only run cases whose group/case contains TEXT (e.g. controller/, stepper/pid)\n");
+    printf("  --min-time-ms N  Minimum duration of one timed repetition (default %d)\n", BENCH_DEFAULT_MIN_TIME_MS);
+    printf("  --gain-schedule FILE  Schedule of the equivalence/*_schedule cases (default: retuned built-ins)\n");
+    printf("Results are printed as JSON lines on stdout.\n");
+}
+
+int main(int argc, char *argv[]) {
+    BenchSettings settings = { (long long)BENCH_DEFAULT_MIN_TIME_MS * 1000000LL, NULL, "water_tank", stdout };
+    const char *schedulePath = NULL;
+
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--filter") == 0 && a + 1 < argc) {
+            settings.filter = argv[++a];
+        } else if (strcmp(argv[a], "--gain-schedule") == 0 && a + 1 < argc) {
+            schedulePath = argv[++a];
+        } else if (strcmp(argv[a], "--min-time-ms") == 0 && a + 1 < argc) {
+            settings.minTimeNs = (long long)atoi(argv[++a]) * 1000000LL;
+        } else if (strcmp(argv[a], "--help") == 0 || strcmp(argv[a], "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            printf("Unknown option: %s\n", argv[a]);
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    initGainScheduleSet(&benchSchedules);
+    if (schedulePath == NULL) {
+        retuneBenchSchedules(&benchSchedules);
+    } else {
+        int line = 0;
+        ErrorCode err = loadGainScheduleSet(schedulePath, &benchSchedules, &line);
+        if (err != ERROR_SUCCESS) {
+            printf("Invalid gain schedule %s (error %d, line %d)\n", schedulePath, err, line);
+            return 1;
+        }
+    }
+
+    TankBench bench;
+    for (int c = 0; c < CONTROLLER_COUNT; c++) {
+        initBenchTank(&bench, &controllers[c], tankModel);
+        benchRun(&settings, "controller", controllers[c].name, 1, benchController, &bench);
+    }
+
+    GainScheduleSet schedules;
+    initGainScheduleSet(&schedules);
+    initBandEdgeErrors();
+    for (int c = 0; c < CONTROLLER_COUNT; c++) {
+        if (selectGainSchedule(&schedules, controllers[c].callback) == NULL) continue;  // Fixed gains
+        initBenchTank(&bench, &controllers[c], tankModel);
+        benchRun(&settings, "band_edge", controllers[c].name, 1, benchBandEdge, &bench);
+    }
+
+    benchEmbedded(&settings);
+
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        initBenchTank(&bench, &controllers[0], models[m].callback);
+        benchRun(&settings, "model", models[m].name, 1, benchModel, &bench);
+    }
+
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        for (int c = 0; c < CONTROLLER_COUNT; c++) {
+            char name[128];
+            snprintf(name, sizeof(name), "%s+%s", controllers[c].name, models[m].name);
+            initBenchTank(&bench, &controllers[c], models[m].callback);
+            benchRun(&settings, "update_system", name, 1, benchUpdateSystem, &bench);
+            initBenchTank(&bench, &controllers[c], models[m].callback);
+            if (bench.stepper) {
+                benchRun(&settings, "stepper", name, 1, benchStepper, &bench);
+            }
+        }
+    }
+
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        initBenchTank(&bench, &controllers[6], models[m].callback);
+        if (bench.sensitivityStepper == NULL) continue;
+        benchRun(&settings, "sensitivity", models[m].name, 1, benchSensitivityStepper, &bench);
+        char name[128];
+        snprintf(name, sizeof(name), "%s_gradient", models[m].name);
+        checkSensitivityGradient(&settings, models[m].callback, name);
+    }
+
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        initBenchTank(&bench, &controllers[6], models[m].callback);
+        WaterTankBatch batch;
+        if (initWaterTankBatch(&batch, BENCH_BATCH_SIZE, &bench.tank.model) != ERROR_SUCCESS) continue;
+        for (int i = 0; i < BENCH_BATCH_SIZE; i++) {
+            setWaterTankBatchPlant(&batch, i, 30.0, 70.0, &controllers[6].params);
+        }
+        benchRun(&settings, "batch", models[m].name, BENCH_BATCH_SIZE, benchBatch, &batch);
+        freeWaterTankBatch(&batch);
+    }
+
+    initBenchTank(&bench, &controllers[6], tankModel);
+    benchNetworks(&settings, &bench.tank.model);
+
+    initBenchTank(&bench, &controllers[0], tankModel);
+    benchMpc(&settings, &bench);
+
+    benchScenarioScaling(&settings);
+    benchTraceIo(&settings);
+    return 0;
+}
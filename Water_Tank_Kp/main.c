@@ -1,22 +1,101 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <signal.h>
 #include "plot.h"
+#include "checkpoint.h"
 #include "controller.h"
+#include "gainschedule.h"
+#include "mpc.h"
+#include "profile.h"
 #include "watertank.h"
+#include "watertank_stepper.h"
+#include "watertank_network.h"
+#include "jobpool.h"
+#include "rtloop.h"
+#include "setpointprofile.h"
+#include "stopcriteria.h"
 
 #ifdef _WIN32
 #include <windows.h>
-#include <process.h>
 #else
 #include <unistd.h>
-#include <pthread.h>
 #endif
 
 // Global flag for Ctrl-C handling
 volatile sig_atomic_t keep_running = 1;
 
+// Run every simulation through the generic updateSystem() callbacks (--generic)
+static int use_generic_pipeline = 0;
+
+// Worker placement of the job pools (--pin-threads: one CPU per worker, spread over the NUMA nodes)
+static JobPoolPlacement worker_placement = JOB_POOL_FLOATING;
+
+// Fixed-rate real-time mode (--realtime): one step per dt of wall-clock time
+static int realtime_mode = 0;
+static int realtime_cpu = -1;       // --rt-cpu: pin simulation threads to this CPU
+static int realtime_priority = 0;   // --rt-priority: SCHED_FIFO priority (0 = default policy)
+
+// Stop criteria: end a run once it settled after the last setpoint step (--early-stop) and/or
+// skip straight to the next setpoint step while the tank is at rest (--fast-forward)
+static int early_stop = 0;
+static int fast_forward = 0;
+static StopCriteria stop_criteria = {
+    .settleTolerance = 0.5,   // --settle-tol: within 0.5% of the setpoint
+    .settleTime = 2.0,        // --settle-time: for 2 s
+    .divergenceLimit = 0.0,   // --divergence-limit: off (the level is bounded to 0-100%)
+    .restRate = 0.05          // Level changing by at most 0.05%/s
+};
+
+// Adaptive-step plant (--adaptive): the Euler phase integrates the tank with tankModelAdaptive
+static int adaptive_model = 0;
+static double adaptive_tolerance = 0.0;  // --adaptive-tol: relative and absolute tolerance (0 = default)
+
+// Coupled tank network (--network N): a cascade of N tanks linked by pipes instead of the 24 runs
+static int network_tanks = 0;
+#define NETWORK_PIPE_CONDUCTANCE 0.5   // Pipe coefficient between neighboring tanks (m^2.5/s)
+
+// Checkpoints (--checkpoint-every S): every S seconds of simulated time each run saves its state
+// to results/checkpoint_<name>.ckp; --resume continues interrupted runs from those files
+static double checkpoint_interval = 0.0;
+static int resume_runs = 0;
+
+// What-if sweep (--what-if N): simulate the PID run up to the fork time once, then fork N
+// gain variants from that checkpoint instead of running the 24 comparisons
+static int what_if_variants = 0;
+static double what_if_fork_time = -1.0;  // --what-if-at: fork time (s, default: first setpoint step)
+#define WHAT_IF_MIN_SCALE 0.5            // Variants scale all three gains from 0.5x ...
+#define WHAT_IF_MAX_SCALE 2.0            // ... to 2x, log-spaced
+
+// Gain schedules of the adaptive controllers (--gain-schedule FILE overrides the built-in tables)
+static GainScheduleSet gain_schedules;
+
+// Model-predictive controller (--mpc): one more run per phase with mpcController on the
+// linearized tank; the input limit is each tank's max_inflow
+static int use_mpc = 0;
+static MpcConfig tank_mpc_config = {
+    .horizon = 20,              // --mpc-horizon: 0.8 s preview at dt = 0.04 s
+    .stateWeight = {1.0},       // Level error (%)
+    .inputWeight = 0.1,
+    .rateWeight = 0.1,
+    .inputMin = 0.0,            // The pump cannot drain the tank
+    .rateLimit = 100.0          // Inflow ramps by at most 100 m³/s per second
+};
+
+// Setpoint profile matching Python Tank 1 reference (percentage 0-100%)
+// Setpoint transitions: 70%→20%→90%→50% of max height (4.507 m)
+static SetpointSegment DEFAULT_SETPOINT_SEGMENTS[] = {
+    SETPOINT_HOLD_SEGMENT( 0.0, 70.0),  // 70% (3.1549 m)
+    SETPOINT_HOLD_SEGMENT(12.0, 20.0),  // 20% (0.9014 m)
+    SETPOINT_HOLD_SEGMENT(24.0, 90.0),  // 90% (4.0563 m)
+    SETPOINT_HOLD_SEGMENT(36.0, 50.0)   // 50% (2.2535 m)
+};
+
+// Profile of every run (--setpoint-profile FILE replaces the built-in steps); read-only while
+// the runs are going, each run follows it with its own cursor
+static SetpointProfile setpoint_profile;
+
 #ifdef _WIN32
 BOOL WINAPI console_ctrl_handler(DWORD dwCtrlType) {
     if (dwCtrlType == CTRL_C_EVENT || dwCtrlType == CTRL_BREAK_EVENT) {
@@ -56,41 +135,51 @@ typedef struct {
     double sim_time;
     int windowIndex;
     SystemModelCallback modelCallback;  // Model callback (Euler or Trapezoidal)
+    RealtimeStats rtStats;              // Step timing (--realtime only)
+    int stepsRun;                       // Steps actually computed (early stop / fast-forward skip the rest)
+    AdaptiveIntegrator integrator;      // Step statistics of the run (tankModelAdaptive only)
 } ThreadData;
 
-// Thread function to run a single simulation
-#ifdef _WIN32
-unsigned __stdcall runSimulation(void *arg) {
-#else
-void* runSimulation(void *arg) {
-#endif
-    ThreadData *data = (ThreadData*)arg;
-    SimulationConfig *sim = data->config;
-    double dt = data->dt;
-    
-    printf("[Thread %s] Starting simulation (Kp=%.2f, Ki=%.2f, Kd=%.2f)...\n", 
-           sim->name,
-           sim->params.Kp,
-           sim->params.Ki,
-           sim->params.Kd);
-    
-    // Initialize data collection (no real-time plotting)
-    void *realtimePlot = NULL;
-    ErrorCode plotErr = initRealtimePlot(sim->name, data->windowIndex, &realtimePlot);
-    if (plotErr == ERROR_SUCCESS && realtimePlot != NULL) {
-        printf("[Thread %s] Data collection initialized\n", sim->name);
-    } else if (plotErr != ERROR_SUCCESS) {
-        printf("[Thread %s] Warning: Data collection failed with error code %d\n", sim->name, plotErr);
+// Checkpoint of a single-tank run (CHECKPOINT_KIND_TANK_RUN): plant and controller state,
+// trace cursor and the run loop's own state
+typedef struct {
+    double dt;                    // Configuration of the saved run, checked on resume
+    ControllerParams params;
+    int model;                    // getRunModelId of the model callback
+    int step;                     // Steps done: the run continues at t = step * dt
+    int stepsRun;
+    double skippedTime;
+    StopMonitor stopMonitor;
+    int traced;                   // trace holds the cursor of the run's trace
+    PlotCursor trace;
+    TankCheckpoint tank;
+} TankRunCheckpoint;
+
+// Model callbacks of the runs, identified in checkpoints by index (addresses change between runs)
+static const SystemModelCallback RUN_MODELS[] = {
+    tankModel, tankModelAdaptive, tankModelTrapezoidal, tankModelTrapezoidalSimplified
+};
+
+static int getRunModelId(SystemModelCallback model) {
+    for (int k = 0; k < (int)(sizeof(RUN_MODELS) / sizeof(RUN_MODELS[0])); k++) {
+        if (RUN_MODELS[k] == model) return k;
     }
-    
-    // Controller state (reset for each simulation)
-    ControllerState controllerState = {
-        .integral = 0.0,
-        .previousError = 0.0,
-        .adaptiveKp = 0.0,
-        .historyIndex = 0,
-        .cumulativeError = 0.0
-    };
+    return -1;
+}
+
+// Checkpoint file of a run: results/checkpoint_<name>.ckp (spaces replaced by underscores)
+static void getRunCheckpointPath(const char *name, char *path, size_t size) {
+    int length = snprintf(path, size, "results/checkpoint_%s.ckp", name);
+    for (int k = (int)strlen("results/checkpoint_"); k < length && (size_t)k < size; k++) {
+        if (path[k] == ' ') path[k] = '_';
+    }
+}
+
+// Set up the tank of a run (initial state, controller, model) for a controller and model callback
+// Returns: ERROR_SUCCESS, or the error of prepareTankModel for an invalid model
+static ErrorCode initRunTank(WaterTank *tank, SimulationConfig *sim, ControllerState *controllerState,
+                        SystemModelCallback modelCallback, double dt) {
+    resetControllerState(controllerState);
     
     // Initialize water tank with controller configuration
     // Python reference: vol_o1_i=30 m³, vol_r1_i=70 m³, radius=5m → area=π*r²≈78.54 m²
@@ -105,7 +194,7 @@ void* runSimulation(void *arg) {
     double initial_volume = (initial_level_pct / 100.0) * max_volume;  // volume = (30/100) × 354 = 106.2 m³
     double initial_height = initial_volume / tank_area;  // height = volume / area = 106.2 / 78.54 = 1.352 m
     
-    WaterTank tank = {
+    *tank = (WaterTank){
         .level = initial_level_pct, // Output: level in percentage (30%)
         .volume = initial_volume,  // Internal state: volume in m³ (106.2 m³)
         .height = initial_height,  // Internal tracking: height in m (1.352 m)
@@ -114,10 +203,11 @@ void* runSimulation(void *arg) {
         .previousNetFlow = 0.0, // Initialize for trapezoidal integration
         .controller = {
             .params = &sim->params,
-            .state = &controllerState,
+            .state = controllerState,
             .getSetpoint = getTankSetpoint,
             .getOutput = getTankOutput,
-            .dt = dt
+            .dt = dt,
+            .schedule = selectGainSchedule(&gain_schedules, sim->controller)
         },
         .model = {
             .outflow_coeff = 0.1,   // Outflow coefficient
@@ -125,34 +215,173 @@ void* runSimulation(void *arg) {
             .max_inflow = 50.0,     // Max 50 m³/s inflow (increased for high Kp values)
             .density = 1000.0,      // Water density (kg/m³) - matches Python density_water=1000
             .max_level = max_level, // 4.507 m maximum height (100%)
-            .callback = data->modelCallback,  // System model callback (Euler/Trapezoidal/Simplified)
-            .netFlowCallback = (data->modelCallback == tankModelTrapezoidalSimplified) ? 
+            .callback = modelCallback,  // System model callback (Euler/Trapezoidal/Simplified)
+            .netFlowCallback = (modelCallback == tankModelTrapezoidalSimplified) ? 
                                calculateTankNetFlowSimplified : calculateTankNetFlow
         }
     };
+    ErrorCode err = prepareTankModel(&tank->model);
+    if (err != ERROR_SUCCESS) return err;
+    initAdaptiveIntegrator(&tank->integrator, adaptive_tolerance, adaptive_tolerance);
+    return ERROR_SUCCESS;
+}
+
+// Saved state of an interrupted run (--resume), if its checkpoint matches this run
+static int loadRunCheckpoint(const ThreadData *data, TankRunCheckpoint *checkpoint) {
+    const SimulationConfig *sim = data->config;
+    char path[512];
+    getRunCheckpointPath(sim->name, path, sizeof(path));
+    ErrorCode err = readCheckpointFile(path, CHECKPOINT_KIND_TANK_RUN, checkpoint, sizeof(*checkpoint));
+    if (err == ERROR_CALLBACK_FAILED) return 0;  // No checkpoint: the run starts from the beginning
+    if (err != ERROR_SUCCESS || checkpoint->dt != data->dt || checkpoint->model != getRunModelId(data->modelCallback) ||
+        memcmp(&checkpoint->params, &sim->params, sizeof(sim->params)) != 0) {
+        printf("[Thread %s] Warning: Checkpoint %s is invalid or from another configuration, starting over\n",
+               sim->name, path);
+        return 0;
+    }
+    return 1;
+}
+
+// Fast-forward is only exact while the controller keeps its state: one more control step with
+// the held error must leave the state bit-identical (P, PD at rest, PI/PID at exactly zero
+// error). The adaptive laws keep growing cumulativeError inside the settle band, which moves
+// them to another gain band later, so they are never skipped while the error is nonzero.
+static int isControllerStateHeld(const WaterTank *tank, ControllerCallback controller, double error) {
+    if (tank->controller.mpc != NULL) return 0;  // Warm start and solver state change every tick
+    ControllerState probe = *tank->controller.state;
+    ControllerConfig config = tank->controller;
+    config.state = &probe;
+    config.history = NULL;
+    double signal = 0.0;
+    if (controller(error, &config, &signal) != ERROR_SUCCESS) return 0;
+    return memcmp(&probe, tank->controller.state, sizeof(probe)) == 0;
+}
+
+// Job function to run a single simulation (executed on a JobPool worker)
+void runSimulation(void *arg) {
+    ThreadData *data = (ThreadData*)arg;
+    SimulationConfig *sim = data->config;
+    double dt = data->dt;
+    beginProfileRun();
+    
+    printf("[Thread %s] Starting simulation (Kp=%.2f, Ki=%.2f, Kd=%.2f)...\n", 
+           sim->name,
+           sim->params.Kp,
+           sim->params.Ki,
+           sim->params.Kd);
+    
+    // MPC warm starts are not checkpointed, so MPC runs always start from the beginning
+    int checkpointing = checkpoint_interval > 0.0 && sim->controller != mpcController;
+    TankRunCheckpoint resumed;
+    int resuming = resume_runs && sim->controller != mpcController && loadRunCheckpoint(data, &resumed);
+    
+    // Initialize data collection (no real-time plotting); a resumed run continues its trace
+    void *realtimePlot = NULL;
+    ErrorCode plotErr = ERROR_SUCCESS;
+    if (resuming && resumed.traced) {
+        plotErr = resumeRealtimePlot(sim->name, data->windowIndex, &resumed.trace, &realtimePlot);
+        if (plotErr != ERROR_SUCCESS) {
+            printf("[Thread %s] Warning: Cannot continue the trace (error code %d), starting over\n",
+                   sim->name, plotErr);
+            resuming = 0;
+        }
+    }
+    if (realtimePlot == NULL) {
+        plotErr = initRealtimePlot(sim->name, data->windowIndex, &realtimePlot);
+    }
+    if (plotErr == ERROR_SUCCESS && realtimePlot != NULL) {
+        printf("[Thread %s] Data collection initialized\n", sim->name);
+    } else if (plotErr != ERROR_SUCCESS) {
+        printf("[Thread %s] Warning: Data collection failed with error code %d\n", sim->name, plotErr);
+    }
+    if (resuming && !resumed.traced && realtimePlot != NULL) {
+        resuming = 0;  // The trace of the saved run is gone: rerun it completely
+    }
+    
+    // Controller state (reset for each simulation)
+    ControllerState controllerState;
+    WaterTank tank;
+    ErrorCode initErr = initRunTank(&tank, sim, &controllerState, data->modelCallback, dt);
+    if (initErr != ERROR_SUCCESS) {
+        printf("[Thread %s] Error: Invalid tank model: Error code %d\n", sim->name, initErr);
+        if (realtimePlot) closeRealtimePlot(realtimePlot, sim->name);
+        endProfileRun(sim->name);
+        return;
+    }
+    
+    // Pick the specialized (inlined) stepper for this controller/model pair when one exists
+    TankStepper fastStep = NULL;
+    if (!use_generic_pipeline && selectTankStepper(&tank, sim->controller, &fastStep) != ERROR_SUCCESS) {
+        fastStep = NULL;
+    }
+    
+    // Real-time mode: each step waits for its absolute deadline (dt of wall-clock time)
+    RealtimeLoop rtLoop;
+    int realtime = 0;
+    if (realtime_mode) {
+        if ((realtime_cpu >= 0 || realtime_priority > 0) &&
+            setRealtimeThreadPolicy(realtime_cpu, realtime_priority) != ERROR_SUCCESS) {
+            printf("[Thread %s] Warning: Could not apply CPU pinning / SCHED_FIFO (missing privileges?)\n",
+                   sim->name);
+        }
+        realtime = initRealtimeLoop(&rtLoop, dt) == ERROR_SUCCESS;
+        if (!realtime) {
+            printf("[Thread %s] Warning: Real-time timer unavailable, running as fast as possible\n", sim->name);
+        }
+    }
+    
+    // Stop criteria; fast-forward would break the wall-clock rate, so it is off in real-time mode
+    int skip_at_rest = fast_forward && !realtime;
+    int monitor_stop = early_stop || skip_at_rest;
+    StopMonitor stopMonitor;
+    resetStopMonitor(&stopMonitor);
+    double skipped_time = 0.0;
     
     // Run simulation matching Python reference
     int i = 0;
+    data->stepsRun = 0;
     double max_time = data->sim_time;  // Use sim_time from thread data
+    if (resuming) {
+        restoreTankCheckpoint(&tank, &resumed.tank);
+        stopMonitor = resumed.stopMonitor;
+        skipped_time = resumed.skippedTime;
+        i = resumed.step;
+        data->stepsRun = resumed.stepsRun;
+        printf("[Thread %s] Resuming from checkpoint at t=%.2f\n", sim->name, i * dt);
+    }
+    double next_checkpoint = i * dt + checkpoint_interval;
+    SetpointCursor setpointCursor;
+    initSetpointCursor(&setpointCursor, &setpoint_profile);
+    
+    // MPC runs: condensed QP of the linearized tank, built once per run
+    MpcController mpc;
+    if (sim->controller == mpcController) {
+        MpcModel linear;
+        MpcConfig mpcConfig = tank_mpc_config;
+        mpcConfig.inputMax = tank.model.max_inflow;
+        if (linearizeTankModel(&tank.model, dt, &linear) == ERROR_SUCCESS &&
+            initMpcController(&mpc, &linear, &mpcConfig, dt) == ERROR_SUCCESS) {
+            tank.controller.mpc = &mpc;
+        } else {
+            printf("[Thread %s] Error: Invalid MPC configuration (horizon 1-%d, limits)\n", sim->name,
+                   MPC_MAX_HORIZON);
+            max_time = 0.0;  // Nothing to run; the data collection is still closed below
+        }
+    }
     while (keep_running && (i * dt < max_time)) {
         double current_time = i * dt;
         
-        // Setpoint profile matching Python Tank 1 reference (percentage 0-100%)
-        // Setpoint transitions: 70%→20%→90%→50% of max height (4.507 m)
-        if (current_time < 12.0) {
-            tank.setpoint = 70.0;  // 70% (3.1549 m)
-        } else if (current_time < 24.0) {
-            tank.setpoint = 20.0;  // 20% (0.9014 m)
-        } else if (current_time < 36.0) {
-            tank.setpoint = 90.0;  // 90% (4.0563 m)
-        } else {
-            tank.setpoint = 50.0;  // 50% (2.2535 m)
-        }
+        tank.setpoint = advanceSetpointCursor(&setpointCursor, current_time);
         
         // Update tank using specified controller
         double current_level;
-        ErrorCode err = updateSystem(&tank, dt, &current_level, 
-                                    sim->controller, NULL);
+        ErrorCode err;
+        PROFILE_SECTION(PROFILE_STEP, err = fastStep ? fastStep(&tank, dt, 1, &current_level)
+                                          : updateSystem(&tank, &tank.controller, tank.model.callback, dt,
+                                                         &current_level, sim->controller, NULL));
+        PROFILE_COUNT(PROFILE_STEP_ERRORS, err != ERROR_SUCCESS);
+        // The tank models do not limit the inflow: count the steps that ask for max_inflow or more
+        PROFILE_COUNT(PROFILE_SATURATIONS, tank.inflow >= tank.model.max_inflow);
         if (err != ERROR_SUCCESS) {
             printf("[Thread %s] Error during system update at t=%.2f: Error code %d\n", 
                    sim->name, current_time, err);
@@ -177,29 +406,445 @@ void* runSimulation(void *arg) {
         }
         
         i++;
+        data->stepsRun++;
+        
+        if (monitor_stop) {
+            StopReason reason = updateStopMonitor(&stopMonitor, &stop_criteria, tank.setpoint - current_level,
+                                                  current_level, tank.inflow, dt);
+            double hold_end = getSetpointHoldEnd(&setpointCursor, current_time);
+            if (reason == STOP_SETTLED && hold_end < max_time) {
+                // At rest before the next setpoint change: the state would not change until then,
+                // as long as the controller holds its state too
+                if (skip_at_rest && hold_end > current_time &&
+                    isControllerStateHeld(&tank, sim->controller, tank.setpoint - current_level)) {
+                    int first_skipped = i;
+                    while (i * dt < hold_end) i++;
+                    skipped_time += (i - first_skipped) * dt;
+                    // Hold the level up to the step so the trace stays a step response
+                    if (realtimePlot && i - 1 > first_skipped) {
+                        updateRealtimePlot(realtimePlot, (i - 1) * dt, current_level, tank.setpoint, tank.inflow);
+                    }
+                    resetStopMonitor(&stopMonitor);
+                }
+            } else if (reason != STOP_NONE && early_stop) {
+                printf("[Thread %s] Stopping early at t=%.2f (%s)\n", sim->name, current_time,
+                       getStopReasonName(reason));
+                break;
+            }
+        }
+        
+        // Save the run between two steps; the trace is flushed first so the file holds every row
+        if (checkpointing && i * dt >= next_checkpoint) {
+            TankRunCheckpoint checkpoint;
+            memset(&checkpoint, 0, sizeof(checkpoint));
+            checkpoint.dt = dt;
+            checkpoint.params = sim->params;
+            checkpoint.model = getRunModelId(data->modelCallback);
+            checkpoint.step = i;
+            checkpoint.stepsRun = data->stepsRun;
+            checkpoint.skippedTime = skipped_time;
+            checkpoint.stopMonitor = stopMonitor;
+            checkpoint.traced = realtimePlot != NULL;
+            saveTankCheckpoint(&tank, &checkpoint.tank);
+            char path[512];
+            getRunCheckpointPath(sim->name, path, sizeof(path));
+            ErrorCode ckpErr = realtimePlot ? getRealtimePlotCursor(realtimePlot, &checkpoint.trace) : ERROR_SUCCESS;
+            if (ckpErr == ERROR_SUCCESS) {
+                ckpErr = writeCheckpointFile(path, CHECKPOINT_KIND_TANK_RUN, &checkpoint, sizeof(checkpoint));
+            }
+            if (ckpErr != ERROR_SUCCESS) {
+                printf("[Thread %s] Warning: Checkpoint at t=%.2f failed: Error code %d\n", sim->name, i * dt, ckpErr);
+            }
+            while (next_checkpoint <= i * dt) next_checkpoint += checkpoint_interval;
+        }
         
-        // No real-time delay - run simulation as fast as possible
+        // Without --realtime there is no delay - run simulation as fast as possible
+        if (realtime) {
+            waitRealtimePeriod(&rtLoop);
+        }
+    }
+    
+    // A finished run (also one stopped early) needs no checkpoint anymore
+    if (checkpointing && keep_running) {
+        char path[512];
+        getRunCheckpointPath(sim->name, path, sizeof(path));
+        remove(path);
+    }
+    
+    if (tank.model.callback == tankModelAdaptive) {
+        data->integrator = tank.integrator;
+        printf("[Thread %s] Adaptive steps: %lu accepted, %lu rejected, %lu evaluations in %d ticks\n",
+               sim->name, tank.integrator.accepted, tank.integrator.rejected, tank.integrator.evaluations,
+               data->stepsRun);
+    }
+    
+    if (skipped_time > 0.0) {
+        printf("[Thread %s] Fast-forwarded %.2f s at rest\n", sim->name, skipped_time);
+    }
+    
+    if (tank.controller.mpc != NULL && mpc.solves > 0) {
+        printf("[Thread %s] MPC: %lu solves, %.2f ADMM iterations per tick, %lu at the iteration cap\n",
+               sim->name, mpc.solves, (double)mpc.iterations / (double)mpc.solves, mpc.capped);
+    }
+    
+    if (realtime) {
+        data->rtStats = rtLoop.stats;
+        closeRealtimeLoop(&rtLoop);
+        printRealtimeReport(stdout, sim->name, &data->rtStats);
     }
     
     // Save final plot to PNG
     if (realtimePlot) {
         printf("[Thread %s] Saving plot to PNG...\n", sim->name);
-        ErrorCode plotErr = closeRealtimePlot(realtimePlot, sim->name);
+        ErrorCode plotErr;
+        PROFILE_SECTION(PROFILE_TRACE_CLOSE, plotErr = closeRealtimePlot(realtimePlot, sim->name));
         if (plotErr != ERROR_SUCCESS) {
             printf("[Thread %s] Warning: Failed to save plot: Error code %d\n", sim->name, plotErr);
         }
     }
     
     printf("[Thread %s] Completed!\n", sim->name);
+    endProfileRun(sim->name);
+}
+
+// Run a cascade of `tanks` coupled tanks (--network): tank i is piped to tank i+1, only the
+// last tank drains, every tank runs its own PID on the setpoint profile. The network is split
+// into one partition per worker for every step.
+static int runTankNetworkCascade(int tanks, int num_threads, double dt, double t_end) {
+    const ControllerParams params = {0.35, 0.08, 0.50};  // Same gains as the PID run
+    ModelConfig model = {
+        .outflow_coeff = 0.1,
+        .area = M_PI * 5.0 * 5.0,
+        .max_inflow = 50.0,
+        .density = 1000.0,
+        .max_level = 4.507,
+        .callback = tankModel,
+        .netFlowCallback = calculateTankNetFlow
+    };
     
-#ifdef _WIN32
+    TankNetwork network;
+    if (initTankNetwork(&network, tanks, tanks - 1, &model) != ERROR_SUCCESS) {
+        printf("Failed to allocate a network of %d tanks\n", tanks);
+        return 1;
+    }
+    SetpointCursor setpointCursor;
+    initSetpointCursor(&setpointCursor, &setpoint_profile);
+    double initialSetpoint = advanceSetpointCursor(&setpointCursor, 0.0);
+    for (int i = 0; i < tanks; i++) {
+        setTankNetworkPlant(&network, i, 30.0, initialSetpoint, &params,
+                            (i + 1 == tanks) ? model.outflow_coeff : 0.0);
+        if (i + 1 < tanks) addTankNetworkPipe(&network, i, i + 1, NETWORK_PIPE_CONDUCTANCE);
+    }
+    if (finalizeTankNetwork(&network) != ERROR_SUCCESS) {
+        printf("Failed to build the pipe matrix\n");
+        freeTankNetwork(&network);
+        return 1;
+    }
+    
+    JobPool *pool = NULL;
+    if (createPlacedJobPool(num_threads, worker_placement, &pool) != ERROR_SUCCESS) {
+        printf("Failed to create worker pool\n");
+        freeTankNetwork(&network);
+        return 1;
+    }
+    int partitions = getJobPoolWorkerCount(pool);
+    if (partitions > TANK_NETWORK_MAX_PARTITIONS) partitions = TANK_NETWORK_MAX_PARTITIONS;
+    printf("Tank network: cascade of %d tanks, %d pipes, %d partitions\n\n", tanks, network.pipeCount, partitions);
+    printf("  %8s %10s %10s %10s %12s\n", "t (s)", "setpoint", "min %", "max %", "mean |err|");
+    
+    int reported = -1;  // Last segment reported
+    for (int i = 0; keep_running && i * dt < t_end; i++) {
+        double setpoint = advanceSetpointCursor(&setpointCursor, i * dt);
+        for (int k = 0; k < tanks; k++) network.setpoint[k] = setpoint;
+        
+        ErrorCode err = partitions > 1 ? stepTankNetworkParallel(&network, pool, partitions, dt)
+                                       : stepTankNetwork(&network, dt);
+        if (err != ERROR_SUCCESS) {
+            printf("Error during network step at t=%.2f: Error code %d\n", i * dt, err);
+            break;
+        }
+        
+        // One line at the end of every profile segment (and at the end of the run)
+        double next_time = (i + 1) * dt;
+        if (next_time >= t_end ||
+            (next_time >= getSetpointSegmentEnd(&setpointCursor) && reported != setpointCursor.segment)) {
+            double lo = INFINITY, hi = -INFINITY, error_sum = 0.0;
+            for (int k = 0; k < tanks; k++) {
+                lo = fmin(lo, network.level[k]);
+                hi = fmax(hi, network.level[k]);
+                error_sum += fabs(network.setpoint[k] - network.level[k]);
+            }
+            printf("  %8.2f %10.1f %10.2f %10.2f %12.3f\n", next_time, setpoint, lo, hi, error_sum / tanks);
+            reported = setpointCursor.segment;
+        }
+    }
+    
+    destroyJobPool(pool);
+    freeTankNetwork(&network);
+    return 0;
+}
+
+// One gain variant of the what-if sweep, forked from the shared checkpoint
+typedef struct {
+    const TankCheckpoint *fork;   // State at the fork (shared, read-only)
+    int forkStep;                 // Steps before the fork
+    double dt;
+    double t_end;
+    SystemModelCallback model;
+    SimulationConfig sim;         // Controller and the variant's gains
+    double scale;                 // Gain factor of the variant
+    double iae;                   // Integral of |error| after the fork (%·s)
+    double finalError;            // Error at t_end (%)
+    int steps;                    // Steps simulated after the fork
+    ErrorCode err;
+} WhatIfVariant;
+
+// Pick the specialized stepper of a run tank unless --generic is set
+static TankStepper selectRunStepper(WaterTank *tank, ControllerCallback controller) {
+    TankStepper fastStep = NULL;
+    if (use_generic_pipeline || selectTankStepper(tank, controller, &fastStep) != ERROR_SUCCESS) return NULL;
+    return fastStep;
+}
+
+// Step a run tank on the setpoint profile from step `*step` while t < until, as runSimulation does
+// Accumulates the integral of |error| into *iae and leaves *step at the first step not taken
+static ErrorCode advanceRunTank(WaterTank *tank, TankStepper fastStep, ControllerCallback controller, double dt,
+                                double until, int *step, double *iae) {
+    SetpointCursor setpointCursor;
+    initSetpointCursor(&setpointCursor, &setpoint_profile);
+    for (; keep_running && *step * dt < until; (*step)++) {
+        tank->setpoint = advanceSetpointCursor(&setpointCursor, *step * dt);
+        double level;
+        ErrorCode err = fastStep ? fastStep(tank, dt, 1, &level)
+                                 : updateSystem(tank, &tank->controller, tank->model.callback, dt, &level,
+                                                controller, NULL);
+        if (err != ERROR_SUCCESS) return err;
+        *iae += fabs(tank->setpoint - level) * dt;
+    }
+    return ERROR_SUCCESS;
+}
+
+// Job function: continue one variant from the fork to t_end (executed on a JobPool worker)
+static void runWhatIfVariant(void *arg) {
+    WhatIfVariant *variant = (WhatIfVariant*)arg;
+    ControllerState controllerState;
+    WaterTank tank;
+    variant->err = initRunTank(&tank, &variant->sim, &controllerState, variant->model, variant->dt);
+    if (variant->err != ERROR_SUCCESS) return;
+    restoreTankCheckpoint(&tank, variant->fork);
+    
+    int step = variant->forkStep;
+    variant->iae = 0.0;
+    variant->err = advanceRunTank(&tank, selectRunStepper(&tank, variant->sim.controller), variant->sim.controller,
+                                  variant->dt, variant->t_end, &step, &variant->iae);
+    variant->steps = step - variant->forkStep;
+    variant->finalError = tank.setpoint - tank.level;
+}
+
+// What-if gain sweep (--what-if): the PID run is simulated once up to the fork time and
+// checkpointed; every variant restores that checkpoint, scales the gains and runs to t_end.
+// The prefix is computed once instead of once per variant.
+static int runWhatIfSweep(int variants, double forkTime, int num_threads, double dt, double t_end) {
+    const ControllerParams baseParams = {0.35, 0.08, 0.50};  // Same gains as the PID run
+    SystemModelCallback model = adaptive_model ? tankModelAdaptive : tankModel;
+    SimulationConfig base = {NULL, NULL, NULL, NULL, "PID Controller", pidController, baseParams};
+    
+    ControllerState controllerState;
+    WaterTank tank;
+    ErrorCode err = initRunTank(&tank, &base, &controllerState, model, dt);
+    int forkStep = 0;
+    double prefixIae = 0.0;
+    if (err == ERROR_SUCCESS) {
+        err = advanceRunTank(&tank, selectRunStepper(&tank, base.controller), base.controller, dt,
+                             forkTime, &forkStep, &prefixIae);
+    }
+    TankCheckpoint fork;
+    if (err != ERROR_SUCCESS || saveTankCheckpoint(&tank, &fork) != ERROR_SUCCESS) {
+        printf("Error during the shared prefix: Error code %d\n", err);
+        return 1;
+    }
+    
+    WhatIfVariant *jobs = (WhatIfVariant*)calloc((size_t)variants, sizeof(WhatIfVariant));
+    JobPool *pool = NULL;
+    if (jobs == NULL || createPlacedJobPool(num_threads, worker_placement, &pool) != ERROR_SUCCESS) {
+        printf("Failed to set up %d what-if variants\n", variants);
+        free(jobs);
+        return 1;
+    }
+    for (int v = 0; v < variants; v++) {
+        WhatIfVariant *variant = &jobs[v];
+        double position = variants > 1 ? (double)v / (double)(variants - 1) : 0.5;
+        variant->scale = WHAT_IF_MIN_SCALE * pow(WHAT_IF_MAX_SCALE / WHAT_IF_MIN_SCALE, position);
+        variant->fork = &fork;
+        variant->forkStep = forkStep;
+        variant->dt = dt;
+        variant->t_end = t_end;
+        variant->model = model;
+        variant->sim = base;
+        variant->sim.params.Kp *= variant->scale;
+        variant->sim.params.Ki *= variant->scale;
+        variant->sim.params.Kd *= variant->scale;
+        if (submitJob(pool, runWhatIfVariant, variant) != ERROR_SUCCESS) {
+            variant->err = ERROR_CALLBACK_FAILED;
+        }
+    }
+    waitJobPool(pool);
+    destroyJobPool(pool);
+    
+    long variantSteps = 0;
+    printf("What-if sweep: %s forked at t=%.2f s (%d steps simulated once, IAE %.3f %%·s so far)\n\n",
+           base.name, forkStep * dt, forkStep, prefixIae);
+    printf("  %7s %8s %8s %8s %14s %12s\n", "scale", "Kp", "Ki", "Kd", "IAE after fork", "final error");
+    for (int v = 0; v < variants; v++) {
+        const WhatIfVariant *variant = &jobs[v];
+        variantSteps += variant->steps;
+        if (variant->err != ERROR_SUCCESS) {
+            printf("  %7.3f  failed: Error code %d\n", variant->scale, variant->err);
+            continue;
+        }
+        printf("  %7.3f %8.4f %8.4f %8.4f %14.3f %12.4f\n", variant->scale, variant->sim.params.Kp,
+               variant->sim.params.Ki, variant->sim.params.Kd, variant->iae, variant->finalError);
+    }
+    long unforked = (long)variants * forkStep + variantSteps;
+    printf("\nSteps: %ld computed, %ld without the fork (%.1f%% saved)\n", forkStep + variantSteps, unforked,
+           unforked > 0 ? 100.0 * (double)(unforked - forkStep - variantSteps) / (double)unforked : 0.0);
+    free(jobs);
     return 0;
-#else
-    return NULL;
-#endif
 }
 
-int main() {
+// Print command line usage
+static void printUsage(const char *program) {
+    printf("Usage: %s [--threads N] [--pin-threads] [--generic] [--live] [--realtime [--rt-cpu N] [--rt-priority P]]\n", program);
+    printf("       [--early-stop] [--fast-forward] [--settle-tol PCT] [--settle-time S]\n");
+    printf("       [--divergence-limit PCT]\n");
+    printf("       [--adaptive [--adaptive-tol TOL]] [--network N] [--mpc [--mpc-horizon N]]\n");
+    printf("       [--gain-schedule FILE] [--setpoint-profile FILE] [--checkpoint-every S] [--resume]\n");
+    printf("       [--what-if N [--what-if-at S]]\n");
+    printf("  --threads N    Worker threads (default: all hardware threads)\n");
+    printf("  --pin-threads  Pin every worker to one CPU, spreading the workers over the NUMA nodes\n");
+    printf("  --generic      Use the generic callback pipeline instead of the specialized steppers\n");
+    printf("  --live         Show a live gnuplot view of the running simulations\n");
+    printf("  --realtime     Run each controller at its real rate (one step per dt) and report timing\n");
+    printf("  --rt-cpu N     Real-time mode: pin simulation threads to CPU N\n");
+    printf("  --rt-priority P  Real-time mode: run simulation threads with SCHED_FIFO priority P\n");
+    printf("  --early-stop   End a run once it settled after the last setpoint step\n");
+    printf("  --fast-forward Skip to the next setpoint step while the tank is settled and at rest\n");
+    printf("  --settle-tol PCT  Settled band around the setpoint in %% (default: 0.5)\n");
+    printf("  --settle-time S   Time the level must stay settled in s (default: 2)\n");
+    printf("  --divergence-limit PCT  Early stop: end a run once |error| exceeds PCT %% (default: off)\n");
+    printf("  --adaptive     Integrate the Euler phase with the adaptive-step (Dormand-Prince) model\n");
+    printf("  --adaptive-tol TOL  Relative and absolute error tolerance of --adaptive (default: 1e-6)\n");
+    printf("  --network N    Simulate a cascade of N coupled tanks (pipes, one PID per tank) instead\n");
+    printf("  --mpc          Add a model-predictive controller run to every phase\n");
+    printf("  --mpc-horizon N  Prediction horizon of --mpc in steps (default: 20, at most %d)\n", MPC_MAX_HORIZON);
+    printf("  --gain-schedule FILE  Gain-schedule tables of the adaptive controllers (see gain_schedule.cfg)\n");
+    printf("  --setpoint-profile FILE  Setpoint segments of every run (see setpoint_profile.cfg)\n");
+    printf("  --checkpoint-every S  Save every run to results/checkpoint_<name>.ckp each S simulated seconds\n");
+    printf("  --resume       Continue interrupted runs (and their traces) from their checkpoints\n");
+    printf("  --what-if N    Fork N PID gain variants (%.1fx to %.1fx) from one checkpoint instead\n",
+           WHAT_IF_MIN_SCALE, WHAT_IF_MAX_SCALE);
+    printf("  --what-if-at S   Fork time of --what-if in s (default: the first setpoint change, %.0f s)\n",
+           DEFAULT_SETPOINT_SEGMENTS[1].start);
+}
+
+int main(int argc, char *argv[]) {
+    int num_threads = 0;  // 0 = one worker per hardware thread
+    initGainScheduleSet(&gain_schedules);
+    
+    // Parse command line options
+    for (int a = 1; a < argc; a++) {
+        if ((strcmp(argv[a], "--threads") == 0 || strcmp(argv[a], "-j") == 0) && a + 1 < argc) {
+            num_threads = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--pin-threads") == 0) {
+            worker_placement = JOB_POOL_PINNED;
+        } else if (strcmp(argv[a], "--generic") == 0) {
+            use_generic_pipeline = 1;
+        } else if (strcmp(argv[a], "--live") == 0) {
+            setPlotLiveView(1);
+        } else if (strcmp(argv[a], "--realtime") == 0) {
+            realtime_mode = 1;
+        } else if (strcmp(argv[a], "--rt-cpu") == 0 && a + 1 < argc) {
+            realtime_cpu = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--rt-priority") == 0 && a + 1 < argc) {
+            realtime_priority = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "--early-stop") == 0) {
+            early_stop = 1;
+        } else if (strcmp(argv[a], "--fast-forward") == 0) {
+            fast_forward = 1;
+        } else if (strcmp(argv[a], "--settle-tol") == 0 && a + 1 < argc) {
+            stop_criteria.settleTolerance = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--settle-time") == 0 && a + 1 < argc) {
+            stop_criteria.settleTime = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--divergence-limit") == 0 && a + 1 < argc) {
+            stop_criteria.divergenceLimit = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--adaptive") == 0) {
+            adaptive_model = 1;
+        } else if (strcmp(argv[a], "--adaptive-tol") == 0 && a + 1 < argc) {
+            adaptive_tolerance = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--network") == 0 && a + 1 < argc) {
+            network_tanks = atoi(argv[++a]);
+            if (network_tanks <= 0) {
+                printf("Network size must be positive\n");
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--mpc") == 0) {
+            use_mpc = 1;
+        } else if (strcmp(argv[a], "--mpc-horizon") == 0 && a + 1 < argc) {
+            tank_mpc_config.horizon = atoi(argv[++a]);
+            if (tank_mpc_config.horizon < 1 || tank_mpc_config.horizon > MPC_MAX_HORIZON) {
+                printf("MPC horizon must be 1-%d: %s\n", MPC_MAX_HORIZON, argv[a]);
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--gain-schedule") == 0 && a + 1 < argc) {
+            const char *path = argv[++a];
+            int line = 0;
+            ErrorCode err = loadGainScheduleSet(path, &gain_schedules, &line);
+            if (err == ERROR_CALLBACK_FAILED) {
+                printf("Cannot read gain schedule %s\n", path);
+                return 1;
+            } else if (err != ERROR_SUCCESS) {
+                printf("Invalid gain schedule %s (line %d, 0 = factor count mismatch)\n", path, line);
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--setpoint-profile") == 0 && a + 1 < argc) {
+            const char *path = argv[++a];
+            int line = 0;
+            freeSetpointProfile(&setpoint_profile);
+            ErrorCode err = loadSetpointProfile(path, &setpoint_profile, &line);
+            if (err == ERROR_CALLBACK_FAILED) {
+                printf("Cannot read setpoint profile %s\n", path);
+                return 1;
+            } else if (err != ERROR_SUCCESS) {
+                printf("Invalid setpoint profile %s (line %d, 0 = segments out of order or empty)\n", path, line);
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--checkpoint-every") == 0 && a + 1 < argc) {
+            checkpoint_interval = atof(argv[++a]);
+            if (!(checkpoint_interval > 0.0)) {
+                printf("Checkpoint interval must be positive\n");
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--resume") == 0) {
+            resume_runs = 1;
+        } else if (strcmp(argv[a], "--what-if") == 0 && a + 1 < argc) {
+            what_if_variants = atoi(argv[++a]);
+            if (what_if_variants <= 0) {
+                printf("Number of what-if variants must be positive\n");
+                return 1;
+            }
+        } else if (strcmp(argv[a], "--what-if-at") == 0 && a + 1 < argc) {
+            what_if_fork_time = atof(argv[++a]);
+        } else if (strcmp(argv[a], "--help") == 0 || strcmp(argv[a], "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            printf("Unknown option: %s\n", argv[a]);
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    
     // Install signal handler for Ctrl-C
 #ifdef _WIN32
     SetConsoleCtrlHandler(console_ctrl_handler, TRUE);
@@ -207,15 +852,33 @@ int main() {
     signal(SIGINT, signal_handler);
 #endif
     
-    printf("Water Tank Control System - Comparing P, PI, PD, and PID Controllers\n");
-    printf("=====================================================================\n");
-    printf("Running 50-second simulation (matching Python reference) and saving plots to PNG files...\n\n");
-    
     // Simulation parameters (matching Python reference: calculus_sim_waterTanks_Kp_controller.py)
     double dt = 0.04;             // Time step (s) - matches Python dt=0.04
     int n = 0;                    // Not used anymore
     double t_end = 50.0;          // Simulation end time (s) - matches Python t_end=50
     
+    if (setpoint_profile.segmentCount == 0) {
+        finishSetpointProfile(&setpoint_profile, DEFAULT_SETPOINT_SEGMENTS,
+                              (int)(sizeof(DEFAULT_SETPOINT_SEGMENTS) / sizeof(DEFAULT_SETPOINT_SEGMENTS[0])));
+    }
+    
+    // Coupled network mode replaces the 24 single-tank runs
+    if (network_tanks > 0) {
+        return runTankNetworkCascade(network_tanks, num_threads, dt, t_end);
+    }
+    
+    // What-if mode replaces them by gain variants forked from one shared prefix
+    if (what_if_variants > 0) {
+        // Default fork: the end of the first segment (mid-run for a single-segment profile)
+        double firstEnd = setpoint_profile.segments[0].end;
+        double forkTime = what_if_fork_time >= 0.0 ? what_if_fork_time : (firstEnd < t_end ? firstEnd : t_end / 2.0);
+        return runWhatIfSweep(what_if_variants, forkTime, num_threads, dt, t_end);
+    }
+    
+    printf("Water Tank Control System - Comparing P, PI, PD, and PID Controllers\n");
+    printf("=====================================================================\n");
+    printf("Running 50-second simulation (matching Python reference) and saving plots to PNG files...\n\n");
+    
     // Controller parameter definitions
     // System now uses PERCENTAGE (0-100%) for level and setpoint
     // Error is in percentage units, so gains can be smaller
@@ -230,9 +893,12 @@ int main() {
     const ControllerParams PARAMS_PI_ADAPTIVE = {0.80, 0.08, 0.0};  // PI Adaptive
     const ControllerParams PARAMS_PID         = {0.35, 0.08, 0.50}; // PID Controller
     const ControllerParams PARAMS_PID_ADAPTIVE = {1.0, 0.08, 0.50}; // PID Adaptive
+    const ControllerParams PARAMS_MPC         = {0.0,  0.0, 0.0};   // MPC: unused (tank_mpc_config)
     
-    // Configure 8 different controllers with optimized tuning
-    SimulationConfig simulations[8] = {
+    // Configure 8 different controllers with optimized tuning (a 9th, MPC, with --mpc)
+    int controllers = use_mpc ? 9 : 8;
+    int runs = 3 * controllers;
+    SimulationConfig simulations[9] = {
         // P Controller: Regular proportional control (high steady-state error)
         {NULL, NULL, NULL, NULL, "P Controller", pController, PARAMS_P},
         
@@ -255,67 +921,20 @@ int main() {
         {NULL, NULL, NULL, NULL, "PID Controller", pidController, PARAMS_PID},
         
         // Adaptive PID Controller: PID with gain scheduling (ultimate performance)
-        {NULL, NULL, NULL, NULL, "PID Adaptive Controller", adaptivePidController, PARAMS_PID_ADAPTIVE}
+        {NULL, NULL, NULL, NULL, "PID Adaptive Controller", adaptivePidController, PARAMS_PID_ADAPTIVE},
+        
+        // MPC Controller: constrained receding-horizon optimization on the linearized tank
+        {NULL, NULL, NULL, NULL, "MPC Controller", mpcController, PARAMS_MPC}
     };
     
     printf("Running simulations for all controller types in parallel...\n");
     printf("=================================================================\n\n");
     
-    // ============= FIRST RUN: Euler Integration (Standard) =============
-    printf("Phase 1: Running with Euler integration (standard model)...\n\n");
-    
-    // Create thread data for each simulation with Euler model
-    ThreadData threadData[8];
-    for (int s = 0; s < 8; s++) {
-        threadData[s].config = &simulations[s];
-        threadData[s].dt = dt;
-        threadData[s].n = n;
-        threadData[s].sim_time = t_end;  // Use t_end for simulation time
-        threadData[s].windowIndex = s;
-        threadData[s].modelCallback = tankModel;  // Euler integration
-    }
-    
-#ifdef _WIN32
-    // Windows threadst_end;  // Use t_end for simulation time
-    HANDLE threads[8];
-    for (int s = 0; s < 8; s++) {
-        threads[s] = (HANDLE)_beginthreadex(NULL, 0, runSimulation, &threadData[s], 0, NULL);
-        if (threads[s] == NULL) {
-            printf("Failed to create thread for %s\n", simulations[s].name);
-        }
-    }
-    
-    // Wait for all threads to complete with timeout
-    DWORD waitResult = WaitForMultipleObjects(8, threads, TRUE, INFINITE);
-    
-    // Close thread handles
-    for (int s = 0; s < 8; s++) {
-        CloseHandle(threads[s]);
-    }
-    
-    printf("\nPhase 1 completed. Euler integration plots saved.\n\n");
-#else
-    // POSIX threads
-    pthread_t threads[8];
-    for (int s = 0; s < 8; s++) {
-        if (pthread_create(&threads[s], NULL, runSimulation, &threadData[s]) != 0) {
-            printf("Failed to create thread for %s\n", simulations[s].name);
-        }
-    }
-    
-    // Wait for all threads to complete
-    for (int s = 0; s < 8; s++) {
-        pthread_join(threads[s], NULL);
-    }
-    
-    printf("\nPhase 1 completed. Euler integration plots saved.\n\n");
-#endif
-    
-    // ============= SECOND RUN: Trapezoidal Integration =============
-    printf("Phase 2: Running with Trapezoidal integration (improved accuracy)...\n\n");
-    
-    // Reconfigure all simulations with Trapezoidal model and update plot names
-    SimulationConfig simulationsTrapezoidal[8] = {
+    // Phase 1: Euler integration (standard model)
+    // Phase 2: Trapezoidal integration (improved accuracy)
+    // Phase 3: Simplified model (no outflow - matches Python reference)
+    // All runs are queued on one pool, so there is no barrier between phases
+    SimulationConfig simulationsTrapezoidal[9] = {
         {NULL, NULL, NULL, NULL, "P Controller Trapezoidal", pController, PARAMS_P},
         {NULL, NULL, NULL, NULL, "P Adaptive Controller Trapezoidal", adaptivePController, PARAMS_P_ADAPTIVE},
         {NULL, NULL, NULL, NULL, "PD Controller Trapezoidal", pdController, PARAMS_PD},
@@ -323,61 +942,11 @@ int main() {
         {NULL, NULL, NULL, NULL, "PI Controller Trapezoidal", piController, PARAMS_PI},
         {NULL, NULL, NULL, NULL, "PI Adaptive Controller Trapezoidal", adaptivePiController, PARAMS_PI_ADAPTIVE},
         {NULL, NULL, NULL, NULL, "PID Controller Trapezoidal", pidController, PARAMS_PID},
-        {NULL, NULL, NULL, NULL, "PID Adaptive Controller Trapezoidal", adaptivePidController, PARAMS_PID_ADAPTIVE}
+        {NULL, NULL, NULL, NULL, "PID Adaptive Controller Trapezoidal", adaptivePidController, PARAMS_PID_ADAPTIVE},
+        {NULL, NULL, NULL, NULL, "MPC Controller Trapezoidal", mpcController, PARAMS_MPC}
     };
     
-    // Create thread data for trapezoidal simulations
-    ThreadData threadDataTrap[8];
-    for (int s = 0; s < 8; s++) {
-        threadDataTrap[s].config = &simulationsTrapezoidal[s];
-        threadDataTrap[s].dt = dt;
-        threadDataTrap[s].n = n;
-        threadDataTrap[s].sim_time = t_end;  // Use t_end for simulation time
-        threadDataTrap[s].windowIndex = s + 8;  // Offset window index to avoid overlap
-        threadDataTrap[s].modelCallback = tankModelTrapezoidal;  // Trapezoidal integration
-    }
-    
-#ifdef _WIN32
-    // Windows threads for trapezoidat_end;  // Use t_end for simulation timeions
-    HANDLE threadsTrap[8];
-    for (int s = 0; s < 8; s++) {
-        threadsTrap[s] = (HANDLE)_beginthreadex(NULL, 0, runSimulation, &threadDataTrap[s], 0, NULL);
-        if (threadsTrap[s] == NULL) {
-            printf("Failed to create thread for %s\n", simulationsTrapezoidal[s].name);
-        }
-    }
-    
-    // Wait for all trapezoidal threads to complete
-    WaitForMultipleObjects(8, threadsTrap, TRUE, INFINITE);
-    
-    // Close thread handles
-    for (int s = 0; s < 8; s++) {
-        CloseHandle(threadsTrap[s]);
-    }
-    
-    printf("\nPhase 2 completed. Trapezoidal integration plots saved.\n");
-#else
-    // POSIX threads for trapezoidal simulations
-    pthread_t threadsTrap[8];
-    for (int s = 0; s < 8; s++) {
-        if (pthread_create(&threadsTrap[s], NULL, runSimulation, &threadDataTrap[s]) != 0) {
-            printf("Failed to create thread for %s\n", simulationsTrapezoidal[s].name);
-        }
-    }
-    
-    // Wait for all trapezoidal threads to complete
-    for (int s = 0; s < 8; s++) {
-        pthread_join(threadsTrap[s], NULL);
-    }
-    
-    printf("\nPhase 2 completed. Trapezoidal integration plots saved.\n");
-#endif
-    
-    // ============= THIRD RUN: Simplified Model (No Outflow) =============
-    printf("\nPhase 3: Running with Simplified model (no outflow - matches Python reference)...\n\n");
-    
-    // All 8 controllers for simplified model comparison
-    SimulationConfig simulationsSimplified[8] = {
+    SimulationConfig simulationsSimplified[9] = {
         {NULL, NULL, NULL, NULL, "P Controller Simplified", pController, PARAMS_P},
         {NULL, NULL, NULL, NULL, "P Adaptive Controller Simplified", adaptivePController, PARAMS_P_ADAPTIVE},
         {NULL, NULL, NULL, NULL, "PD Controller Simplified", pdController, PARAMS_PD},
@@ -385,61 +954,103 @@ int main() {
         {NULL, NULL, NULL, NULL, "PI Controller Simplified", piController, PARAMS_PI},
         {NULL, NULL, NULL, NULL, "PI Adaptive Controller Simplified", adaptivePiController, PARAMS_PI_ADAPTIVE},
         {NULL, NULL, NULL, NULL, "PID Controller Simplified", pidController, PARAMS_PID},
-        {NULL, NULL, NULL, NULL, "PID Adaptive Controller Simplified", adaptivePidController, PARAMS_PID_ADAPTIVE}
+        {NULL, NULL, NULL, NULL, "PID Adaptive Controller Simplified", adaptivePidController, PARAMS_PID_ADAPTIVE},
+        {NULL, NULL, NULL, NULL, "MPC Controller Simplified", mpcController, PARAMS_MPC}
     };
     
-    // Create thread data for simplified simulations
-    ThreadData threadDataSimp[8];
-    for (int s = 0; s < 8; s++) {
-        threadDataSimp[s].config = &simulationsSimplified[s];
-        threadDataSimp[s].dt = dt;
-        threadDataSimp[s].n = n;
-        threadDataSimp[s].sim_time = t_end;  // Use t_end for simulation time
-        threadDataSimp[s].windowIndex = s + 16;  // Offset window index to avoid overlap
-        threadDataSimp[s].modelCallback = tankModelTrapezoidalSimplified;  // Simplified model
-    }
+    SimulationConfig *phaseConfigs[3] = { simulations, simulationsTrapezoidal, simulationsSimplified };
+    SystemModelCallback phaseModels[3] = { adaptive_model ? tankModelAdaptive : tankModel,
+                                           tankModelTrapezoidal, tankModelTrapezoidalSimplified };
     
-#ifdef _WIN32
-    // Windows threads for simplified simulations
-    HANDLE threadsSimp[8];
-    for (int s = 0; s < 8; s++) {
-        threadsSimp[s] = (HANDLE)_beginthreadex(NULL, 0, runSimulation, &threadDataSimp[s], 0, NULL);
-        if (threadsSimp[s] == NULL) {
-            printf("Failed to create thread for %s\n", simulationsSimplified[s].name);
+    // Create thread data for every (phase, controller) pair
+    ThreadData threadData[27];
+    for (int phase = 0; phase < 3; phase++) {
+        for (int s = 0; s < controllers; s++) {
+            ThreadData *data = &threadData[phase * controllers + s];
+            data->config = &phaseConfigs[phase][s];
+            data->dt = dt;
+            data->n = n;
+            data->sim_time = t_end;  // Use t_end for simulation time
+            data->windowIndex = phase * controllers + s;  // Offset window index to avoid overlap
+            data->modelCallback = phaseModels[phase];
+            memset(&data->rtStats, 0, sizeof(data->rtStats));
+            data->stepsRun = 0;
+            initAdaptiveIntegrator(&data->integrator, 0.0, 0.0);
         }
     }
     
-    // Wait for all simplified threads to complete
-    WaitForMultipleObjects(8, threadsSimp, TRUE, INFINITE);
+    // Real-time runs must execute concurrently to keep their rate: one worker per run
+    if (realtime_mode && num_threads == 0) {
+        num_threads = runs;
+    }
+    
+    // Check gnuplot and start the trace writer thread
+    initPlot();
     
-    // Close thread handles
-    for (int s = 0; s < 8; s++) {
-        CloseHandle(threadsSimp[s]);
+    JobPool *pool = NULL;
+    if (createPlacedJobPool(num_threads, worker_placement, &pool) != ERROR_SUCCESS) {
+        printf("Failed to create worker pool\n");
+        closePlot();
+        return 1;
     }
+    if (worker_placement == JOB_POOL_PINNED) {
+        printf("Pinned %d of %d workers over %d NUMA node(s)\n", getJobPoolPinnedCount(pool),
+               getJobPoolWorkerCount(pool), getNumaNodeCount());
+    }
+    printf("Running %d simulations on %d worker threads...\n\n", runs, getJobPoolWorkerCount(pool));
     
-    printf("\nPhase 3 completed. Simplified model plots saved.\n");
-#else
-    // POSIX threads for simplified simulations
-    pthread_t threadsSimp[8];
-    for (int s = 0; s < 8; s++) {
-        if (pthread_create(&threadsSimp[s], NULL, runSimulation, &threadDataSimp[s]) != 0) {
-            printf("Failed to create thread for %s\n", simulationsSimplified[s].name);
+    for (int j = 0; j < runs; j++) {
+        if (submitJob(pool, runSimulation, &threadData[j]) != ERROR_SUCCESS) {
+            printf("Failed to queue simulation for %s\n", threadData[j].config->name);
+        }
+    }
+    
+    // Wait for all simulations to complete
+    waitJobPool(pool);
+    destroyJobPool(pool);
+    closePlot();
+    
+    if (realtime_mode) {
+        RealtimeStats total;
+        memset(&total, 0, sizeof(total));
+        for (int j = 0; j < runs; j++) {
+            mergeRealtimeStats(&total, &threadData[j].rtStats);
         }
+        printf("\n");
+        printRealtimeReport(stdout, "all simulations", &total);
     }
     
-    // Wait for all simplified threads to complete
-    for (int s = 0; s < 8; s++) {
-        pthread_join(threadsSimp[s], NULL);
+    if (adaptive_model) {
+        unsigned long accepted = 0, rejected = 0, evaluations = 0;
+        long ticks = 0;
+        for (int j = 0; j < controllers; j++) {
+            accepted += threadData[j].integrator.accepted;
+            rejected += threadData[j].integrator.rejected;
+            evaluations += threadData[j].integrator.evaluations;
+            ticks += threadData[j].stepsRun;
+        }
+        printf("\nAdaptive model: %lu steps accepted, %lu rejected, %lu evaluations over %ld controller ticks\n",
+               accepted, rejected, evaluations, ticks);
     }
     
-    printf("\nPhase 3 completed. Simplified model plots saved.\n");
-#endif
+    if (early_stop || fast_forward) {
+        long steps_run = 0;
+        long steps_full = 0;
+        while (steps_full * dt < t_end) steps_full++;  // Same step count as the run loop
+        steps_full *= runs;
+        for (int j = 0; j < runs; j++) {
+            steps_run += threadData[j].stepsRun;
+        }
+        printf("\nStop criteria: computed %ld of %ld steps (%.1f%% skipped)\n", steps_run, steps_full,
+               steps_full > 0 ? 100.0 * (double)(steps_full - steps_run) / (double)steps_full : 0.0);
+    }
     
     printf("\n=================================================================\n");
     printf("All simulations completed!\n\n");
     
     // Static plots are saved by real-time plotting
-    printf("Total plots generated: 24 (8 Euler + 8 Trapezoidal + 8 Simplified)\n");
+    printf("Total plots generated: %d (%d Euler + %d Trapezoidal + %d Simplified)\n", runs, controllers, controllers,
+           controllers);
     printf("All plots have been saved.\n");
     
     printf("\nPress Enter to close...\n");
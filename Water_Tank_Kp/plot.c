@@ -1,4 +1,9 @@
 #include "plot.h"
+#include "objectpool.h"
+#include "profile.h"
+#include "telemetry.h"
+#include "threads.h"
+#include "tracewriter.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,7 +12,6 @@
 #include <windows.h>
 #else
 #include <unistd.h>
-#include <pthread.h>
 #include <sys/stat.h>
 #include <math.h>
 #endif
@@ -15,32 +19,313 @@
 // Global state for plotting
 static int useFallback = 0;
 
-#ifdef _WIN32
-static CRITICAL_SECTION gnuplotMutex;
-static int mutexInitialized = 0;
-#endif
+// Batch script written instead when no gnuplot process can be started
+#define RENDER_SCRIPT_PATH "results/render_plots.gp"
+#define PROFILE_REPORT_PATH "results/profile.jsonl"
 
-// Structure to hold real-time plot data
-#define MAX_PLOT_POINTS 2000  // Store all data points (100s / 0.1s = 1000 points, 2000 for safety)
+// Live view (--live): telemetry frames streamed to a gnuplot window
+#define LIVE_FRAME_RATE 10.0
+#define LIVE_VALUE_COUNT 3       // level, setpoint, control
+static int liveViewEnabled = 0;
+static FILE *livePipe = NULL;
 
-typedef struct {
-    double time;
-    double level;
-    double setpoint;
-    double control;
-} PlotDataPoint;
+// Trace columns written for every run (time, level, setpoint, control)
+static const char *const traceColumns[] = { "time", "level", "setpoint", "control" };
+#define TRACE_COLUMN_COUNT ((int)(sizeof(traceColumns) / sizeof(traceColumns[0])))
 
 typedef struct {
-    FILE *gnuplotPipe;
     char sanitizedName[256];
-    int pointCount;
-    PlotDataPoint *dataBuffer;
-    int bufferSize;
-    int bufferIndex;
+    const char *controllerType;  // Results subdirectory (P, PI, PD, PID, MPC, other)
+    char tracePath[512];         // Binary trace read back by gnuplot
+    TraceWriter *trace;          // Streams samples to tracePath
+    TelemetryChannel *live;      // Live view channel (NULL unless --live)
     int windowIndex;
+    // Data ranges for axis scaling, tracked while streaming
+    double minTime, maxTime;
+    double minLevel, maxLevel;
+    double minControl, maxControl;
 } RealtimePlot;
 
+// Finished trace waiting to be rendered to PNG
+typedef struct RenderJob {
+    char controllerName[256];
+    char tracePath[512];
+    char outputName[512];
+    double minTime, maxTime;
+    double minLevel, maxLevel;
+    double minControl, maxControl;
+    struct RenderJob *next;
+} RenderJob;
+
+// Plot handles and render jobs recycled between runs (initPlot / closePlot)
+static ObjectPool plotPool;
+static ObjectPool renderJobPool;
+
+// Render queue: simulation threads enqueue finished traces, one render thread feeds them
+// to a single long-lived gnuplot process (or to a batch script if gnuplot can't be started)
+static struct {
+    ThreadMutex mutex;
+    ThreadCond jobAvailable;
+    RenderJob *head;             // FIFO of pending jobs
+    RenderJob *tail;
+    int stopping;                // Set by closePlot: drain the queue, then exit
+    int running;                 // Render thread started
+    int usePipe;                 // output is a gnuplot pipe (else a batch script file)
+    FILE *output;
+    ThreadHandle thread;
+} renderQueue;
+
+// Results subdirectory for a controller name
+static const char* getControllerType(const char *controllerName) {
+    if (strstr(controllerName, "MPC") != NULL) return "MPC";
+    if (strstr(controllerName, "PID") != NULL) return "PID";
+    if (strstr(controllerName, "PI") != NULL) return "PI";
+    if (strstr(controllerName, "PD") != NULL) return "PD";
+    if (strstr(controllerName, "P ") != NULL || strncmp(controllerName, "P ", 2) == 0) return "P";
+    return "other";
+}
+
+// Create results/ and results/<controllerType>/ if they don't exist
+static void createResultsDirectory(const char *controllerType) {
+    char subdir[256];
+    snprintf(subdir, sizeof(subdir), "results/%s", controllerType);
+#ifdef _WIN32
+    CreateDirectoryA("results", NULL);
+    CreateDirectoryA(subdir, NULL);
+#else
+    mkdir("results", 0755);
+    mkdir(subdir, 0755);
+#endif
+}
+
+// Write the gnuplot commands for one job (two-panel PNG read from the binary trace)
+static void writeRenderCommands(FILE *out, const RenderJob *job) {
+    // Add margins to ranges
+    double timeMargin = (job->maxTime - job->minTime) * 0.05;
+    double levelMargin = (job->maxLevel - job->minLevel) * 0.1;
+    double controlMargin = (job->maxControl - job->minControl) * 0.1;
+    
+    // Ensure minimum margin if range is too small
+    if (levelMargin < 0.5) levelMargin = 0.5;
+    if (controlMargin < 0.05) controlMargin = 0.05;
+    
+    // gnuplot reads the float64 rows straight from the trace file (binary input, no text formatting)
+    char traceSource[768];
+    snprintf(traceSource, sizeof(traceSource),
+             "'%s' binary skip=%d format='%%float64%%float64%%float64%%float64' endian=little",
+             job->tracePath, 32 + TRACE_COLUMN_COUNT * TRACE_COLUMN_NAME_SIZE);
+    
+    fprintf(out, "set output '%s'\n", job->outputName);
+    fprintf(out, "set multiplot layout 2,1\n");
+    fprintf(out, "set grid\n");
+    fprintf(out, "set xlabel 'Time (s)'\n");
+    fprintf(out, "set key top right\n");
+    
+    // Plot water level with explicit ranges to avoid warnings
+    fprintf(out, "set title 'Water Tank Level Control - %s'\n", job->controllerName);
+    fprintf(out, "set ylabel 'Water Level (m)'\n");
+    fprintf(out, "set xrange [%f:%f]\n", job->minTime - timeMargin, job->maxTime + timeMargin);
+    fprintf(out, "set yrange [%f:%f]\n", job->minLevel - levelMargin, job->maxLevel + levelMargin);
+    fprintf(out, "plot %s using 1:2 with lines lw 2 lt rgb 'blue' title 'Actual Level', "
+            "%s using 1:3 with lines lw 2 lt rgb 'red' dashtype 2 title 'Setpoint'\n", traceSource, traceSource);
+    
+    // Plot control signal with explicit ranges
+    fprintf(out, "set title 'Control Signal (Inflow Rate) - %s'\n", job->controllerName);
+    fprintf(out, "set ylabel 'Inflow (m³/s)'\n");
+    fprintf(out, "set xrange [%f:%f]\n", job->minTime - timeMargin, job->maxTime + timeMargin);
+    fprintf(out, "set yrange [%f:%f]\n", job->minControl - controlMargin, job->maxControl + controlMargin);
+    fprintf(out, "plot %s using 1:4 with lines lw 2 lt rgb 'green' title 'Control Signal'\n", traceSource);
+    
+    fprintf(out, "unset multiplot\n");
+    fprintf(out, "set output\n");  // Close output file
+}
+
+// Render thread: drains the queue until closePlot() sets stopping
+static ThreadReturn THREAD_CALL renderMain(void *arg) {
+    (void)arg;
+    
+    for (;;) {
+        threadMutexLock(&renderQueue.mutex);
+        while (renderQueue.head == NULL && !renderQueue.stopping) {
+            threadCondWait(&renderQueue.jobAvailable, &renderQueue.mutex);
+        }
+        RenderJob *job = renderQueue.head;
+        if (job != NULL) {
+            renderQueue.head = job->next;
+            if (renderQueue.head == NULL) renderQueue.tail = NULL;
+        }
+        threadMutexUnlock(&renderQueue.mutex);
+        
+        if (job == NULL) break;  // Stopping and queue drained
+        
+        writeRenderCommands(renderQueue.output, job);
+        fflush(renderQueue.output);
+        if (renderQueue.usePipe) {
+            printf("Plot saved to '%s'\n", job->outputName);
+        }
+        returnPoolObject(&renderJobPool, job);
+    }
+    return THREAD_RETURN_VALUE;
+}
+
+// Open the render output (gnuplot pipe, or the batch script) and start the render thread
+static void startRenderQueue(void) {
+    renderQueue.head = renderQueue.tail = NULL;
+    renderQueue.stopping = 0;
+    renderQueue.output = NULL;
+    renderQueue.usePipe = 0;
+    
+    if (!useFallback) {
+#ifdef _WIN32
+        _putenv("PATH=C:\\Program Files\\gnuplot\\bin;%PATH%");
+        renderQueue.output = _popen("\"C:\\Program Files\\gnuplot\\bin\\wgnuplot.exe\"", "w");
+#else
+        renderQueue.output = popen("gnuplot", "w");
+#endif
+        renderQueue.usePipe = renderQueue.output != NULL;
+    }
+    if (renderQueue.output == NULL) {
+#ifdef _WIN32
+        CreateDirectoryA("results", NULL);
+#else
+        mkdir("results", 0755);
+#endif
+        renderQueue.output = fopen(RENDER_SCRIPT_PATH, "w");
+        if (renderQueue.output == NULL) {
+            fprintf(stderr, "Warning: Could not create %s, plots will not be rendered\n", RENDER_SCRIPT_PATH);
+            return;
+        }
+    }
+    fprintf(renderQueue.output, "set terminal pngcairo size 1000,700 enhanced font 'Verdana,10'\n");
+    
+    threadMutexInit(&renderQueue.mutex);
+    threadCondInit(&renderQueue.jobAvailable);
+    renderQueue.running = threadCreate(&renderQueue.thread, renderMain, NULL);
+    if (!renderQueue.running) {
+        fprintf(stderr, "Warning: Could not start the render thread, plots will not be rendered\n");
+        threadCondDestroy(&renderQueue.jobAvailable);
+        threadMutexDestroy(&renderQueue.mutex);
+    }
+}
+
+// Render every queued job, then close gnuplot (waits for the last PNG) or the script
+static void stopRenderQueue(void) {
+    if (renderQueue.running) {
+        threadMutexLock(&renderQueue.mutex);
+        renderQueue.stopping = 1;
+        threadCondSignal(&renderQueue.jobAvailable);
+        threadMutexUnlock(&renderQueue.mutex);
+        
+        threadJoin(renderQueue.thread);
+        renderQueue.running = 0;
+        threadCondDestroy(&renderQueue.jobAvailable);
+        threadMutexDestroy(&renderQueue.mutex);
+    }
+    if (renderQueue.output == NULL) return;
+    
+    if (renderQueue.usePipe) {
+        fprintf(renderQueue.output, "exit\n");  // Explicitly tell gnuplot to exit
+        fflush(renderQueue.output);
+#ifdef _WIN32
+        _pclose(renderQueue.output);
+#else
+        pclose(renderQueue.output);
+#endif
+    } else {
+        fclose(renderQueue.output);
+        printf("gnuplot not available: render the plots later with 'gnuplot %s'\n", RENDER_SCRIPT_PATH);
+    }
+    renderQueue.output = NULL;
+}
+
+// Live view frame (viewer thread): level and control of every running simulation
+static void renderLiveFrame(void *context, const TelemetryView *views, int viewCount) {
+    FILE *out = (FILE*)context;
+    
+    // Empty datablocks can't be plotted yet
+    int plottable = 0;
+    for (int v = 0; v < viewCount; v++) {
+        if (views[v].historyCount > 0) plottable++;
+    }
+    if (plottable == 0) return;
+    
+    for (int v = 0; v < viewCount; v++) {
+        fprintf(out, "$run%d << EOD\n", v);
+        for (int i = 0; i < views[v].historyCount; i++) {
+            const TelemetrySample *sample = &views[v].history[i];
+            fprintf(out, "%f %f %f %f\n", sample->time, sample->values[0], sample->values[1], sample->values[2]);
+        }
+        fprintf(out, "EOD\n");
+    }
+    
+    fprintf(out, "set multiplot layout 2,1 title 'Live view (%d running)'\n", viewCount);
+    fprintf(out, "set grid\n");
+    fprintf(out, "set key outside right noenhanced\n");
+    fprintf(out, "set autoscale\n");
+    const char *panels[2][2] = { { "Water Level (m)", "2" }, { "Inflow (m³/s)", "4" } };
+    for (int p = 0; p < 2; p++) {
+        fprintf(out, "set ylabel '%s'\n", panels[p][0]);
+        fprintf(out, "plot ");
+        const char *separator = "";
+        for (int v = 0; v < viewCount; v++) {
+            if (views[v].historyCount == 0) continue;
+            fprintf(out, "%s$run%d using 1:%s with lines title '%s'", separator,
+                    v, panels[p][1], views[v].name);
+            separator = ", ";
+        }
+        fprintf(out, "\n");
+    }
+    fprintf(out, "unset multiplot\n");
+    fflush(out);
+}
+
+// Open the live gnuplot window and start the telemetry viewer
+static void startLiveView(void) {
+    if (useFallback) {
+        fprintf(stderr, "Warning: gnuplot not found, live view disabled\n");
+        return;
+    }
+#ifdef _WIN32
+    livePipe = _popen("\"C:\\Program Files\\gnuplot\\bin\\wgnuplot.exe\" -persist", "w");
+#else
+    livePipe = popen("gnuplot -persist", "w");
+#endif
+    if (livePipe == NULL) {
+        fprintf(stderr, "Warning: Could not start gnuplot, live view disabled\n");
+        return;
+    }
+    if (startTelemetryViewer(LIVE_FRAME_RATE, renderLiveFrame, livePipe) != ERROR_SUCCESS) {
+        fprintf(stderr, "Warning: Could not start the telemetry viewer, live view disabled\n");
+#ifdef _WIN32
+        _pclose(livePipe);
+#else
+        pclose(livePipe);
+#endif
+        livePipe = NULL;
+    }
+}
+
+// Render the final live frame and close the window's pipe (the window persists)
+static void stopLiveView(void) {
+    stopTelemetryViewer();
+    if (livePipe) {
+#ifdef _WIN32
+        _pclose(livePipe);
+#else
+        pclose(livePipe);
+#endif
+        livePipe = NULL;
+    }
+}
+
+void setPlotLiveView(int enabled) {
+    liveViewEnabled = enabled;
+}
+
 void initPlot(void) {
+    initObjectPool(&plotPool, sizeof(RealtimePlot));
+    initObjectPool(&renderJobPool, sizeof(RenderJob));
+    
     // Check if gnuplot is available
 #ifdef _WIN32
     FILE *test = _popen("gnuplot-qt5 --version 2>nul", "r");
@@ -51,34 +336,71 @@ void initPlot(void) {
     FILE *test = popen("gnuplot --version 2>/dev/null", "r");
 #endif
     
-    if (test == NULL) {
-        fprintf(stderr, "Warning: gnuplot not found. Falling back to CSV output.\n");
-        fprintf(stderr, "Data will be saved to 'output.csv'. You can plot it with Excel or another tool.\n");
+    // The shell starts even without gnuplot, so a missing binary shows up in the exit status
+    int status = -1;
+    if (test != NULL) {
+        char line[128];
+        while (fgets(line, sizeof(line), test) != NULL) { }
+#ifdef _WIN32
+        status = _pclose(test);
+#else
+        status = pclose(test);
+#endif
+    }
+    
+    if (status != 0) {
+        fprintf(stderr, "Warning: gnuplot not found. Plot commands will be saved to '%s'.\n", RENDER_SCRIPT_PATH);
+        fprintf(stderr, "Traces are still written to results/<type>/trace_<name>.trc.\n");
         useFallback = 1;
-    } else {
+    }
+    
+    // Counters of the instrumentation build (common/profile.h) go to PROFILE_REPORT_PATH
+#ifdef ACS_PROFILE
 #ifdef _WIN32
-        _pclose(test);
+    CreateDirectoryA("results", NULL);
 #else
-        pclose(test);
+    mkdir("results", 0755);
+#endif
+    if (openProfileReport(PROFILE_REPORT_PATH, "water_tank") != ERROR_SUCCESS) {
+        fprintf(stderr, "Warning: Could not create %s\n", PROFILE_REPORT_PATH);
+    }
 #endif
+    
+    // Traces are streamed to disk by a background writer thread
+    if (startTraceWriterThread() != ERROR_SUCCESS) {
+        fprintf(stderr, "Error: Could not start the trace writer thread\n");
+    }
+    
+    // Finished traces are rendered to PNG by the render thread
+    startRenderQueue();
+    
+    if (liveViewEnabled) {
+        startLiveView();
     }
 }
 
 void closePlot(void) {
-    // Not needed for script file approach
+    stopLiveView();
+    stopRenderQueue();
+    stopTraceWriterThread();
+    closeProfileReport();
+    releaseObjectPool(&renderJobPool, NULL);
+    releaseObjectPool(&plotPool, NULL);
 }
 
 int isPlotFallbackEnabled(void) {
     return useFallback;
 }
 
-ErrorCode initRealtimePlot(const char *controllerName, int windowIndex, void **plotHandle) {
+// Open the plot of a run: a new trace, or the trace of a resumed run continued at cursor
+static ErrorCode openRealtimePlot(const char *controllerName, int windowIndex, const PlotCursor *cursor,
+                                  void **plotHandle) {
     if (plotHandle == NULL || controllerName == NULL) return ERROR_NULL_POINTER;
     
     *plotHandle = NULL;
     
     // Always create plot structure to store data, even if gnuplot isn't available
-    RealtimePlot *plot = (RealtimePlot*)malloc(sizeof(RealtimePlot));
+    RealtimePlot *plot = (RealtimePlot*)takePoolObject(&plotPool);
     if (!plot) return ERROR_NULL_POINTER;
     
     // Sanitize controller name
@@ -87,40 +409,99 @@ ErrorCode initRealtimePlot(const char *controllerName, int windowIndex, void **p
         if (plot->sanitizedName[i] == ' ') plot->sanitizedName[i] = '_';
     }
     
-    plot->pointCount = 0;
-    plot->bufferSize = MAX_PLOT_POINTS;
-    plot->bufferIndex = 0;
     plot->windowIndex = windowIndex;
-    plot->gnuplotPipe = NULL;  // No real-time plotting, only save at end
+    plot->minTime = plot->minLevel = plot->minControl = 0.0;
+    plot->maxTime = plot->maxLevel = plot->maxControl = 0.0;
+    if (cursor != NULL) {
+        plot->minTime = cursor->minTime;
+        plot->maxTime = cursor->maxTime;
+        plot->minLevel = cursor->minLevel;
+        plot->maxLevel = cursor->maxLevel;
+        plot->minControl = cursor->minControl;
+        plot->maxControl = cursor->maxControl;
+    }
     
-    plot->dataBuffer = (PlotDataPoint*)malloc(MAX_PLOT_POINTS * sizeof(PlotDataPoint));
-    if (!plot->dataBuffer) {
-        free(plot);
-        return ERROR_NULL_POINTER;
+    // Stream samples to results/<type>/trace_<name>.trc (float64 rows)
+    plot->controllerType = getControllerType(controllerName);
+    createResultsDirectory(plot->controllerType);
+    snprintf(plot->tracePath, sizeof(plot->tracePath), "results/%s/trace_%s%s",
+             plot->controllerType, plot->sanitizedName, getTraceFileExtension(TRACE_FORMAT_BINARY_F64));
+    ErrorCode err = cursor != NULL
+        ? reopenTraceWriter(plot->tracePath, TRACE_FORMAT_BINARY_F64, TRACE_COLUMN_COUNT, traceColumns,
+                            cursor->rows, &plot->trace)
+        : openTraceWriter(plot->tracePath, TRACE_FORMAT_BINARY_F64, TRACE_COLUMN_COUNT, traceColumns,
+                          &plot->trace);
+    if (err != ERROR_SUCCESS) {
+        returnPoolObject(&plotPool, plot);
+        return err;
+    }
+    
+    // Live view is best effort: without a channel the run is just not shown
+    plot->live = NULL;
+    if (isTelemetryViewerRunning()) {
+        openTelemetryChannel(controllerName, LIVE_VALUE_COUNT, &plot->live);
     }
     
     *plotHandle = plot;
     return ERROR_SUCCESS;
 }
 
+ErrorCode initRealtimePlot(const char *controllerName, int windowIndex, void **plotHandle) {
+    return openRealtimePlot(controllerName, windowIndex, NULL, plotHandle);
+}
+
+ErrorCode resumeRealtimePlot(const char *controllerName, int windowIndex, const PlotCursor *cursor,
+                             void **plotHandle) {
+    if (cursor == NULL) return ERROR_NULL_POINTER;
+    return openRealtimePlot(controllerName, windowIndex, cursor, plotHandle);
+}
+
+ErrorCode getRealtimePlotCursor(void *plotHandle, PlotCursor *cursor) {
+    if (plotHandle == NULL || cursor == NULL) return ERROR_NULL_POINTER;
+    
+    RealtimePlot *plot = (RealtimePlot*)plotHandle;
+    ErrorCode err = flushTraceWriter(plot->trace);
+    if (err != ERROR_SUCCESS) return err;
+    cursor->rows = getTraceRowCount(plot->trace);
+    cursor->minTime = plot->minTime;
+    cursor->maxTime = plot->maxTime;
+    cursor->minLevel = plot->minLevel;
+    cursor->maxLevel = plot->maxLevel;
+    cursor->minControl = plot->minControl;
+    cursor->maxControl = plot->maxControl;
+    return ERROR_SUCCESS;
+}
+
 ErrorCode updateRealtimePlot(void *plotHandle, double time, double level, 
                              double setpoint, double control_signal) {
     if (!plotHandle) return ERROR_NULL_POINTER;
     
     RealtimePlot *plot = (RealtimePlot*)plotHandle;
+    const double row[TRACE_COLUMN_COUNT] = { time, level, setpoint, control_signal };
     
-    // Store in circular buffer
-    plot->dataBuffer[plot->bufferIndex].time = time;
-    plot->dataBuffer[plot->bufferIndex].level = level;
-    plot->dataBuffer[plot->bufferIndex].setpoint = setpoint;
-    plot->dataBuffer[plot->bufferIndex].control = control_signal;
-    
-    plot->bufferIndex = (plot->bufferIndex + 1) % plot->bufferSize;
-    plot->pointCount++;
+    // Track data ranges so the plot can be scaled without reading the trace back
+    if (getTraceRowCount(plot->trace) == 0) {
+        plot->minTime = plot->maxTime = time;
+        plot->minLevel = plot->maxLevel = level;
+        plot->minControl = plot->maxControl = control_signal;
+    } else {
+        if (time < plot->minTime) plot->minTime = time;
+        if (time > plot->maxTime) plot->maxTime = time;
+        if (level < plot->minLevel) plot->minLevel = level;
+        if (level > plot->maxLevel) plot->maxLevel = level;
+        if (control_signal < plot->minControl) plot->minControl = control_signal;
+        if (control_signal > plot->maxControl) plot->maxControl = control_signal;
+    }
     
-    // No real-time plotting - data is just stored and plotted at the end
+    // Live view push is wait-free (dropped if the viewer is behind)
+    if (plot->live) {
+        pushTelemetrySample(plot->live, time, &row[1]);
+    }
     
-    return ERROR_SUCCESS;
+    // Stream the sample; full chunks are written by the background thread
+    ErrorCode err;
+    PROFILE_SECTION(PROFILE_TRACE_APPEND, err = appendTraceRow(plot->trace, row));
+    return err;
 }
 
 ErrorCode closeRealtimePlot(void *plotHandle, const char *controllerName) {
@@ -129,168 +510,62 @@ ErrorCode closeRealtimePlot(void *plotHandle, const char *controllerName) {
     
     RealtimePlot *plot = (RealtimePlot*)plotHandle;
     
-    // Prepare data range
-    int totalPoints = (plot->pointCount < plot->bufferSize) ? plot->pointCount : plot->bufferSize;
-    int startIdx = (plot->pointCount < plot->bufferSize) ? 0 : plot->bufferIndex;
-    
-    // Open gnuplot pipe only for final PNG generation
-#ifdef _WIN32
-    _putenv("PATH=C:\\Program Files\\gnuplot\\bin;%PATH%");
-    plot->gnuplotPipe = _popen("\"C:\\Program Files\\gnuplot\\bin\\wgnuplot.exe\"", "w");
-#else
-    plot->gnuplotPipe = popen("gnuplot -persist", "w");
-#endif
-    
-    if (!plot->gnuplotPipe) {
-        free(plot->dataBuffer);
-        free(plot);
-        return ERROR_CALLBACK_FAILED;
+    // The viewer shows the run one last time and frees the channel
+    closeTelemetryChannel(plot->live);
+    plot->live = NULL;
+    
+    // Flush the trace so gnuplot can read the complete file
+    long totalPoints = getTraceRowCount(plot->trace);
+    ErrorCode traceErr = closeTraceWriter(plot->trace);
+    plot->trace = NULL;
+    if (traceErr != ERROR_SUCCESS) {
+        fprintf(stderr, "Error: Could not write trace file %s\n", plot->tracePath);
+        returnPoolObject(&plotPool, plot);
+        return traceErr;
     }
     
     // Validate we have data to plot
     if (totalPoints < 2) {
-        fprintf(stderr, "Warning: Not enough data points (%d) to generate plot for %s\n", 
+        fprintf(stderr, "Warning: Not enough data points (%ld) to generate plot for %s\n", 
                 totalPoints, controllerName);
-        free(plot->dataBuffer);
-#ifdef _WIN32
-        _pclose(plot->gnuplotPipe);
-#else
-        pclose(plot->gnuplotPipe);
-#endif
-        free(plot);
+        returnPoolObject(&plotPool, plot);
         return ERROR_CALLBACK_FAILED;
     }
     
-    // Calculate data ranges for proper axis scaling
-    double minTime = plot->dataBuffer[startIdx].time;
-    double maxTime = plot->dataBuffer[startIdx].time;
-    double minLevel = plot->dataBuffer[startIdx].level;
-    double maxLevel = plot->dataBuffer[startIdx].level;
-    double minControl = plot->dataBuffer[startIdx].control;
-    double maxControl = plot->dataBuffer[startIdx].control;
-    
-    for (int i = 0; i < totalPoints; i++) {
-        int idx = (startIdx + i) % plot->bufferSize;
-        double t = plot->dataBuffer[idx].time;
-        double l = plot->dataBuffer[idx].level;
-        double c = plot->dataBuffer[idx].control;
-        
-        if (t < minTime) minTime = t;
-        if (t > maxTime) maxTime = t;
-        if (l < minLevel) minLevel = l;
-        if (l > maxLevel) maxLevel = l;
-        if (c < minControl) minControl = c;
-        if (c > maxControl) maxControl = c;
-    }
-    
-    // Add margins to ranges
-    double timeMargin = (maxTime - minTime) * 0.05;
-    double levelMargin = (maxLevel - minLevel) * 0.1;
-    double controlMargin = (maxControl - minControl) * 0.1;
-    
-    // Ensure minimum margin if range is too small
-    if (levelMargin < 0.5) levelMargin = 0.5;
-    if (controlMargin < 0.05) controlMargin = 0.05;
-    
-    // Save to PNG file using datablocks (already defined from real-time updates)
-    // Redefine datablocks with all collected data
-    fprintf(plot->gnuplotPipe, "$level << EOD\n");
-    for (int i = 0; i < totalPoints; i++) {
-        int idx = (startIdx + i) % plot->bufferSize;
-        fprintf(plot->gnuplotPipe, "%f %f\n", plot->dataBuffer[idx].time, plot->dataBuffer[idx].level);
-    }
-    fprintf(plot->gnuplotPipe, "EOD\n");
-    
-    fprintf(plot->gnuplotPipe, "$setpoint << EOD\n");
-    for (int i = 0; i < totalPoints; i++) {
-        int idx = (startIdx + i) % plot->bufferSize;
-        fprintf(plot->gnuplotPipe, "%f %f\n", plot->dataBuffer[idx].time, plot->dataBuffer[idx].setpoint);
+    if (!renderQueue.running) {
+        returnPoolObject(&plotPool, plot);
+        return ERROR_CALLBACK_FAILED;
     }
-    fprintf(plot->gnuplotPipe, "EOD\n");
     
-    fprintf(plot->gnuplotPipe, "$control << EOD\n");
-    for (int i = 0; i < totalPoints; i++) {
-        int idx = (startIdx + i) % plot->bufferSize;
-        fprintf(plot->gnuplotPipe, "%f %f\n", plot->dataBuffer[idx].time, plot->dataBuffer[idx].control);
+    // Hand the finished trace to the render thread and return immediately
+    RenderJob *job = (RenderJob*)takePoolObject(&renderJobPool);
+    if (!job) {
+        returnPoolObject(&plotPool, plot);
+        return ERROR_NULL_POINTER;
     }
-    fprintf(plot->gnuplotPipe, "EOD\n");
-    
-    // Flush datablocks before plotting to ensure they're ready
-    fflush(plot->gnuplotPipe);
-    
-    // Determine controller type and create appropriate subdirectory
-    const char *controllerType = "other";
-    if (strstr(controllerName, "PID") != NULL) {
-        controllerType = "PID";
-    } else if (strstr(controllerName, "PI") != NULL) {
-        controllerType = "PI";
-    } else if (strstr(controllerName, "PD") != NULL) {
-        controllerType = "PD";
-    } else if (strstr(controllerName, "P ") != NULL || strncmp(controllerName, "P ", 2) == 0) {
-        controllerType = "P";
+    snprintf(job->controllerName, sizeof(job->controllerName), "%s", controllerName);
+    snprintf(job->tracePath, sizeof(job->tracePath), "%s", plot->tracePath);
+    snprintf(job->outputName, sizeof(job->outputName), "results/%s/plot_%s.png",
+             plot->controllerType, plot->sanitizedName);
+    job->minTime = plot->minTime;
+    job->maxTime = plot->maxTime;
+    job->minLevel = plot->minLevel;
+    job->maxLevel = plot->maxLevel;
+    job->minControl = plot->minControl;
+    job->maxControl = plot->maxControl;
+    job->next = NULL;
+    
+    threadMutexLock(&renderQueue.mutex);
+    if (renderQueue.tail) {
+        renderQueue.tail->next = job;
+    } else {
+        renderQueue.head = job;
     }
+    renderQueue.tail = job;
+    threadCondSignal(&renderQueue.jobAvailable);
+    threadMutexUnlock(&renderQueue.mutex);
     
-    // Create results directory structure if it doesn't exist
-#ifdef _WIN32
-    CreateDirectoryA("results", NULL);
-    char subdir[256];
-    snprintf(subdir, sizeof(subdir), "results/%s", controllerType);
-    CreateDirectoryA(subdir, NULL);
-#else
-    mkdir("results", 0755);
-    char subdir[256];
-    snprintf(subdir, sizeof(subdir), "results/%s", controllerType);
-    mkdir(subdir, 0755);
-#endif
-    
-    // Now save to PNG using datablocks in the appropriate subdirectory
-    char outputName[512];
-    snprintf(outputName, sizeof(outputName), "results/%s/plot_%s.png", controllerType, plot->sanitizedName);
-    fprintf(plot->gnuplotPipe, "set terminal pngcairo size 1000,700 enhanced font 'Verdana,10'\n");
-    fprintf(plot->gnuplotPipe, "set output '%s'\n", outputName);
-    fprintf(plot->gnuplotPipe, "set multiplot layout 2,1\n");
-    fprintf(plot->gnuplotPipe, "set grid\n");
-    fprintf(plot->gnuplotPipe, "set xlabel 'Time (s)'\n");
-    fprintf(plot->gnuplotPipe, "set key top right\n");
-    
-    // Plot water level with explicit ranges to avoid warnings
-    fprintf(plot->gnuplotPipe, "set title 'Water Tank Level Control - %s'\n", controllerName);
-    fprintf(plot->gnuplotPipe, "set ylabel 'Water Level (m)'\n");
-    fprintf(plot->gnuplotPipe, "set xrange [%f:%f]\n", minTime - timeMargin, maxTime + timeMargin);
-    fprintf(plot->gnuplotPipe, "set yrange [%f:%f]\n", minLevel - levelMargin, maxLevel + levelMargin);
-    fprintf(plot->gnuplotPipe, "plot $level using 1:2 with lines lw 2 lt rgb 'blue' title 'Actual Level', "
-            "$setpoint using 1:2 with lines lw 2 lt rgb 'red' dashtype 2 title 'Setpoint'\n");
-    
-    // Plot control signal with explicit ranges
-    fprintf(plot->gnuplotPipe, "set title 'Control Signal (Inflow Rate) - %s'\n", controllerName);
-    fprintf(plot->gnuplotPipe, "set ylabel 'Inflow (m³/s)'\n");
-    fprintf(plot->gnuplotPipe, "set xrange [%f:%f]\n", minTime - timeMargin, maxTime + timeMargin);
-    fprintf(plot->gnuplotPipe, "set yrange [%f:%f]\n", minControl - controlMargin, maxControl + controlMargin);
-    fprintf(plot->gnuplotPipe, "plot $control using 1:2 with lines lw 2 lt rgb 'green' title 'Control Signal'\n");
-    
-    fprintf(plot->gnuplotPipe, "unset multiplot\n");
-    fprintf(plot->gnuplotPipe, "set output\n");  // Close output file
-    fprintf(plot->gnuplotPipe, "exit\n");  // Explicitly tell gnuplot to exit
-    fflush(plot->gnuplotPipe);
-    
-    // Wait briefly for gnuplot to finish writing
-#ifdef _WIN32
-    Sleep(500);
-#else
-    usleep(500000);
-#endif
-    
-    // Cleanup
-    if (plot->dataBuffer) free(plot->dataBuffer);
-#ifdef _WIN32
-    _pclose(plot->gnuplotPipe);
-#else
-    pclose(plot->gnuplotPipe);
-#endif
-    
-    printf("Plot saved to '%s'\n", outputName);
-    
-    free(plot);
+    returnPoolObject(&plotPool, plot);
     return ERROR_SUCCESS;
 }
 
@@ -308,7 +583,9 @@ void generatePlot(double *time, double *level, double *setpoint,
         
         // Determine controller type
         const char *controllerType = "other";
-        if (strstr(controllerName, "PID") != NULL) {
+        if (strstr(controllerName, "MPC") != NULL) {
+            controllerType = "MPC";
+        } else if (strstr(controllerName, "PID") != NULL) {
             controllerType = "PID";
         } else if (strstr(controllerName, "PI") != NULL) {
             controllerType = "PI";
@@ -368,7 +645,9 @@ void generatePlot(double *time, double *level, double *setpoint,
             
             // Determine controller type
             const char *controllerType = "other";
-            if (strstr(controllerName, "PID") != NULL) {
+            if (strstr(controllerName, "MPC") != NULL) {
+                controllerType = "MPC";
+            } else if (strstr(controllerName, "PID") != NULL) {
                 controllerType = "PID";
             } else if (strstr(controllerName, "PI") != NULL) {
                 controllerType = "PI";
@@ -3,10 +3,16 @@
 
 #include "controller.h"
 
-// Initialize plotting system (checks for gnuplot availability)
+// Initialize plotting system (checks for gnuplot availability, starts the trace writer
+// and render threads and, in an instrumentation build, the profiling report)
 void initPlot(void);
 
-// Close plotting system (cleanup)
+// Enable the live view (call before initPlot): a gnuplot window redrawn at a fixed frame
+// rate from lock-free telemetry rings; the simulations never wait for it
+void setPlotLiveView(int enabled);
+
+// Close plotting system: renders every queued plot, then stops the render and trace
+// writer threads (all plots must be closed)
 void closePlot(void);
 
 // Generate plot with water tank simulation data
@@ -29,12 +35,33 @@ int isPlotFallbackEnabled(void);
 // Returns: ErrorCode (ERROR_SUCCESS or error code), sets plotHandle to plot pointer or NULL
 ErrorCode initRealtimePlot(const char *controllerName, int windowIndex, void **plotHandle);
 
+// Position of a run's trace, saved in a checkpoint so a resumed run continues the same trace
+typedef struct {
+    long rows;                      // Samples written
+    double minTime, maxTime;        // Data ranges tracked for the plot axes
+    double minLevel, maxLevel;
+    double minControl, maxControl;
+} PlotCursor;
+
+// Continue the trace of an interrupted run (results/<type>/trace_<name>.trc)
+// Samples after the cursor are dropped; the plot then behaves like initRealtimePlot's.
+// Returns: ErrorCode (ERROR_INVALID_PARAMETER if the trace is missing samples or does not match)
+ErrorCode resumeRealtimePlot(const char *controllerName, int windowIndex, const PlotCursor *cursor,
+                             void **plotHandle);
+
+// Write the samples collected so far to the trace and return its cursor
+// Returns: ErrorCode
+ErrorCode getRealtimePlotCursor(void *plotHandle, PlotCursor *cursor);
+
 // Update real-time plot with new data point
+// Samples are streamed to results/<type>/trace_<name>.trc, so the run length is unbounded
 // Returns: ErrorCode
 ErrorCode updateRealtimePlot(void *plotHandle, double time, double level, 
                              double setpoint, double control_signal);
 
-// Close real-time plot and save final image
+// Close real-time plot and queue the final image
+// Returns immediately; the PNG is rendered by a single long-lived gnuplot process
+// (or written to results/render_plots.gp when gnuplot is unavailable).
 // Returns: ErrorCode
 ErrorCode closeRealtimePlot(void *plotHandle, const char *controllerName);
 
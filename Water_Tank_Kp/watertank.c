@@ -1,5 +1,61 @@
 #include "watertank.h"
-#include <math.h>
+#include "watertank_kernels.h"
+#include <stddef.h>
+#include <string.h>
+
+// Derive the run-invariant coefficients once per run instead of once per step
+ErrorCode prepareTankModel(ModelConfig *model) {
+    if (model == NULL) return ERROR_NULL_POINTER;
+    if (model->area <= 0.0 || model->density <= 0.0 || model->max_level <= 0.0) return ERROR_INVALID_PARAMETER;
+    
+    model->prepared.inverse_area = 1.0 / model->area;
+    model->prepared.inverse_density = 1.0 / model->density;
+    model->prepared.outflow_mass_coeff = model->outflow_coeff * model->density;
+    model->prepared.max_volume = model->area * model->max_level;
+    model->prepared.percent_per_volume = 100.0 / model->prepared.max_volume;
+    return ERROR_SUCCESS;
+}
+
+// Level error of an integrating tank: only the inflow enters the model, the outflow is estimated
+ErrorCode linearizeTankModel(const ModelConfig *model, double dt, MpcModel *linear) {
+    if (model == NULL || linear == NULL) return ERROR_NULL_POINTER;
+    if (dt <= 0.0 || model->prepared.percent_per_volume <= 0.0) return ERROR_INVALID_PARAMETER;
+    
+    memset(linear, 0, sizeof(*linear));
+    linear->states = 1;
+    linear->A[0][0] = 1.0;
+    linear->B[0] = -dt * model->prepared.percent_per_volume;  // More inflow, smaller error
+    return ERROR_SUCCESS;
+}
+
+ErrorCode saveTankCheckpoint(const WaterTank *tank, TankCheckpoint *checkpoint) {
+    if (tank == NULL || checkpoint == NULL || tank->controller.state == NULL) return ERROR_NULL_POINTER;
+    
+    memset(checkpoint, 0, sizeof(*checkpoint));  // No padding garbage in checkpoint files
+    checkpoint->level = tank->level;
+    checkpoint->volume = tank->volume;
+    checkpoint->height = tank->height;
+    checkpoint->setpoint = tank->setpoint;
+    checkpoint->inflow = tank->inflow;
+    checkpoint->previousNetFlow = tank->previousNetFlow;
+    checkpoint->controller = *tank->controller.state;
+    checkpoint->integrator = tank->integrator;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode restoreTankCheckpoint(WaterTank *tank, const TankCheckpoint *checkpoint) {
+    if (tank == NULL || checkpoint == NULL || tank->controller.state == NULL) return ERROR_NULL_POINTER;
+    
+    tank->level = checkpoint->level;
+    tank->volume = checkpoint->volume;
+    tank->height = checkpoint->height;
+    tank->setpoint = checkpoint->setpoint;
+    tank->inflow = checkpoint->inflow;
+    tank->previousNetFlow = checkpoint->previousNetFlow;
+    *tank->controller.state = checkpoint->controller;
+    tank->integrator = checkpoint->integrator;
+    return ERROR_SUCCESS;
+}
 
 // Get desired water level from tank
 ErrorCode getTankSetpoint(void *system, double *setpoint) {
@@ -29,29 +85,45 @@ ErrorCode tankModel(void *system, double input, double dt, double *output) {
     tank->inflow = input;
     
     // Convert volume to height for physics calculation: height = volume / area
-    double level_m = tank->volume / tank->model.area;
+    double level_m = tank->volume * tank->model.prepared.inverse_area;
     
-    // Calculate net MASS flow using callback: ṁ = (dvol_w/dt) * ρ_w
+    // Calculate net MASS flow: ṁ = (dvol_w/dt) * ρ_w
     double netMassFlow = calculateTankNetFlow(tank, level_m, tank->inflow);
     
-    // Volume change: dvol_w/dt = ṁ / ρ
-    double dVolume = (netMassFlow / tank->model.density) * dt;
+    // Integrate volume, clamp and derive height/level
+    tankEulerIntegrate(tank, netMassFlow, dt);
     
-    // Update volume (m³) - INTERNAL STATE
-    tank->volume += dVolume;
+    // Return the updated water level (percentage) as output
+    *output = tank->level;
+    return ERROR_SUCCESS;
+}
+
+// Volume derivative for the adaptive integrator: dvol_w/dt = ṁ / ρ at the held inflow
+static ErrorCode tankVolumeDerivative(void *system, const double *state, double *derivative) {
+    WaterTank *tank = (WaterTank *)system;
+    double level_m = state[0] * tank->model.prepared.inverse_area;
+    derivative[0] = tank->model.netFlowCallback(tank, level_m, tank->inflow) * tank->model.prepared.inverse_density;
+    return ERROR_SUCCESS;
+}
+
+// Water tank model with adaptive-step integration
+// Sub-steps inside dt only where the outflow curvature needs it (near empty, large steps)
+ErrorCode tankModelAdaptive(void *system, double input, double dt, double *output) {
+    if (system == NULL || output == NULL) return ERROR_NULL_POINTER;
     
-    // Calculate max volume: V_max = area × max_level
-    double max_volume = tank->model.area * tank->model.max_level;
+    WaterTank *tank = (WaterTank *)system;
     
-    // Keep volume within physical limits
-    if (tank->volume < 0) tank->volume = 0;
-    if (tank->volume > max_volume) tank->volume = max_volume;
+    // Set inflow from control input (held constant over the tick)
+    tank->inflow = input;
     
-    // Derive height from volume: height = volume / area
-    tank->height = tank->volume / tank->model.area;
+    double volume = tank->volume;
+    ErrorCode err = integrateAdaptive(&tank->integrator, tankVolumeDerivative, tank, 1, &volume, dt);
+    if (err != ERROR_SUCCESS) return err;
     
-    // Derive level (percentage) from volume: level% = (volume / V_max) × 100
-    tank->level = (tank->volume / max_volume) * 100.0;
+    // Clamp and derive height/level like the Euler model
+    tank->volume = volume;
+    tankStoreVolume(tank, 1);
+    tank->previousNetFlow = tank->model.netFlowCallback(tank, tank->height, tank->inflow);
     
     // Return the updated water level (percentage) as output
     *output = tank->level;
@@ -63,27 +135,17 @@ ErrorCode tankModel(void *system, double input, double dt, double *output) {
 // Net volumetric flow = inflow - outflow, where outflow = coeff * sqrt(level)
 // Net mass flow = net volumetric flow * density
 double calculateTankNetFlow(WaterTank *tank, double level, double inflow) {
-    // Outflow proportional to square root of level (Torricelli's law)
-    double outflow = tank->model.outflow_coeff * sqrt(fmax(level, 0.0));
-    
-    // Net volumetric flow rate (m³/s)
-    double netVolumetricFlow = inflow - outflow;
-    
-    // Convert to mass flow rate: ṁ = (dvol_w/dt) * ρ_w
-    double netMassFlow = netVolumetricFlow * tank->model.density;
-    
-    return netMassFlow;
+    return tankNetFlowLaw(&tank->model, level, inflow);
 }
 
 // Calculate simplified net flow (no outflow dynamics)
 // Matches Python reference implementation where control input is directly mass flow
 // No Torricelli's law, no outflow - pure accumulation
 double calculateTankNetFlowSimplified(WaterTank *tank, double level, double inflow) {
-    (void)level;  // Unused parameter in simplified model
     // In simplified model, inflow is treated as direct mass flow rate
     // No outflow calculation - the controller has perfect control
     // This matches: m_dot = Kp * error (Python implementation)
-    return inflow * tank->model.density;  // Convert volumetric inflow to mass flow
+    return tankNetFlowSimplifiedLaw(&tank->model, level, inflow);
 }
 
 // Water tank model with trapezoidal integration
@@ -99,34 +161,14 @@ ErrorCode tankModelTrapezoidal(void *system, double input, double dt, double *ou
     tank->inflow = input;
     
     // Convert volume to height for physics calculation: height = volume / area
-    double level_m = tank->volume / tank->model.area;
+    double level_m = tank->volume * tank->model.prepared.inverse_area;
     
     // Calculate net MASS flow at current level (this becomes ṁ[t_i])
     // netFlowCallback returns ṁ = (dvol_w/dt) * ρ_w
     double massFlow_current = tank->model.netFlowCallback(tank, level_m, tank->inflow);
     
-    // Apply trapezoidal rule: average of previous and current mass flows
-    // ṁ_avg = (ṁ[t_{i-1}] + ṁ[t_i]) / 2
-    double massFlow_avg = (tank->previousNetFlow + massFlow_current) / 2.0;
-    
-    // Convert mass flow to volume change: dvol_w/dt = ṁ / ρ
-    double volumeChange = (massFlow_avg / tank->model.density) * dt;
-    
-    // Update volume (m³) - INTERNAL STATE
-    tank->volume += volumeChange;
-    
-    // Calculate max volume: V_max = area × max_level
-    double max_volume = tank->model.area * tank->model.max_level;
-    
-    // Keep volume within physical limits
-    if (tank->volume < 0) tank->volume = 0;
-    if (tank->volume > max_volume) tank->volume = max_volume;
-    
-    // Derive level (percentage) from volume: level% = (volume / V_max) × 100
-    tank->level = (tank->volume / max_volume) * 100.0;
-    
-    // Store current mass flow for next iteration (it becomes the previous value)
-    tank->previousNetFlow = massFlow_current;
+    // Apply trapezoidal rule, clamp and derive level (height is not tracked by this model)
+    tankTrapezoidalIntegrate(tank, massFlow_current, dt, 0);
     
     // Return the updated water level as output (percentage)
     *output = tank->level;
@@ -145,39 +187,15 @@ ErrorCode tankModelTrapezoidalSimplified(void *system, double input, double dt,
     tank->inflow = input;
     
     // Convert volume to height for physics calculation: height = volume / area
-    double level_m = tank->volume / tank->model.area;
+    double level_m = tank->volume * tank->model.prepared.inverse_area;
     
     // In simplified model: ṁ = input * density (no outflow)
     // This is equivalent to Python: m_dot = Kp * error
     double massFlow_current = tank->model.netFlowCallback(tank, level_m, tank->inflow);
     
-    // Apply trapezoidal rule: average of previous and current mass flows
+    // Apply trapezoidal rule, clamp and derive height/level
     // Python equation: volume[i] = volume[i-1] + (m_dot[i-1] + m_dot[i])/(2*density) * dt
-    // ṁ_avg = (ṁ[t_{i-1}] + ṁ[t_i]) / 2
-    double massFlow_avg = (tank->previousNetFlow + massFlow_current) / 2.0;
-    
-    // Convert mass flow to volume change: dvol_w/dt = ṁ / ρ
-    // This matches: (m_dot[i-1] + m_dot[i])/(2*density)
-    double volumeChange = (massFlow_avg / tank->model.density) * dt;
-    
-    // Update volume (m³) - INTERNAL STATE
-    tank->volume += volumeChange;
-    
-    // Calculate max volume: V_max = area × max_level
-    double max_volume = tank->model.area * tank->model.max_level;
-    
-    // Keep volume within physical limits
-    if (tank->volume < 0) tank->volume = 0;
-    if (tank->volume > max_volume) tank->volume = max_volume;
-    
-    // Derive height from volume: height = volume / area
-    tank->height = tank->volume / tank->model.area;
-    
-    // Derive level (percentage) from volume: level% = (volume / V_max) × 100
-    tank->level = (tank->volume / max_volume) * 100.0;
-    
-    // Store current mass flow for next iteration (it becomes the previous value)
-    tank->previousNetFlow = massFlow_current;
+    tankTrapezoidalIntegrate(tank, massFlow_current, dt, 1);
     
     // Return the updated water level (percentage) as output
     *output = tank->level;
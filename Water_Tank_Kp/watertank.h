@@ -2,6 +2,8 @@
 #define WATERTANK_H
 
 #include "controller.h"
+#include "integrator.h"
+#include "mpc.h"
 
 // Forward declaration
 typedef struct WaterTank WaterTank;
@@ -12,6 +14,17 @@ typedef struct WaterTank WaterTank;
 // Returns: net flow (inflow - outflow)
 typedef double (*NetFlowCallback)(WaterTank *tank, double level, double inflow);
 
+// Run-invariant coefficients derived from the model parameters (prepareTankModel)
+// The per-step code reads only these, so the volume/height/percentage conversions
+// are multiplications instead of divisions
+typedef struct {
+    double inverse_area;        // 1/area (1/m²)
+    double inverse_density;     // 1/ρ (m³/kg)
+    double outflow_mass_coeff;  // Torricelli mass outflow coefficient: outflow_coeff * ρ
+    double max_volume;          // V_max = area × max_level (m³)
+    double percent_per_volume;  // 100 / V_max (%/m³)
+} TankModelConstants;
+
 // Model configuration structure
 typedef struct {
     double outflow_coeff;      // Outflow coefficient
@@ -21,6 +34,7 @@ typedef struct {
     double max_level;          // Maximum tank height (m) for 100% normalization (e.g., 4.507 m)
     SystemModelCallback callback; // System model callback
     NetFlowCallback netFlowCallback; // Net flow calculation callback
+    TankModelConstants prepared;     // Derived coefficients (set by prepareTankModel)
 } ModelConfig;
 
 // Water tank simulation parameters
@@ -33,8 +47,67 @@ typedef struct WaterTank {
     double previousNetFlow; // Net flow from previous iteration (for trapezoidal integration)
     ControllerConfig controller; // Controller configuration with callbacks
     ModelConfig model;      // Model configuration with parameters
+    AdaptiveIntegrator integrator; // Step control and statistics of tankModelAdaptive
 } WaterTank;
 
+// Derivatives of the tank state with respect to the PID gains (index GAIN_KP, GAIN_KI, GAIN_KD)
+// Propagated next to the state by the sensitivity steppers (watertank_stepper.h);
+// zero-fill it at the start of a run, since the initial state does not depend on the gains
+typedef struct {
+    double level[GAIN_COUNT];           // d(level)/d(gain) - OUTPUT
+    double volume[GAIN_COUNT];          // d(volume)/d(gain)
+    double inflow[GAIN_COUNT];          // d(inflow)/d(gain)
+    double previousNetFlow[GAIN_COUNT]; // d(previousNetFlow)/d(gain)
+    ControllerSensitivity controller;   // Derivatives of the PID state
+} TankSensitivity;
+
+// Dynamic state of a tank run between two steps (saveTankCheckpoint)
+// Everything a step carries over to the next one. The model, the gains and the callbacks are
+// configuration: the code restoring a checkpoint sets them up as for the saved run. The warm
+// start of mpcController is not included.
+typedef struct {
+    double level;
+    double volume;
+    double height;
+    double setpoint;
+    double inflow;
+    double previousNetFlow;
+    ControllerState controller;      // Integral, previous error, cumulative error
+    AdaptiveIntegrator integrator;   // Step hint and statistics of tankModelAdaptive
+} TankCheckpoint;
+
+// Derive the run-invariant coefficients of a model (model->prepared)
+// Must be called after setting, and after every change of, outflow_coeff, area, density or max_level
+// Parameters:
+//   model: model configuration
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (area, density or max_level <= 0)
+ErrorCode prepareTankModel(ModelConfig *model);
+
+// Capture the dynamic state of a tank and its controller
+// Parameters:
+//   tank: tank between two steps (controller.state set)
+//   checkpoint: pointer to store the state
+// Returns: ERROR_SUCCESS or ERROR_NULL_POINTER
+ErrorCode saveTankCheckpoint(const WaterTank *tank, TankCheckpoint *checkpoint);
+
+// Put a tank back into a saved state; the next step continues the saved run exactly
+// A checkpoint can be restored any number of times, e.g. to fork variants of a run.
+// Parameters:
+//   tank: tank configured like the saved run (model, controller callbacks, controller.state)
+//   checkpoint: saved state
+// Returns: ERROR_SUCCESS or ERROR_NULL_POINTER
+ErrorCode restoreTankCheckpoint(WaterTank *tank, const TankCheckpoint *checkpoint);
+
+// Prediction model of mpcController in level error coordinates (e = setpoint - level, %)
+// e+ = e - dt * (100 / V_max) * (inflow - w): the level integrates the inflow, the Torricelli
+// outflow is the input disturbance w that the controller's observer tracks.
+// Parameters:
+//   model: prepared model configuration
+//   dt: controller period (seconds)
+//   linear: pointer to store the one-state model
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (dt <= 0, model not prepared)
+ErrorCode linearizeTankModel(const ModelConfig *model, double dt, MpcModel *linear);
+
 // Get desired water level from tank (GetSetpointCallback compatible)
 // Parameters:
 //   system: pointer to WaterTank structure (cast from void*)
@@ -59,6 +132,17 @@ ErrorCode getTankOutput(void *system, double *output);
 // Returns: ErrorCode
 ErrorCode tankModel(void *system, double input, double dt, double *output);
 
+// Water tank math model with adaptive-step Dormand–Prince integration (Torricelli's law)
+// The inflow is held over dt and the volume is integrated with error-controlled internal
+// steps (tank->integrator: tolerances, step hint carried across ticks, step statistics)
+// Parameters:
+//   system: pointer to WaterTank structure (cast from void*)
+//   input: inflow rate (m³/s)
+//   dt: time step (seconds)
+//   output: pointer to store water level after update
+// Returns: ErrorCode
+ErrorCode tankModelAdaptive(void *system, double input, double dt, double *output);
+
 // Calculate net flow for water tank (inflow - outflow)
 // Uses Torricelli's law: outflow = coeff * sqrt(level)
 // Parameters:
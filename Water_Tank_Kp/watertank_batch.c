@@ -0,0 +1,181 @@
+#include "watertank_batch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Number of per-tank arrays carved out of the batch allocation
+#define TANK_BATCH_ARRAYS 11
+
+// Round array length up to 8 doubles so every array starts on a 64-byte boundary
+// relative to the allocation (keeps vector loads aligned across arrays)
+#define TANK_BATCH_STRIDE(n) ((((size_t)(n)) + 7) & ~(size_t)7)
+
+ErrorCode initWaterTankBatch(WaterTankBatch *batch, int count, const ModelConfig *model) {
+    if (batch == NULL || model == NULL) return ERROR_NULL_POINTER;
+    if (count <= 0 || model->area <= 0.0 || model->max_level <= 0.0 || model->density <= 0.0) {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    // Select the integration scheme once, instead of dispatching through callbacks every step
+    TankBatchModel modelType;
+    if (model->callback == tankModel) {
+        modelType = TANK_BATCH_EULER;
+    } else if (model->callback == tankModelTrapezoidal) {
+        modelType = TANK_BATCH_TRAPEZOIDAL;
+    } else if (model->callback == tankModelTrapezoidalSimplified) {
+        modelType = TANK_BATCH_TRAPEZOIDAL_SIMPLIFIED;
+    } else {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    ModelConfig prepared = *model;
+    if (prepareTankModel(&prepared) != ERROR_SUCCESS) return ERROR_INVALID_PARAMETER;  // Shared 1/area, 1/ρ, c*ρ and V_max
+
+    size_t stride = TANK_BATCH_STRIDE(count);
+    double *block = (double*)calloc(stride * TANK_BATCH_ARRAYS, sizeof(double));
+    if (block == NULL) return ERROR_NULL_POINTER;
+
+    batch->count = count;
+    batch->modelType = modelType;
+    batch->model = prepared;
+    batch->volume          = block;
+    batch->height          = block + stride * 1;
+    batch->level           = block + stride * 2;
+    batch->setpoint        = block + stride * 3;
+    batch->inflow          = block + stride * 4;
+    batch->previousNetFlow = block + stride * 5;
+    batch->integral        = block + stride * 6;
+    batch->previousError   = block + stride * 7;
+    batch->Kp              = block + stride * 8;
+    batch->Ki              = block + stride * 9;
+    batch->Kd              = block + stride * 10;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode setWaterTankBatchPlant(WaterTankBatch *batch, int index, double initial_level_pct,
+                                 double setpoint, const ControllerParams *params) {
+    if (batch == NULL || params == NULL || batch->volume == NULL) return ERROR_NULL_POINTER;
+    if (index < 0 || index >= batch->count) return ERROR_INVALID_PARAMETER;
+
+    // Same conversion as runSimulation: volume = (level% / 100) × V_max
+    double volume = (initial_level_pct / 100.0) * batch->model.prepared.max_volume;
+
+    batch->volume[index] = volume;
+    batch->height[index] = volume * batch->model.prepared.inverse_area;
+    batch->level[index] = initial_level_pct;
+    batch->setpoint[index] = setpoint;
+    batch->inflow[index] = 0.0;
+    batch->previousNetFlow[index] = 0.0;
+    batch->integral[index] = 0.0;
+    batch->previousError[index] = 0.0;
+    batch->Kp[index] = params->Kp;
+    batch->Ki[index] = params->Ki;
+    batch->Kd[index] = params->Kd;
+    return ERROR_SUCCESS;
+}
+
+// Kernel parameter list: every array is a separate restrict-qualified parameter, since
+// GCC only takes restrict into account for function parameters when proving that the
+// arrays do not overlap (block-scope restrict pointers still get runtime alias checks).
+#define TANK_BATCH_KERNEL_PARAMS                                                   \
+    int n, double dt, double inverse_area, double density, double inverse_density, \
+    double outflow_mass_coeff, double max_volume, double percent_per_volume,       \
+    double *restrict volume, double *restrict height, double *restrict level,      \
+    const double *restrict setpoint, double *restrict inflow,                      \
+    double *restrict previousNetFlow, double *restrict integral,                   \
+    double *restrict previousError, const double *restrict Kp,                     \
+    const double *restrict Ki, const double *restrict Kd
+
+// PID law shared by every scheme (same arithmetic as pidController)
+// Written as a macro so each loop below stays a single straight-line body the compiler can vectorize.
+// Clamps in the loops are written as `x > lo ? x : lo` / `x < hi ? x : hi`, the form that maps
+// onto vector max/min instructions (`x < lo ? lo : x` has different NaN semantics and does not).
+#define TANK_BATCH_PID(i, u)                                               \
+    do {                                                                   \
+        double error_ = setpoint[i] - level[i];                            \
+        integral[i] += error_ * dt;                                        \
+        double derivative_ = (error_ - previousError[i]) / dt;             \
+        previousError[i] = error_;                                         \
+        (u) = Kp[i] * error_ + Ki[i] * integral[i] + Kd[i] * derivative_;  \
+        inflow[i] = (u);                                                   \
+    } while (0)
+
+// tankModel: vol += ((u*ρ - c*ρ*sqrt(h)) / ρ) * dt
+static void stepTankBatchEuler(TANK_BATCH_KERNEL_PARAMS) {
+    (void)previousNetFlow;  // Euler scheme keeps no flow history
+    for (int i = 0; i < n; i++) {
+        double u;
+        TANK_BATCH_PID(i, u);
+        double level_m = volume[i] * inverse_area;
+        double netMassFlow = u * density - outflow_mass_coeff * sqrt(level_m > 0.0 ? level_m : 0.0);
+        double v = volume[i] + (netMassFlow * inverse_density) * dt;
+        v = v > 0.0 ? v : 0.0;
+        v = v < max_volume ? v : max_volume;
+        volume[i] = v;
+        height[i] = v * inverse_area;
+        level[i] = v * percent_per_volume;
+    }
+}
+
+// tankModelTrapezoidal: vol += ((ṁ[t_{i-1}] + ṁ[t_i]) / 2 / ρ) * dt
+static void stepTankBatchTrapezoidal(TANK_BATCH_KERNEL_PARAMS) {
+    for (int i = 0; i < n; i++) {
+        double u;
+        TANK_BATCH_PID(i, u);
+        double level_m = volume[i] * inverse_area;
+        double massFlow = u * density - outflow_mass_coeff * sqrt(level_m > 0.0 ? level_m : 0.0);
+        double massFlow_avg = (previousNetFlow[i] + massFlow) / 2.0;
+        double v = volume[i] + (massFlow_avg * inverse_density) * dt;
+        v = v > 0.0 ? v : 0.0;
+        v = v < max_volume ? v : max_volume;
+        volume[i] = v;
+        height[i] = v * inverse_area;
+        level[i] = v * percent_per_volume;
+        previousNetFlow[i] = massFlow;
+    }
+}
+
+// tankModelTrapezoidalSimplified: no outflow, ṁ = u * ρ
+static void stepTankBatchTrapezoidalSimplified(TANK_BATCH_KERNEL_PARAMS) {
+    (void)outflow_mass_coeff;  // Simplified scheme has no outflow
+    for (int i = 0; i < n; i++) {
+        double u;
+        TANK_BATCH_PID(i, u);
+        double massFlow = u * density;
+        double massFlow_avg = (previousNetFlow[i] + massFlow) / 2.0;
+        double v = volume[i] + (massFlow_avg * inverse_density) * dt;
+        v = v > 0.0 ? v : 0.0;
+        v = v < max_volume ? v : max_volume;
+        volume[i] = v;
+        height[i] = v * inverse_area;
+        level[i] = v * percent_per_volume;
+        previousNetFlow[i] = massFlow;
+    }
+}
+
+ErrorCode stepWaterTankBatch(WaterTankBatch *batch, double dt) {
+    if (batch == NULL || batch->volume == NULL) return ERROR_NULL_POINTER;
+    if (dt <= 0.0) return ERROR_INVALID_PARAMETER;
+
+    void (*kernel)(TANK_BATCH_KERNEL_PARAMS);
+    switch (batch->modelType) {
+    case TANK_BATCH_EULER:                  kernel = stepTankBatchEuler; break;
+    case TANK_BATCH_TRAPEZOIDAL:            kernel = stepTankBatchTrapezoidal; break;
+    case TANK_BATCH_TRAPEZOIDAL_SIMPLIFIED: kernel = stepTankBatchTrapezoidalSimplified; break;
+    default: return ERROR_INVALID_PARAMETER;
+    }
+
+    const TankModelConstants *prepared = &batch->model.prepared;
+    kernel(batch->count, dt, prepared->inverse_area, batch->model.density, prepared->inverse_density,
+           prepared->outflow_mass_coeff, prepared->max_volume, prepared->percent_per_volume,
+           batch->volume, batch->height, batch->level, batch->setpoint, batch->inflow,
+           batch->previousNetFlow, batch->integral, batch->previousError,
+           batch->Kp, batch->Ki, batch->Kd);
+    return ERROR_SUCCESS;
+}
+
+void freeWaterTankBatch(WaterTankBatch *batch) {
+    if (batch == NULL) return;
+    free(batch->volume);  // All arrays live in the block starting at volume
+    memset(batch, 0, sizeof(*batch));
+}
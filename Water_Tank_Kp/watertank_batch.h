@@ -0,0 +1,67 @@
+#ifndef WATERTANK_BATCH_H
+#define WATERTANK_BATCH_H
+
+#include "watertank.h"
+
+// Integration scheme shared by every tank in a batch
+typedef enum {
+    TANK_BATCH_EULER = 0,              // Same physics as tankModel
+    TANK_BATCH_TRAPEZOIDAL,            // Same physics as tankModelTrapezoidal
+    TANK_BATCH_TRAPEZOIDAL_SIMPLIFIED  // Same physics as tankModelTrapezoidalSimplified
+} TankBatchModel;
+
+// Batch of N water tanks stored as structure-of-arrays
+// All tanks share one physical configuration and one integration scheme,
+// and all of them run the PID law (P, PI and PD are PID with zero gains).
+// Each array holds `count` values, index i belongs to tank i.
+typedef struct {
+    int count;                 // Number of tanks in the batch
+    TankBatchModel modelType;  // Integration scheme (derived from model.callback)
+    ModelConfig model;         // Shared physical parameters
+    double *volume;            // Water volume (m³) - INTERNAL STATE
+    double *height;            // Water height (m) - INTERNAL TRACKING
+    double *level;             // Water level (0-100%) - OUTPUT
+    double *setpoint;          // Desired water level (0-100%)
+    double *inflow;            // Last control signal (m³/s)
+    double *previousNetFlow;   // Net mass flow from previous step (trapezoidal schemes)
+    double *integral;          // Controller integral term
+    double *previousError;     // Controller previous error (derivative term)
+    double *Kp;                // Proportional gain
+    double *Ki;                // Integral gain
+    double *Kd;                // Derivative gain
+} WaterTankBatch;
+
+// Allocate a batch of tanks sharing one model configuration
+// The integration scheme is derived from model->callback, which must be
+// tankModel, tankModelTrapezoidal or tankModelTrapezoidalSimplified.
+// All tanks start empty with zero gains; use setWaterTankBatchPlant to configure them.
+// Parameters:
+//   batch: batch to initialize
+//   count: number of tanks (> 0)
+//   model: shared model configuration
+// Returns: ErrorCode
+ErrorCode initWaterTankBatch(WaterTankBatch *batch, int count, const ModelConfig *model);
+
+// Configure the initial state and gains of one tank in the batch
+// Parameters:
+//   batch: initialized batch
+//   index: tank index (0 to count-1)
+//   initial_level_pct: initial water level (0-100%)
+//   setpoint: desired water level (0-100%)
+//   params: controller gains (Kp, Ki, Kd)
+// Returns: ErrorCode
+ErrorCode setWaterTankBatchPlant(WaterTankBatch *batch, int index, double initial_level_pct,
+                                 double setpoint, const ControllerParams *params);
+
+// Advance every tank in the batch by one time step (controller + model)
+// Equivalent to calling updateSystem() with pidController on each tank.
+// Parameters:
+//   batch: initialized batch
+//   dt: time step (seconds)
+// Returns: ErrorCode
+ErrorCode stepWaterTankBatch(WaterTankBatch *batch, double dt);
+
+// Release the arrays owned by the batch
+void freeWaterTankBatch(WaterTankBatch *batch);
+
+#endif // WATERTANK_BATCH_H
@@ -0,0 +1,149 @@
+#ifndef WATERTANK_KERNELS_H
+#define WATERTANK_KERNELS_H
+
+#include <math.h>
+#include "watertank.h"
+
+// Inline building blocks of the tank models in watertank.c
+// The SystemModelCallback functions and the specialized steppers (watertank_stepper.c)
+// are both assembled from these, so the two paths share one implementation of the physics.
+// No NULL checks: callers validate the tank before using them.
+// Invariant coefficients come from model->prepared (prepareTankModel).
+
+// Net mass flow with Torricelli outflow: ṁ = (inflow - coeff * sqrt(level)) * ρ
+// (same as calculateTankNetFlow)
+static inline double tankNetFlowLaw(const ModelConfig *model, double level, double inflow) {
+    // Mass outflow proportional to square root of level (Torricelli's law): (coeff * ρ) * sqrt(level)
+    double mass_outflow = model->prepared.outflow_mass_coeff * sqrt(fmax(level, 0.0));
+
+    // Net mass flow rate: ṁ = (dvol_w/dt) * ρ_w
+    return inflow * model->density - mass_outflow;
+}
+
+// Net mass flow without outflow: ṁ = inflow * ρ (same as calculateTankNetFlowSimplified)
+static inline double tankNetFlowSimplifiedLaw(const ModelConfig *model, double level, double inflow) {
+    (void)level;  // Unused parameter in simplified model
+    return inflow * model->density;
+}
+
+// Clamp the volume to [0, V_max] and derive the percentage level
+// Parameters:
+//   tank: water tank
+//   trackHeight: also derive tank->height from the volume
+// Returns: updated level (percentage 0-100%)
+static inline double tankStoreVolume(WaterTank *tank, int trackHeight) {
+    double max_volume = tank->model.prepared.max_volume;  // V_max = area × max_level
+
+    // Keep volume within physical limits
+    if (tank->volume < 0) tank->volume = 0;
+    if (tank->volume > max_volume) tank->volume = max_volume;
+
+    // Derive height from volume: height = volume / area
+    if (trackHeight) tank->height = tank->volume * tank->model.prepared.inverse_area;
+
+    // Derive level (percentage) from volume: level% = (volume / V_max) × 100
+    tank->level = tank->volume * tank->model.prepared.percent_per_volume;
+    return tank->level;
+}
+
+// Euler integration step (tankModel): vol += (ṁ / ρ) * dt
+// Parameters:
+//   tank: water tank (inflow already set)
+//   netMassFlow: net mass flow at the current level (kg/s)
+//   dt: time step (seconds)
+// Returns: updated level (percentage 0-100%)
+static inline double tankEulerIntegrate(WaterTank *tank, double netMassFlow, double dt) {
+    // Volume change: dvol_w/dt = ṁ / ρ
+    tank->volume += (netMassFlow * tank->model.prepared.inverse_density) * dt;
+    return tankStoreVolume(tank, 1);
+}
+
+// Trapezoidal integration step: vol += ((ṁ[t_{i-1}] + ṁ[t_i]) / 2 / ρ) * dt
+// Parameters:
+//   tank: water tank (inflow already set)
+//   massFlow_current: net mass flow at the current level, ṁ[t_i] (kg/s)
+//   dt: time step (seconds)
+//   trackHeight: also derive tank->height (tankModelTrapezoidal does not)
+// Returns: updated level (percentage 0-100%)
+static inline double tankTrapezoidalIntegrate(WaterTank *tank, double massFlow_current, double dt,
+                                              int trackHeight) {
+    // ṁ_avg = (ṁ[t_{i-1}] + ṁ[t_i]) / 2
+    double massFlow_avg = (tank->previousNetFlow + massFlow_current) / 2.0;
+
+    // Convert mass flow to volume change: dvol_w/dt = ṁ / ρ
+    tank->volume += (massFlow_avg * tank->model.prepared.inverse_density) * dt;
+    double level = tankStoreVolume(tank, trackHeight);
+
+    // Store current mass flow for next iteration (it becomes the previous value)
+    tank->previousNetFlow = massFlow_current;
+    return level;
+}
+
+// Forward-mode sensitivity kernels: derivatives of the steps above with respect to the PID gains
+// Each one mirrors its primal kernel; a volume pinned at 0 or V_max has zero sensitivity.
+
+// Derivative of tankNetFlowLaw: dṁ = ρ * d(inflow) - (coeff * ρ) / (2 * sqrt(level)) * d(level)
+// (the outflow term is taken as flat at an empty tank, where its slope is unbounded)
+static inline void tankNetFlowSensitivityLaw(const ModelConfig *model, double level,
+                                             const TankSensitivity *sensitivity, double *dFlow) {
+    double outflow_slope = level > 0.0 ? 0.5 * model->prepared.outflow_mass_coeff / sqrt(level) : 0.0;
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        double dLevel = sensitivity->volume[g] * model->prepared.inverse_area;
+        dFlow[g] = sensitivity->inflow[g] * model->density - outflow_slope * dLevel;
+    }
+}
+
+// Derivative of tankNetFlowSimplifiedLaw: dṁ = ρ * d(inflow)
+static inline void tankNetFlowSimplifiedSensitivityLaw(const ModelConfig *model, double level,
+                                                       const TankSensitivity *sensitivity, double *dFlow) {
+    (void)level;
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        dFlow[g] = sensitivity->inflow[g] * model->density;
+    }
+}
+
+// Derivative of tankStoreVolume (after the primal clamp): zero while the volume is pinned
+static inline void tankStoreVolumeSensitivity(const WaterTank *tank, TankSensitivity *sensitivity) {
+    int pinned = tank->volume <= 0.0 || tank->volume >= tank->model.prepared.max_volume;
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        if (pinned) sensitivity->volume[g] = 0.0;
+        sensitivity->level[g] = sensitivity->volume[g] * tank->model.prepared.percent_per_volume;
+    }
+}
+
+// tankEulerIntegrate with sensitivities: dvol += (dṁ / ρ) * dt
+// Parameters:
+//   tank: water tank (inflow already set)
+//   sensitivity: state derivatives (inflow already set)
+//   netMassFlow: net mass flow at the current level (kg/s)
+//   dFlow: its derivatives
+//   dt: time step (seconds)
+// Returns: updated level (percentage 0-100%)
+static inline double tankEulerSensitivityIntegrate(WaterTank *tank, TankSensitivity *sensitivity,
+                                                   double netMassFlow, const double *dFlow, double dt) {
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        sensitivity->volume[g] += (dFlow[g] * tank->model.prepared.inverse_density) * dt;
+    }
+    double level = tankEulerIntegrate(tank, netMassFlow, dt);
+    tankStoreVolumeSensitivity(tank, sensitivity);
+    return level;
+}
+
+// tankTrapezoidalIntegrate with sensitivities: dvol += ((dṁ[t_{i-1}] + dṁ[t_i]) / 2 / ρ) * dt
+// Parameters: as tankEulerSensitivityIntegrate, plus
+//   trackHeight: also derive tank->height
+// Returns: updated level (percentage 0-100%)
+static inline double tankTrapezoidalSensitivityIntegrate(WaterTank *tank, TankSensitivity *sensitivity,
+                                                         double massFlow_current, const double *dFlow,
+                                                         double dt, int trackHeight) {
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        double dFlow_avg = (sensitivity->previousNetFlow[g] + dFlow[g]) / 2.0;
+        sensitivity->volume[g] += (dFlow_avg * tank->model.prepared.inverse_density) * dt;
+        sensitivity->previousNetFlow[g] = dFlow[g];
+    }
+    double level = tankTrapezoidalIntegrate(tank, massFlow_current, dt, trackHeight);
+    tankStoreVolumeSensitivity(tank, sensitivity);
+    return level;
+}
+
+#endif // WATERTANK_KERNELS_H
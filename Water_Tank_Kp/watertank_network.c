@@ -0,0 +1,241 @@
+#include "watertank_network.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Number of per-tank arrays carved out of the network allocation
+#define TANK_NETWORK_ARRAYS 12
+
+// Round array length up to 8 doubles so every array starts on a 64-byte boundary
+// relative to the allocation (same layout as the tank batch)
+#define TANK_NETWORK_STRIDE(n) ((((size_t)(n)) + 7) & ~(size_t)7)
+
+ErrorCode initTankNetwork(TankNetwork *network, int count, int maxPipes, const ModelConfig *model) {
+    if (network == NULL || model == NULL) return ERROR_NULL_POINTER;
+    if (count <= 0 || maxPipes < 0) return ERROR_INVALID_PARAMETER;
+
+    memset(network, 0, sizeof(*network));
+    network->model = *model;
+    if (prepareTankModel(&network->model) != ERROR_SUCCESS) return ERROR_INVALID_PARAMETER;
+
+    size_t stride = TANK_NETWORK_STRIDE(count);
+    double *block = (double*)calloc(stride * TANK_NETWORK_ARRAYS, sizeof(double));
+    network->rowStart = (int*)calloc((size_t)count + 1, sizeof(int));
+    if (maxPipes > 0) {
+        network->pipeFrom = (int*)malloc((size_t)maxPipes * sizeof(int));
+        network->pipeTo = (int*)malloc((size_t)maxPipes * sizeof(int));
+        network->pipeConductance = (double*)malloc((size_t)maxPipes * sizeof(double));
+    }
+    if (block == NULL || network->rowStart == NULL ||
+        (maxPipes > 0 && (network->pipeFrom == NULL || network->pipeTo == NULL || network->pipeConductance == NULL))) {
+        free(block);
+        network->volume = NULL;
+        freeTankNetwork(network);
+        return ERROR_NULL_POINTER;
+    }
+
+    network->count = count;
+    network->pipeCapacity = maxPipes;
+    network->volume        = block;
+    network->height        = block + stride * 1;
+    network->nextHeight    = block + stride * 2;
+    network->level         = block + stride * 3;
+    network->setpoint      = block + stride * 4;
+    network->inflow        = block + stride * 5;
+    network->drain         = block + stride * 6;
+    network->integral      = block + stride * 7;
+    network->previousError = block + stride * 8;
+    network->Kp            = block + stride * 9;
+    network->Ki            = block + stride * 10;
+    network->Kd            = block + stride * 11;
+    for (int i = 0; i < count; i++) {
+        network->drain[i] = model->outflow_coeff;
+    }
+    return ERROR_SUCCESS;
+}
+
+ErrorCode setTankNetworkPlant(TankNetwork *network, int index, double initial_level_pct, double setpoint,
+                              const ControllerParams *params, double drain) {
+    if (network == NULL || params == NULL || network->volume == NULL) return ERROR_NULL_POINTER;
+    if (index < 0 || index >= network->count || drain < 0.0) return ERROR_INVALID_PARAMETER;
+
+    // Same conversion as runSimulation: volume = (level% / 100) × V_max
+    double volume = (initial_level_pct / 100.0) * network->model.prepared.max_volume;
+
+    network->volume[index] = volume;
+    network->height[index] = volume * network->model.prepared.inverse_area;
+    network->level[index] = initial_level_pct;
+    network->setpoint[index] = setpoint;
+    network->inflow[index] = 0.0;
+    network->drain[index] = drain;
+    network->integral[index] = 0.0;
+    network->previousError[index] = 0.0;
+    network->Kp[index] = params->Kp;
+    network->Ki[index] = params->Ki;
+    network->Kd[index] = params->Kd;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode addTankNetworkPipe(TankNetwork *network, int a, int b, double conductance) {
+    if (network == NULL || network->volume == NULL) return ERROR_NULL_POINTER;
+    if (network->finalized || network->pipeCount >= network->pipeCapacity) return ERROR_INVALID_PARAMETER;
+    if (a < 0 || a >= network->count || b < 0 || b >= network->count || a == b || !(conductance > 0.0)) {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    network->pipeFrom[network->pipeCount] = a;
+    network->pipeTo[network->pipeCount] = b;
+    network->pipeConductance[network->pipeCount] = conductance;
+    network->pipeCount++;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode finalizeTankNetwork(TankNetwork *network) {
+    if (network == NULL || network->volume == NULL) return ERROR_NULL_POINTER;
+    if (network->finalized) return ERROR_INVALID_PARAMETER;
+
+    // Counting sort of the edge list into rows: every pipe is stored in the rows of both tanks
+    int entries = network->pipeCount * 2;
+    network->neighbor = (int*)malloc((size_t)(entries > 0 ? entries : 1) * sizeof(int));
+    network->conductance = (double*)malloc((size_t)(entries > 0 ? entries : 1) * sizeof(double));
+    int *fill = (int*)calloc((size_t)network->count, sizeof(int));
+    if (network->neighbor == NULL || network->conductance == NULL || fill == NULL) {
+        free(fill);
+        return ERROR_NULL_POINTER;
+    }
+
+    int *rowStart = network->rowStart;
+    memset(rowStart, 0, ((size_t)network->count + 1) * sizeof(int));
+    for (int p = 0; p < network->pipeCount; p++) {
+        rowStart[network->pipeFrom[p] + 1]++;
+        rowStart[network->pipeTo[p] + 1]++;
+    }
+    for (int i = 0; i < network->count; i++) {
+        rowStart[i + 1] += rowStart[i];
+    }
+    for (int p = 0; p < network->pipeCount; p++) {
+        int a = network->pipeFrom[p];
+        int b = network->pipeTo[p];
+        int ka = rowStart[a] + fill[a]++;
+        int kb = rowStart[b] + fill[b]++;
+        network->neighbor[ka] = b;
+        network->conductance[ka] = network->pipeConductance[p];
+        network->neighbor[kb] = a;
+        network->conductance[kb] = network->pipeConductance[p];
+    }
+    free(fill);
+
+    network->finalized = 1;
+    return ERROR_SUCCESS;
+}
+
+// Pipe law: Q = sign(Δh) * sqrt(|Δh|), linear below TANK_PIPE_LAMINAR_HEAD (continuous at the
+// boundary) so the derivative stays bounded when two tanks level out
+static inline double tankPipeFlowLaw(double head) {
+    double magnitude = fabs(head);
+    if (magnitude < TANK_PIPE_LAMINAR_HEAD) {
+        return head * (1.0 / sqrt(TANK_PIPE_LAMINAR_HEAD));
+    }
+    return copysign(sqrt(magnitude), head);
+}
+
+void stepTankNetworkRange(TankNetwork *network, int first, int last, double dt) {
+    const double *restrict height = network->height;
+    double *restrict nextHeight = network->nextHeight;
+    const int *rowStart = network->rowStart;
+    const int *neighbor = network->neighbor;
+    const double *conductance = network->conductance;
+    double inverse_area = network->model.prepared.inverse_area;
+    double max_volume = network->model.prepared.max_volume;
+    double percent_per_volume = network->model.prepared.percent_per_volume;
+
+    for (int i = first; i < last; i++) {
+        // PID law (same arithmetic as pidController)
+        double error = network->setpoint[i] - network->level[i];
+        network->integral[i] += error * dt;
+        double derivative = (error - network->previousError[i]) / dt;
+        network->previousError[i] = error;
+        double u = network->Kp[i] * error + network->Ki[i] * network->integral[i] + network->Kd[i] * derivative;
+        network->inflow[i] = u;
+
+        // Exchange with the neighbors (previous-step heads) and the Torricelli drain
+        double h = height[i];
+        double exchange = 0.0;
+        for (int k = rowStart[i]; k < rowStart[i + 1]; k++) {
+            exchange += conductance[k] * tankPipeFlowLaw(height[neighbor[k]] - h);
+        }
+        double netFlow = u + exchange - network->drain[i] * sqrt(h > 0.0 ? h : 0.0);
+
+        // Euler step, clamp and derive height/level (as tankModel; ṁ/ρ cancels to the volume flow)
+        double v = network->volume[i] + netFlow * dt;
+        v = v > 0.0 ? v : 0.0;
+        v = v < max_volume ? v : max_volume;
+        network->volume[i] = v;
+        network->level[i] = v * percent_per_volume;
+        nextHeight[i] = v * inverse_area;
+    }
+}
+
+void completeTankNetworkStep(TankNetwork *network) {
+    double *swap = network->height;
+    network->height = network->nextHeight;
+    network->nextHeight = swap;
+}
+
+ErrorCode stepTankNetwork(TankNetwork *network, double dt) {
+    if (network == NULL || network->volume == NULL) return ERROR_NULL_POINTER;
+    if (!network->finalized || dt <= 0.0) return ERROR_INVALID_PARAMETER;
+
+    stepTankNetworkRange(network, 0, network->count, dt);
+    completeTankNetworkStep(network);
+    return ERROR_SUCCESS;
+}
+
+// Index range of one partition (pool job of stepTankNetworkParallel)
+typedef struct {
+    TankNetwork *network;
+    int first;
+    int last;
+    double dt;
+} TankNetworkPartition;
+
+static void stepTankNetworkPartition(void *arg) {
+    TankNetworkPartition *partition = (TankNetworkPartition*)arg;
+    stepTankNetworkRange(partition->network, partition->first, partition->last, partition->dt);
+}
+
+ErrorCode stepTankNetworkParallel(TankNetwork *network, JobPool *pool, int partitions, double dt) {
+    if (network == NULL || pool == NULL || network->volume == NULL) return ERROR_NULL_POINTER;
+    if (!network->finalized || dt <= 0.0 || partitions < 1 || partitions > TANK_NETWORK_MAX_PARTITIONS) {
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (partitions > network->count) partitions = network->count;
+
+    TankNetworkPartition ranges[TANK_NETWORK_MAX_PARTITIONS];
+    for (int p = 0; p < partitions; p++) {
+        ranges[p].network = network;
+        ranges[p].first = (int)((long long)network->count * p / partitions);
+        ranges[p].last = (int)((long long)network->count * (p + 1) / partitions);
+        ranges[p].dt = dt;
+        if (submitJob(pool, stepTankNetworkPartition, &ranges[p]) != ERROR_SUCCESS) {
+            stepTankNetworkPartition(&ranges[p]);  // Step inline rather than leave a hole
+        }
+    }
+
+    // Every partition must have read the old heads before they are replaced
+    waitJobPool(pool);
+    completeTankNetworkStep(network);
+    return ERROR_SUCCESS;
+}
+
+void freeTankNetwork(TankNetwork *network) {
+    if (network == NULL) return;
+    free(network->volume);  // All per-tank arrays live in the block starting at volume
+    free(network->rowStart);
+    free(network->neighbor);
+    free(network->conductance);
+    free(network->pipeFrom);
+    free(network->pipeTo);
+    free(network->pipeConductance);
+    memset(network, 0, sizeof(*network));
+}
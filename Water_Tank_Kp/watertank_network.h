@@ -0,0 +1,120 @@
+#ifndef WATERTANK_NETWORK_H
+#define WATERTANK_NETWORK_H
+
+#include "watertank.h"
+#include "jobpool.h"
+
+// Coupled network of water tanks linked by pipes
+// Every tank has its own PID controller (P, PI and PD are PID with zero gains) and its own
+// drain; tanks exchange water through pipes, Q = k * sign(Δh) * sqrt(|Δh|) (Torricelli),
+// linearized inside TANK_PIPE_LAMINAR_HEAD so the flow stays smooth when the heads level out.
+// All tanks share one vessel geometry (ModelConfig) and are stepped with explicit Euler
+// like tankModel.
+//
+// State is stored as structure-of-arrays; the pipes form a symmetric sparse flow matrix in
+// CSR layout (each pipe appears in the rows of both of its tanks), so a step costs
+// O(tanks + pipes). A step only reads the heads of the previous step and every tank writes
+// just its own row, so contiguous index ranges can be stepped concurrently
+// (stepTankNetworkParallel). Number the tanks so that partitions are mostly self-contained
+// (a cascade in order, a grid row by row) to keep neighbor reads local.
+
+#define TANK_PIPE_LAMINAR_HEAD 1e-3        // Head difference (m) below which the pipe law is linear
+#define TANK_NETWORK_MAX_PARTITIONS 64     // Upper bound of stepTankNetworkParallel partitions
+
+typedef struct {
+    int count;                 // Number of tanks
+    int pipeCount;             // Pipes added (undirected)
+    int pipeCapacity;          // Pipes that fit in the edge list
+    int finalized;             // CSR built (finalizeTankNetwork), pipes are frozen
+    ModelConfig model;         // Shared vessel geometry and density (prepared)
+    // Per-tank arrays (index i belongs to tank i)
+    double *volume;            // Water volume (m³) - INTERNAL STATE
+    double *height;            // Water height (m) of the last completed step
+    double *nextHeight;        // Height being computed by the running step (swapped with height)
+    double *level;             // Water level (0-100%) - OUTPUT
+    double *setpoint;          // Desired water level (0-100%)
+    double *inflow;            // Last control signal (m³/s)
+    double *drain;             // Torricelli drain coefficient to the outside (0 = closed)
+    double *integral;          // Controller integral term
+    double *previousError;     // Controller previous error (derivative term)
+    double *Kp;                // Proportional gain
+    double *Ki;                // Integral gain
+    double *Kd;                // Derivative gain
+    // Sparse flow matrix (CSR): the pipes of tank i are entries rowStart[i] .. rowStart[i+1]-1
+    int *rowStart;             // count + 1 row offsets
+    int *neighbor;             // Tank at the other end of each entry
+    double *conductance;       // Pipe coefficient k of each entry (m^2.5/s)
+    // Edge list collected by addTankNetworkPipe (converted to CSR by finalizeTankNetwork)
+    int *pipeFrom;
+    int *pipeTo;
+    double *pipeConductance;
+} TankNetwork;
+
+// Allocate a network
+// All tanks start empty with zero gains and the model's outflow_coeff as drain;
+// use setTankNetworkPlant and addTankNetworkPipe to configure them, then finalizeTankNetwork.
+// Parameters:
+//   network: network to initialize
+//   count: number of tanks (> 0)
+//   maxPipes: capacity of the pipe list (>= 0)
+//   model: shared vessel geometry (area, max_level, density, outflow_coeff)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER (also on allocation failure) or ERROR_INVALID_PARAMETER
+ErrorCode initTankNetwork(TankNetwork *network, int count, int maxPipes, const ModelConfig *model);
+
+// Configure the initial state, gains and drain of one tank
+// Parameters:
+//   network: initialized network
+//   index: tank index (0 to count-1)
+//   initial_level_pct: initial water level (0-100%)
+//   setpoint: desired water level (0-100%)
+//   params: controller gains (Kp, Ki, Kd)
+//   drain: Torricelli drain coefficient to the outside (0 = no drain)
+// Returns: ErrorCode
+ErrorCode setTankNetworkPlant(TankNetwork *network, int index, double initial_level_pct, double setpoint,
+                              const ControllerParams *params, double drain);
+
+// Connect two tanks with a pipe (before finalizeTankNetwork)
+// Parameters:
+//   network: initialized network
+//   a, b: tank indices (different)
+//   conductance: pipe coefficient k (> 0)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (bad index, full list, finalized)
+ErrorCode addTankNetworkPipe(TankNetwork *network, int a, int b, double conductance);
+
+// Build the CSR flow matrix from the added pipes; the network can be stepped afterwards
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER (also on allocation failure) or ERROR_INVALID_PARAMETER
+ErrorCode finalizeTankNetwork(TankNetwork *network);
+
+// Advance tanks first .. last-1 by one step, reading height and writing nextHeight
+// Building block of the stepping calls; every tank of the network must be covered once
+// before the step is completed with completeTankNetworkStep.
+// Parameters:
+//   network: finalized network
+//   first, last: tank range
+//   dt: time step (seconds)
+void stepTankNetworkRange(TankNetwork *network, int first, int last, double dt);
+
+// Finish a step: the heights of the step become the ones the next step reads
+void completeTankNetworkStep(TankNetwork *network);
+
+// Advance the whole network by one time step (every controller + the coupled model)
+// Parameters:
+//   network: finalized network
+//   dt: time step (seconds)
+// Returns: ErrorCode
+ErrorCode stepTankNetwork(TankNetwork *network, double dt);
+
+// Advance the whole network by one time step, split into contiguous partitions on a pool
+// Same result as stepTankNetwork for any partition count.
+// Parameters:
+//   network: finalized network
+//   pool: worker pool (waited on before returning)
+//   partitions: number of index ranges (1 to TANK_NETWORK_MAX_PARTITIONS)
+//   dt: time step (seconds)
+// Returns: ErrorCode
+ErrorCode stepTankNetworkParallel(TankNetwork *network, JobPool *pool, int partitions, double dt);
+
+// Release the arrays owned by the network
+void freeTankNetwork(TankNetwork *network);
+
+#endif // WATERTANK_NETWORK_H
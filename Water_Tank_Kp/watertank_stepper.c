@@ -0,0 +1,169 @@
+#include "watertank_stepper.h"
+#include "controller_kernels.h"
+#include "watertank_kernels.h"
+#include <stddef.h>
+
+// Integration steps (same kernels as the tankModel* callbacks)
+#define TANK_STEP_EULER(tank, flow, dt)               tankEulerIntegrate((tank), (flow), (dt))
+#define TANK_STEP_TRAPEZOIDAL(tank, flow, dt)         tankTrapezoidalIntegrate((tank), (flow), (dt), 0)
+#define TANK_STEP_TRAPEZOIDAL_TRACKED(tank, flow, dt) tankTrapezoidalIntegrate((tank), (flow), (dt), 1)
+
+// Integration steps with sensitivities (same kernels as above)
+#define TANK_SENSITIVITY_STEP_EULER(tank, sens, flow, dFlow, dt) \
+    tankEulerSensitivityIntegrate((tank), (sens), (flow), (dFlow), (dt))
+#define TANK_SENSITIVITY_STEP_TRAPEZOIDAL(tank, sens, flow, dFlow, dt) \
+    tankTrapezoidalSensitivityIntegrate((tank), (sens), (flow), (dFlow), (dt), 0)
+#define TANK_SENSITIVITY_STEP_TRAPEZOIDAL_TRACKED(tank, sens, flow, dFlow, dt) \
+    tankTrapezoidalSensitivityIntegrate((tank), (sens), (flow), (dFlow), (dt), 1)
+
+// Model pipelines with a specialized variant, expanded once per controller
+// X(callback, law, name, model callback, net flow callback, net flow law, integration step)
+// tankModel always uses Torricelli outflow, so its net flow callback is not checked (NULL).
+#define TANK_STEPPER_MODEL_LIST(X, callback, law)                                              \
+    X(callback, law, Euler, tankModel, NULL,                                                   \
+      tankNetFlowLaw, TANK_STEP_EULER)                                                         \
+    X(callback, law, Trapezoidal, tankModelTrapezoidal, calculateTankNetFlow,                  \
+      tankNetFlowLaw, TANK_STEP_TRAPEZOIDAL)                                                   \
+    X(callback, law, TrapezoidalNoOutflow, tankModelTrapezoidal, calculateTankNetFlowSimplified, \
+      tankNetFlowSimplifiedLaw, TANK_STEP_TRAPEZOIDAL)                                         \
+    X(callback, law, Simplified, tankModelTrapezoidalSimplified, calculateTankNetFlowSimplified, \
+      tankNetFlowSimplifiedLaw, TANK_STEP_TRAPEZOIDAL_TRACKED)                                 \
+    X(callback, law, SimplifiedOutflow, tankModelTrapezoidalSimplified, calculateTankNetFlow,  \
+      tankNetFlowLaw, TANK_STEP_TRAPEZOIDAL_TRACKED)
+
+// Stepper for one (controller, model) pair: the same sequence as updateSystem()
+// (getTankSetpoint, getTankOutput, calculateError, controller, model) with direct field access
+#define DEFINE_TANK_STEPPER(callback, law, name, modelCallback, netFlowCallback, netFlowLaw, integrate) \
+    static ErrorCode stepTank_##callback##_##name(WaterTank *tank, double dt, int steps,               \
+                                                  double *output) {                                     \
+        const ControllerParams *params = tank->controller.params;                                       \
+        ControllerState *state = tank->controller.state;                                                \
+        double controllerDt = tank->controller.dt;                                                      \
+        const GainSchedule *schedule = tank->controller.schedule;                                       \
+        for (int k = 0; k < steps; k++) {                                                               \
+            double error = tank->setpoint - tank->level;                                                \
+            tank->inflow = law(error, params, state, controllerDt, schedule);                           \
+            double level_m = tank->volume * tank->model.prepared.inverse_area;                          \
+            double flow = netFlowLaw(&tank->model, level_m, tank->inflow);                              \
+            integrate(tank, flow, dt);                                                                  \
+        }                                                                                               \
+        *output = tank->level;                                                                          \
+        return ERROR_SUCCESS;                                                                           \
+    }
+
+#define DEFINE_TANK_STEPPERS(callback, law) TANK_STEPPER_MODEL_LIST(DEFINE_TANK_STEPPER, callback, law)
+CONTROLLER_LAW_LIST(DEFINE_TANK_STEPPERS)
+
+// Lookup table of the generated steppers
+typedef struct {
+    ControllerCallback controller;
+    SystemModelCallback model;
+    NetFlowCallback netFlow;  // NULL = any
+    TankStepper stepper;
+} TankStepperEntry;
+
+#define TANK_STEPPER_ENTRY(callback, law, name, modelCallback, netFlowCallback, netFlowLaw, integrate) \
+    { callback, modelCallback, netFlowCallback, stepTank_##callback##_##name },
+#define TANK_STEPPER_ENTRIES(callback, law) TANK_STEPPER_MODEL_LIST(TANK_STEPPER_ENTRY, callback, law)
+
+static const TankStepperEntry tankSteppers[] = {
+    CONTROLLER_LAW_LIST(TANK_STEPPER_ENTRIES)
+};
+
+ErrorCode selectTankStepper(const WaterTank *tank, ControllerCallback controller, TankStepper *stepper) {
+    if (tank == NULL || controller == NULL || stepper == NULL) return ERROR_NULL_POINTER;
+    *stepper = NULL;
+
+    // Everything updateSystem() and the controllers would check on every step, checked once
+    if (tank->controller.params == NULL || tank->controller.state == NULL) return ERROR_NULL_POINTER;
+    if (tank->controller.getSetpoint != getTankSetpoint || tank->controller.getOutput != getTankOutput) {
+        return ERROR_INVALID_PARAMETER;
+    }
+    if (tank->controller.history != NULL) return ERROR_INVALID_PARAMETER;  // Recorded by updateSystem() only
+
+    for (size_t i = 0; i < sizeof(tankSteppers) / sizeof(tankSteppers[0]); i++) {
+        const TankStepperEntry *entry = &tankSteppers[i];
+        if (entry->controller == controller && entry->model == tank->model.callback &&
+            (entry->netFlow == NULL || entry->netFlow == tank->model.netFlowCallback)) {
+            *stepper = entry->stepper;
+            return ERROR_SUCCESS;
+        }
+    }
+    return ERROR_INVALID_PARAMETER;
+}
+
+// Model pipelines with a sensitivity variant (pidController only)
+// X(name, model callback, net flow callback, net flow law, net flow sensitivity, integration step)
+#define TANK_SENSITIVITY_MODEL_LIST(X)                                                             \
+    X(Euler, tankModel, NULL,                                                                      \
+      tankNetFlowLaw, tankNetFlowSensitivityLaw, TANK_SENSITIVITY_STEP_EULER)                      \
+    X(Trapezoidal, tankModelTrapezoidal, calculateTankNetFlow,                                     \
+      tankNetFlowLaw, tankNetFlowSensitivityLaw, TANK_SENSITIVITY_STEP_TRAPEZOIDAL)                \
+    X(TrapezoidalNoOutflow, tankModelTrapezoidal, calculateTankNetFlowSimplified,                  \
+      tankNetFlowSimplifiedLaw, tankNetFlowSimplifiedSensitivityLaw, TANK_SENSITIVITY_STEP_TRAPEZOIDAL) \
+    X(Simplified, tankModelTrapezoidalSimplified, calculateTankNetFlowSimplified,                  \
+      tankNetFlowSimplifiedLaw, tankNetFlowSimplifiedSensitivityLaw,                               \
+      TANK_SENSITIVITY_STEP_TRAPEZOIDAL_TRACKED)                                                   \
+    X(SimplifiedOutflow, tankModelTrapezoidalSimplified, calculateTankNetFlow,                     \
+      tankNetFlowLaw, tankNetFlowSensitivityLaw, TANK_SENSITIVITY_STEP_TRAPEZOIDAL_TRACKED)
+
+// Sensitivity stepper: the PID stepper sequence with the tangent of every step alongside.
+// The error is setpoint - level with a fixed setpoint, so d(error) = -d(level).
+// The inflow is not limited by the tank models, so it follows the control signal exactly.
+#define DEFINE_TANK_SENSITIVITY_STEPPER(name, modelCallback, netFlowCallback, netFlowLaw,          \
+                                        netFlowSensitivity, integrate)                             \
+    static ErrorCode stepTankSensitivity_##name(WaterTank *tank, TankSensitivity *sensitivity,     \
+                                                double dt, int steps, double *output) {            \
+        const ControllerParams *params = tank->controller.params;                                  \
+        ControllerState *state = tank->controller.state;                                           \
+        double controllerDt = tank->controller.dt;                                                 \
+        for (int k = 0; k < steps; k++) {                                                          \
+            double error = tank->setpoint - tank->level;                                           \
+            double dError[GAIN_COUNT], dFlow[GAIN_COUNT];                                          \
+            for (int g = 0; g < GAIN_COUNT; g++) dError[g] = -sensitivity->level[g];               \
+            tank->inflow = pidSensitivityLaw(error, params, state, controllerDt,                   \
+                                             &sensitivity->controller, dError, sensitivity->inflow); \
+            double level_m = tank->volume * tank->model.prepared.inverse_area;                     \
+            netFlowSensitivity(&tank->model, level_m, sensitivity, dFlow);                         \
+            double flow = netFlowLaw(&tank->model, level_m, tank->inflow);                         \
+            integrate(tank, sensitivity, flow, dFlow, dt);                                         \
+        }                                                                                          \
+        *output = tank->level;                                                                     \
+        return ERROR_SUCCESS;                                                                      \
+    }
+
+TANK_SENSITIVITY_MODEL_LIST(DEFINE_TANK_SENSITIVITY_STEPPER)
+
+typedef struct {
+    SystemModelCallback model;
+    NetFlowCallback netFlow;  // NULL = any
+    TankSensitivityStepper stepper;
+} TankSensitivityStepperEntry;
+
+#define TANK_SENSITIVITY_STEPPER_ENTRY(name, modelCallback, netFlowCallback, netFlowLaw,           \
+                                       netFlowSensitivity, integrate)                              \
+    { modelCallback, netFlowCallback, stepTankSensitivity_##name },
+
+static const TankSensitivityStepperEntry tankSensitivitySteppers[] = {
+    TANK_SENSITIVITY_MODEL_LIST(TANK_SENSITIVITY_STEPPER_ENTRY)
+};
+
+ErrorCode selectTankSensitivityStepper(const WaterTank *tank, TankSensitivityStepper *stepper) {
+    if (stepper == NULL) return ERROR_NULL_POINTER;
+    *stepper = NULL;
+
+    // Same preconditions as the PID stepper
+    TankStepper primal = NULL;
+    ErrorCode err = selectTankStepper(tank, pidController, &primal);
+    if (err != ERROR_SUCCESS) return err;
+
+    for (size_t i = 0; i < sizeof(tankSensitivitySteppers) / sizeof(tankSensitivitySteppers[0]); i++) {
+        const TankSensitivityStepperEntry *entry = &tankSensitivitySteppers[i];
+        if (entry->model == tank->model.callback &&
+            (entry->netFlow == NULL || entry->netFlow == tank->model.netFlowCallback)) {
+            *stepper = entry->stepper;
+            return ERROR_SUCCESS;
+        }
+    }
+    return ERROR_INVALID_PARAMETER;
+}
@@ -0,0 +1,57 @@
+#ifndef WATERTANK_STEPPER_H
+#define WATERTANK_STEPPER_H
+
+#include "watertank.h"
+
+// Specialized stepping function for one (controller, model) pair
+// Runs `steps` iterations of controller + model with the setpoint held constant, with
+// every callback of the generic updateSystem() pipeline inlined and no per-step checks.
+// Only call it on the tank it was selected for by selectTankStepper().
+// Parameters:
+//   tank: water tank validated by selectTankStepper
+//   dt: model time step (seconds)
+//   steps: number of steps to run
+//   output: pointer to store water level after the last step (percentage 0-100%)
+// Returns: ErrorCode
+typedef ErrorCode (*TankStepper)(WaterTank *tank, double dt, int steps, double *output);
+
+// Select the specialized stepper matching a tank configuration
+// The generated variants cover every controller in controller.h combined with tankModel,
+// tankModelTrapezoidal and tankModelTrapezoidalSimplified (with either net flow callback).
+// The tank must use getTankSetpoint/getTankOutput and have params and state set; any other
+// configuration returns ERROR_INVALID_PARAMETER and must keep using updateSystem(),
+// whose results the steppers reproduce exactly. So does a controller with an error history
+// attached (only updateSystem() records it, so the stepper loops stay free of it).
+// Parameters:
+//   tank: configured water tank (controller and model filled in)
+//   controller: controller callback the tank would be driven with
+//   stepper: pointer to store the selected stepper
+// Returns: ErrorCode
+ErrorCode selectTankStepper(const WaterTank *tank, ControllerCallback controller, TankStepper *stepper);
+
+// Sensitivity stepper: pidController + model steps that also propagate the derivatives of the
+// state with respect to Kp, Ki and Kd (forward mode, one tangent per gain)
+// The primal trajectory is exactly that of the TankStepper for the same configuration, so one
+// run yields the trajectory and, through sensitivity->level, the exact gradient of any cost
+// built from it. Only call it on the tank it was selected for.
+// Parameters:
+//   tank: water tank validated by selectTankSensitivityStepper
+//   sensitivity: state derivatives (zero-filled at the start of the run, updated)
+//   dt: model time step (seconds)
+//   steps: number of steps to run
+//   output: pointer to store water level after the last step (percentage 0-100%)
+// Returns: ErrorCode
+typedef ErrorCode (*TankSensitivityStepper)(WaterTank *tank, TankSensitivity *sensitivity,
+                                            double dt, int steps, double *output);
+
+// Select the sensitivity stepper for a tank driven by pidController
+// Covers tankModel, tankModelTrapezoidal and tankModelTrapezoidalSimplified (with either net flow
+// callback) under the same conditions as selectTankStepper; any other model returns
+// ERROR_INVALID_PARAMETER.
+// Parameters:
+//   tank: configured water tank (controller and model filled in)
+//   stepper: pointer to store the selected stepper
+// Returns: ErrorCode
+ErrorCode selectTankSensitivityStepper(const WaterTank *tank, TankSensitivityStepper *stepper);
+
+#endif // WATERTANK_STEPPER_H
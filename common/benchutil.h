@@ -0,0 +1,113 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+// Timing helpers shared by the bench executables (Water_Tank_Kp/bench.c, FreeFall_Object/code/bench.c)
+// Every measurement is printed as one JSON object per line:
+//   {"suite":"water_tank","group":"controller","case":"pController","threads":1,
+//    "items":1048576,"ns_per_item":3.412}
+// so runs can be diffed or loaded (e.g. pandas.read_json(path, lines=True)) to catch regressions.
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define BENCH_DEFAULT_MIN_TIME_MS 100  // Minimum duration of one timed repetition
+#define BENCH_REPETITIONS 3            // Timed repetitions; the fastest one is reported
+
+// Body of a benchmark: run `iterations` iterations (each one processes itemsPerIteration items)
+typedef void (*BenchBody)(void *context, long iterations);
+
+// Settings shared by all measurements of a run
+typedef struct {
+    long long minTimeNs;   // Grow the iteration count until one repetition takes this long
+    const char *filter;    // Only run cases whose "group/case" contains this (NULL = all)
+    const char *suite;     // Suite name in the output
+    FILE *out;             // Output stream for the JSON lines
+} BenchSettings;
+
+// Monotonic clock in nanoseconds
+static inline long long benchNowNs(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+// Check a case against the --filter substring
+static inline int benchSelected(const BenchSettings *settings, const char *group, const char *name) {
+    if (settings->filter == NULL) return 1;
+    char key[256];
+    snprintf(key, sizeof(key), "%s/%s", group, name);
+    return strstr(key, settings->filter) != NULL;
+}
+
+// Print one result line
+static inline void benchReport(const BenchSettings *settings, const char *group, const char *name,
+                               int threads, long long items, double nsPerItem) {
+    fprintf(settings->out,
+            "{\"suite\":\"%s\",\"group\":\"%s\",\"case\":\"%s\",\"threads\":%d,\"items\":%lld,\"ns_per_item\":%.3f}\n",
+            settings->suite, group, name, threads, items, nsPerItem);
+    fflush(settings->out);
+}
+
+// Print one equivalence line: largest deviation of a trajectory from its reference run
+//   {"suite":"water_tank","group":"equivalence","case":"pidController_q16","steps":1250,
+//    "max_output_error":0.0012,"max_signal_error":0.0004,"tolerance":0.5,"pass":true}
+static inline void benchReportDeviation(const BenchSettings *settings, const char *group, const char *name,
+                                        long steps, double maxOutputError, double maxSignalError,
+                                        double tolerance) {
+    if (!benchSelected(settings, group, name)) return;
+    fprintf(settings->out,
+            "{\"suite\":\"%s\",\"group\":\"%s\",\"case\":\"%s\",\"steps\":%ld,\"max_output_error\":%.6g,"
+            "\"max_signal_error\":%.6g,\"tolerance\":%g,\"pass\":%s}\n",
+            settings->suite, group, name, steps, maxOutputError, maxSignalError, tolerance,
+            maxOutputError <= tolerance ? "true" : "false");
+    fflush(settings->out);
+}
+
+// Time a body: double the iteration count until a repetition lasts minTimeNs, then report the
+// fastest of BENCH_REPETITIONS repetitions (ns per item)
+static inline void benchRun(const BenchSettings *settings, const char *group, const char *name,
+                            long itemsPerIteration, BenchBody body, void *context) {
+    if (!benchSelected(settings, group, name)) return;
+
+    long iterations = 1;
+    long long elapsed = 0;
+    for (;;) {
+        long long start = benchNowNs();
+        body(context, iterations);
+        elapsed = benchNowNs() - start;
+        if (elapsed >= settings->minTimeNs || iterations >= (1L << 30)) break;
+        // Jump close to the target once the timing is meaningful
+        if (elapsed > 1000000) {
+            double scale = (double)settings->minTimeNs / (double)elapsed * 1.2;
+            iterations = (long)((double)iterations * (scale > 2.0 ? scale : 2.0));
+        } else {
+            iterations *= 2;
+        }
+    }
+
+    long long best = elapsed;
+    for (int r = 1; r < BENCH_REPETITIONS; r++) {
+        long long start = benchNowNs();
+        body(context, iterations);
+        long long t = benchNowNs() - start;
+        if (t < best) best = t;
+    }
+    long long items = (long long)iterations * itemsPerIteration;
+    benchReport(settings, group, name, 1, items, (double)best / (double)items);
+}
+
+#endif // BENCHUTIL_H
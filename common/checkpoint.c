@@ -0,0 +1,114 @@
+#include "checkpoint.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static void putU32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t getU32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// FNV-1a over the payload bytes
+static uint32_t checksumPayload(const void *payload, size_t size) {
+    const unsigned char *bytes = (const unsigned char*)payload;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Push the written file to the storage device (C buffers, then the OS cache)
+static int syncCheckpointFile(FILE *file) {
+    if (fflush(file) != 0) return 0;
+#ifdef _WIN32
+    return FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(file))) != 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Replace path with the completely written temporary file
+static int replaceCheckpointFile(const char *temporary, const char *path) {
+#ifdef _WIN32
+    return MoveFileExA(temporary, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (rename(temporary, path) != 0) return 0;
+    // Make the rename itself durable: sync the directory entry (best effort, not every
+    // file system allows opening a directory)
+    char directory[1024];
+    const char *slash = strrchr(path, '/');
+    size_t length = slash == NULL ? 0 : (size_t)(slash - path);
+    if (length == 0 || length >= sizeof(directory)) {
+        strcpy(directory, slash == path ? "/" : ".");
+    } else {
+        memcpy(directory, path, length);
+        directory[length] = '\0';
+    }
+    int fd = open(directory, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    return 1;
+#endif
+}
+
+ErrorCode writeCheckpointFile(const char *path, uint32_t kind, const void *payload, size_t size) {
+    if (path == NULL || payload == NULL) return ERROR_NULL_POINTER;
+    if (size > UINT32_MAX) return ERROR_INVALID_PARAMETER;
+
+    char temporary[1024];
+    if (snprintf(temporary, sizeof(temporary), "%s.tmp", path) >= (int)sizeof(temporary)) {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    unsigned char header[CHECKPOINT_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    putU32(header + 8, kind);
+    putU32(header + 12, (uint32_t)size);
+    putU32(header + 16, checksumPayload(payload, size));
+
+    FILE *file = fopen(temporary, "wb");
+    if (file == NULL) return ERROR_CALLBACK_FAILED;
+    int ok = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+             fwrite(payload, 1, size, file) == size;
+    if (ok && !syncCheckpointFile(file)) ok = 0;  // On disk before it replaces the old checkpoint
+    if (fclose(file) != 0) ok = 0;
+    if (!ok || !replaceCheckpointFile(temporary, path)) {
+        remove(temporary);
+        return ERROR_CALLBACK_FAILED;
+    }
+    return ERROR_SUCCESS;
+}
+
+ErrorCode readCheckpointFile(const char *path, uint32_t kind, void *payload, size_t size) {
+    if (path == NULL || payload == NULL) return ERROR_NULL_POINTER;
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return ERROR_CALLBACK_FAILED;
+
+    unsigned char header[CHECKPOINT_HEADER_SIZE];
+    int complete = fread(header, 1, sizeof(header), file) == sizeof(header);
+    ErrorCode err = ERROR_SUCCESS;
+    if (!complete || memcmp(header, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+        getU32(header + 8) != kind || getU32(header + 12) != size) {
+        err = ERROR_INVALID_PARAMETER;
+    } else if (fread(payload, 1, size, file) != size || fgetc(file) != EOF ||
+               checksumPayload(payload, size) != getU32(header + 16)) {
+        err = ERROR_INVALID_PARAMETER;  // Truncated, trailing data or corrupted
+    }
+    fclose(file);
+    return err;
+}
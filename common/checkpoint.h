@@ -0,0 +1,48 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "errorcode.h"
+
+// Checkpoint files: one snapshot of a paused run, written atomically
+// The payload is a plain state structure of the run (e.g. TankRunCheckpoint) stored in the
+// native layout, so a checkpoint is read back by the build that wrote it. The header
+// identifies the payload and guards against truncated or foreign files.
+//
+// File layout:
+//   offset  0: char     magic[8]      "ACSCKP1\0"
+//   offset  8: uint32   kind          payload type (CHECKPOINT_KIND_*)
+//   offset 12: uint32   payloadSize   bytes after the header
+//   offset 16: uint32   checksum      FNV-1a of the payload
+//   offset 20: uint32   reserved      0
+//   offset 24: payload
+
+#define CHECKPOINT_MAGIC "ACSCKP1"
+#define CHECKPOINT_HEADER_SIZE 24
+
+// Payload types
+#define CHECKPOINT_KIND_TANK_RUN 1u     // Water_Tank_Kp run (TankRunCheckpoint in main.c)
+
+// Write a checkpoint
+// The file is written next to path, flushed to disk (fsync / FlushFileBuffers) and renamed
+// over it, so a process crash or power loss while writing leaves the previous checkpoint intact.
+// Parameters:
+//   path: checkpoint file path
+//   kind: payload type
+//   payload: state to store
+//   size: payload size in bytes
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_CALLBACK_FAILED (file not written)
+ErrorCode writeCheckpointFile(const char *path, uint32_t kind, const void *payload, size_t size);
+
+// Read a checkpoint written by writeCheckpointFile
+// Parameters:
+//   path: checkpoint file path
+//   kind: expected payload type
+//   payload: receives the state (unspecified on error)
+//   size: expected payload size in bytes
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER, ERROR_CALLBACK_FAILED (no readable file) or
+//          ERROR_INVALID_PARAMETER (not a checkpoint of this kind and size, or corrupted)
+ErrorCode readCheckpointFile(const char *path, uint32_t kind, void *payload, size_t size);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,180 @@
+#include "controller.h"
+#include "controller_kernels.h"
+#include "profile.h"
+#include <stddef.h>
+#include <string.h>
+
+// Built-in gain schedules (values in controller.h, shared with the firmware tables)
+#define GAIN_SCHEDULE_DOUBLE(x) (x)
+const GainSchedule adaptivePGainSchedule = ADAPTIVE_PD_GAIN_SCHEDULE(GAIN_SCHEDULE_DOUBLE, GAIN_SCHEDULE_UNUSED);
+const GainSchedule adaptivePdGainSchedule = ADAPTIVE_PD_GAIN_SCHEDULE(GAIN_SCHEDULE_DOUBLE, GAIN_SCHEDULE_UNUSED);
+const GainSchedule adaptivePiGainSchedule = ADAPTIVE_PI_GAIN_SCHEDULE(GAIN_SCHEDULE_DOUBLE, GAIN_SCHEDULE_UNUSED);
+const GainSchedule adaptivePidGainSchedule = ADAPTIVE_PI_GAIN_SCHEDULE(GAIN_SCHEDULE_DOUBLE, GAIN_SCHEDULE_UNUSED);
+
+void resetControllerState(ControllerState *state) {
+    if (state == NULL) return;
+    state->integral = 0.0;
+    state->previousError = 0.0;
+    state->cumulativeError = 0.0;
+}
+
+ErrorCode initControllerConfig(ControllerConfig *config, ControllerParams *params, ControllerState *state,
+                               double dt) {
+    if (config == NULL || params == NULL || state == NULL) return ERROR_NULL_POINTER;
+    if (!(dt > 0.0)) return ERROR_INVALID_PARAMETER;
+
+    memset(config, 0, sizeof(*config));
+    config->params = params;
+    config->state = state;
+    config->dt = dt;
+    resetControllerState(state);
+    return ERROR_SUCCESS;
+}
+
+ErrorCode initErrorHistory(ErrorHistory *history, double *buffer, unsigned int length) {
+    if (history == NULL || buffer == NULL) return ERROR_NULL_POINTER;
+    if (length == 0 || (length & (length - 1)) != 0) return ERROR_INVALID_PARAMETER;
+
+    history->errors = buffer;
+    history->mask = length - 1;
+    resetErrorHistory(history);
+    return ERROR_SUCCESS;
+}
+
+void resetErrorHistory(ErrorHistory *history) {
+    if (history == NULL || history->errors == NULL) return;
+    for (unsigned int i = 0; i <= history->mask; i++) {
+        history->errors[i] = 0.0;
+    }
+    history->count = 0;
+}
+
+// Error calculation function
+ErrorCode calculateError(double setpoint, double currentOutput, double *error) {
+    if (error == NULL) return ERROR_NULL_POINTER;
+    
+    *error = setpoint - currentOutput;
+    return ERROR_SUCCESS;
+}
+
+// Simple Proportional controller (non-adaptive)
+ErrorCode pController(double error, ControllerConfig *config, double *controlSignal) {
+    if (config == NULL || controlSignal == NULL) return ERROR_NULL_POINTER;
+    
+    if (config->params == NULL) return ERROR_NULL_POINTER;
+    
+    *controlSignal = pControlLaw(error, config->params, config->state, config->dt, config->schedule);
+    return ERROR_SUCCESS;
+}
+
+// Adaptive Proportional controller with gain scheduling
+ErrorCode adaptivePController(double error, ControllerConfig *config, double *controlSignal) {
+    if (config == NULL || controlSignal == NULL) return ERROR_NULL_POINTER;
+    
+    if (config->params == NULL || config->state == NULL) return ERROR_NULL_POINTER;
+    
+    *controlSignal = adaptivePControlLaw(error, config->params, config->state, config->dt, config->schedule);
+    return ERROR_SUCCESS;
+}
+
+// PI controller
+ErrorCode piController(double error, ControllerConfig *config, double *controlSignal) {
+    if (config == NULL || controlSignal == NULL) return ERROR_NULL_POINTER;
+    
+    if (config->params == NULL || config->state == NULL) return ERROR_NULL_POINTER;
+    
+    *controlSignal = piControlLaw(error, config->params, config->state, config->dt, config->schedule);
+    return ERROR_SUCCESS;
+}
+
+// PD controller
+ErrorCode pdController(double error, ControllerConfig *config, double *controlSignal) {
+    if (config == NULL || controlSignal == NULL) return ERROR_NULL_POINTER;
+    
+    if (config->params == NULL || config->state == NULL) return ERROR_NULL_POINTER;
+    
+    *controlSignal = pdControlLaw(error, config->params, config->state, config->dt, config->schedule);
+    return ERROR_SUCCESS;
+}
+
+// PID controller
+ErrorCode pidController(double error, ControllerConfig *config, double *controlSignal) {
+    if (config == NULL || controlSignal == NULL) return ERROR_NULL_POINTER;
+    
+    if (config->params == NULL || config->state == NULL) return ERROR_NULL_POINTER;
+    
+    *controlSignal = pidControlLaw(error, config->params, config->state, config->dt, config->schedule);
+    return ERROR_SUCCESS;
+}
+
+// Adaptive PD controller with gain scheduling
+ErrorCode adaptivePdController(double error, ControllerConfig *config, double *controlSignal) {
+    if (config == NULL || controlSignal == NULL) return ERROR_NULL_POINTER;
+    
+    if (config->params == NULL || config->state == NULL) return ERROR_NULL_POINTER;
+    
+    *controlSignal = adaptivePdControlLaw(error, config->params, config->state, config->dt, config->schedule);
+    return ERROR_SUCCESS;
+}
+
+// Adaptive PI controller with gain scheduling
+ErrorCode adaptivePiController(double error, ControllerConfig *config, double *controlSignal) {
+    if (config == NULL || controlSignal == NULL) return ERROR_NULL_POINTER;
+    
+    if (config->params == NULL || config->state == NULL) return ERROR_NULL_POINTER;
+    
+    *controlSignal = adaptivePiControlLaw(error, config->params, config->state, config->dt, config->schedule);
+    return ERROR_SUCCESS;
+}
+
+// Adaptive PID controller with gain scheduling
+ErrorCode adaptivePidController(double error, ControllerConfig *config, double *controlSignal) {
+    if (config == NULL || controlSignal == NULL) return ERROR_NULL_POINTER;
+    
+    if (config->params == NULL || config->state == NULL) return ERROR_NULL_POINTER;
+    
+    *controlSignal = adaptivePidControlLaw(error, config->params, config->state, config->dt, config->schedule);
+    return ERROR_SUCCESS;
+}
+
+// Generic system update using controller and model callbacks
+ErrorCode updateSystem(void *system, ControllerConfig *config, SystemModelCallback modelCallback,
+                  double dt, double *output,
+                  ControllerCallback controllerCallback,
+                  ErrorCalculationCallback errorCalcCallback) {
+    if (errorCalcCallback == NULL) {
+        errorCalcCallback = calculateError;
+    }
+    if (controllerCallback == NULL || system == NULL || config == NULL || output == NULL) {
+        return ERROR_NULL_POINTER;
+    }
+    
+    if (config->getSetpoint == NULL || config->getOutput == NULL || 
+        config->params == NULL || modelCallback == NULL) {
+        return ERROR_NULL_POINTER;
+    }
+    
+    // Get setpoint and current output from system
+    double setpoint, currentOutput;
+    ErrorCode err = config->getSetpoint(system, &setpoint);
+    if (err != ERROR_SUCCESS) return err;
+    
+    err = config->getOutput(system, &currentOutput);
+    if (err != ERROR_SUCCESS) return err;
+    
+    // Calculate error using callback if provided, otherwise use default calculateError function
+    double error;
+    err = errorCalcCallback(setpoint, currentOutput, &error);
+    if (err != ERROR_SUCCESS) return err;
+    if (config->history != NULL) recordErrorHistory(config->history, error);
+    
+    // Calculate control input using controller callback with error as input
+    double controlInput;
+    PROFILE_SECTION(PROFILE_CONTROLLER, err = controllerCallback(error, config, &controlInput));
+    PROFILE_COUNT(PROFILE_CONTROLLER_ERRORS, err != ERROR_SUCCESS);
+    if (err != ERROR_SUCCESS) return err;
+    
+    // Update system using the plant's model callback
+    PROFILE_SECTION(PROFILE_MODEL, err = modelCallback(system, controlInput, dt, output));
+    return err;
+}
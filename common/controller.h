@@ -0,0 +1,279 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <math.h>
+#include "errorcode.h"
+
+// Get output callback function type
+// Parameters:
+//   system: pointer to system state structure
+//   output: pointer to store current system output (measured variable)
+// Returns: ErrorCode
+typedef ErrorCode (*GetOutputCallback)(void *system, double *output);
+
+// Get setpoint callback function type
+// Parameters:
+//   system: pointer to system state structure
+//   setpoint: pointer to store desired system output
+// Returns: ErrorCode
+typedef ErrorCode (*GetSetpointCallback)(void *system, double *setpoint);
+
+// Controller parameters structure
+// Contains gain constants for P, PI, and PID controllers
+typedef struct {
+    double Kp;  // Proportional gain
+    double Ki;  // Integral gain
+    double Kd;  // Derivative gain
+} ControllerParams;
+
+// Controller state structure
+// Contains only what the control laws read back on the next step; all-zero is the initial
+// state (resetControllerState), so states can be zero-filled or packed densely
+typedef struct {
+    double integral;      // Accumulated integral of error
+    double previousError; // Previous error for derivative calculation
+    double cumulativeError; // Decayed |error| sum for adaptive gain adjustment
+} ControllerState;
+
+// Gains a sensitivity run differentiates by (index into every *Sensitivity array)
+#define GAIN_KP 0
+#define GAIN_KI 1
+#define GAIN_KD 2
+#define GAIN_COUNT 3
+
+// Derivatives of the PID controller state with respect to Kp, Ki and Kd
+// Carried next to ControllerState by the sensitivity steppers (pidSensitivityLaw);
+// all-zero at the start of a run, since the initial state does not depend on the gains
+typedef struct {
+    double integral[GAIN_COUNT];      // d(integral)/d(gain)
+    double previousError[GAIN_COUNT]; // d(previousError)/d(gain)
+} ControllerSensitivity;
+
+// Optional record of the most recent controller errors (diagnostics, no control law reads it)
+// The length is a power of two so the ring index is a mask, not a modulo.
+typedef struct {
+    double *errors;       // Caller-owned buffer of mask + 1 entries
+    unsigned int mask;    // Length - 1
+    unsigned int count;   // Errors recorded so far (the next slot is count & mask)
+} ErrorHistory;
+
+// Gain schedule of the adaptive controllers
+// Each table maps a measured value to a multiplier in steps: the lookup finds how many band
+// edges the value exceeds (a branchless binary search over the GAIN_SCHEDULE_MAX_EDGES edge
+// slots, 2^3 - 1 so it is always three compares) and takes factor[count]. Edges are
+// ascending; unused edges are GAIN_SCHEDULE_UNUSED so no value exceeds them.
+#define GAIN_SCHEDULE_MAX_EDGES 7
+#define GAIN_SCHEDULE_UNUSED INFINITY
+
+typedef struct {
+    double edge[GAIN_SCHEDULE_MAX_EDGES];        // Ascending band edges
+    double factor[GAIN_SCHEDULE_MAX_EDGES + 1];  // factor[k]: value above exactly k edges
+} GainBands;
+
+// adaptiveKp = Kp * error(|error|) * cumulative(cumulativeError) * trend * rate(|error rate|),
+// trend = trendBoost while the error decreases at a rate inside (trendMinRate, trendMaxRate)
+typedef struct {
+    GainBands error;        // Gain by error magnitude
+    GainBands cumulative;   // Boost by decayed cumulative error (persistent error)
+    GainBands rate;         // Damping by error rate magnitude (oscillation)
+    double trendMinRate;
+    double trendMaxRate;
+    double trendBoost;
+} GainSchedule;
+
+// Values of the built-in schedules, shared by the double tables below and the float32/Q16.16
+// firmware tables (controller_embedded.h) so the two cannot drift apart: V(x) converts a
+// constant to the table type, U is the unused-edge value of that type.
+// |error| bands 0.02/0.05/0.15/0.3/0.6/1.0, cumulative-error boosts, trend boost for an error
+// decreasing at 0.15-1.5 per second, damping above 2.5 and 4.0 per second
+#define ADAPTIVE_ERROR_BANDS(V, U)                                                                 \
+    { { V(0.02), V(0.05), V(0.15), V(0.3), V(0.6), V(1.0), U },                                    \
+      { V(0.85), V(1.0), V(1.15), V(1.5), V(2.0), V(2.5), V(3.5), V(3.5) } }
+#define ADAPTIVE_RATE_BANDS(V, U)                                                                  \
+    { { V(2.5), V(4.0), U, U, U, U, U },                                                           \
+      { V(1.0), V(0.70), V(0.55), V(0.55), V(0.55), V(0.55), V(0.55), V(0.55) } }
+// P and PD: aggressive cumulative boosts to overcome the steady-state error
+#define ADAPTIVE_PD_GAIN_SCHEDULE(V, U)                                                            \
+    { ADAPTIVE_ERROR_BANDS(V, U),                                                                  \
+      { { V(0.3), V(1.0), V(3.0), U, U, U, U },                                                    \
+        { V(1.0), V(1.3), V(1.6), V(2.0), V(2.0), V(2.0), V(2.0), V(2.0) } },                      \
+      ADAPTIVE_RATE_BANDS(V, U), V(0.15), V(1.5), V(1.35) }
+// PI and PID: the integral already removes steady-state error, so the boosts are milder
+#define ADAPTIVE_PI_GAIN_SCHEDULE(V, U)                                                            \
+    { ADAPTIVE_ERROR_BANDS(V, U),                                                                  \
+      { { V(0.5), V(2.0), V(5.0), U, U, U, U },                                                    \
+        { V(1.0), V(1.15), V(1.3), V(1.5), V(1.5), V(1.5), V(1.5), V(1.5) } },                     \
+      ADAPTIVE_RATE_BANDS(V, U), V(0.15), V(1.5), V(1.35) }
+
+// Built-in schedules (the tuned tables of each adaptive controller)
+extern const GainSchedule adaptivePGainSchedule;
+extern const GainSchedule adaptivePdGainSchedule;
+extern const GainSchedule adaptivePiGainSchedule;
+extern const GainSchedule adaptivePidGainSchedule;
+
+// Model-predictive controller state (mpc.h)
+struct MpcController;
+
+// Controller configuration structure
+// Contains all callbacks and parameters needed by the controller
+typedef struct {
+    ControllerParams *params;  // Pointer to controller parameters (Kp, Ki, Kd)
+    ControllerState *state;    // Pointer to controller state (integral, previousError)
+    GetSetpointCallback getSetpoint;     // Function to get desired system output
+    GetOutputCallback getOutput;         // Function to get current system output
+    double dt;                           // Time step for integral/derivative calculations
+    struct MpcController *mpc;           // Cached QP and warm start (mpcController only, else NULL)
+    const GainSchedule *schedule;        // Adaptive gain schedule (NULL: the controller's built-in table)
+    ErrorHistory *history;               // Errors recorded by updateSystem() (NULL: not recorded)
+} ControllerConfig;
+
+// Reset a controller state to its initial values (no integral, previous or cumulative error)
+// Parameters:
+//   state: state to reset
+void resetControllerState(ControllerState *state);
+
+// Initialize a controller configuration and reset its state
+// The plant still sets getSetpoint/getOutput; mpc, schedule and history are cleared.
+// Parameters:
+//   config: configuration to initialize
+//   params: controller gains (kept by pointer)
+//   state: controller state (kept by pointer, reset)
+//   dt: controller time step (seconds)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (dt not positive)
+ErrorCode initControllerConfig(ControllerConfig *config, ControllerParams *params, ControllerState *state,
+                               double dt);
+
+// Initialize an error history over a caller buffer
+// Parameters:
+//   history: history to initialize
+//   buffer: storage for `length` errors
+//   length: number of errors kept, a power of two
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (length not a power of two)
+ErrorCode initErrorHistory(ErrorHistory *history, double *buffer, unsigned int length);
+
+// Forget every recorded error (the buffer is zeroed)
+// Parameters:
+//   history: history to reset
+void resetErrorHistory(ErrorHistory *history);
+
+// Record one error, overwriting the oldest once the buffer is full
+static inline void recordErrorHistory(ErrorHistory *history, double error) {
+    history->errors[history->count & history->mask] = error;
+    history->count++;
+}
+
+// Error calculation callback function type
+// Parameters:
+//   setpoint: desired system output
+//   currentOutput: current system output (measured variable)
+//   error: pointer to store calculated error
+// Returns: ErrorCode
+typedef ErrorCode (*ErrorCalculationCallback)(double setpoint, double currentOutput, double *error);
+
+// Controller callback function type
+// Controllers only see their own configuration, so one implementation serves every plant
+// Parameters:
+//   error: control error
+//   config: controller configuration (params, state, dt)
+//   controlSignal: pointer to store control signal output
+// Returns: ErrorCode
+typedef ErrorCode (*ControllerCallback)(double error, ControllerConfig *config, double *controlSignal);
+
+// Generic system model callback function type
+// Parameters:
+//   system: pointer to system state structure
+//   input: control input to the system
+//   dt: time step (seconds)
+//   output: pointer to store system output (e.g., measured variable)
+// Returns: ErrorCode
+typedef ErrorCode (*SystemModelCallback)(void *system, double input, double dt, double *output);
+
+// Error calculation function
+// Parameters:
+//   setpoint: desired system output
+//   currentOutput: current system output (measured variable)
+//   error: pointer to store calculated error
+// Returns: ErrorCode
+ErrorCode calculateError(double setpoint, double currentOutput, double *error);
+
+// Proportional controller (can be used as ControllerCallback)
+// Parameters:
+//   error: control error
+//   config: controller configuration (params, state, dt)
+//   controlSignal: pointer to store control signal output
+// Returns: ErrorCode
+ErrorCode pController(double error, ControllerConfig *config, double *controlSignal);
+
+// Adaptive Proportional controller with gain scheduling (can be used as ControllerCallback)
+// Parameters:
+//   error: control error
+//   config: controller configuration (params, state, dt)
+//   controlSignal: pointer to store control signal output
+// Returns: ErrorCode
+ErrorCode adaptivePController(double error, ControllerConfig *config, double *controlSignal);
+
+// PI controller (can be used as ControllerCallback)
+// Parameters:
+//   error: control error
+//   config: controller configuration (params, state, dt)
+//   controlSignal: pointer to store control signal output
+// Returns: ErrorCode
+ErrorCode piController(double error, ControllerConfig *config, double *controlSignal);
+
+// PD controller (can be used as ControllerCallback)
+// Parameters:
+//   error: control error
+//   config: controller configuration (params, state, dt)
+//   controlSignal: pointer to store control signal output
+// Returns: ErrorCode
+ErrorCode pdController(double error, ControllerConfig *config, double *controlSignal);
+
+// PID controller (can be used as ControllerCallback)
+// Parameters:
+//   error: control error
+//   config: controller configuration (params, state, dt)
+//   controlSignal: pointer to store control signal output
+// Returns: ErrorCode
+ErrorCode pidController(double error, ControllerConfig *config, double *controlSignal);
+
+// Adaptive PD controller with gain scheduling (can be used as ControllerCallback)
+// Parameters:
+//   error: control error
+//   config: controller configuration (params, state, dt)
+//   controlSignal: pointer to store control signal output
+// Returns: ErrorCode
+ErrorCode adaptivePdController(double error, ControllerConfig *config, double *controlSignal);
+
+// Adaptive PI controller with gain scheduling (can be used as ControllerCallback)
+// Parameters:
+//   error: control error
+//   config: controller configuration (params, state, dt)
+//   controlSignal: pointer to store control signal output
+// Returns: ErrorCode
+ErrorCode adaptivePiController(double error, ControllerConfig *config, double *controlSignal);
+
+// Adaptive PID controller with gain scheduling (can be used as ControllerCallback)
+// Parameters:
+//   error: control error
+//   config: controller configuration (params, state, dt)
+//   controlSignal: pointer to store control signal output
+// Returns: ErrorCode
+ErrorCode adaptivePidController(double error, ControllerConfig *config, double *controlSignal);
+
+// Generic system update using controller and model callbacks
+// Works with any plant: the plant provides its controller configuration and model callback
+// Parameters:
+//   system: pointer to plant structure (passed to getSetpoint/getOutput and the model)
+//   config: controller configuration of the plant (getSetpoint, getOutput, params, state)
+//   modelCallback: plant model callback (e.g. tank->model.callback)
+//   dt: time step (seconds)
+//   output: pointer to store system output after update
+//   controllerCallback: function pointer to controller algorithm
+//   errorCalcCallback: function pointer to error calculation (optional, uses calculateError if NULL)
+// Returns: ErrorCode
+ErrorCode updateSystem(void *system, ControllerConfig *config, SystemModelCallback modelCallback,
+                  double dt, double *output,
+                  ControllerCallback controllerCallback,
+                  ErrorCalculationCallback errorCalcCallback);
+
+#endif // CONTROLLER_H
@@ -0,0 +1,108 @@
+#include "controller_embedded.h"
+#include <math.h>
+#include <stddef.h>
+
+q16_t q16FromDouble(double value) {
+    double scaled = value * (double)Q16_ONE;
+    if (!(scaled == scaled)) return 0;  // NaN
+    if (scaled >= (double)Q16_MAX) return Q16_MAX;
+    if (scaled <= (double)Q16_MIN) return Q16_MIN;
+    return (q16_t)lround(scaled);
+}
+
+double q16ToDouble(q16_t value) {
+    return (double)value / (double)Q16_ONE;
+}
+
+ErrorCode initControllerParamsF32(ControllerParamsF32 *out, const ControllerParams *params, double dt,
+                                  double accumulatorLimit) {
+    if (out == NULL || params == NULL) return ERROR_NULL_POINTER;
+    if (!(dt > 0.0)) return ERROR_INVALID_PARAMETER;
+
+    out->Kp = (float)params->Kp;
+    out->Ki = (float)params->Ki;
+    out->Kd = (float)params->Kd;
+    out->dt = (float)dt;
+    out->inverse_dt = (float)(1.0 / dt);
+    out->accumulatorLimit = accumulatorLimit > 0.0 ? (float)accumulatorLimit : FLT_MAX;
+    out->schedule = NULL;
+    return ERROR_SUCCESS;
+}
+
+// A value fits Q16.16 if it is inside the range and a non-zero value does not round to 0
+static int fitsQ16(double value) {
+    double magnitude = fabs(value);
+    return magnitude < q16ToDouble(Q16_MAX) && (magnitude == 0.0 || magnitude * Q16_ONE >= 0.5);
+}
+
+ErrorCode initControllerParamsQ16(ControllerParamsQ16 *out, const ControllerParams *params, double dt,
+                                  double accumulatorLimit) {
+    if (out == NULL || params == NULL) return ERROR_NULL_POINTER;
+    if (!(dt > 0.0)) return ERROR_INVALID_PARAMETER;
+    if (!fitsQ16(params->Kp) || !fitsQ16(params->Ki) || !fitsQ16(params->Kd) ||
+        !fitsQ16(dt) || !fitsQ16(1.0 / dt)) {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    out->Kp = q16FromDouble(params->Kp);
+    out->Ki = q16FromDouble(params->Ki);
+    out->Kd = q16FromDouble(params->Kd);
+    out->dt = q16FromDouble(dt);
+    out->inverse_dt = q16FromDouble(1.0 / dt);
+    out->accumulatorLimit = accumulatorLimit > 0.0 ? q16FromDouble(accumulatorLimit) : Q16_MAX;
+    out->schedule = NULL;
+    return ERROR_SUCCESS;
+}
+
+static void convertGainBandsF32(GainBandsF32 *out, const GainBands *bands) {
+    for (int k = 0; k < GAIN_SCHEDULE_MAX_EDGES; k++) out->edge[k] = (float)bands->edge[k];
+    for (int k = 0; k <= GAIN_SCHEDULE_MAX_EDGES; k++) out->factor[k] = (float)bands->factor[k];
+}
+
+ErrorCode initGainScheduleF32(GainScheduleF32 *out, const GainSchedule *schedule) {
+    if (out == NULL || schedule == NULL) return ERROR_NULL_POINTER;
+    convertGainBandsF32(&out->error, &schedule->error);
+    convertGainBandsF32(&out->cumulative, &schedule->cumulative);
+    convertGainBandsF32(&out->rate, &schedule->rate);
+    out->trendMinRate = (float)schedule->trendMinRate;
+    out->trendMaxRate = (float)schedule->trendMaxRate;
+    out->trendBoost = (float)schedule->trendBoost;
+    return ERROR_SUCCESS;
+}
+
+// Edges saturate (an unused +inf edge becomes Q16_MAX); factors must fit
+static int convertGainBandsQ16(GainBandsQ16 *out, const GainBands *bands) {
+    for (int k = 0; k < GAIN_SCHEDULE_MAX_EDGES; k++) out->edge[k] = q16FromDouble(bands->edge[k]);
+    for (int k = 0; k <= GAIN_SCHEDULE_MAX_EDGES; k++) {
+        if (!fitsQ16(bands->factor[k])) return 0;
+        out->factor[k] = q16FromDouble(bands->factor[k]);
+    }
+    return 1;
+}
+
+ErrorCode initGainScheduleQ16(GainScheduleQ16 *out, const GainSchedule *schedule) {
+    if (out == NULL || schedule == NULL) return ERROR_NULL_POINTER;
+    if (!convertGainBandsQ16(&out->error, &schedule->error) ||
+        !convertGainBandsQ16(&out->cumulative, &schedule->cumulative) ||
+        !convertGainBandsQ16(&out->rate, &schedule->rate) || !fitsQ16(schedule->trendBoost)) {
+        return ERROR_INVALID_PARAMETER;
+    }
+    out->trendMinRate = q16FromDouble(schedule->trendMinRate);
+    out->trendMaxRate = q16FromDouble(schedule->trendMaxRate);
+    out->trendBoost = q16FromDouble(schedule->trendBoost);
+    return ERROR_SUCCESS;
+}
+
+void resetControllerStateF32(ControllerStateF32 *state) {
+    if (state == NULL) return;
+    state->integral = 0.0f;
+    state->previousError = 0.0f;
+    state->cumulativeError = 0.0f;
+}
+
+void resetControllerStateQ16(ControllerStateQ16 *state) {
+    if (state == NULL) return;
+    state->integral = 0;
+    state->previousError = 0;
+    state->cumulativeError = 0;
+}
@@ -0,0 +1,426 @@
+#ifndef CONTROLLER_EMBEDDED_H
+#define CONTROLLER_EMBEDDED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <float.h>
+#include "controller.h"
+
+// Firmware builds of the control laws (TM4C129: Cortex-M4F, single-precision FPU only)
+// The simulation keeps the double laws of controller_kernels.h; these are the same laws in
+// float32 and in Q16.16 fixed point, for targets where double is software-emulated.
+// Differences to the double laws, all chosen for the MCU:
+// - dt and 1/dt are prepared once (initControllerParamsF32/Q16), so no law divides
+// - integral and cumulativeError saturate at accumulatorLimit (anti-windup, and in Q16
+//   every sum, product and the output saturate instead of wrapping around)
+// - the adaptive laws read their gain schedule from float32/Q16.16 tables: the built-in ones
+//   are built from the same values as the double tables (controller.h), and a retuned
+//   GainSchedule (gainschedule.h) is converted with initGainScheduleF32/Q16 and passed in
+//   through the prepared gains, so the firmware follows the schedule the host runs
+// Desktop equivalence against the double laws: the "equivalence" group of the bench executables.
+//
+// The firmware picks one type at compile time: float32 by default, Q16.16 with
+// -DCONTROLLER_NUMERIC_Q16 (control_t, EmbeddedControllerParams, ... at the end of this file).
+
+// ===== Q16.16 fixed point =====
+
+typedef int32_t q16_t;                 // Signed 16.16 fixed point
+#define Q16_ONE 65536
+#define Q16_MAX INT32_MAX              // ~32768.0
+#define Q16_MIN (-INT32_MAX)           // Symmetric, so negation and abs never overflow
+
+// Compile-time conversion of a constant (rounded to nearest)
+#define Q16_CONST(x) ((q16_t)((x) * 65536.0 + ((x) >= 0 ? 0.5 : -0.5)))
+
+static inline q16_t q16Saturate(int64_t value) {
+    return value > Q16_MAX ? Q16_MAX : (value < Q16_MIN ? Q16_MIN : (q16_t)value);
+}
+
+static inline q16_t q16Add(q16_t a, q16_t b) {
+    return q16Saturate((int64_t)a + b);
+}
+
+static inline q16_t q16Sub(q16_t a, q16_t b) {
+    return q16Saturate((int64_t)a - b);
+}
+
+// Product rounded to nearest (arithmetic right shift, as on every supported compiler)
+static inline q16_t q16Mul(q16_t a, q16_t b) {
+    return q16Saturate(((int64_t)a * b + (Q16_ONE / 2)) >> 16);
+}
+
+static inline q16_t q16Abs(q16_t a) {
+    return a < 0 ? -a : a;
+}
+
+static inline q16_t q16Clamp(q16_t value, q16_t limit) {
+    return value > limit ? limit : (value < -limit ? -limit : value);
+}
+
+// Conversion from/to double (saturating, rounded to nearest)
+q16_t q16FromDouble(double value);
+double q16ToDouble(q16_t value);
+
+// ===== Gain schedules =====
+// Same layout and lookup as GainBands/GainSchedule (controller.h); unused edges are +inf
+// (float32) or Q16_MAX (Q16.16), so no value exceeds them
+
+typedef struct {
+    float edge[GAIN_SCHEDULE_MAX_EDGES];
+    float factor[GAIN_SCHEDULE_MAX_EDGES + 1];
+} GainBandsF32;
+
+typedef struct {
+    GainBandsF32 error;
+    GainBandsF32 cumulative;
+    GainBandsF32 rate;
+    float trendMinRate;
+    float trendMaxRate;
+    float trendBoost;
+} GainScheduleF32;
+
+typedef struct {
+    q16_t edge[GAIN_SCHEDULE_MAX_EDGES];
+    q16_t factor[GAIN_SCHEDULE_MAX_EDGES + 1];
+} GainBandsQ16;
+
+typedef struct {
+    GainBandsQ16 error;
+    GainBandsQ16 cumulative;
+    GainBandsQ16 rate;
+    q16_t trendMinRate;
+    q16_t trendMaxRate;
+    q16_t trendBoost;
+} GainScheduleQ16;
+
+// Built-in tables of the adaptive laws (P and PD: adaptivePGainSchedule/adaptivePdGainSchedule,
+// PI and PID: adaptivePi/PidGainSchedule)
+#define GAIN_SCHEDULE_F32(x) ((float)(x))
+static const GainScheduleF32 ADAPTIVE_P_GAIN_SCHEDULE_F32 = ADAPTIVE_PD_GAIN_SCHEDULE(GAIN_SCHEDULE_F32, INFINITY);
+static const GainScheduleF32 ADAPTIVE_PD_GAIN_SCHEDULE_F32 = ADAPTIVE_PD_GAIN_SCHEDULE(GAIN_SCHEDULE_F32, INFINITY);
+static const GainScheduleF32 ADAPTIVE_PI_GAIN_SCHEDULE_F32 = ADAPTIVE_PI_GAIN_SCHEDULE(GAIN_SCHEDULE_F32, INFINITY);
+static const GainScheduleQ16 ADAPTIVE_P_GAIN_SCHEDULE_Q16 = ADAPTIVE_PD_GAIN_SCHEDULE(Q16_CONST, Q16_MAX);
+static const GainScheduleQ16 ADAPTIVE_PD_GAIN_SCHEDULE_Q16 = ADAPTIVE_PD_GAIN_SCHEDULE(Q16_CONST, Q16_MAX);
+static const GainScheduleQ16 ADAPTIVE_PI_GAIN_SCHEDULE_Q16 = ADAPTIVE_PI_GAIN_SCHEDULE(Q16_CONST, Q16_MAX);
+
+// Convert a double gain schedule (e.g. loaded by loadGainScheduleSet) for the float32 laws
+// Parameters:
+//   out: table to fill
+//   schedule: double schedule
+// Returns: ERROR_SUCCESS or ERROR_NULL_POINTER
+ErrorCode initGainScheduleF32(GainScheduleF32 *out, const GainSchedule *schedule);
+
+// Convert a double gain schedule for the Q16.16 laws (edges and trend rates saturate to the
+// Q16.16 range, unused edges become Q16_MAX)
+// Parameters: as initGainScheduleF32
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (a factor or the
+//          trend boost does not fit Q16.16 / rounds to 0)
+ErrorCode initGainScheduleQ16(GainScheduleQ16 *out, const GainSchedule *schedule);
+
+// ===== Gains and state =====
+
+// Gains with the time step prepared (float32)
+typedef struct {
+    float Kp;
+    float Ki;
+    float Kd;
+    float dt;                // Controller period (seconds)
+    float inverse_dt;        // 1 / dt
+    float accumulatorLimit;  // Saturation of integral and cumulativeError
+    const GainScheduleF32 *schedule;  // Adaptive laws: gain schedule (NULL: the law's built-in table)
+} ControllerParamsF32;
+
+typedef struct {
+    float integral;
+    float previousError;
+    float cumulativeError;
+} ControllerStateF32;
+
+// Gains with the time step prepared (Q16.16)
+typedef struct {
+    q16_t Kp;
+    q16_t Ki;
+    q16_t Kd;
+    q16_t dt;
+    q16_t inverse_dt;
+    q16_t accumulatorLimit;
+    const GainScheduleQ16 *schedule;  // Adaptive laws: gain schedule (NULL: the law's built-in table)
+} ControllerParamsQ16;
+
+typedef struct {
+    q16_t integral;
+    q16_t previousError;
+    q16_t cumulativeError;
+} ControllerStateQ16;
+
+// Convert double gains for the float32 laws (schedule: NULL, set it to pass a retuned table)
+// Parameters:
+//   out: gains to fill
+//   params: double gains (Kp, Ki, Kd)
+//   dt: controller period (seconds, > 0)
+//   accumulatorLimit: saturation of integral and cumulativeError (<= 0: FLT_MAX)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (dt <= 0)
+ErrorCode initControllerParamsF32(ControllerParamsF32 *out, const ControllerParams *params, double dt,
+                                  double accumulatorLimit);
+
+// Convert double gains for the Q16.16 laws
+// Parameters: as initControllerParamsF32 (accumulatorLimit <= 0: Q16 range)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER
+//          (dt <= 0, or a gain, dt or 1/dt that does not fit Q16.16 / rounds to 0)
+ErrorCode initControllerParamsQ16(ControllerParamsQ16 *out, const ControllerParams *params, double dt,
+                                  double accumulatorLimit);
+
+// Zero a controller state
+void resetControllerStateF32(ControllerStateF32 *state);
+void resetControllerStateQ16(ControllerStateQ16 *state);
+
+// ===== float32 laws =====
+// Same structure as the double laws in controller_kernels.h
+// Parameters (all laws):
+//   error: control error
+//   params: prepared gains
+//   state: controller state
+// Returns: control signal
+
+static inline float controlClampF32(float value, float limit) {
+    return value > limit ? limit : (value < -limit ? -limit : value);
+}
+
+// Factor of the band a value falls in (branchless binary search, as gainBandFactor)
+static inline float gainBandFactorF32(const GainBandsF32 *bands, float value) {
+    const float *edge = bands->edge;
+    int above = (value > edge[3]) << 2;
+    above += (value > edge[above + 1]) << 1;
+    above += value > edge[above];
+    return bands->factor[above];
+}
+
+// Adaptive proportional gain shared by the adaptive P/PD/PI/PID laws: Kp times the error,
+// cumulative-error, trend and rate factors of the schedule (applied in this order)
+static inline float adaptiveGainF32(const GainScheduleF32 *schedule, float baseKp, float absError,
+                                    float errorRate, float cumulativeError) {
+    float absErrorRate = errorRate > 0.0f ? errorRate : -errorRate;
+    float gain = baseKp * gainBandFactorF32(&schedule->error, absError);
+    gain *= gainBandFactorF32(&schedule->cumulative, cumulativeError);
+    if (errorRate < 0.0f && absErrorRate > schedule->trendMinRate && absErrorRate < schedule->trendMaxRate) {
+        gain *= schedule->trendBoost;
+    }
+    gain *= gainBandFactorF32(&schedule->rate, absErrorRate);
+    return gain;
+}
+
+static inline float pControlLawF32(float error, const ControllerParamsF32 *params, ControllerStateF32 *state) {
+    (void)state;  // Stateless
+    return params->Kp * error;
+}
+
+static inline float piControlLawF32(float error, const ControllerParamsF32 *params, ControllerStateF32 *state) {
+    state->integral = controlClampF32(state->integral + error * params->dt, params->accumulatorLimit);
+    return params->Kp * error + params->Ki * state->integral;
+}
+
+static inline float pdControlLawF32(float error, const ControllerParamsF32 *params, ControllerStateF32 *state) {
+    float derivative = (error - state->previousError) * params->inverse_dt;
+    state->previousError = error;
+    return params->Kp * error + params->Kd * derivative;
+}
+
+static inline float pidControlLawF32(float error, const ControllerParamsF32 *params, ControllerStateF32 *state) {
+    state->integral = controlClampF32(state->integral + error * params->dt, params->accumulatorLimit);
+    float derivative = (error - state->previousError) * params->inverse_dt;
+    state->previousError = error;
+    return params->Kp * error + params->Ki * state->integral + params->Kd * derivative;
+}
+
+// Decayed cumulative error of the adaptive laws (saturating)
+static inline float updateCumulativeErrorF32(float absError, const ControllerParamsF32 *params,
+                                             ControllerStateF32 *state) {
+    state->cumulativeError = controlClampF32(state->cumulativeError * 0.98f + absError * params->dt,
+                                             params->accumulatorLimit);
+    return state->cumulativeError;
+}
+
+static inline float adaptivePControlLawF32(float error, const ControllerParamsF32 *params,
+                                           ControllerStateF32 *state) {
+    float errorRate = (error - state->previousError) * params->inverse_dt;
+    float absError = error > 0.0f ? error : -error;
+    float cumulative = updateCumulativeErrorF32(absError, params, state);
+    float gain = adaptiveGainF32(params->schedule != NULL ? params->schedule : &ADAPTIVE_P_GAIN_SCHEDULE_F32,
+                                 params->Kp, absError, errorRate, cumulative);
+    state->previousError = error;
+    return gain * error;
+}
+
+static inline float adaptivePdControlLawF32(float error, const ControllerParamsF32 *params,
+                                            ControllerStateF32 *state) {
+    float derivative = (error - state->previousError) * params->inverse_dt;
+    float absError = error > 0.0f ? error : -error;
+    float cumulative = updateCumulativeErrorF32(absError, params, state);
+    float gain = adaptiveGainF32(params->schedule != NULL ? params->schedule : &ADAPTIVE_PD_GAIN_SCHEDULE_F32,
+                                 params->Kp, absError, derivative, cumulative);
+    state->previousError = error;
+    return gain * error + params->Kd * derivative;
+}
+
+static inline float adaptivePiControlLawF32(float error, const ControllerParamsF32 *params,
+                                            ControllerStateF32 *state) {
+    state->integral = controlClampF32(state->integral + error * params->dt, params->accumulatorLimit);
+    float errorRate = (error - state->previousError) * params->inverse_dt;
+    float absError = error > 0.0f ? error : -error;
+    float cumulative = updateCumulativeErrorF32(absError, params, state);
+    float gain = adaptiveGainF32(params->schedule != NULL ? params->schedule : &ADAPTIVE_PI_GAIN_SCHEDULE_F32,
+                                 params->Kp, absError, errorRate, cumulative);
+    state->previousError = error;
+    return gain * error + params->Ki * state->integral;
+}
+
+static inline float adaptivePidControlLawF32(float error, const ControllerParamsF32 *params,
+                                             ControllerStateF32 *state) {
+    state->integral = controlClampF32(state->integral + error * params->dt, params->accumulatorLimit);
+    float derivative = (error - state->previousError) * params->inverse_dt;
+    float absError = error > 0.0f ? error : -error;
+    float cumulative = updateCumulativeErrorF32(absError, params, state);
+    float gain = adaptiveGainF32(params->schedule != NULL ? params->schedule : &ADAPTIVE_PI_GAIN_SCHEDULE_F32,
+                                 params->Kp, absError, derivative, cumulative);
+    state->previousError = error;
+    return gain * error + params->Ki * state->integral + params->Kd * derivative;
+}
+
+// ===== Q16.16 laws =====
+// Same structure as the float32 laws; every operation saturates
+
+static inline q16_t gainBandFactorQ16(const GainBandsQ16 *bands, q16_t value) {
+    const q16_t *edge = bands->edge;
+    int above = (value > edge[3]) << 2;
+    above += (value > edge[above + 1]) << 1;
+    above += value > edge[above];
+    return bands->factor[above];
+}
+
+static inline q16_t adaptiveGainQ16(const GainScheduleQ16 *schedule, q16_t baseKp, q16_t absError,
+                                    q16_t errorRate, q16_t cumulativeError) {
+    q16_t absErrorRate = q16Abs(errorRate);
+    q16_t gain = q16Mul(baseKp, gainBandFactorQ16(&schedule->error, absError));
+    gain = q16Mul(gain, gainBandFactorQ16(&schedule->cumulative, cumulativeError));
+    if (errorRate < 0 && absErrorRate > schedule->trendMinRate && absErrorRate < schedule->trendMaxRate) {
+        gain = q16Mul(gain, schedule->trendBoost);
+    }
+    gain = q16Mul(gain, gainBandFactorQ16(&schedule->rate, absErrorRate));
+    return gain;
+}
+
+static inline q16_t pControlLawQ16(q16_t error, const ControllerParamsQ16 *params, ControllerStateQ16 *state) {
+    (void)state;  // Stateless
+    return q16Mul(params->Kp, error);
+}
+
+static inline q16_t piControlLawQ16(q16_t error, const ControllerParamsQ16 *params, ControllerStateQ16 *state) {
+    state->integral = q16Clamp(q16Add(state->integral, q16Mul(error, params->dt)), params->accumulatorLimit);
+    return q16Add(q16Mul(params->Kp, error), q16Mul(params->Ki, state->integral));
+}
+
+static inline q16_t pdControlLawQ16(q16_t error, const ControllerParamsQ16 *params, ControllerStateQ16 *state) {
+    q16_t derivative = q16Mul(q16Sub(error, state->previousError), params->inverse_dt);
+    state->previousError = error;
+    return q16Add(q16Mul(params->Kp, error), q16Mul(params->Kd, derivative));
+}
+
+static inline q16_t pidControlLawQ16(q16_t error, const ControllerParamsQ16 *params, ControllerStateQ16 *state) {
+    state->integral = q16Clamp(q16Add(state->integral, q16Mul(error, params->dt)), params->accumulatorLimit);
+    q16_t derivative = q16Mul(q16Sub(error, state->previousError), params->inverse_dt);
+    state->previousError = error;
+    return q16Add(q16Add(q16Mul(params->Kp, error), q16Mul(params->Ki, state->integral)),
+                  q16Mul(params->Kd, derivative));
+}
+
+static inline q16_t updateCumulativeErrorQ16(q16_t absError, const ControllerParamsQ16 *params,
+                                             ControllerStateQ16 *state) {
+    q16_t decayed = q16Mul(state->cumulativeError, Q16_CONST(0.98));
+    state->cumulativeError = q16Clamp(q16Add(decayed, q16Mul(absError, params->dt)), params->accumulatorLimit);
+    return state->cumulativeError;
+}
+
+static inline q16_t adaptivePControlLawQ16(q16_t error, const ControllerParamsQ16 *params,
+                                           ControllerStateQ16 *state) {
+    q16_t errorRate = q16Mul(q16Sub(error, state->previousError), params->inverse_dt);
+    q16_t absError = q16Abs(error);
+    q16_t cumulative = updateCumulativeErrorQ16(absError, params, state);
+    q16_t gain = adaptiveGainQ16(params->schedule != NULL ? params->schedule : &ADAPTIVE_P_GAIN_SCHEDULE_Q16,
+                                 params->Kp, absError, errorRate, cumulative);
+    state->previousError = error;
+    return q16Mul(gain, error);
+}
+
+static inline q16_t adaptivePdControlLawQ16(q16_t error, const ControllerParamsQ16 *params,
+                                            ControllerStateQ16 *state) {
+    q16_t derivative = q16Mul(q16Sub(error, state->previousError), params->inverse_dt);
+    q16_t absError = q16Abs(error);
+    q16_t cumulative = updateCumulativeErrorQ16(absError, params, state);
+    q16_t gain = adaptiveGainQ16(params->schedule != NULL ? params->schedule : &ADAPTIVE_PD_GAIN_SCHEDULE_Q16,
+                                 params->Kp, absError, derivative, cumulative);
+    state->previousError = error;
+    return q16Add(q16Mul(gain, error), q16Mul(params->Kd, derivative));
+}
+
+static inline q16_t adaptivePiControlLawQ16(q16_t error, const ControllerParamsQ16 *params,
+                                            ControllerStateQ16 *state) {
+    state->integral = q16Clamp(q16Add(state->integral, q16Mul(error, params->dt)), params->accumulatorLimit);
+    q16_t errorRate = q16Mul(q16Sub(error, state->previousError), params->inverse_dt);
+    q16_t absError = q16Abs(error);
+    q16_t cumulative = updateCumulativeErrorQ16(absError, params, state);
+    q16_t gain = adaptiveGainQ16(params->schedule != NULL ? params->schedule : &ADAPTIVE_PI_GAIN_SCHEDULE_Q16,
+                                 params->Kp, absError, errorRate, cumulative);
+    state->previousError = error;
+    return q16Add(q16Mul(gain, error), q16Mul(params->Ki, state->integral));
+}
+
+static inline q16_t adaptivePidControlLawQ16(q16_t error, const ControllerParamsQ16 *params,
+                                             ControllerStateQ16 *state) {
+    state->integral = q16Clamp(q16Add(state->integral, q16Mul(error, params->dt)), params->accumulatorLimit);
+    q16_t derivative = q16Mul(q16Sub(error, state->previousError), params->inverse_dt);
+    q16_t absError = q16Abs(error);
+    q16_t cumulative = updateCumulativeErrorQ16(absError, params, state);
+    q16_t gain = adaptiveGainQ16(params->schedule != NULL ? params->schedule : &ADAPTIVE_PI_GAIN_SCHEDULE_Q16,
+                                 params->Kp, absError, derivative, cumulative);
+    state->previousError = error;
+    return q16Add(q16Add(q16Mul(gain, error), q16Mul(params->Ki, state->integral)),
+                  q16Mul(params->Kd, derivative));
+}
+
+// X-macro list pairing every double ControllerCallback with its embedded laws
+// Usage: #define X(callback, f32Law, q16Law) ... then EMBEDDED_CONTROLLER_LAW_LIST(X)
+#define EMBEDDED_CONTROLLER_LAW_LIST(X)                                         \
+    X(pController,           pControlLawF32,           pControlLawQ16)           \
+    X(piController,          piControlLawF32,          piControlLawQ16)          \
+    X(pdController,          pdControlLawF32,          pdControlLawQ16)          \
+    X(pidController,         pidControlLawF32,         pidControlLawQ16)         \
+    X(adaptivePController,   adaptivePControlLawF32,   adaptivePControlLawQ16)   \
+    X(adaptivePdController,  adaptivePdControlLawF32,  adaptivePdControlLawQ16)  \
+    X(adaptivePiController,  adaptivePiControlLawF32,  adaptivePiControlLawQ16)  \
+    X(adaptivePidController, adaptivePidControlLawF32, adaptivePidControlLawQ16)
+
+// ===== Firmware numeric type =====
+
+#ifdef CONTROLLER_NUMERIC_Q16
+typedef q16_t control_t;
+typedef ControllerParamsQ16 EmbeddedControllerParams;
+typedef ControllerStateQ16 EmbeddedControllerState;
+#define controlFromDouble(value) q16FromDouble(value)
+#define controlToDouble(value) q16ToDouble(value)
+#define initEmbeddedControllerParams initControllerParamsQ16
+#define resetEmbeddedControllerState resetControllerStateQ16
+#define embeddedPidControlLaw pidControlLawQ16
+#define embeddedAdaptivePidControlLaw adaptivePidControlLawQ16
+#else
+typedef float control_t;
+typedef ControllerParamsF32 EmbeddedControllerParams;
+typedef ControllerStateF32 EmbeddedControllerState;
+#define controlFromDouble(value) ((float)(value))
+#define controlToDouble(value) ((double)(value))
+#define initEmbeddedControllerParams initControllerParamsF32
+#define resetEmbeddedControllerState resetControllerStateF32
+#define embeddedPidControlLaw pidControlLawF32
+#define embeddedAdaptivePidControlLaw adaptivePidControlLawF32
+#endif
+
+#endif // CONTROLLER_EMBEDDED_H
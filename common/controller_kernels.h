@@ -0,0 +1,254 @@
+#ifndef CONTROLLER_KERNELS_H
+#define CONTROLLER_KERNELS_H
+
+#include <math.h>
+#include <stddef.h>
+#include "controller.h"
+
+// Inline control laws behind the ControllerCallback functions in controller.c
+// Each law takes its gains, state and time step directly and performs no NULL checks:
+// the callbacks validate their arguments and then call the law, while specialized
+// steppers (e.g. watertank_stepper.c) validate once at setup and call the laws from
+// their inner loop, where the compiler can inline them.
+// Parameters (all laws):
+//   error: control error
+//   params: controller gains (Kp, Ki, Kd)
+//   state: controller state (integral, previousError, adaptive terms)
+//   dt: controller time step (seconds)
+//   schedule: gain schedule of the adaptive laws (NULL: the law's built-in table, others ignore it)
+// Returns: control signal
+
+// Factor of the band a value falls in: a branchless binary search over the 7 edge slots
+// (each compare picks the half to look at next) gives the number of edges the value
+// exceeds, which indexes the factor table; NaN exceeds no edge
+static inline double gainBandFactor(const GainBands *bands, double value) {
+    const double *edge = bands->edge;
+    int above = (value > edge[3]) << 2;
+    above += (value > edge[above + 1]) << 1;
+    above += value > edge[above];
+    return bands->factor[above];
+}
+
+// Adaptive proportional gain: Kp times the error, cumulative-error, trend and rate factors
+// (applied in this order). The trend boost is selected, not branched on.
+static inline double scheduleAdaptiveGain(const GainSchedule *schedule, double baseKp, double absError,
+                                          double errorRate, double cumulativeError) {
+    double absErrorRate = fabs(errorRate);
+    int trending = (errorRate < 0) & (absErrorRate > schedule->trendMinRate) & (absErrorRate < schedule->trendMaxRate);
+    const double trendFactor[2] = { 1.0, schedule->trendBoost };
+    double gain = baseKp * gainBandFactor(&schedule->error, absError);
+    gain *= gainBandFactor(&schedule->cumulative, cumulativeError);
+    gain *= trendFactor[trending];
+    gain *= gainBandFactor(&schedule->rate, absErrorRate);
+    return gain;
+}
+
+// Simple Proportional controller (non-adaptive)
+static inline double pControlLaw(double error, const ControllerParams *params,
+                                 ControllerState *state, double dt,
+                                 const GainSchedule *schedule) {
+    (void)state;  // Stateless
+    (void)dt;
+    (void)schedule;
+    
+    // Apply proportional control: control signal = Kp * error
+    return params->Kp * error;
+}
+
+// Adaptive Proportional controller with gain scheduling
+static inline double adaptivePControlLaw(double error, const ControllerParams *params,
+                                         ControllerState *state, double dt,
+                                         const GainSchedule *schedule) {
+    // Calculate error magnitude and rate of change
+    double absError = fabs(error);
+    double errorRate = (error - state->previousError) / dt;
+    
+    // Update cumulative error (with decay to prevent unbounded growth)
+    state->cumulativeError = state->cumulativeError * 0.98 + absError * dt;
+    
+    // Gain scheduling (the built-in table is tuned extremely aggressively: very high gain for
+    // large errors, significant gain near the setpoint to eliminate steady-state error)
+    double adaptiveKp = scheduleAdaptiveGain(schedule != NULL ? schedule : &adaptivePGainSchedule,
+                                             params->Kp, absError, errorRate, state->cumulativeError);
+    
+    // Update previous error for next iteration
+    state->previousError = error;
+    
+    // Apply proportional control with adaptive gain
+    return adaptiveKp * error;
+}
+
+// PI controller
+static inline double piControlLaw(double error, const ControllerParams *params,
+                                  ControllerState *state, double dt,
+                                  const GainSchedule *schedule) {
+    (void)schedule;  // Fixed gains
+    
+    // Update integral term
+    state->integral += error * dt;
+    
+    // Apply PI control: control signal = Kp * error + Ki * integral
+    return params->Kp * error +
+           params->Ki * state->integral;
+}
+
+// PD controller
+static inline double pdControlLaw(double error, const ControllerParams *params,
+                                  ControllerState *state, double dt,
+                                  const GainSchedule *schedule) {
+    (void)schedule;  // Fixed gains
+    
+    // Calculate derivative term
+    double derivative = (error - state->previousError) / dt;
+    
+    // Update previous error
+    state->previousError = error;
+    
+    // Apply PD control: control signal = Kp * error + Kd * derivative
+    return params->Kp * error +
+           params->Kd * derivative;
+}
+
+// PID controller
+static inline double pidControlLaw(double error, const ControllerParams *params,
+                                   ControllerState *state, double dt,
+                                   const GainSchedule *schedule) {
+    (void)schedule;  // Fixed gains
+    
+    // Update integral term
+    state->integral += error * dt;
+    
+    // Calculate derivative term
+    double derivative = (error - state->previousError) / dt;
+    
+    // Update previous error
+    state->previousError = error;
+    
+    // Apply PID control: control signal = Kp * error + Ki * integral + Kd * derivative
+    return params->Kp * error +
+           params->Ki * state->integral +
+           params->Kd * derivative;
+}
+
+// PID controller with forward-mode gain sensitivities
+// Returns exactly what pidControlLaw returns and also differentiates the step: given
+// dError[g] = d(error)/d(gain g), it stores dControl[g] = d(control signal)/d(gain g) and
+// advances the state derivatives. For u = Kp*e + Ki*I + Kd*D with I += e*dt, D = (e - e_prev)/dt:
+//   du/dθ = [e, I, D]·(θ is Kp, Ki, Kd) + Kp*de/dθ + Ki*dI/dθ + Kd*dD/dθ
+// Parameters (besides those of pidControlLaw):
+//   sensitivity: derivatives of the controller state (updated)
+//   dError: derivatives of the error (GAIN_COUNT entries)
+//   dControl: receives the derivatives of the control signal (GAIN_COUNT entries)
+static inline double pidSensitivityLaw(double error, const ControllerParams *params,
+                                       ControllerState *state, double dt,
+                                       ControllerSensitivity *sensitivity,
+                                       const double *dError, double *dControl) {
+    double integral = state->integral + error * dt;
+    double derivative = (error - state->previousError) / dt;
+    double direct[GAIN_COUNT] = { error, integral, derivative };  // ∂u/∂θ at fixed state
+
+    for (int g = 0; g < GAIN_COUNT; g++) {
+        sensitivity->integral[g] += dError[g] * dt;
+        double dDerivative = (dError[g] - sensitivity->previousError[g]) / dt;
+        sensitivity->previousError[g] = dError[g];
+        dControl[g] = direct[g] +
+                      params->Kp * dError[g] +
+                      params->Ki * sensitivity->integral[g] +
+                      params->Kd * dDerivative;
+    }
+
+    // Primal step through the regular law so the trajectory matches pidController bit for bit
+    return pidControlLaw(error, params, state, dt, NULL);
+}
+
+// Adaptive PD controller with gain scheduling
+static inline double adaptivePdControlLaw(double error, const ControllerParams *params,
+                                          ControllerState *state, double dt,
+                                          const GainSchedule *schedule) {
+    // Calculate derivative term
+    double derivative = (error - state->previousError) / dt;
+    
+    // Calculate error magnitude for adaptive tuning
+    double absError = fabs(error);
+    
+    // Update cumulative error (with decay to prevent unbounded growth)
+    state->cumulativeError = state->cumulativeError * 0.98 + absError * dt;
+    
+    // Gain scheduling (the derivative is the error rate)
+    double adaptiveKp = scheduleAdaptiveGain(schedule != NULL ? schedule : &adaptivePdGainSchedule,
+                                             params->Kp, absError, derivative, state->cumulativeError);
+    
+    // Update previous error
+    state->previousError = error;
+    
+    // Apply PD control with adaptive proportional gain
+    return adaptiveKp * error + params->Kd * derivative;
+}
+
+// Adaptive PI controller with gain scheduling
+static inline double adaptivePiControlLaw(double error, const ControllerParams *params,
+                                          ControllerState *state, double dt,
+                                          const GainSchedule *schedule) {
+    // Update integral term
+    state->integral += error * dt;
+    
+    // Calculate error magnitude and rate for adaptive tuning
+    double absError = fabs(error);
+    double errorRate = (error - state->previousError) / dt;
+    
+    // Update cumulative error (with decay to prevent unbounded growth)
+    state->cumulativeError = state->cumulativeError * 0.98 + absError * dt;
+    
+    // Gain scheduling
+    double adaptiveKp = scheduleAdaptiveGain(schedule != NULL ? schedule : &adaptivePiGainSchedule,
+                                             params->Kp, absError, errorRate, state->cumulativeError);
+    
+    // Update previous error
+    state->previousError = error;
+    
+    // Apply PI control with adaptive proportional gain
+    return adaptiveKp * error + params->Ki * state->integral;
+}
+
+// Adaptive PID controller with gain scheduling
+static inline double adaptivePidControlLaw(double error, const ControllerParams *params,
+                                           ControllerState *state, double dt,
+                                           const GainSchedule *schedule) {
+    // Update integral term
+    state->integral += error * dt;
+    
+    // Calculate derivative term
+    double derivative = (error - state->previousError) / dt;
+    
+    // Calculate error magnitude for adaptive tuning
+    double absError = fabs(error);
+    
+    // Update cumulative error (with decay to prevent unbounded growth)
+    state->cumulativeError = state->cumulativeError * 0.98 + absError * dt;
+    
+    // Gain scheduling (the derivative is the error rate)
+    double adaptiveKp = scheduleAdaptiveGain(schedule != NULL ? schedule : &adaptivePidGainSchedule,
+                                             params->Kp, absError, derivative, state->cumulativeError);
+    
+    // Update previous error
+    state->previousError = error;
+    
+    // Apply PID control with adaptive proportional gain
+    return adaptiveKp * error +
+           params->Ki * state->integral +
+           params->Kd * derivative;
+}
+
+// X-macro list pairing every ControllerCallback with its inline control law
+// Usage: #define X(callback, law) ... then CONTROLLER_LAW_LIST(X)
+#define CONTROLLER_LAW_LIST(X)                      \
+    X(pController,           pControlLaw)           \
+    X(adaptivePController,   adaptivePControlLaw)   \
+    X(piController,          piControlLaw)          \
+    X(pdController,          pdControlLaw)          \
+    X(pidController,         pidControlLaw)         \
+    X(adaptivePdController,  adaptivePdControlLaw)  \
+    X(adaptivePiController,  adaptivePiControlLaw)  \
+    X(adaptivePidController, adaptivePidControlLaw)
+
+#endif // CONTROLLER_KERNELS_H
@@ -0,0 +1,12 @@
+#ifndef ERRORCODE_H
+#define ERRORCODE_H
+
+// Error code enumeration for application errors
+typedef enum {
+    ERROR_SUCCESS = 0,           // Operation completed successfully
+    ERROR_NULL_POINTER,          // Null pointer provided
+    ERROR_INVALID_PARAMETER,     // Invalid parameter value
+    ERROR_CALLBACK_FAILED        // Callback function failed
+} ErrorCode;
+
+#endif // ERRORCODE_H
@@ -0,0 +1,157 @@
+#include "gainschedule.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+void initGainScheduleSet(GainScheduleSet *set) {
+    if (set == NULL) return;
+    set->p = adaptivePGainSchedule;
+    set->pd = adaptivePdGainSchedule;
+    set->pi = adaptivePiGainSchedule;
+    set->pid = adaptivePidGainSchedule;
+}
+
+const GainSchedule *selectGainSchedule(const GainScheduleSet *set, ControllerCallback controller) {
+    if (set == NULL) return NULL;
+    if (controller == adaptivePController) return &set->p;
+    if (controller == adaptivePdController) return &set->pd;
+    if (controller == adaptivePiController) return &set->pi;
+    if (controller == adaptivePidController) return &set->pid;
+    return NULL;
+}
+
+// Parse up to `capacity` numbers separated by spaces
+// Returns: number of values, or -1 on a malformed or surplus value
+static int parseScheduleValues(const char *text, double *values, int capacity) {
+    int count = 0;
+    for (;;) {
+        while (isspace((unsigned char)*text)) text++;
+        if (*text == '\0') return count;
+        if (count == capacity) return -1;
+        char *end;
+        values[count] = strtod(text, &end);
+        if (end == text || !(values[count] == values[count])) return -1;
+        count++;
+        text = end;
+    }
+}
+
+// Replace the edges (ascending, finite) or the factors of a band table
+// The factor count is checked against the edge count once the whole file is read.
+static int setScheduleBands(GainBands *bands, int *factorCount, int edges, const double *values, int count) {
+    if (edges) {
+        for (int i = 0; i < count; i++) {
+            if (values[i] >= GAIN_SCHEDULE_UNUSED || values[i] <= -GAIN_SCHEDULE_UNUSED) return 0;
+            if (i > 0 && !(values[i] > values[i - 1])) return 0;
+        }
+        for (int i = 0; i < GAIN_SCHEDULE_MAX_EDGES; i++) {
+            bands->edge[i] = i < count ? values[i] : GAIN_SCHEDULE_UNUSED;
+        }
+    } else {
+        if (count < 1) return 0;
+        // Factors past the last edge repeat the last value (never indexed)
+        for (int i = 0; i <= GAIN_SCHEDULE_MAX_EDGES; i++) {
+            bands->factor[i] = values[i < count ? i : count - 1];
+        }
+        *factorCount = count;
+    }
+    return 1;
+}
+
+static int countScheduleEdges(const GainBands *bands) {
+    int count = 0;
+    while (count < GAIN_SCHEDULE_MAX_EDGES && bands->edge[count] < GAIN_SCHEDULE_UNUSED) count++;
+    return count;
+}
+
+ErrorCode loadGainScheduleSet(const char *path, GainScheduleSet *set, int *errorLine) {
+    if (errorLine != NULL) *errorLine = 0;
+    if (path == NULL || set == NULL) return ERROR_NULL_POINTER;
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return ERROR_CALLBACK_FAILED;
+
+    // Factor counts of every table (edges are counted at the end), seeded from the current set
+    static const char *const controllers[4] = { "p", "pd", "pi", "pid" };
+    GainSchedule *schedules[4] = { &set->p, &set->pd, &set->pi, &set->pid };
+    int factorCount[4][3];
+    for (int c = 0; c < 4; c++) {
+        factorCount[c][0] = countScheduleEdges(&schedules[c]->error) + 1;
+        factorCount[c][1] = countScheduleEdges(&schedules[c]->cumulative) + 1;
+        factorCount[c][2] = countScheduleEdges(&schedules[c]->rate) + 1;
+    }
+
+    char line[GAIN_SCHEDULE_LINE_SIZE];
+    int lineNumber = 0;
+    ErrorCode result = ERROR_SUCCESS;
+    while (result == ERROR_SUCCESS && fgets(line, sizeof(line), file) != NULL) {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        char *key = line;
+        while (isspace((unsigned char)*key)) key++;
+        if (*key == '\0') continue;
+
+        // "<controller>.<table> = values"
+        char *equals = strchr(key, '=');
+        char *dot = strchr(key, '.');
+        if (equals == NULL || dot == NULL || dot > equals) {
+            result = ERROR_INVALID_PARAMETER;
+            break;
+        }
+        char *keyEnd = equals;
+        while (keyEnd > dot && isspace((unsigned char)keyEnd[-1])) keyEnd--;
+        *dot = '\0';
+        *keyEnd = '\0';
+        const char *table = dot + 1;
+
+        int c = 0;
+        while (c < 4 && strcmp(key, controllers[c]) != 0) c++;
+        double values[GAIN_SCHEDULE_MAX_EDGES + 1];
+        int count = parseScheduleValues(equals + 1, values, GAIN_SCHEDULE_MAX_EDGES + 1);
+        if (c == 4 || count < 0) {
+            result = ERROR_INVALID_PARAMETER;
+            break;
+        }
+
+        GainSchedule *schedule = schedules[c];
+        int ok;
+        if (strcmp(table, "error_edges") == 0) {
+            ok = count <= GAIN_SCHEDULE_MAX_EDGES && setScheduleBands(&schedule->error, NULL, 1, values, count);
+        } else if (strcmp(table, "error_factors") == 0) {
+            ok = setScheduleBands(&schedule->error, &factorCount[c][0], 0, values, count);
+        } else if (strcmp(table, "cumulative_edges") == 0) {
+            ok = count <= GAIN_SCHEDULE_MAX_EDGES && setScheduleBands(&schedule->cumulative, NULL, 1, values, count);
+        } else if (strcmp(table, "cumulative_factors") == 0) {
+            ok = setScheduleBands(&schedule->cumulative, &factorCount[c][1], 0, values, count);
+        } else if (strcmp(table, "rate_edges") == 0) {
+            ok = count <= GAIN_SCHEDULE_MAX_EDGES && setScheduleBands(&schedule->rate, NULL, 1, values, count);
+        } else if (strcmp(table, "rate_factors") == 0) {
+            ok = setScheduleBands(&schedule->rate, &factorCount[c][2], 0, values, count);
+        } else if (strcmp(table, "trend") == 0) {
+            ok = count == 3 && values[0] >= 0.0 && values[1] > values[0];
+            if (ok) {
+                schedule->trendMinRate = values[0];
+                schedule->trendMaxRate = values[1];
+                schedule->trendBoost = values[2];
+            }
+        } else {
+            ok = 0;
+        }
+        if (!ok) result = ERROR_INVALID_PARAMETER;
+    }
+    fclose(file);
+
+    // Every table needs exactly one factor per band
+    for (int c = 0; result == ERROR_SUCCESS && c < 4; c++) {
+        if (factorCount[c][0] != countScheduleEdges(&schedules[c]->error) + 1 ||
+            factorCount[c][1] != countScheduleEdges(&schedules[c]->cumulative) + 1 ||
+            factorCount[c][2] != countScheduleEdges(&schedules[c]->rate) + 1) {
+            result = ERROR_INVALID_PARAMETER;
+            lineNumber = 0;  // Not tied to one line
+        }
+    }
+    if (result == ERROR_INVALID_PARAMETER && errorLine != NULL) *errorLine = lineNumber;
+    return result;
+}
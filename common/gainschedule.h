@@ -0,0 +1,47 @@
+#ifndef GAINSCHEDULE_H
+#define GAINSCHEDULE_H
+
+#include "controller.h"
+
+// Gain schedules of the adaptive controllers, loadable from a text file
+// One table per line, "<controller>.<table> = <values>", '#' starts a comment:
+//   pid.error_edges        = 0.02 0.05 0.15 0.3 0.6 1.0    # ascending |error| band edges
+//   pid.error_factors      = 0.85 1.0 1.15 1.5 2.0 2.5 3.5 # one more factor than edges
+//   pid.cumulative_edges   = 0.5 2.0 5.0
+//   pid.cumulative_factors = 1.0 1.15 1.3 1.5
+//   pid.rate_edges         = 2.5 4.0
+//   pid.rate_factors       = 1.0 0.70 0.55
+//   pid.trend              = 0.15 1.5 1.35                 # min rate, max rate, boost
+// Controllers: p, pd, pi, pid (adaptivePController ... adaptivePidController). Tables that are
+// not listed keep the built-in values, so a file only needs the entries being retuned.
+
+#define GAIN_SCHEDULE_LINE_SIZE 512
+
+// Schedules of the four adaptive controllers
+typedef struct {
+    GainSchedule p;
+    GainSchedule pd;
+    GainSchedule pi;
+    GainSchedule pid;
+} GainScheduleSet;
+
+// Fill a set with the built-in schedules
+// Parameters:
+//   set: set to initialize
+void initGainScheduleSet(GainScheduleSet *set);
+
+// Override tables of a set from a schedule file
+// Parameters:
+//   path: schedule file
+//   set: initialized set (tables listed in the file are replaced)
+//   errorLine: optional, receives the offending line number on ERROR_INVALID_PARAMETER (else 0)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER, ERROR_CALLBACK_FAILED (file cannot be read) or
+//          ERROR_INVALID_PARAMETER (unknown key, too many edges, edges not ascending,
+//          factor count != edge count + 1; the set may be partially updated)
+ErrorCode loadGainScheduleSet(const char *path, GainScheduleSet *set, int *errorLine);
+
+// Schedule of an adaptive controller callback
+// Returns: the set's schedule, or NULL for controllers without gain scheduling
+const GainSchedule *selectGainSchedule(const GainScheduleSet *set, ControllerCallback controller);
+
+#endif // GAINSCHEDULE_H
@@ -0,0 +1,118 @@
+#include "integrator.h"
+#include <math.h>
+#include <stddef.h>
+
+// Dormand–Prince 5(4) tableau
+static const double A21 = 1.0 / 5.0;
+static const double A31 = 3.0 / 40.0, A32 = 9.0 / 40.0;
+static const double A41 = 44.0 / 45.0, A42 = -56.0 / 15.0, A43 = 32.0 / 9.0;
+static const double A51 = 19372.0 / 6561.0, A52 = -25360.0 / 2187.0, A53 = 64448.0 / 6561.0,
+                    A54 = -212.0 / 729.0;
+static const double A61 = 9017.0 / 3168.0, A62 = -355.0 / 33.0, A63 = 46732.0 / 5247.0, A64 = 49.0 / 176.0,
+                    A65 = -5103.0 / 18656.0;
+// 5th-order weights (also row 7 of the tableau: FSAL)
+static const double B1 = 35.0 / 384.0, B3 = 500.0 / 1113.0, B4 = 125.0 / 192.0, B5 = -2187.0 / 6784.0,
+                    B6 = 11.0 / 84.0;
+// Difference between the 5th- and 4th-order weights (error estimate)
+static const double E1 = 71.0 / 57600.0, E3 = -71.0 / 16695.0, E4 = 71.0 / 1920.0, E5 = -17253.0 / 339200.0,
+                    E6 = 22.0 / 525.0, E7 = -1.0 / 40.0;
+
+// Step size controller: h_new = h * clamp(SAFETY * err^(-1/5), MIN_FACTOR, MAX_FACTOR)
+#define STEP_SAFETY 0.9
+#define STEP_MIN_FACTOR 0.2
+#define STEP_MAX_FACTOR 5.0
+
+void initAdaptiveIntegrator(AdaptiveIntegrator *integrator, double relTol, double absTol) {
+    if (integrator == NULL) return;
+    integrator->relTol = relTol;
+    integrator->absTol = absTol;
+    integrator->maxStep = 0.0;
+    integrator->stepHint = 0.0;
+    integrator->accepted = 0;
+    integrator->rejected = 0;
+    integrator->evaluations = 0;
+}
+
+ErrorCode integrateAdaptive(AdaptiveIntegrator *integrator, StateDerivativeCallback derivative, void *system,
+                            int size, double *state, double duration) {
+    if (integrator == NULL || derivative == NULL || state == NULL) return ERROR_NULL_POINTER;
+    if (size < 1 || size > INTEGRATOR_MAX_STATE || !(duration >= 0.0)) return ERROR_INVALID_PARAMETER;
+    if (duration == 0.0) return ERROR_SUCCESS;
+
+    double relTol = integrator->relTol > 0.0 ? integrator->relTol : INTEGRATOR_DEFAULT_REL_TOL;
+    double absTol = integrator->absTol > 0.0 ? integrator->absTol : INTEGRATOR_DEFAULT_ABS_TOL;
+    double maxStep = integrator->maxStep > 0.0 ? integrator->maxStep : duration;
+    double minStep = duration * 1e-10;
+
+    double k1[INTEGRATOR_MAX_STATE], k2[INTEGRATOR_MAX_STATE], k3[INTEGRATOR_MAX_STATE];
+    double k4[INTEGRATOR_MAX_STATE], k5[INTEGRATOR_MAX_STATE], k6[INTEGRATOR_MAX_STATE];
+    double k7[INTEGRATOR_MAX_STATE], y[INTEGRATOR_MAX_STATE], next[INTEGRATOR_MAX_STATE];
+
+    // The input changed since the last call, so k1 is evaluated fresh (FSAL only within a call)
+    ErrorCode err = derivative(system, state, k1);
+    integrator->evaluations++;
+    if (err != ERROR_SUCCESS) return err;
+
+    double h = integrator->stepHint > 0.0 ? integrator->stepHint : duration;
+    if (h > maxStep) h = maxStep;
+    double t = 0.0;
+    for (int steps = 0; t < duration; steps++) {
+        if (steps >= INTEGRATOR_MAX_STEPS_PER_CALL) return ERROR_CALLBACK_FAILED;
+
+        double remaining = duration - t;
+        int last = h >= remaining;
+        double step = last ? remaining : h;
+
+        for (int i = 0; i < size; i++) y[i] = state[i] + step * A21 * k1[i];
+        if ((err = derivative(system, y, k2)) != ERROR_SUCCESS) return err;
+        for (int i = 0; i < size; i++) y[i] = state[i] + step * (A31 * k1[i] + A32 * k2[i]);
+        if ((err = derivative(system, y, k3)) != ERROR_SUCCESS) return err;
+        for (int i = 0; i < size; i++) y[i] = state[i] + step * (A41 * k1[i] + A42 * k2[i] + A43 * k3[i]);
+        if ((err = derivative(system, y, k4)) != ERROR_SUCCESS) return err;
+        for (int i = 0; i < size; i++) {
+            y[i] = state[i] + step * (A51 * k1[i] + A52 * k2[i] + A53 * k3[i] + A54 * k4[i]);
+        }
+        if ((err = derivative(system, y, k5)) != ERROR_SUCCESS) return err;
+        for (int i = 0; i < size; i++) {
+            y[i] = state[i] + step * (A61 * k1[i] + A62 * k2[i] + A63 * k3[i] + A64 * k4[i] + A65 * k5[i]);
+        }
+        if ((err = derivative(system, y, k6)) != ERROR_SUCCESS) return err;
+        for (int i = 0; i < size; i++) {
+            next[i] = state[i] + step * (B1 * k1[i] + B3 * k3[i] + B4 * k4[i] + B5 * k5[i] + B6 * k6[i]);
+        }
+        if ((err = derivative(system, next, k7)) != ERROR_SUCCESS) return err;
+        integrator->evaluations += 6;
+
+        // RMS of the local error scaled by the mixed tolerance
+        double errorNorm = 0.0;
+        for (int i = 0; i < size; i++) {
+            double e = step * (E1 * k1[i] + E3 * k3[i] + E4 * k4[i] + E5 * k5[i] + E6 * k6[i] + E7 * k7[i]);
+            double scale = absTol + relTol * fmax(fabs(state[i]), fabs(next[i]));
+            errorNorm += (e / scale) * (e / scale);
+        }
+        errorNorm = sqrt(errorNorm / (double)size);
+
+        double factor = errorNorm > 0.0 ? STEP_SAFETY * pow(errorNorm, -0.2) : STEP_MAX_FACTOR;
+        if (factor < STEP_MIN_FACTOR) factor = STEP_MIN_FACTOR;
+        if (factor > STEP_MAX_FACTOR) factor = STEP_MAX_FACTOR;
+
+        if (errorNorm <= 1.0 || step <= minStep) {
+            // Accept (a step at the minimum size is forced through instead of stalling)
+            for (int i = 0; i < size; i++) {
+                state[i] = next[i];
+                k1[i] = k7[i];
+            }
+            t = last ? duration : t + step;
+            integrator->accepted++;
+            // The hint is the controller's proposal, not the step shortened to hit the interval end
+            if (!last || factor < 1.0) h = step * factor;
+        } else {
+            integrator->rejected++;
+            h = step * factor;
+        }
+        if (h > maxStep) h = maxStep;
+        if (h < minStep) h = minStep;
+    }
+    integrator->stepHint = h;
+    return ERROR_SUCCESS;
+}
@@ -0,0 +1,52 @@
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include "errorcode.h"
+
+// Error-controlled adaptive-step ODE integration (Dormand–Prince 5(4), FSAL)
+// Used by the adaptive plant models (tankModelAdaptive, objectModelAdaptive): between two
+// controller ticks the control input is held and the plant state is integrated over the
+// whole tick with as many internal steps as the local error estimate requires, so smooth
+// stretches cost one step per tick and stiff corners get sub-stepped.
+
+#define INTEGRATOR_MAX_STATE 4             // Largest state vector
+#define INTEGRATOR_DEFAULT_REL_TOL 1e-6
+#define INTEGRATOR_DEFAULT_ABS_TOL 1e-6
+#define INTEGRATOR_MAX_STEPS_PER_CALL 10000
+
+// State derivative of an autonomous system (inputs held constant during integrate calls)
+// Parameters:
+//   system: plant passed to integrateAdaptive
+//   state: state vector
+//   derivative: pointer to store d(state)/dt
+// Returns: ErrorCode
+typedef ErrorCode (*StateDerivativeCallback)(void *system, const double *state, double *derivative);
+
+// Step control settings and per-run statistics
+// A zero-initialized integrator uses the default tolerances.
+typedef struct {
+    double relTol;                 // Relative tolerance (<= 0: INTEGRATOR_DEFAULT_REL_TOL)
+    double absTol;                 // Absolute tolerance (<= 0: INTEGRATOR_DEFAULT_ABS_TOL)
+    double maxStep;                // Largest internal step (<= 0: the whole interval)
+    double stepHint;               // Next step size, carried across calls (0: try the whole interval)
+    unsigned long accepted;        // Internal steps taken
+    unsigned long rejected;        // Internal steps rejected by the error test
+    unsigned long evaluations;     // Derivative evaluations
+} AdaptiveIntegrator;
+
+// Reset an integrator (tolerances <= 0 select the defaults)
+void initAdaptiveIntegrator(AdaptiveIntegrator *integrator, double relTol, double absTol);
+
+// Integrate state over duration with error-controlled steps
+// Parameters:
+//   integrator: step control and statistics (updated)
+//   derivative: state derivative callback
+//   system: plant passed to the callback
+//   size: state vector length (1..INTEGRATOR_MAX_STATE)
+//   state: state vector, advanced in place
+//   duration: integration interval (s)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER, ERROR_INVALID_PARAMETER or the callback's error
+ErrorCode integrateAdaptive(AdaptiveIntegrator *integrator, StateDerivativeCallback derivative, void *system,
+                            int size, double *state, double duration);
+
+#endif // INTEGRATOR_H
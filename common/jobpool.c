@@ -0,0 +1,357 @@
+#include "jobpool.h"
+#include "threads.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// Initial capacity of each worker queue (grows by doubling)
+#define JOB_QUEUE_INITIAL_CAPACITY 64
+
+typedef struct {
+    JobFunction function;
+    void *arg;
+    JobGroup *group;         // Optional completion group
+} Job;
+
+// Double-ended job queue owned by one worker
+// The owner takes jobs from the front (submission order); thieves take from the back.
+typedef struct {
+    ThreadMutex lock;
+    Job *jobs;       // Circular buffer
+    int capacity;
+    int head;        // Index of the front job
+    int count;
+} JobQueue;
+
+typedef struct {
+    JobPool *pool;
+    int index;
+    int node;                // NUMA node of the worker (0 for a floating pool)
+} WorkerContext;
+
+struct JobPool {
+    int workerCount;          // Running worker threads
+    int queueCount;           // Allocated queues (one per requested worker)
+    ThreadHandle *threads;
+    WorkerContext *contexts;
+    JobQueue *queues;
+    ThreadMutex lock;         // Protects the counters and flags below
+    ThreadCond workAvailable; // Signaled when a job is queued or on shutdown
+    ThreadCond allDone;       // Signaled when pendingJobs drops to zero
+    long queuedJobs;          // Jobs sitting in a queue
+    long pendingJobs;         // Jobs submitted and not yet finished
+    int nextQueue;            // Round-robin submission cursor
+    int shuttingDown;
+    int pinnedWorkers;        // Workers restricted to their placement CPU
+};
+
+int getHardwareConcurrency(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (int)count : 1;
+}
+
+static int pushJob(JobQueue *queue, Job job) {
+    threadMutexLock(&queue->lock);
+    if (queue->count == queue->capacity) {
+        int newCapacity = queue->capacity * 2;
+        Job *grown = (Job*)malloc((size_t)newCapacity * sizeof(Job));
+        if (grown == NULL) {
+            threadMutexUnlock(&queue->lock);
+            return 0;
+        }
+        for (int i = 0; i < queue->count; i++) {
+            grown[i] = queue->jobs[(queue->head + i) % queue->capacity];
+        }
+        free(queue->jobs);
+        queue->jobs = grown;
+        queue->capacity = newCapacity;
+        queue->head = 0;
+    }
+    queue->jobs[(queue->head + queue->count) % queue->capacity] = job;
+    queue->count++;
+    threadMutexUnlock(&queue->lock);
+    return 1;
+}
+
+// Owner side: take the oldest job
+static int popFrontJob(JobQueue *queue, Job *job) {
+    int found = 0;
+    threadMutexLock(&queue->lock);
+    if (queue->count > 0) {
+        *job = queue->jobs[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        found = 1;
+    }
+    threadMutexUnlock(&queue->lock);
+    return found;
+}
+
+// Thief side: take the newest job
+static int popBackJob(JobQueue *queue, Job *job) {
+    int found = 0;
+    threadMutexLock(&queue->lock);
+    if (queue->count > 0) {
+        queue->count--;
+        *job = queue->jobs[(queue->head + queue->count) % queue->capacity];
+        found = 1;
+    }
+    threadMutexUnlock(&queue->lock);
+    return found;
+}
+
+// Own queue first, then steal from the workers of the same node, then from the other nodes
+static int takeJob(JobPool *pool, int self, Job *job) {
+    if (popFrontJob(&pool->queues[self], job)) return 1;
+    int node = pool->contexts[self].node;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int k = 1; k < pool->workerCount; k++) {
+            int victim = (self + k) % pool->workerCount;
+            if ((pool->contexts[victim].node == node) != (pass == 0)) continue;
+            if (popBackJob(&pool->queues[victim], job)) return 1;
+        }
+    }
+    return 0;
+}
+
+static void workerLoop(WorkerContext *context) {
+    JobPool *pool = context->pool;
+    for (;;) {
+        Job job;
+        if (takeJob(pool, context->index, &job)) {
+            threadMutexLock(&pool->lock);
+            pool->queuedJobs--;
+            threadMutexUnlock(&pool->lock);
+
+            job.function(job.arg);
+
+            if (job.group != NULL) {
+                threadMutexLock(&job.group->lock);
+                job.group->pending--;
+                if (job.group->pending == 0) threadCondBroadcast(&job.group->done);
+                threadMutexUnlock(&job.group->lock);
+            }
+
+            threadMutexLock(&pool->lock);
+            pool->pendingJobs--;
+            if (pool->pendingJobs == 0) threadCondBroadcast(&pool->allDone);
+            threadMutexUnlock(&pool->lock);
+            continue;
+        }
+
+        // Nothing to run or steal: sleep until new work arrives
+        threadMutexLock(&pool->lock);
+        while (pool->queuedJobs == 0 && !pool->shuttingDown) {
+            threadCondWait(&pool->workAvailable, &pool->lock);
+        }
+        int stop = pool->shuttingDown && pool->queuedJobs == 0;
+        threadMutexUnlock(&pool->lock);
+        if (stop) break;
+    }
+}
+
+static ThreadReturn THREAD_CALL workerMain(void *arg) {
+    WorkerContext *context = (WorkerContext*)arg;
+    setThreadNumaNode(context->node);  // Objects the worker's jobs take come from its node
+    workerLoop(context);
+    return THREAD_RETURN_VALUE;
+}
+
+ErrorCode createJobPool(int numWorkers, JobPool **pool) {
+    return createPlacedJobPool(numWorkers, JOB_POOL_FLOATING, pool);
+}
+
+ErrorCode createPlacedJobPool(int numWorkers, JobPoolPlacement placement, JobPool **pool) {
+    if (pool == NULL) return ERROR_NULL_POINTER;
+    *pool = NULL;
+    if (numWorkers <= 0) numWorkers = getHardwareConcurrency();
+
+    JobPool *p = (JobPool*)calloc(1, sizeof(JobPool));
+    if (p == NULL) return ERROR_NULL_POINTER;
+
+    p->workerCount = numWorkers;
+    p->queueCount = numWorkers;
+    p->threads = (ThreadHandle*)calloc((size_t)numWorkers, sizeof(ThreadHandle));
+    p->contexts = (WorkerContext*)calloc((size_t)numWorkers, sizeof(WorkerContext));
+    p->queues = (JobQueue*)calloc((size_t)numWorkers, sizeof(JobQueue));
+    if (p->threads == NULL || p->contexts == NULL || p->queues == NULL) {
+        free(p->threads);
+        free(p->contexts);
+        free(p->queues);
+        free(p);
+        return ERROR_NULL_POINTER;
+    }
+
+    threadMutexInit(&p->lock);
+    threadCondInit(&p->workAvailable);
+    threadCondInit(&p->allDone);
+    for (int i = 0; i < numWorkers; i++) {
+        threadMutexInit(&p->queues[i].lock);
+        p->queues[i].capacity = JOB_QUEUE_INITIAL_CAPACITY;
+        p->queues[i].jobs = (Job*)malloc(JOB_QUEUE_INITIAL_CAPACITY * sizeof(Job));
+        p->contexts[i].pool = p;
+        p->contexts[i].index = i;
+    }
+
+    // Pinned pool: every worker gets a CPU, spread over the NUMA nodes
+    int *cpus = NULL;
+    if (placement == JOB_POOL_PINNED) {
+        cpus = (int*)malloc((size_t)numWorkers * sizeof(int));
+        int *nodes = (int*)malloc((size_t)numWorkers * sizeof(int));
+        if (cpus != NULL && nodes != NULL && getSpreadCpuPlacement(numWorkers, cpus, nodes)) {
+            for (int i = 0; i < numWorkers; i++) p->contexts[i].node = nodes[i];
+        } else {
+            free(cpus);
+            cpus = NULL;  // Topology unknown: the workers float
+        }
+        free(nodes);
+    }
+
+    // Start workers; a pool with fewer threads than requested is still usable
+    int started = 0;
+    for (int i = 0; i < numWorkers; i++) {
+        if (p->queues[i].jobs == NULL) break;
+        if (!threadCreate(&p->threads[i], workerMain, &p->contexts[i])) break;
+        // Pinned before any job can be submitted, so no job runs off its node
+        if (cpus != NULL && threadSetAffinity(p->threads[i], cpus[i])) p->pinnedWorkers++;
+        started++;
+    }
+    free(cpus);
+    if (started == 0) {
+        p->workerCount = 0;
+        destroyJobPool(p);
+        return ERROR_CALLBACK_FAILED;
+    }
+    p->workerCount = started;
+
+    *pool = p;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode submitJob(JobPool *pool, JobFunction function, void *arg) {
+    return submitGroupJob(pool, NULL, function, arg);
+}
+
+void initJobGroup(JobGroup *group) {
+    if (group == NULL) return;
+    threadMutexInit(&group->lock);
+    threadCondInit(&group->done);
+    group->pending = 0;
+}
+
+// Count a job in or out of its group (group may be NULL)
+static void addGroupJobs(JobGroup *group, long delta) {
+    if (group == NULL) return;
+    threadMutexLock(&group->lock);
+    group->pending += delta;
+    if (group->pending == 0) threadCondBroadcast(&group->done);
+    threadMutexUnlock(&group->lock);
+}
+
+ErrorCode submitGroupJob(JobPool *pool, JobGroup *group, JobFunction function, void *arg) {
+    if (pool == NULL || function == NULL) return ERROR_NULL_POINTER;
+
+    threadMutexLock(&pool->lock);
+    if (pool->shuttingDown) {
+        threadMutexUnlock(&pool->lock);
+        return ERROR_INVALID_PARAMETER;
+    }
+    int target = pool->nextQueue;
+    pool->nextQueue = (pool->nextQueue + 1) % pool->workerCount;
+    pool->pendingJobs++;
+    pool->queuedJobs++;
+    threadMutexUnlock(&pool->lock);
+
+    Job job = { function, arg, group };
+    addGroupJobs(group, 1);
+    if (!pushJob(&pool->queues[target], job)) {
+        addGroupJobs(group, -1);
+        threadMutexLock(&pool->lock);
+        pool->pendingJobs--;
+        pool->queuedJobs--;
+        if (pool->pendingJobs == 0) threadCondBroadcast(&pool->allDone);
+        threadMutexUnlock(&pool->lock);
+        return ERROR_NULL_POINTER;
+    }
+
+    threadMutexLock(&pool->lock);
+    threadCondSignal(&pool->workAvailable);
+    threadMutexUnlock(&pool->lock);
+    return ERROR_SUCCESS;
+}
+
+ErrorCode waitJobPool(JobPool *pool) {
+    if (pool == NULL) return ERROR_NULL_POINTER;
+
+    threadMutexLock(&pool->lock);
+    while (pool->pendingJobs > 0) {
+        threadCondWait(&pool->allDone, &pool->lock);
+    }
+    threadMutexUnlock(&pool->lock);
+    return ERROR_SUCCESS;
+}
+
+ErrorCode waitJobGroup(JobGroup *group) {
+    if (group == NULL) return ERROR_NULL_POINTER;
+
+    threadMutexLock(&group->lock);
+    while (group->pending > 0) {
+        threadCondWait(&group->done, &group->lock);
+    }
+    threadMutexUnlock(&group->lock);
+    return ERROR_SUCCESS;
+}
+
+void destroyJobGroup(JobGroup *group) {
+    if (group == NULL) return;
+    threadCondDestroy(&group->done);
+    threadMutexDestroy(&group->lock);
+}
+
+int getJobPoolWorkerCount(const JobPool *pool) {
+    return pool ? pool->workerCount : 0;
+}
+
+int getJobPoolPinnedCount(const JobPool *pool) {
+    return pool ? pool->pinnedWorkers : 0;
+}
+
+void destroyJobPool(JobPool *pool) {
+    if (pool == NULL) return;
+
+    if (pool->workerCount > 0) {
+        waitJobPool(pool);
+
+        threadMutexLock(&pool->lock);
+        pool->shuttingDown = 1;
+        threadCondBroadcast(&pool->workAvailable);
+        threadMutexUnlock(&pool->lock);
+
+        for (int i = 0; i < pool->workerCount; i++) {
+            threadJoin(pool->threads[i]);
+        }
+    }
+
+    // Queues are allocated for every requested worker, even if fewer threads started
+    for (int i = 0; i < pool->queueCount; i++) {
+        free(pool->queues[i].jobs);
+        threadMutexDestroy(&pool->queues[i].lock);
+    }
+    threadCondDestroy(&pool->workAvailable);
+    threadCondDestroy(&pool->allDone);
+    threadMutexDestroy(&pool->lock);
+    free(pool->threads);
+    free(pool->contexts);
+    free(pool->queues);
+    free(pool);
+}
@@ -0,0 +1,97 @@
+#ifndef JOBPOOL_H
+#define JOBPOOL_H
+
+#include "errorcode.h"
+#include "threads.h"
+
+// Job function type executed by a pool worker
+// Parameters:
+//   arg: user pointer passed to submitJob (e.g. a ThreadData for runSimulation)
+typedef void (*JobFunction)(void *arg);
+
+// Fixed-size pool of worker threads with one work-stealing queue per worker
+// Jobs are distributed round-robin over the worker queues; a worker whose own
+// queue is empty steals from the other queues before going to sleep, from the queues of
+// workers on its own NUMA node first.
+typedef struct JobPool JobPool;
+
+// Placement of the worker threads
+typedef enum {
+    JOB_POOL_FLOATING = 0,  // The OS schedules the workers
+    JOB_POOL_PINNED         // Worker i pinned to one CPU, the workers spread round-robin over the
+                            // NUMA nodes (getSpreadCpuPlacement); a job's allocations are then
+                            // first touched on its worker's node and recycled there (objectpool.h)
+} JobPoolPlacement;
+
+// Completion group: a set of jobs that can be waited for on its own, without waiting for the
+// rest of the pool's work (a future of several jobs)
+typedef struct {
+    ThreadMutex lock;
+    ThreadCond done;         // Signaled when pending drops to zero
+    long pending;            // Jobs of the group submitted and not yet finished
+} JobGroup;
+
+// Number of hardware threads available to the process (at least 1)
+int getHardwareConcurrency(void);
+
+// Create a job pool and start its worker threads
+// Parameters:
+//   numWorkers: number of worker threads (<= 0 selects getHardwareConcurrency())
+//   pool: pointer to store the new pool
+// Returns: ErrorCode
+ErrorCode createJobPool(int numWorkers, JobPool **pool);
+
+// Create a job pool with a worker placement
+// Pinning is best effort: workers whose CPU cannot be set keep floating (getJobPoolPinnedCount).
+// Parameters:
+//   numWorkers: number of worker threads (<= 0 selects getHardwareConcurrency())
+//   placement: JOB_POOL_FLOATING (same as createJobPool) or JOB_POOL_PINNED
+//   pool: pointer to store the new pool
+// Returns: ErrorCode
+ErrorCode createPlacedJobPool(int numWorkers, JobPoolPlacement placement, JobPool **pool);
+
+// Queue a job for execution on the pool
+// The job may start immediately; jobs submitted from inside a job are allowed.
+// Parameters:
+//   pool: job pool
+//   function: job function
+//   arg: argument passed to the job function (must stay valid until the job finishes)
+// Returns: ErrorCode
+ErrorCode submitJob(JobPool *pool, JobFunction function, void *arg);
+
+// Set up an empty completion group
+void initJobGroup(JobGroup *group);
+
+// Queue a job as part of a completion group
+// Parameters:
+//   pool: job pool
+//   group: initialized group (must stay valid until waitJobGroup returns)
+//   function: job function
+//   arg: argument passed to the job function (must stay valid until the job finishes)
+// Returns: ErrorCode
+ErrorCode submitGroupJob(JobPool *pool, JobGroup *group, JobFunction function, void *arg);
+
+// Block until every job of the group has finished (must not be called from inside a job)
+// Returns: ErrorCode
+ErrorCode waitJobGroup(JobGroup *group);
+
+// Release a finished group
+void destroyJobGroup(JobGroup *group);
+
+// Block until every job submitted so far has finished
+// Must not be called from inside a job.
+// Parameters:
+//   pool: job pool
+// Returns: ErrorCode
+ErrorCode waitJobPool(JobPool *pool);
+
+// Number of worker threads in the pool
+int getJobPoolWorkerCount(const JobPool *pool);
+
+// Number of workers pinned to a CPU (0 for a floating pool)
+int getJobPoolPinnedCount(const JobPool *pool);
+
+// Wait for outstanding jobs, stop the workers and free the pool
+void destroyJobPool(JobPool *pool);
+
+#endif // JOBPOOL_H
@@ -0,0 +1,405 @@
+#include "mpc.h"
+#include <math.h>
+#include <string.h>
+
+// ADMM settings (OSQP-style iteration with over-relaxation)
+#define MPC_RHO_SCALE 100.0        // Penalty relative to the mean Hessian diagonal
+#define MPC_SIGMA_SCALE 1e-6       // Proximal term relative to the mean Hessian diagonal
+#define MPC_ALPHA 1.6              // Over-relaxation
+#define MPC_UNBOUNDED 1e20         // Bound of disabled rate constraints
+
+// Terminal weight: discrete Riccati iteration until the cost-to-go stops changing
+#define MPC_RICCATI_MAX_ITERATIONS 100000
+#define MPC_RICCATI_TOLERANCE 1e-12
+
+void initMpcConfig(MpcConfig *config) {
+    if (config == NULL) return;
+    memset(config, 0, sizeof(*config));
+    config->horizon = 15;
+    config->stateWeight[0] = 1.0;
+    config->inputWeight = 0.1;
+    config->rateWeight = 0.1;
+    config->inputMin = -1.0;
+    config->inputMax = 1.0;
+}
+
+// Cost-to-go of the unconstrained problem (LQR), used as terminal weight so that short
+// horizons still see the whole transient
+static void solveMpcTerminalWeight(const MpcModel *model, const double *stateWeight, double inputWeight,
+                                   double P[MPC_MAX_STATES][MPC_MAX_STATES]) {
+    int n = model->states;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) P[i][j] = (i == j) ? stateWeight[i] : 0.0;
+    }
+    for (int iteration = 0; iteration < MPC_RICCATI_MAX_ITERATIONS; iteration++) {
+        // P' = Q + AᵀPA - (AᵀPB)(AᵀPB)ᵀ / (r + BᵀPB)
+        double PA[MPC_MAX_STATES][MPC_MAX_STATES], PB[MPC_MAX_STATES], APB[MPC_MAX_STATES];
+        double BPB = inputWeight;
+        for (int i = 0; i < n; i++) {
+            PB[i] = 0.0;
+            for (int j = 0; j < n; j++) {
+                PA[i][j] = 0.0;
+                for (int k = 0; k < n; k++) PA[i][j] += P[i][k] * model->A[k][j];
+                PB[i] += P[i][j] * model->B[j];
+            }
+            BPB += model->B[i] * PB[i];
+        }
+        for (int i = 0; i < n; i++) {
+            APB[i] = 0.0;
+            for (int k = 0; k < n; k++) APB[i] += model->A[k][i] * PB[k];
+        }
+        double change = 0.0, size = 0.0;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                double next = (i == j) ? stateWeight[i] : 0.0;
+                for (int k = 0; k < n; k++) next += model->A[k][i] * PA[k][j];
+                next -= APB[i] * APB[j] / BPB;
+                change = fmax(change, fabs(next - P[i][j]));
+                size = fmax(size, fabs(next));
+                P[i][j] = next;
+            }
+        }
+        if (change <= MPC_RICCATI_TOLERANCE * size) break;
+    }
+}
+
+// Invert a symmetric positive definite matrix through its Cholesky factor
+// Returns: ERROR_SUCCESS or ERROR_INVALID_PARAMETER (not positive definite)
+static ErrorCode invertMpcSystem(int n, double K[MPC_MAX_HORIZON][MPC_MAX_HORIZON],
+                                 double inverse[MPC_MAX_HORIZON][MPC_MAX_HORIZON]) {
+    double L[MPC_MAX_HORIZON][MPC_MAX_HORIZON];
+    memset(L, 0, sizeof(L));
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j <= i; j++) {
+            double sum = K[i][j];
+            for (int k = 0; k < j; k++) sum -= L[i][k] * L[j][k];
+            if (i == j) {
+                if (!(sum > 0.0)) return ERROR_INVALID_PARAMETER;
+                L[i][i] = sqrt(sum);
+            } else {
+                L[i][j] = sum / L[j][j];
+            }
+        }
+    }
+    // Column c of the inverse: L Lᵀ x = e_c
+    for (int c = 0; c < n; c++) {
+        double v[MPC_MAX_HORIZON];
+        for (int i = 0; i < n; i++) {
+            double sum = (i == c) ? 1.0 : 0.0;
+            for (int k = 0; k < i; k++) sum -= L[i][k] * v[k];
+            v[i] = sum / L[i][i];
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            double sum = v[i];
+            for (int k = i + 1; k < n; k++) sum -= L[k][i] * v[k];
+            v[i] = sum / L[i][i];
+        }
+        for (int i = 0; i < n; i++) inverse[i][c] = v[i];
+    }
+    return ERROR_SUCCESS;
+}
+
+ErrorCode initMpcController(MpcController *mpc, const MpcModel *model, const MpcConfig *config, double dt) {
+    if (mpc == NULL || model == NULL || config == NULL) return ERROR_NULL_POINTER;
+    int n = model->states;
+    int N = config->horizon;
+    if (n < 1 || n > MPC_MAX_STATES || N < 1 || N > MPC_MAX_HORIZON || dt <= 0.0) return ERROR_INVALID_PARAMETER;
+    if (!(config->inputMax > config->inputMin) || !(config->inputWeight > 0.0) || config->rateWeight < 0.0) {
+        return ERROR_INVALID_PARAMETER;
+    }
+    // The observer reads the disturbance off the last state, so the input must act on it
+    if (model->B[n - 1] == 0.0) return ERROR_INVALID_PARAMETER;
+    for (int i = 0; i < n; i++) {
+        if (config->stateWeight[i] < 0.0) return ERROR_INVALID_PARAMETER;
+    }
+
+    memset(mpc, 0, sizeof(*mpc));
+    mpc->config = *config;
+    if (mpc->config.maxIterations <= 0) mpc->config.maxIterations = MPC_DEFAULT_MAX_ITERATIONS;
+    if (mpc->config.tolerance <= 0.0) mpc->config.tolerance = MPC_DEFAULT_TOLERANCE;
+    if (mpc->config.disturbanceGain <= 0.0) mpc->config.disturbanceGain = MPC_DEFAULT_DISTURBANCE_GAIN;
+    if (mpc->config.disturbanceGain > 1.0) mpc->config.disturbanceGain = 1.0;
+    mpc->dt = dt;
+    mpc->horizon = N;
+    mpc->inputScale = 0.5 * (config->inputMax - config->inputMin);
+
+    // Normalized model: u = inputScale * v
+    mpc->model = *model;
+    for (int i = 0; i < n; i++) mpc->model.B[i] = model->B[i] * mpc->inputScale;
+    const MpcModel *m = &mpc->model;
+
+    double P[MPC_MAX_STATES][MPC_MAX_STATES];
+    solveMpcTerminalWeight(m, config->stateWeight, config->inputWeight, P);
+
+    // Prediction blocks: powers[k] = A^(k+1), impulse[k] = A^k B
+    double powers[MPC_MAX_HORIZON][MPC_MAX_STATES][MPC_MAX_STATES];
+    double impulse[MPC_MAX_HORIZON][MPC_MAX_STATES];
+    for (int k = 0; k < N; k++) {
+        for (int i = 0; i < n; i++) {
+            impulse[k][i] = 0.0;
+            for (int j = 0; j < n; j++) {
+                powers[k][i][j] = 0.0;
+                if (k == 0) {
+                    powers[k][i][j] = m->A[i][j];
+                } else {
+                    for (int l = 0; l < n; l++) powers[k][i][j] += m->A[i][l] * powers[k - 1][l][j];
+                }
+                impulse[k][i] += (k == 0 ? (i == j ? 1.0 : 0.0) : powers[k - 1][i][j]) * m->B[j];
+            }
+        }
+    }
+
+    // Condensed Hessian H = ΓᵀQΓ + rI + sDᵀD and gradient map Γ ᵀQΦ; z_{k+1} has weight Q,
+    // the last predicted state the terminal weight
+    double H[MPC_MAX_HORIZON][MPC_MAX_HORIZON];
+    for (int a = 0; a < N; a++) {
+        for (int b = 0; b < N; b++) {
+            double sum = 0.0;
+            for (int k = (a > b ? a : b); k < N; k++) {
+                const double *ga = impulse[k - a];
+                const double *gb = impulse[k - b];
+                for (int i = 0; i < n; i++) {
+                    for (int j = 0; j < n; j++) {
+                        double w = (k + 1 == N) ? P[i][j] : (i == j ? config->stateWeight[i] : 0.0);
+                        sum += ga[i] * w * gb[j];
+                    }
+                }
+            }
+            H[a][b] = sum;
+        }
+        for (int j = 0; j < n; j++) {
+            double sum = 0.0;
+            for (int k = a; k < N; k++) {
+                for (int i = 0; i < n; i++) {
+                    for (int l = 0; l < n; l++) {
+                        double w = (k + 1 == N) ? P[i][l] : (i == l ? config->stateWeight[i] : 0.0);
+                        sum += impulse[k - a][i] * w * powers[k][l][j];
+                    }
+                }
+            }
+            mpc->gradient[a][j] = sum;
+        }
+    }
+
+    // Input change operator D (row 0: u_0 - u_{-1}, u_{-1} moves into the bounds): DᵀD is
+    // tridiagonal, 2 on the diagonal except the last entry, -1 next to it. The constraint
+    // matrix is [I; D], so AcᵀAc = I + DᵀD.
+    double trace = 0.0;
+    for (int a = 0; a < N; a++) {
+        H[a][a] += config->inputWeight + config->rateWeight * ((a + 1 < N) ? 2.0 : 1.0);
+        if (a + 1 < N) {
+            H[a][a + 1] -= config->rateWeight;
+            H[a + 1][a] -= config->rateWeight;
+        }
+        trace += H[a][a];
+    }
+    mpc->rho = MPC_RHO_SCALE * trace / N;
+    mpc->sigma = MPC_SIGMA_SCALE * trace / N;
+
+    double K[MPC_MAX_HORIZON][MPC_MAX_HORIZON];
+    for (int a = 0; a < N; a++) {
+        for (int b = 0; b < N; b++) K[a][b] = H[a][b];
+        K[a][a] += mpc->sigma + mpc->rho * ((a + 1 < N) ? 3.0 : 2.0);
+        if (a + 1 < N) K[a][a + 1] -= mpc->rho;
+        if (a > 0) K[a][a - 1] -= mpc->rho;
+    }
+    ErrorCode err = invertMpcSystem(N, H, mpc->hessianInverse);
+    if (err == ERROR_SUCCESS) err = invertMpcSystem(N, K, mpc->systemInverse);
+    if (err != ERROR_SUCCESS) return err;
+
+    resetMpcController(mpc);
+    return ERROR_SUCCESS;
+}
+
+void resetMpcController(MpcController *mpc) {
+    if (mpc == NULL) return;
+    memset(mpc->x, 0, sizeof(mpc->x));
+    memset(mpc->z, 0, sizeof(mpc->z));
+    memset(mpc->y, 0, sizeof(mpc->y));
+    memset(mpc->previousState, 0, sizeof(mpc->previousState));
+    mpc->started = 0;
+    // The actuator starts at rest (or at the nearest limit)
+    mpc->previousInput = fmin(fmax(0.0, mpc->config.inputMin), mpc->config.inputMax);
+    mpc->disturbance = 0.0;
+    mpc->solves = 0;
+    mpc->iterations = 0;
+    mpc->lastIterations = 0;
+    mpc->capped = 0;
+}
+
+// Constraint values Ac x: inputs, then input changes (row 0 of the changes is x_0 itself)
+static inline void applyMpcConstraints(int N, const double *x, double *out) {
+    for (int k = 0; k < N; k++) {
+        out[k] = x[k];
+        out[N + k] = (k > 0) ? x[k] - x[k - 1] : x[0];
+    }
+}
+
+// Acᵀ v
+static inline double applyMpcConstraintsTransposed(int N, const double *v, int k) {
+    return v[k] + v[N + k] - ((k + 1 < N) ? v[N + k + 1] : 0.0);
+}
+
+// ADMM on the constrained problem, x̃ = K⁻¹(σx - q + Acᵀ(ρz - y)) followed by the relaxed
+// projection of Ac x̃ onto the bounds, started from the previous solution shifted by one tick
+// Parameters:
+//   mpc: controller (x, z, y hold the previous solution and receive the new one)
+//   q: linear term
+//   lower, upper: bounds of the 2N constraint rows
+//   w: normalized disturbance (x is stored as u / scale, the solver works on u / scale - w)
+// Returns: iterations run
+static int solveMpcConstrained(MpcController *mpc, const double *q, const double *lower, const double *upper,
+                               double w) {
+    int N = mpc->horizon;
+    double *x = mpc->x;
+    double *z = mpc->z;
+    double *y = mpc->y;
+    if (mpc->started) {
+        for (int k = 0; k < N; k++) x[k] = x[(k + 1 < N) ? k + 1 : k] - w;
+    } else {
+        for (int k = 0; k < N; k++) x[k] = fmin(fmax(0.0, lower[k]), upper[k]);
+        memset(y, 0, sizeof(double) * 2 * (size_t)N);
+    }
+    applyMpcConstraints(N, x, z);
+    for (int r = 0; r < 2 * N; r++) z[r] = fmin(fmax(z[r], lower[r]), upper[r]);
+
+    double rho = mpc->rho;
+    double sigma = mpc->sigma;
+    double tolerance = mpc->config.tolerance;
+    double rhs[MPC_MAX_HORIZON], tilde[MPC_MAX_HORIZON];
+    double scaled[2 * MPC_MAX_HORIZON], constrained[2 * MPC_MAX_HORIZON];
+    int iteration = 0;
+    while (iteration < mpc->config.maxIterations) {
+        iteration++;
+        for (int r = 0; r < 2 * N; r++) scaled[r] = rho * z[r] - y[r];
+        for (int k = 0; k < N; k++) rhs[k] = sigma * x[k] - q[k] + applyMpcConstraintsTransposed(N, scaled, k);
+        for (int k = 0; k < N; k++) {
+            const double *row = mpc->systemInverse[k];
+            double sum = 0.0;
+            for (int j = 0; j < N; j++) sum += row[j] * rhs[j];
+            tilde[k] = sum;
+        }
+        applyMpcConstraints(N, tilde, constrained);
+        for (int k = 0; k < N; k++) x[k] = MPC_ALPHA * tilde[k] + (1.0 - MPC_ALPHA) * x[k];
+        for (int r = 0; r < 2 * N; r++) {
+            double relaxed = MPC_ALPHA * constrained[r] + (1.0 - MPC_ALPHA) * z[r];
+            double next = fmin(fmax(relaxed + y[r] / rho, lower[r]), upper[r]);
+            y[r] += rho * (relaxed - next);
+            scaled[r] = next - z[r];
+            z[r] = next;
+        }
+
+        // Residuals: primal |Ac x - z|, dual ρ|Acᵀ Δz|, each against the mixed tolerance
+        // tolerance * (1 + size of the terms it compares)
+        applyMpcConstraints(N, x, constrained);
+        double primal = 0.0, dual = 0.0, primalSize = 0.0, dualSize = 0.0;
+        for (int r = 0; r < 2 * N; r++) {
+            primal = fmax(primal, fabs(constrained[r] - z[r]));
+            primalSize = fmax(primalSize, fmax(fabs(constrained[r]), fabs(z[r])));
+        }
+        for (int k = 0; k < N; k++) {
+            dual = fmax(dual, fabs(applyMpcConstraintsTransposed(N, scaled, k)));
+            dualSize = fmax(dualSize, fmax(fabs(applyMpcConstraintsTransposed(N, y, k)), fabs(q[k])));
+        }
+        if (primal <= tolerance * (1.0 + primalSize) && rho * dual <= tolerance * (1.0 + dualSize)) break;
+    }
+    return iteration;
+}
+
+ErrorCode mpcController(double error, ControllerConfig *config, double *controlSignal) {
+    if (config == NULL || controlSignal == NULL) return ERROR_NULL_POINTER;
+    MpcController *mpc = config->mpc;
+    if (mpc == NULL || mpc->horizon <= 0) return ERROR_NULL_POINTER;
+
+    const MpcModel *m = &mpc->model;
+    const MpcConfig *c = &mpc->config;
+    int n = m->states;
+    int N = mpc->horizon;
+    int last = n - 1;
+    double scale = mpc->inputScale;
+
+    // Measured state: the error and (two-state models) its rate
+    double state[MPC_MAX_STATES];
+    state[0] = error;
+    if (n > 1) state[1] = mpc->started ? (error - mpc->previousState[0]) / mpc->dt : 0.0;
+
+    // Disturbance observer: the input that explains the last state change. A change no input
+    // within the limits could explain is a setpoint step (the error jumps), not a disturbance:
+    // the observer skips it and the rate keeps its prediction.
+    if (mpc->started) {
+        double predicted = 0.0;
+        for (int j = 0; j < n; j++) predicted += m->A[last][j] * mpc->previousState[j];
+        double innovation = (state[last] - predicted) / m->B[last];
+        double explained = mpc->previousInput / scale - innovation;
+        if (fabs(explained - mpc->disturbance / scale) <= 2.0 * MPC_SETPOINT_JUMP) {
+            mpc->disturbance += c->disturbanceGain * (explained * scale - mpc->disturbance);
+        } else if (n > 1) {
+            state[1] = predicted + m->B[1] * (mpc->previousInput - mpc->disturbance) / scale;
+        }
+    }
+    double w = mpc->disturbance / scale;
+
+    // Bounds of the constraint rows in the solver variable x = u / scale - w
+    double lower[2 * MPC_MAX_HORIZON], upper[2 * MPC_MAX_HORIZON];
+    double inputLow = c->inputMin / scale - w;
+    double inputHigh = c->inputMax / scale - w;
+    double change = (c->rateLimit > 0.0) ? c->rateLimit * mpc->dt / scale : MPC_UNBOUNDED;
+    double previous = mpc->previousInput / scale - w;
+    for (int k = 0; k < N; k++) {
+        lower[k] = inputLow;
+        upper[k] = inputHigh;
+        lower[N + k] = (k == 0) ? previous - change : -change;
+        upper[N + k] = (k == 0) ? previous + change : change;
+    }
+
+    // Linear term q = ΓᵀQΦ z0, plus the change from the previous input
+    double q[MPC_MAX_HORIZON];
+    for (int k = 0; k < N; k++) {
+        double sum = 0.0;
+        for (int j = 0; j < n; j++) sum += mpc->gradient[k][j] * state[j];
+        q[k] = sum;
+    }
+    q[0] -= c->rateWeight * previous;
+
+    // Unconstrained optimum -H⁻¹q: nothing to iterate if it respects every limit
+    double *x = mpc->x;
+    double optimum[MPC_MAX_HORIZON], constrained[2 * MPC_MAX_HORIZON];
+    for (int k = 0; k < N; k++) {
+        const double *row = mpc->hessianInverse[k];
+        double sum = 0.0;
+        for (int j = 0; j < N; j++) sum -= row[j] * q[j];
+        optimum[k] = sum;
+    }
+    applyMpcConstraints(N, optimum, constrained);
+    int feasible = 1;
+    for (int r = 0; r < 2 * N && feasible; r++) {
+        feasible = constrained[r] >= lower[r] && constrained[r] <= upper[r];
+    }
+    int iteration = 0;
+    if (feasible) {
+        memcpy(x, optimum, sizeof(double) * (size_t)N);
+        memcpy(mpc->z, constrained, sizeof(double) * 2 * (size_t)N);
+        memset(mpc->y, 0, sizeof(double) * 2 * (size_t)N);
+    } else {
+        iteration = solveMpcConstrained(mpc, q, lower, upper, w);
+    }
+    mpc->lastIterations = iteration;
+    mpc->iterations += (unsigned long)iteration;
+    mpc->solves++;
+    if (iteration >= c->maxIterations) mpc->capped++;
+
+    // Apply the first input; the limits hold exactly even if ADMM stopped early
+    double u = (x[0] + w) * scale;
+    if (c->rateLimit > 0.0) {
+        double step = c->rateLimit * mpc->dt;
+        u = fmin(fmax(u, mpc->previousInput - step), mpc->previousInput + step);
+    }
+    u = fmin(fmax(u, c->inputMin), c->inputMax);
+    for (int k = 0; k < N; k++) x[k] += w;
+
+    for (int j = 0; j < n; j++) mpc->previousState[j] = state[j];
+    mpc->previousInput = u;
+    mpc->started = 1;
+    *controlSignal = u;
+    return ERROR_SUCCESS;
+}
@@ -0,0 +1,104 @@
+#ifndef MPC_H
+#define MPC_H
+
+#include "controller.h"
+
+// Discrete-time model-predictive controller (mpcController)
+// The plant is linearized in error coordinates, z+ = A z + B (u - w): z[0] is the control
+// error, z[1] (two-state models) its rate, w an input disturbance (drain outflow, gravity and
+// drag) that an observer estimates from the prediction error of the last step. Every tick a
+// condensed box QP over the horizon is solved,
+//   min ½ Σ z_kᵀ Q z_k + ½ r Σ (u_k - w)² + ½ s Σ (u_k - u_{k-1})²,  terminal weight: LQR cost-to-go
+//   s.t. inputMin <= u_k <= inputMax, |u_k - u_{k-1}| <= rateLimit * dt
+// Everything that does not depend on the measurement (prediction matrices, the inverses of the
+// Hessian and of the ADMM system matrix) is computed once by initMpcController, so a tick costs
+// N-by-N matrix-vector products and no allocation: the unconstrained optimum is tried first
+// and taken if it respects the limits, otherwise ADMM iterates from the previous solution
+// shifted by one step. The input is normalized by half its range inside the solver,
+// so the weights do not depend on the plant's units.
+
+#define MPC_MAX_HORIZON 32                 // Largest prediction horizon (steps)
+#define MPC_MAX_STATES 2                   // Largest model (error, error rate)
+#define MPC_DEFAULT_MAX_ITERATIONS 50      // ADMM iterations per tick (maxIterations <= 0)
+#define MPC_DEFAULT_TOLERANCE 1e-3         // ADMM relative residual tolerance (tolerance <= 0)
+#define MPC_DEFAULT_DISTURBANCE_GAIN 0.5   // Observer gain (disturbanceGain <= 0)
+#define MPC_SETPOINT_JUMP 2.0              // Innovation (input ranges) read as a setpoint change
+
+// Linear prediction model in error coordinates
+typedef struct {
+    int states;                                  // 1 (error) or 2 (error, error rate)
+    double A[MPC_MAX_STATES][MPC_MAX_STATES];    // State transition over one tick
+    double B[MPC_MAX_STATES];                    // Effect of the input (plant units) over one tick
+} MpcModel;
+
+// Controller settings
+typedef struct {
+    int horizon;                           // Prediction horizon (1..MPC_MAX_HORIZON steps)
+    double stateWeight[MPC_MAX_STATES];    // Q diagonal (error, error rate)
+    double inputWeight;                    // r: weight of (u - w) in half input ranges (> 0)
+    double rateWeight;                     // s: weight of the input change per tick in half input ranges
+    double inputMin;                       // Lower input limit (e.g. 0 inflow, -max_force)
+    double inputMax;                       // Upper input limit (max_inflow, max_force)
+    double rateLimit;                      // Largest input change per second (<= 0: unlimited)
+    double disturbanceGain;                // Observer gain, 0..1 (<= 0: MPC_DEFAULT_DISTURBANCE_GAIN)
+    int maxIterations;                     // ADMM iteration cap per tick (<= 0: default)
+    double tolerance;                      // ADMM stopping tolerance (<= 0: default)
+} MpcConfig;
+
+// Controller state: cached condensed QP, warm start and observer
+typedef struct MpcController {
+    MpcConfig config;
+    MpcModel model;                        // Model with the input normalized (B * inputScale)
+    double dt;
+    int horizon;
+    double inputScale;                     // Half input range
+    double rho;                            // ADMM penalty
+    double sigma;                          // ADMM proximal regularization
+    // Cached at setup
+    double gradient[MPC_MAX_HORIZON][MPC_MAX_STATES];     // q = gradient * z0 (Γᵀ Q Φ)
+    double hessianInverse[MPC_MAX_HORIZON][MPC_MAX_HORIZON];  // H⁻¹ (unconstrained solution)
+    double systemInverse[MPC_MAX_HORIZON][MPC_MAX_HORIZON];   // (H + σI + ρ AcᵀAc)⁻¹ (ADMM step)
+    // Solver iterates (normalized input, kept across ticks for warm starting)
+    double x[MPC_MAX_HORIZON];                            // Inputs over the horizon (u / inputScale)
+    double z[2 * MPC_MAX_HORIZON];                        // Constraint values: inputs, then changes
+    double y[2 * MPC_MAX_HORIZON];                        // Constraint multipliers
+    // Observer
+    int started;                           // A previous tick exists
+    double previousState[MPC_MAX_STATES];  // z of the previous tick
+    double previousInput;                  // Input applied at the previous tick (plant units)
+    double disturbance;                    // Estimated input disturbance w (plant units)
+    // Statistics
+    unsigned long solves;                  // Ticks solved
+    unsigned long iterations;              // ADMM iterations over all ticks
+    int lastIterations;                    // ADMM iterations of the last tick (0: unconstrained optimum)
+    unsigned long capped;                  // Ticks that hit maxIterations
+} MpcController;
+
+// Defaults for a configuration (horizon 15, weights 1 / 0.1 / 0.1, input -1..1, no rate limit)
+// Parameters:
+//   config: configuration to fill
+void initMpcConfig(MpcConfig *config);
+
+// Build the condensed QP of a model and reset the controller
+// Parameters:
+//   mpc: controller to initialize
+//   model: linear model in error coordinates (one tick of dt)
+//   config: horizon, weights and limits
+//   dt: controller period (seconds)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER
+//          (bad horizon or state count, inputMax <= inputMin, inputWeight <= 0, zero B)
+ErrorCode initMpcController(MpcController *mpc, const MpcModel *model, const MpcConfig *config, double dt);
+
+// Forget the warm start, observer and statistics (keeps the cached matrices)
+void resetMpcController(MpcController *mpc);
+
+// Model-predictive controller (ControllerCallback compatible)
+// Uses config->mpc, which must point to an initialized MpcController
+// Parameters:
+//   error: control error
+//   config: controller configuration (mpc, dt)
+//   controlSignal: pointer to store the input, within inputMin..inputMax
+// Returns: ERROR_SUCCESS or ERROR_NULL_POINTER
+ErrorCode mpcController(double error, ControllerConfig *config, double *controlSignal);
+
+#endif // MPC_H
@@ -0,0 +1,288 @@
+#include "msgsocket.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int SocketLength;
+#define pollMsgSockets WSAPoll
+typedef WSAPOLLFD MsgPollEntry;
+#else
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+typedef socklen_t SocketLength;
+#define pollMsgSockets poll
+typedef struct pollfd MsgPollEntry;
+#endif
+
+// Writes to a closed connection fail with an error instead of raising SIGPIPE
+#ifdef MSG_NOSIGNAL
+#define MSG_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define MSG_SEND_FLAGS 0
+#endif
+
+static void putU32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t getU32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+ErrorCode initMsgSockets(void) {
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) return ERROR_CALLBACK_FAILED;
+#elif !defined(MSG_NOSIGNAL)
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    return ERROR_SUCCESS;
+}
+
+void cleanupMsgSockets(void) {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void closeMsgSocket(MsgSocket socket) {
+    if (socket == MSG_SOCKET_INVALID) return;
+#ifdef _WIN32
+    closesocket((SOCKET)socket);
+#else
+    close(socket);
+#endif
+}
+
+// Small frames (results, chunk requests) go out immediately instead of waiting for an ACK
+static void setNoDelay(MsgSocket socket) {
+    int on = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+}
+
+ErrorCode listenMsgSocket(int port, MsgSocket *listener) {
+    if (listener == NULL) return ERROR_NULL_POINTER;
+    *listener = MSG_SOCKET_INVALID;
+    if (port < 1 || port > 65535) return ERROR_INVALID_PARAMETER;
+
+    MsgSocket socketHandle = (MsgSocket)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (socketHandle == MSG_SOCKET_INVALID) return ERROR_CALLBACK_FAILED;
+
+    // A restarted coordinator can take the port over from connections still in TIME_WAIT
+    int on = 1;
+    setsockopt(socketHandle, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((unsigned short)port);
+    if (bind(socketHandle, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(socketHandle, SOMAXCONN) != 0) {
+        closeMsgSocket(socketHandle);
+        return ERROR_CALLBACK_FAILED;
+    }
+    *listener = socketHandle;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode acceptMsgSocket(MsgSocket listener, MsgSocket *connection, char *peer, size_t peerSize) {
+    if (connection == NULL) return ERROR_NULL_POINTER;
+
+    struct sockaddr_storage address;
+    SocketLength length = (SocketLength)sizeof(address);
+    MsgSocket accepted = (MsgSocket)accept(listener, (struct sockaddr*)&address, &length);
+    *connection = accepted;
+    if (accepted == MSG_SOCKET_INVALID) return ERROR_CALLBACK_FAILED;
+    setNoDelay(accepted);
+
+    if (peer != NULL && peerSize > 0) {
+        char host[NI_MAXHOST], service[NI_MAXSERV];
+        if (getnameinfo((struct sockaddr*)&address, length, host, sizeof(host), service, sizeof(service),
+                        NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+            snprintf(peer, peerSize, "%s:%s", host, service);
+        } else {
+            snprintf(peer, peerSize, "?");
+        }
+    }
+    return ERROR_SUCCESS;
+}
+
+ErrorCode connectMsgSocket(const char *host, int port, MsgSocket *connection) {
+    if (host == NULL || connection == NULL) return ERROR_NULL_POINTER;
+    *connection = MSG_SOCKET_INVALID;
+    if (port < 1 || port > 65535) return ERROR_INVALID_PARAMETER;
+
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+    struct addrinfo hints, *addresses = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    if (getaddrinfo(host, service, &hints, &addresses) != 0) return ERROR_CALLBACK_FAILED;
+
+    // First address that accepts the connection (e.g. "localhost" may resolve to ::1 first)
+    ErrorCode err = ERROR_CALLBACK_FAILED;
+    for (struct addrinfo *a = addresses; a != NULL; a = a->ai_next) {
+        MsgSocket socketHandle = (MsgSocket)socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (socketHandle == MSG_SOCKET_INVALID) continue;
+        if (connect(socketHandle, a->ai_addr, (SocketLength)a->ai_addrlen) == 0) {
+            setNoDelay(socketHandle);
+            *connection = socketHandle;
+            err = ERROR_SUCCESS;
+            break;
+        }
+        closeMsgSocket(socketHandle);
+    }
+    freeaddrinfo(addresses);
+    return err;
+}
+
+ErrorCode setMsgSocketTimeout(MsgSocket socket, int timeoutMs) {
+    if (timeoutMs < 0) timeoutMs = 0;
+#ifdef _WIN32
+    DWORD timeout = (DWORD)timeoutMs;
+#else
+    struct timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+#endif
+    if (setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout)) != 0 ||
+        setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout)) != 0) {
+        return ERROR_CALLBACK_FAILED;
+    }
+    return ERROR_SUCCESS;
+}
+
+// Send every byte (a blocking send may write only part of the buffer)
+static int sendAll(MsgSocket socket, const unsigned char *data, size_t size) {
+    while (size > 0) {
+        int piece = size > (1u << 30) ? (1 << 30) : (int)size;
+        int sent = (int)send(socket, (const char*)data, piece, MSG_SEND_FLAGS);
+        if (sent <= 0) {
+#ifndef _WIN32
+            if (sent < 0 && errno == EINTR) continue;
+#endif
+            return 0;
+        }
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return 1;
+}
+
+// Receive exactly size bytes
+static int receiveAll(MsgSocket socket, unsigned char *data, size_t size) {
+    while (size > 0) {
+        int piece = size > (1u << 30) ? (1 << 30) : (int)size;
+        int received = (int)recv(socket, (char*)data, piece, 0);
+        if (received <= 0) {
+#ifndef _WIN32
+            if (received < 0 && errno == EINTR) continue;
+#endif
+            return 0;  // Closed by the peer, reset or timed out
+        }
+        data += received;
+        size -= (size_t)received;
+    }
+    return 1;
+}
+
+ErrorCode sendMessageParts(MsgSocket socket, uint32_t type, const MsgPart *parts, int count) {
+    if (parts == NULL && count > 0) return ERROR_NULL_POINTER;
+
+    size_t total = 0;
+    for (int p = 0; p < count; p++) {
+        if (parts[p].data == NULL && parts[p].size > 0) return ERROR_NULL_POINTER;
+        total += parts[p].size;
+        if (total > MSG_MAX_PAYLOAD) return ERROR_INVALID_PARAMETER;
+    }
+
+    unsigned char header[MSG_HEADER_SIZE];
+    putU32(header, type);
+    putU32(header + 4, (uint32_t)total);
+    if (!sendAll(socket, header, sizeof(header))) return ERROR_CALLBACK_FAILED;
+    for (int p = 0; p < count; p++) {
+        if (!sendAll(socket, (const unsigned char*)parts[p].data, parts[p].size)) return ERROR_CALLBACK_FAILED;
+    }
+    return ERROR_SUCCESS;
+}
+
+ErrorCode sendMessage(MsgSocket socket, uint32_t type, const void *payload, size_t size) {
+    MsgPart part = { payload, size };
+    return sendMessageParts(socket, type, &part, 1);
+}
+
+ErrorCode receiveMessage(MsgSocket socket, uint32_t *type, MsgBuffer *buffer) {
+    if (type == NULL || buffer == NULL) return ERROR_NULL_POINTER;
+
+    unsigned char header[MSG_HEADER_SIZE];
+    if (!receiveAll(socket, header, sizeof(header))) return ERROR_CALLBACK_FAILED;
+    uint32_t size = getU32(header + 4);
+    if (size > MSG_MAX_PAYLOAD) return ERROR_INVALID_PARAMETER;
+
+    if (size > buffer->capacity) {
+        unsigned char *grown = (unsigned char*)realloc(buffer->data, size);
+        if (grown == NULL) return ERROR_NULL_POINTER;
+        buffer->data = grown;
+        buffer->capacity = size;
+    }
+    if (!receiveAll(socket, buffer->data, size)) return ERROR_CALLBACK_FAILED;
+    buffer->size = size;
+    *type = getU32(header);
+    return ERROR_SUCCESS;
+}
+
+int waitMsgSockets(const MsgSocket *sockets, int count, int timeoutMs, int *ready) {
+    if (sockets == NULL || ready == NULL || count < 0 || count > MSG_WAIT_MAX_SOCKETS) return -1;
+
+    MsgPollEntry entries[MSG_WAIT_MAX_SOCKETS];
+    int index[MSG_WAIT_MAX_SOCKETS];
+    int watched = 0;
+    for (int i = 0; i < count; i++) {
+        ready[i] = 0;
+        if (sockets[i] == MSG_SOCKET_INVALID) continue;
+        entries[watched].fd = sockets[i];
+        entries[watched].events = POLLIN;
+        entries[watched].revents = 0;
+        index[watched++] = i;
+    }
+    if (watched == 0) return 0;
+
+    int result = pollMsgSockets(entries, (unsigned long)watched, timeoutMs);
+    if (result < 0) {
+#ifndef _WIN32
+        if (errno == EINTR) return 0;
+#endif
+        return -1;
+    }
+    int readable = 0;
+    for (int w = 0; w < watched; w++) {
+        // A hang-up or error also counts: the next receive reports it
+        if (entries[w].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ready[index[w]] = 1;
+            readable++;
+        }
+    }
+    return readable;
+}
+
+void freeMsgBuffer(MsgBuffer *buffer) {
+    if (buffer == NULL) return;
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
@@ -0,0 +1,122 @@
+#ifndef MSGSOCKET_H
+#define MSGSOCKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "errorcode.h"
+
+// Framed messages over TCP for the distributed scenario runners
+// Every message is an 8-byte header (uint32 type, uint32 payload size, little-endian)
+// followed by the payload. Sends and receives are blocking and always move whole
+// messages; waitMsgSockets tells which connections have a message (or a hang-up) waiting,
+// so one thread can serve many peers. Network failures return ERROR_CALLBACK_FAILED.
+
+#define MSG_HEADER_SIZE 8
+#define MSG_MAX_PAYLOAD (256u * 1024u * 1024u)  // Larger frames are rejected as corrupt
+#define MSG_WAIT_MAX_SOCKETS 1024                // Sockets one waitMsgSockets call can watch
+
+#ifdef _WIN32
+typedef uintptr_t MsgSocket;   // SOCKET
+#else
+typedef int MsgSocket;
+#endif
+#define MSG_SOCKET_INVALID ((MsgSocket)-1)
+
+// One piece of a message payload (sendMessageParts)
+typedef struct {
+    const void *data;
+    size_t size;
+} MsgPart;
+
+// Receive buffer, grown as needed and reused between messages (free with freeMsgBuffer)
+typedef struct {
+    unsigned char *data;
+    size_t size;       // Payload size of the last message
+    size_t capacity;
+} MsgBuffer;
+
+// Start the socket layer (WSAStartup on Windows; broken pipes become errors, not signals)
+// Returns: ERROR_SUCCESS or ERROR_CALLBACK_FAILED
+ErrorCode initMsgSockets(void);
+
+// Stop the socket layer (after every socket is closed)
+void cleanupMsgSockets(void);
+
+// Listen for connections on a TCP port of every local interface
+// Parameters:
+//   port: TCP port (1-65535)
+//   listener: pointer to store the listening socket
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER, ERROR_INVALID_PARAMETER (port) or
+//          ERROR_CALLBACK_FAILED (port in use or not permitted)
+ErrorCode listenMsgSocket(int port, MsgSocket *listener);
+
+// Accept one pending connection
+// Parameters:
+//   listener: listening socket (readable according to waitMsgSockets)
+//   connection: pointer to store the connected socket
+//   peer: optional buffer for the peer address ("host:port"), may be NULL
+//   peerSize: size of peer
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_CALLBACK_FAILED
+ErrorCode acceptMsgSocket(MsgSocket listener, MsgSocket *connection, char *peer, size_t peerSize);
+
+// Connect to a listening peer
+// Parameters:
+//   host: host name or address
+//   port: TCP port
+//   connection: pointer to store the connected socket
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER, ERROR_INVALID_PARAMETER (port) or
+//          ERROR_CALLBACK_FAILED (host unknown or not listening)
+ErrorCode connectMsgSocket(const char *host, int port, MsgSocket *connection);
+
+// Limit how long a send or receive may block once started (0 = no limit)
+// Parameters:
+//   socket: connected socket
+//   timeoutMs: timeout in milliseconds
+// Returns: ERROR_SUCCESS or ERROR_CALLBACK_FAILED
+ErrorCode setMsgSocketTimeout(MsgSocket socket, int timeoutMs);
+
+// Send one message
+// Parameters:
+//   socket: connected socket
+//   type: message type
+//   payload: payload bytes (may be NULL when size is 0)
+//   size: payload size (at most MSG_MAX_PAYLOAD)
+// Returns: ERROR_SUCCESS, ERROR_INVALID_PARAMETER (too large) or ERROR_CALLBACK_FAILED
+ErrorCode sendMessage(MsgSocket socket, uint32_t type, const void *payload, size_t size);
+
+// Send one message whose payload is the concatenation of several parts (no copy)
+// Parameters:
+//   socket: connected socket
+//   type: message type
+//   parts: payload parts in order
+//   count: number of parts
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER, ERROR_INVALID_PARAMETER (too large) or
+//          ERROR_CALLBACK_FAILED
+ErrorCode sendMessageParts(MsgSocket socket, uint32_t type, const MsgPart *parts, int count);
+
+// Receive one whole message
+// Parameters:
+//   socket: connected socket
+//   type: pointer to store the message type
+//   buffer: receives the payload (buffer->size bytes)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER (also if the buffer could not grow),
+//          ERROR_INVALID_PARAMETER (frame larger than MSG_MAX_PAYLOAD) or
+//          ERROR_CALLBACK_FAILED (closed by the peer, timeout)
+ErrorCode receiveMessage(MsgSocket socket, uint32_t *type, MsgBuffer *buffer);
+
+// Wait until at least one socket can be read (a message, a connection or a hang-up)
+// Parameters:
+//   sockets: sockets to watch (MSG_SOCKET_INVALID entries are skipped)
+//   count: number of sockets (at most MSG_WAIT_MAX_SOCKETS)
+//   timeoutMs: longest wait in milliseconds (-1 = no limit)
+//   ready: receives 1 for every readable socket, 0 otherwise (count entries)
+// Returns: number of readable sockets (0 on timeout), or -1 on error
+int waitMsgSockets(const MsgSocket *sockets, int count, int timeoutMs, int *ready);
+
+// Close a socket (MSG_SOCKET_INVALID is ignored)
+void closeMsgSocket(MsgSocket socket);
+
+// Release the memory of a receive buffer
+void freeMsgBuffer(MsgBuffer *buffer);
+
+#endif // MSGSOCKET_H
@@ -0,0 +1,90 @@
+#include "objectpool.h"
+#include <stdlib.h>
+
+// Free-list link stored in the first bytes of a cached object
+typedef struct PoolLink {
+    struct PoolLink *next;
+} PoolLink;
+
+// Hidden prefix of every object: the node whose free list it returns to
+typedef union {
+    int node;
+    long double alignLongDouble;  // Keeps the object as aligned as malloc returns it (16 bytes)
+    unsigned char padding[16];
+} PoolHeader;
+
+#define POOL_HEADER(object) ((PoolHeader*)(object) - 1)
+
+void initObjectPool(ObjectPool *pool, size_t objectSize) {
+    if (pool == NULL) return;
+    threadMutexInit(&pool->lock);
+    pool->objectSize = objectSize < sizeof(PoolLink) ? sizeof(PoolLink) : objectSize;
+    for (int n = 0; n < THREAD_MAX_NUMA_NODES; n++) pool->freeList[n] = NULL;
+    pool->cached = 0;
+    pool->allocated = 0;
+}
+
+void* takePoolObject(ObjectPool *pool) {
+    if (pool == NULL) return NULL;
+    int node = getThreadNumaNode();
+
+    threadMutexLock(&pool->lock);
+    PoolLink *object = (PoolLink*)pool->freeList[node];
+    if (object != NULL) {
+        pool->freeList[node] = object->next;
+        pool->cached--;
+        threadMutexUnlock(&pool->lock);
+        object->next = NULL;
+        return object;
+    }
+    pool->allocated++;
+    threadMutexUnlock(&pool->lock);
+
+    // Allocate outside the lock; a failure is not counted
+    PoolHeader *header = (PoolHeader*)calloc(1, sizeof(PoolHeader) + pool->objectSize);
+    if (header == NULL) {
+        threadMutexLock(&pool->lock);
+        pool->allocated--;
+        threadMutexUnlock(&pool->lock);
+        return NULL;
+    }
+    header->node = node;
+    return header + 1;
+}
+
+void returnPoolObject(ObjectPool *pool, void *object) {
+    if (pool == NULL || object == NULL) return;
+
+    PoolLink *link = (PoolLink*)object;
+    int node = POOL_HEADER(object)->node;
+    threadMutexLock(&pool->lock);
+    link->next = (PoolLink*)pool->freeList[node];
+    pool->freeList[node] = link;
+    pool->cached++;
+    threadMutexUnlock(&pool->lock);
+}
+
+size_t getObjectPoolAllocations(ObjectPool *pool) {
+    if (pool == NULL) return 0;
+    threadMutexLock(&pool->lock);
+    size_t allocated = pool->allocated;
+    threadMutexUnlock(&pool->lock);
+    return allocated;
+}
+
+void releaseObjectPool(ObjectPool *pool, void (*releaseObject)(void *object)) {
+    if (pool == NULL) return;
+
+    for (int n = 0; n < THREAD_MAX_NUMA_NODES; n++) {
+        PoolLink *object = (PoolLink*)pool->freeList[n];
+        while (object != NULL) {
+            PoolLink *next = object->next;
+            if (releaseObject != NULL) releaseObject(object);
+            free(POOL_HEADER(object));
+            object = next;
+        }
+        pool->freeList[n] = NULL;
+    }
+    pool->cached = 0;
+    threadMutexDestroy(&pool->lock);
+}
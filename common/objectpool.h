@@ -0,0 +1,54 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <stddef.h>
+#include "threads.h"
+
+// Recycling allocator for fixed-size objects shared by the simulation threads
+// Released objects go onto a free list and are handed out again by the next take, so a
+// batch that opens and closes one trace per run only allocates until the pool holds as
+// many objects as were ever in use at once; after that warm-up it never calls malloc.
+// The cached objects are freed by releaseObjectPool.
+// Objects remember the NUMA node hint (threads.h) of the thread that allocated them and are
+// recycled through that node's free list, so a worker pinned to a node gets back objects
+// (and the buffers they reference) whose pages were first touched on its own node.
+
+typedef struct {
+    ThreadMutex lock;
+    size_t objectSize;
+    void *freeList[THREAD_MAX_NUMA_NODES];  // Recycled objects per node, linked through their first bytes
+    size_t cached;           // Objects on the free lists
+    size_t allocated;        // Objects taken from the heap since initObjectPool
+} ObjectPool;
+
+// Set up an empty pool
+// Parameters:
+//   pool: pool to initialize
+//   objectSize: bytes per object (at least sizeof(void*))
+void initObjectPool(ObjectPool *pool, size_t objectSize);
+
+// Take an object: a recycled one of the caller's node, or a new zero-filled one from the heap
+// A recycled object keeps its previous contents except the first sizeof(void*) bytes,
+// which held the free-list link, so buffers referenced by the object can be reused too.
+// Parameters:
+//   pool: initialized pool
+// Returns: the object, or NULL if the allocation failed
+void* takePoolObject(ObjectPool *pool);
+
+// Put an object back on the free list (NULL is ignored)
+// Parameters:
+//   pool: pool the object was taken from
+//   object: object to recycle
+void returnPoolObject(ObjectPool *pool, void *object);
+
+// Number of objects the pool has taken from the heap (constant once the pool is warm)
+size_t getObjectPoolAllocations(ObjectPool *pool);
+
+// Free every cached object
+// Objects still in use are not tracked and stay valid; return them before releasing.
+// Parameters:
+//   pool: pool to release (initialize it again before reuse)
+//   releaseObject: optional, called on each cached object before it is freed
+void releaseObjectPool(ObjectPool *pool, void (*releaseObject)(void *object));
+
+#endif // OBJECTPOOL_H
@@ -0,0 +1,104 @@
+#include "onlinestats.h"
+#include <math.h>
+#include <string.h>
+#include <stddef.h>
+
+// Bucket i holds values in (gamma^(i-1+offset), gamma^(i+offset)], gamma = (1+a)/(1-a)
+#define SKETCH_GAMMA ((1.0 + QUANTILE_SKETCH_ACCURACY) / (1.0 - QUANTILE_SKETCH_ACCURACY))
+
+// Constant expressions: folded by the compiler
+static double sketchLogGamma(void) {
+    return log(SKETCH_GAMMA);
+}
+
+static int sketchOffset(void) {
+    return (int)ceil(log(QUANTILE_SKETCH_MIN_VALUE) / sketchLogGamma());
+}
+
+void initOnlineStats(OnlineStats *stats) {
+    if (stats == NULL) return;
+    stats->count = 0;
+    stats->mean = 0.0;
+    stats->m2 = 0.0;
+    stats->min = INFINITY;
+    stats->max = -INFINITY;
+}
+
+void addOnlineSample(OnlineStats *stats, double value) {
+    if (stats == NULL) return;
+    stats->count++;
+    double delta = value - stats->mean;
+    stats->mean += delta / (double)stats->count;
+    stats->m2 += delta * (value - stats->mean);
+    if (value < stats->min) stats->min = value;
+    if (value > stats->max) stats->max = value;
+}
+
+void mergeOnlineStats(OnlineStats *into, const OnlineStats *from) {
+    if (into == NULL || from == NULL || from->count == 0) return;
+    if (into->count == 0) {
+        *into = *from;
+        return;
+    }
+    double n1 = (double)into->count;
+    double n2 = (double)from->count;
+    double n = n1 + n2;
+    double delta = from->mean - into->mean;
+    into->mean += delta * n2 / n;
+    into->m2 += from->m2 + delta * delta * n1 * n2 / n;
+    into->count += from->count;
+    if (from->min < into->min) into->min = from->min;
+    if (from->max > into->max) into->max = from->max;
+}
+
+double getOnlineVariance(const OnlineStats *stats) {
+    if (stats == NULL || stats->count < 2) return 0.0;
+    return stats->m2 / (double)(stats->count - 1);
+}
+
+void initQuantileSketch(QuantileSketch *sketch) {
+    if (sketch == NULL) return;
+    memset(sketch, 0, sizeof(*sketch));
+}
+
+void addSketchSample(QuantileSketch *sketch, double value) {
+    if (sketch == NULL) return;
+    sketch->count++;
+    if (!(value >= QUANTILE_SKETCH_MIN_VALUE)) {  // Also catches NaN
+        sketch->zeroCount++;
+        return;
+    }
+    int index = (int)ceil(log(value) / sketchLogGamma()) - sketchOffset();
+    if (index < 0) index = 0;
+    if (index >= QUANTILE_SKETCH_BUCKETS) index = QUANTILE_SKETCH_BUCKETS - 1;
+    sketch->buckets[index]++;
+}
+
+void mergeQuantileSketch(QuantileSketch *into, const QuantileSketch *from) {
+    if (into == NULL || from == NULL) return;
+    into->count += from->count;
+    into->zeroCount += from->zeroCount;
+    for (int i = 0; i < QUANTILE_SKETCH_BUCKETS; i++) {
+        into->buckets[i] += from->buckets[i];
+    }
+}
+
+double getSketchQuantile(const QuantileSketch *sketch, double q) {
+    if (sketch == NULL || sketch->count == 0) return 0.0;
+    if (q < 0.0) q = 0.0;
+    if (q > 1.0) q = 1.0;
+
+    // Rank of the requested sample (0-based), then walk the buckets up to it
+    uint64_t rank = (uint64_t)(q * (double)(sketch->count - 1));
+    if (rank < sketch->zeroCount) return 0.0;
+    uint64_t seen = sketch->zeroCount;
+    for (int i = 0; i < QUANTILE_SKETCH_BUCKETS; i++) {
+        seen += sketch->buckets[i];
+        if (seen > rank) {
+            // Midpoint (in relative terms) of the bucket's value range
+            double upper = exp((double)(i + sketchOffset()) * sketchLogGamma());
+            return 2.0 * upper / (SKETCH_GAMMA + 1.0);
+        }
+    }
+    return exp((double)(QUANTILE_SKETCH_BUCKETS - 1 + sketchOffset()) * sketchLogGamma());
+}
@@ -0,0 +1,60 @@
+#ifndef ONLINESTATS_H
+#define ONLINESTATS_H
+
+#include <stdint.h>
+
+// Streaming statistics for Monte Carlo batches
+// OnlineStats keeps count/mean/variance (Welford) and min/max; QuantileSketch keeps a
+// log-bucketed histogram with bounded relative error (DDSketch-style). Both are updated
+// one sample at a time in O(1) and merged exactly, so every worker can keep its own
+// copy and the copies are combined once at the end without locks.
+
+typedef struct {
+    uint64_t count;
+    double mean;
+    double m2;      // Sum of squared deviations from the mean
+    double min;
+    double max;
+} OnlineStats;
+
+#define QUANTILE_SKETCH_ACCURACY 0.01   // Relative error of a quantile (1%)
+#define QUANTILE_SKETCH_MIN_VALUE 1e-6  // Samples below count as zero
+#define QUANTILE_SKETCH_BUCKETS 1536    // Covers QUANTILE_SKETCH_MIN_VALUE to ~1e7 at 1% accuracy
+
+// Quantile sketch for non-negative samples (negative samples count as zero,
+// samples above the covered range go to the last bucket)
+typedef struct {
+    uint64_t count;
+    uint64_t zeroCount;
+    uint32_t buckets[QUANTILE_SKETCH_BUCKETS];
+} QuantileSketch;
+
+// Reset to an empty set of samples
+void initOnlineStats(OnlineStats *stats);
+
+// Add one sample
+void addOnlineSample(OnlineStats *stats, double value);
+
+// Add the samples of another set (Chan et al. pairwise update)
+void mergeOnlineStats(OnlineStats *into, const OnlineStats *from);
+
+// Sample variance (0 with fewer than two samples)
+double getOnlineVariance(const OnlineStats *stats);
+
+// Reset to an empty sketch
+void initQuantileSketch(QuantileSketch *sketch);
+
+// Add one sample
+void addSketchSample(QuantileSketch *sketch, double value);
+
+// Add the samples of another sketch
+void mergeQuantileSketch(QuantileSketch *into, const QuantileSketch *from);
+
+// Estimate a quantile
+// Parameters:
+//   sketch: sketch to query
+//   q: quantile in [0, 1] (0.5 = median)
+// Returns: estimate within QUANTILE_SKETCH_ACCURACY relative error (0 for an empty sketch)
+double getSketchQuantile(const QuantileSketch *sketch, double q);
+
+#endif // ONLINESTATS_H
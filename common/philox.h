@@ -0,0 +1,57 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <stdint.h>
+
+// Philox4x32-10 counter-based random number generator (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3", SC'11)
+// The output is a pure function of (counter, key): scenario k of a batch uses counter k and
+// the batch seed as key, so any range of a batch can be generated on any thread, in any
+// order, with identical results. scripts/generate_random_scenarios.py implements the same
+// function bit for bit.
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+// Four 32-bit outputs of one counter value
+typedef struct {
+    uint32_t v[4];
+} PhiloxBlock;
+
+// Generate the block for a 128-bit counter (two 64-bit halves) and a 64-bit key
+// Parameters:
+//   counter: low 64 bits of the counter (e.g. the scenario index)
+//   stream: high 64 bits of the counter (independent sub-streams, 0 by default)
+//   key: generator key (e.g. the batch seed)
+// Returns: four independent uniformly distributed 32-bit values
+static inline PhiloxBlock philox4x32(uint64_t counter, uint64_t stream, uint64_t key) {
+    uint32_t c0 = (uint32_t)counter, c1 = (uint32_t)(counter >> 32);
+    uint32_t c2 = (uint32_t)stream, c3 = (uint32_t)(stream >> 32);
+    uint32_t k0 = (uint32_t)key, k1 = (uint32_t)(key >> 32);
+    for (int round = 0; round < PHILOX_ROUNDS; round++) {
+        if (round > 0) {
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+    }
+    PhiloxBlock block = {{c0, c1, c2, c3}};
+    return block;
+}
+
+// Map a 32-bit output to a double in [0, 1)
+static inline double philoxUniform(uint32_t value) {
+    return (double)value * (1.0 / 4294967296.0);
+}
+
+#endif // PHILOX_H
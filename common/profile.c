@@ -0,0 +1,130 @@
+#include "profile.h"
+
+int isProfilingEnabled(void) {
+#ifdef ACS_PROFILE
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+#ifdef ACS_PROFILE
+
+#include <stdio.h>
+#include <string.h>
+#include "threads.h"
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+PROFILE_THREAD_LOCAL ProfileCounters profileThreadCounters;
+
+static const char *const sectionNames[PROFILE_SECTION_COUNT] = {
+    "step", "controller", "model", "trace_append", "trace_close"
+};
+
+static const char *const counterNames[PROFILE_COUNTER_COUNT] = {
+    "saturations", "controller_errors", "step_errors"
+};
+
+// Report file and the total of the ended runs (lock held by endProfileRun)
+static struct {
+    ThreadMutex lock;
+    FILE *file;
+    char suite[64];
+    ProfileCounters total;
+    uint64_t runs;
+    int open;
+} profileReport;
+
+uint64_t readProfileClock(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static const char* getProfileTickUnit(void) {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+// One report line (the caller holds the lock)
+// runs < 0: a line of one run
+static void writeProfileLine(const char *name, long long runs, const ProfileCounters *counters) {
+    FILE *f = profileReport.file;
+    fprintf(f, "{\"suite\":\"%s\",\"run\":\"%s\",", profileReport.suite, name);
+    if (runs >= 0) fprintf(f, "\"runs\":%lld,", runs);
+    fprintf(f, "\"tick_unit\":\"%s\",\"sample_interval\":%d,\"sections\":{",
+            getProfileTickUnit(), PROFILE_SAMPLE_INTERVAL);
+    for (int s = 0; s < PROFILE_SECTION_COUNT; s++) {
+        double perCall = counters->sampled[s] > 0 ? (double)counters->ticks[s] / (double)counters->sampled[s] : 0.0;
+        fprintf(f, "%s\"%s\":{\"calls\":%llu,\"sampled\":%llu,\"ticks\":%llu,\"ticks_per_call\":%.1f}",
+                s == 0 ? "" : ",", sectionNames[s], (unsigned long long)counters->calls[s],
+                (unsigned long long)counters->sampled[s], (unsigned long long)counters->ticks[s], perCall);
+    }
+    fputc('}', f);
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) {
+        fprintf(f, ",\"%s\":%llu", counterNames[c], (unsigned long long)counters->counters[c]);
+    }
+    fputs("}\n", f);
+}
+
+ErrorCode openProfileReport(const char *path, const char *suite) {
+    if (path == NULL || suite == NULL) return ERROR_NULL_POINTER;
+    if (profileReport.open) return ERROR_INVALID_PARAMETER;
+
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return ERROR_CALLBACK_FAILED;
+    threadMutexInit(&profileReport.lock);
+    profileReport.file = file;
+    snprintf(profileReport.suite, sizeof(profileReport.suite), "%s", suite);
+    memset(&profileReport.total, 0, sizeof(profileReport.total));
+    profileReport.runs = 0;
+    profileReport.open = 1;
+    return ERROR_SUCCESS;
+}
+
+void beginProfileRun(void) {
+    memset(&profileThreadCounters, 0, sizeof(profileThreadCounters));
+}
+
+void endProfileRun(const char *name) {
+    if (!profileReport.open) return;
+    const ProfileCounters *run = &profileThreadCounters;
+
+    threadMutexLock(&profileReport.lock);
+    writeProfileLine(name != NULL ? name : "", -1, run);
+    for (int s = 0; s < PROFILE_SECTION_COUNT; s++) {
+        profileReport.total.calls[s] += run->calls[s];
+        profileReport.total.sampled[s] += run->sampled[s];
+        profileReport.total.ticks[s] += run->ticks[s];
+    }
+    for (int c = 0; c < PROFILE_COUNTER_COUNT; c++) {
+        profileReport.total.counters[c] += run->counters[c];
+    }
+    profileReport.runs++;
+    threadMutexUnlock(&profileReport.lock);
+}
+
+void closeProfileReport(void) {
+    if (!profileReport.open) return;
+    writeProfileLine("total", (long long)profileReport.runs, &profileReport.total);
+    fclose(profileReport.file);
+    threadMutexDestroy(&profileReport.lock);
+    profileReport.file = NULL;
+    profileReport.open = 0;
+}
+
+#endif // ACS_PROFILE
@@ -0,0 +1,125 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include "errorcode.h"
+
+// Hot-path profiling counters (instrumentation build: cmake -DACS_PROFILE=ON)
+// Each thread counts into its own ProfileCounters, so the hot path takes no lock:
+//   - calls of every section, and the ticks (TSC cycles on x86, else nanoseconds) of every
+//     PROFILE_SAMPLE_INTERVAL-th call; ticks / sampled is the mean cost of a call
+//   - saturation hits of the plant input (max_force, max_inflow), controller-callback errors
+//     and failed steps
+// A runner brackets each run with beginProfileRun / endProfileRun; endProfileRun writes the
+// counters of the run as one JSON line and adds them to the total that closeProfileReport
+// writes last:
+//   {"suite":"water_tank","run":"PID_Controller","tick_unit":"cycles","sample_interval":64,
+//    "sections":{"step":{"calls":4000,"sampled":63,"ticks":50211,"ticks_per_call":797.0},...},
+//    "saturations":12,"controller_errors":0,"step_errors":0}
+//   {"suite":"water_tank","run":"total","runs":8,...}
+// Without ACS_PROFILE every macro and report function below compiles to nothing.
+
+#define PROFILE_SAMPLE_INTERVAL 64  // Time every 64th call of a section (power of 2)
+
+typedef enum {
+    PROFILE_STEP = 0,          // One plant step (specialized stepper or updateSystem)
+    PROFILE_CONTROLLER,        // Controller callback inside updateSystem
+    PROFILE_MODEL,             // Model callback inside updateSystem
+    PROFILE_TRACE_APPEND,      // updateRealtimePlot
+    PROFILE_TRACE_CLOSE,       // closeRealtimePlot (flush, file close, plot output)
+    PROFILE_SECTION_COUNT
+} ProfileSection;
+
+typedef enum {
+    PROFILE_SATURATIONS = 0,   // Steps with the plant input at its limit
+    PROFILE_CONTROLLER_ERRORS, // Controller callbacks that returned an error
+    PROFILE_STEP_ERRORS,       // Plant steps that returned an error
+    PROFILE_COUNTER_COUNT
+} ProfileCounter;
+
+typedef struct {
+    uint64_t calls[PROFILE_SECTION_COUNT];
+    uint64_t sampled[PROFILE_SECTION_COUNT];   // Calls timed
+    uint64_t ticks[PROFILE_SECTION_COUNT];     // Ticks of the timed calls
+    uint64_t counters[PROFILE_COUNTER_COUNT];
+} ProfileCounters;
+
+// 1 in an instrumentation build
+int isProfilingEnabled(void);
+
+#ifdef ACS_PROFILE
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILE_THREAD_LOCAL __thread
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+// Counters of the calling thread
+extern PROFILE_THREAD_LOCAL ProfileCounters profileThreadCounters;
+
+// Tick source: TSC cycles on x86, else a monotonic clock in nanoseconds
+uint64_t readProfileClock(void);
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+#define PROFILE_TICKS() ((uint64_t)__rdtsc())
+#else
+#define PROFILE_TICKS() readProfileClock()
+#endif
+
+// Count a call of a section; returns its start tick if this call is timed, else 0
+static inline uint64_t startProfileSection(ProfileSection section) {
+    uint64_t call = profileThreadCounters.calls[section]++;
+    return (call & (PROFILE_SAMPLE_INTERVAL - 1)) == 0 ? PROFILE_TICKS() : 0;
+}
+
+static inline void endProfileSection(ProfileSection section, uint64_t start) {
+    if (start == 0) return;
+    profileThreadCounters.ticks[section] += PROFILE_TICKS() - start;
+    profileThreadCounters.sampled[section]++;
+}
+
+// Time a statement as a section:  PROFILE_SECTION(PROFILE_STEP, err = step(...));
+#define PROFILE_SECTION(section, statement) do {                  \
+        uint64_t profileStart = startProfileSection(section);     \
+        statement;                                                \
+        endProfileSection(section, profileStart);                 \
+    } while (0)
+
+// Count an event when the condition holds:  PROFILE_COUNT(PROFILE_SATURATIONS, |u| >= max)
+#define PROFILE_COUNT(counter, condition) \
+    (profileThreadCounters.counters[counter] += (condition) ? 1u : 0u)
+
+// Write the report as JSON lines (one per run, then the total)
+// Parameters:
+//   path: report file
+//   suite: suite name in every line
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_CALLBACK_FAILED (cannot create path)
+ErrorCode openProfileReport(const char *path, const char *suite);
+
+// Start a run: reset the counters of the calling thread
+void beginProfileRun(void);
+
+// End a run on the calling thread: write its line and add it to the total
+// Parameters:
+//   name: run name in the report
+void endProfileRun(const char *name);
+
+// Write the total line and close the report (runs must have ended)
+void closeProfileReport(void);
+
+#else
+
+#define PROFILE_SECTION(section, statement) do { statement; } while (0)
+#define PROFILE_COUNT(counter, condition) ((void)0)
+#define openProfileReport(path, suite) ((void)(path), (void)(suite), ERROR_SUCCESS)
+#define beginProfileRun() ((void)0)
+#define endProfileRun(name) ((void)0)
+#define closeProfileReport() ((void)0)
+
+#endif // ACS_PROFILE
+
+#endif // PROFILE_H
@@ -0,0 +1,190 @@
+#include "rtloop.h"
+#include "threads.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+#define RT_REPORT_SIZE 4096
+
+// Monotonic clock in nanoseconds
+static long long nowNs(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (long long)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+// log2 bucket of a duration in microseconds
+static int histogramBin(double us) {
+    int bin = 0;
+    double upper = 1.0;
+    while (us >= upper && bin < RT_HISTOGRAM_BINS - 1) {
+        upper *= 2.0;
+        bin++;
+    }
+    return bin;
+}
+
+ErrorCode setRealtimeThreadPolicy(int cpu, int fifoPriority) {
+    int failed = cpu >= 0 && !pinCurrentThread(cpu);
+#ifdef _WIN32
+    if (fifoPriority > 0 && !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+        failed = 1;
+    }
+#else
+    if (fifoPriority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = fifoPriority;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) failed = 1;
+    }
+#endif
+    return failed ? ERROR_CALLBACK_FAILED : ERROR_SUCCESS;
+}
+
+ErrorCode initRealtimeLoop(RealtimeLoop *loop, double period) {
+    if (loop == NULL) return ERROR_NULL_POINTER;
+    if (period <= 0.0) return ERROR_INVALID_PARAMETER;
+
+    memset(loop, 0, sizeof(*loop));
+    loop->periodNs = (long long)(period * 1e9 + 0.5);
+#ifdef _WIN32
+    loop->timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (loop->timer == NULL) {
+        // Older Windows: regular timer (resolution follows the system tick)
+        loop->timer = CreateWaitableTimerW(NULL, TRUE, NULL);
+    }
+    if (loop->timer == NULL) return ERROR_CALLBACK_FAILED;
+#endif
+    loop->stepStartNs = nowNs();
+    loop->nextDeadlineNs = loop->stepStartNs + loop->periodNs;
+    return ERROR_SUCCESS;
+}
+
+// Sleep until an absolute monotonic time
+static void sleepUntil(RealtimeLoop *loop, long long deadlineNs) {
+#ifdef _WIN32
+    long long remaining = deadlineNs - nowNs();
+    if (remaining <= 0) return;
+    LARGE_INTEGER due;
+    due.QuadPart = -(remaining / 100);  // Relative, in 100 ns units
+    if (SetWaitableTimer(loop->timer, &due, 0, NULL, NULL, FALSE)) {
+        WaitForSingleObject(loop->timer, INFINITE);
+    }
+#else
+    (void)loop;
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadlineNs / 1000000000LL);
+    ts.tv_nsec = (long)(deadlineNs % 1000000000LL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) { }
+#endif
+}
+
+ErrorCode waitRealtimePeriod(RealtimeLoop *loop) {
+    if (loop == NULL) return ERROR_NULL_POINTER;
+
+    RealtimeStats *stats = &loop->stats;
+    long long now = nowNs();
+    double computeUs = (double)(now - loop->stepStartNs) / 1000.0;
+    stats->steps++;
+    stats->totalComputeUs += computeUs;
+    if (computeUs > stats->maxComputeUs) stats->maxComputeUs = computeUs;
+    stats->computeHistogram[histogramBin(computeUs)]++;
+
+    if (now >= loop->nextDeadlineNs) {
+        // Overrun: skip the periods already missed and keep the original phase
+        stats->missedDeadlines++;
+        long long behind = now - loop->nextDeadlineNs;
+        loop->nextDeadlineNs += (behind / loop->periodNs + 1) * loop->periodNs;
+    }
+
+    sleepUntil(loop, loop->nextDeadlineNs);
+
+    long long wake = nowNs();
+    double latencyUs = (double)(wake - loop->nextDeadlineNs) / 1000.0;
+    if (latencyUs < 0.0) latencyUs = 0.0;  // Some timers wake marginally early
+    stats->totalLatencyUs += latencyUs;
+    if (latencyUs > stats->maxLatencyUs) stats->maxLatencyUs = latencyUs;
+    stats->latencyHistogram[histogramBin(latencyUs)]++;
+
+    loop->stepStartNs = wake;
+    loop->nextDeadlineNs += loop->periodNs;
+    return ERROR_SUCCESS;
+}
+
+void closeRealtimeLoop(RealtimeLoop *loop) {
+    if (loop == NULL) return;
+#ifdef _WIN32
+    if (loop->timer) CloseHandle(loop->timer);
+    loop->timer = NULL;
+#endif
+}
+
+void mergeRealtimeStats(RealtimeStats *total, const RealtimeStats *stats) {
+    if (total == NULL || stats == NULL) return;
+
+    total->steps += stats->steps;
+    total->missedDeadlines += stats->missedDeadlines;
+    total->totalComputeUs += stats->totalComputeUs;
+    total->totalLatencyUs += stats->totalLatencyUs;
+    if (stats->maxComputeUs > total->maxComputeUs) total->maxComputeUs = stats->maxComputeUs;
+    if (stats->maxLatencyUs > total->maxLatencyUs) total->maxLatencyUs = stats->maxLatencyUs;
+    for (int b = 0; b < RT_HISTOGRAM_BINS; b++) {
+        total->computeHistogram[b] += stats->computeHistogram[b];
+        total->latencyHistogram[b] += stats->latencyHistogram[b];
+    }
+}
+
+void printRealtimeReport(FILE *out, const char *name, const RealtimeStats *stats) {
+    if (out == NULL || stats == NULL) return;
+
+    char report[RT_REPORT_SIZE];
+    size_t len = 0;
+    long steps = stats->steps > 0 ? stats->steps : 1;
+
+#define RT_APPEND(...) \
+    do { \
+        if (len < sizeof(report)) len += (size_t)snprintf(report + len, sizeof(report) - len, __VA_ARGS__); \
+    } while (0)
+
+    RT_APPEND("Real-time report: %s\n", name ? name : "");
+    RT_APPEND("  steps %ld, missed deadlines %ld (%.2f%%)\n", stats->steps, stats->missedDeadlines,
+              100.0 * (double)stats->missedDeadlines / (double)steps);
+    RT_APPEND("  compute time     mean %10.1f us, max %10.1f us\n",
+              stats->totalComputeUs / (double)steps, stats->maxComputeUs);
+    RT_APPEND("  wake-up latency  mean %10.1f us, max %10.1f us\n",
+              stats->totalLatencyUs / (double)steps, stats->maxLatencyUs);
+    RT_APPEND("  %-20s %10s %10s\n", "bucket (us)", "compute", "latency");
+    for (int b = 0; b < RT_HISTOGRAM_BINS; b++) {
+        if (stats->computeHistogram[b] == 0 && stats->latencyHistogram[b] == 0) continue;
+        long lower = b == 0 ? 0 : 1L << (b - 1);
+        if (b == RT_HISTOGRAM_BINS - 1) {
+            RT_APPEND("  [%8ld,      inf) %10ld %10ld\n", lower,
+                      stats->computeHistogram[b], stats->latencyHistogram[b]);
+        } else {
+            RT_APPEND("  [%8ld, %8ld) %10ld %10ld\n", lower, 1L << b,
+                      stats->computeHistogram[b], stats->latencyHistogram[b]);
+        }
+    }
+#undef RT_APPEND
+
+    fputs(report, out);
+    fflush(out);
+}
@@ -0,0 +1,74 @@
+#ifndef RTLOOP_H
+#define RTLOOP_H
+
+#include <stdio.h>
+#include "errorcode.h"
+
+// Fixed-rate real-time loop with deadline and jitter instrumentation
+// Each period ends with waitRealtimePeriod(), which sleeps until an absolute deadline
+// (clock_nanosleep with TIMER_ABSTIME, or a high-resolution waitable timer on Windows),
+// so compute time and wake-up jitter never accumulate into drift. Every step records its
+// compute time, its wake-up latency (actual wake - deadline) and whether it overran the
+// next deadline. The timings go into log2 histograms.
+
+// Histogram buckets in microseconds: bucket 0 = [0, 1), bucket k = [2^(k-1), 2^k),
+// the last bucket collects everything above
+#define RT_HISTOGRAM_BINS 24
+
+typedef struct {
+    long steps;
+    long missedDeadlines;                  // Steps that finished after the next deadline
+    double totalComputeUs;
+    double maxComputeUs;
+    double totalLatencyUs;
+    double maxLatencyUs;
+    long computeHistogram[RT_HISTOGRAM_BINS];
+    long latencyHistogram[RT_HISTOGRAM_BINS];
+} RealtimeStats;
+
+typedef struct {
+    long long periodNs;
+    long long nextDeadlineNs;              // Absolute monotonic time of the next wake-up
+    long long stepStartNs;                 // Wake-up time of the current step
+    RealtimeStats stats;
+#ifdef _WIN32
+    void *timer;                           // Waitable timer handle
+#endif
+} RealtimeLoop;
+
+// Pin the calling thread to a CPU and/or switch it to SCHED_FIFO
+// (Windows: affinity mask and THREAD_PRIORITY_TIME_CRITICAL)
+// Parameters:
+//   cpu: CPU index to pin to, or -1 to keep the current affinity
+//   fifoPriority: SCHED_FIFO priority (1-99), or 0 to keep the current policy
+// Returns: ErrorCode (ERROR_CALLBACK_FAILED if a setting was refused, e.g. without privileges)
+ErrorCode setRealtimeThreadPolicy(int cpu, int fifoPriority);
+
+// Start a loop; the first period begins now
+// Parameters:
+//   loop: loop to initialize
+//   period: period in seconds (> 0)
+// Returns: ErrorCode
+ErrorCode initRealtimeLoop(RealtimeLoop *loop, double period);
+
+// End the current step: record its timing and sleep until the next absolute deadline
+// After an overrun the loop skips the periods it missed and stays phase-aligned.
+// Parameters:
+//   loop: running loop
+// Returns: ErrorCode
+ErrorCode waitRealtimePeriod(RealtimeLoop *loop);
+
+// Release the loop's timer
+void closeRealtimeLoop(RealtimeLoop *loop);
+
+// Add the statistics of one loop to a total
+void mergeRealtimeStats(RealtimeStats *total, const RealtimeStats *stats);
+
+// Print a report (summary and histograms) in one write, so concurrent reports don't interleave
+// Parameters:
+//   out: output stream
+//   name: run name for the title
+//   stats: statistics to report
+void printRealtimeReport(FILE *out, const char *name, const RealtimeStats *stats);
+
+#endif // RTLOOP_H
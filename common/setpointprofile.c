@@ -0,0 +1,271 @@
+#include "setpointprofile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SETPOINT_MAX_ARGUMENTS 5  // sine: start offset amplitude period phase
+
+// Starts ascending from 0; fills in the segment ends
+static int linkSetpointSegments(SetpointSegment *segments, int count) {
+    if (count < 1 || segments[0].start != 0.0) return 0;
+    for (int k = 0; k < count; k++) {
+        if (k + 1 < count && !(segments[k + 1].start > segments[k].start)) return 0;
+        segments[k].end = k + 1 < count ? segments[k + 1].start : INFINITY;
+    }
+    return 1;
+}
+
+ErrorCode finishSetpointProfile(SetpointProfile *profile, SetpointSegment *segments, int count) {
+    if (profile == NULL || segments == NULL) return ERROR_NULL_POINTER;
+    memset(profile, 0, sizeof(*profile));
+    if (!linkSetpointSegments(segments, count)) return ERROR_INVALID_PARAMETER;
+    profile->segments = segments;
+    profile->segmentCount = count;
+    return ERROR_SUCCESS;
+}
+
+// Grow an array to hold at least `needed` elements (capacity doubles)
+static int reserveSetpointArray(void **array, int *capacity, int needed, size_t size) {
+    if (needed <= *capacity) return 1;
+    int grown = *capacity > 0 ? *capacity * 2 : 16;
+    while (grown < needed) grown *= 2;
+    void *resized = realloc(*array, (size_t)grown * size);
+    if (resized == NULL) return 0;
+    *array = resized;
+    *capacity = grown;
+    return 1;
+}
+
+// Append the numbers of a line to the sample table
+// Returns: 1, 0 on a malformed value, -1 out of memory
+static int appendSetpointSamples(SetpointProfile *profile, int *capacity, const char *text) {
+    for (;;) {
+        while (isspace((unsigned char)*text)) text++;
+        if (*text == '\0') return 1;
+        char *end;
+        double value = strtod(text, &end);
+        if (end == text || !isfinite(value)) return 0;
+        if (!reserveSetpointArray((void**)&profile->samples, capacity, profile->sampleCount + 1, sizeof(double))) {
+            return -1;
+        }
+        profile->samples[profile->sampleCount++] = value;
+        text = end;
+    }
+}
+
+// Parse "<start> <arguments>" of a segment line into a segment
+static int parseSetpointSegment(const char *type, const char *text, SetpointSegment *segment, const char **rest) {
+    double args[SETPOINT_MAX_ARGUMENTS];
+    int needed, optional = 0;
+    memset(segment, 0, sizeof(*segment));
+    if (strcmp(type, "hold") == 0) {
+        segment->type = SETPOINT_HOLD;
+        needed = 2;
+    } else if (strcmp(type, "ramp") == 0) {
+        segment->type = SETPOINT_RAMP;
+        needed = 4;
+    } else if (strcmp(type, "sine") == 0) {
+        segment->type = SETPOINT_SINE;
+        needed = 4;
+        optional = 1;
+    } else if (strcmp(type, "trajectory") == 0) {
+        segment->type = SETPOINT_TRAJECTORY;
+        needed = 2;  // Start and interval; the samples follow
+    } else {
+        return 0;
+    }
+
+    int count = 0;
+    for (;;) {
+        while (isspace((unsigned char)*text)) text++;
+        if (*text == '\0' || count == needed + optional) break;
+        char *end;
+        args[count] = strtod(text, &end);
+        if (end == text || !isfinite(args[count])) return 0;
+        count++;
+        text = end;
+    }
+    *rest = text;
+    if (count < needed || (segment->type != SETPOINT_TRAJECTORY && *text != '\0')) return 0;
+
+    segment->start = args[0];
+    switch (segment->type) {
+    case SETPOINT_HOLD:
+        segment->value = args[1];
+        break;
+    case SETPOINT_RAMP:
+        if (!(args[3] > 0.0)) return 0;
+        segment->value = args[1];
+        segment->delta = args[2] - args[1];
+        segment->rate = 1.0 / args[3];
+        break;
+    case SETPOINT_SINE:
+        if (!(args[3] > 0.0)) return 0;
+        segment->value = args[1];
+        segment->delta = args[2];
+        segment->rate = 2.0 * M_PI / args[3];
+        segment->phase = count > needed ? args[4] * M_PI / 180.0 : 0.0;
+        break;
+    case SETPOINT_TRAJECTORY:
+        if (!(args[1] > 0.0)) return 0;
+        segment->rate = 1.0 / args[1];
+        break;
+    }
+    return 1;
+}
+
+ErrorCode loadSetpointProfile(const char *path, SetpointProfile *profile, int *errorLine) {
+    if (errorLine != NULL) *errorLine = 0;
+    if (path == NULL || profile == NULL) return ERROR_NULL_POINTER;
+    memset(profile, 0, sizeof(*profile));
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return ERROR_CALLBACK_FAILED;
+
+    int segmentCapacity = 0, sampleCapacity = 0;
+    profile->owned = 1;
+    char line[SETPOINT_PROFILE_LINE_SIZE];
+    int lineNumber = 0;
+    ErrorCode result = ERROR_SUCCESS;
+    while (result == ERROR_SUCCESS && fgets(line, sizeof(line), file) != NULL) {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        char *key = line;
+        while (isspace((unsigned char)*key)) key++;
+        if (*key == '\0') continue;
+
+        SetpointSegment *last = profile->segmentCount > 0 ? &profile->segments[profile->segmentCount - 1] : NULL;
+        const char *samples = NULL;
+        if (isdigit((unsigned char)*key) || *key == '-' || *key == '+' || *key == '.') {
+            // Continuation of the last trajectory
+            if (last == NULL || last->type != SETPOINT_TRAJECTORY) {
+                result = ERROR_INVALID_PARAMETER;
+                break;
+            }
+            samples = key;
+        } else {
+            char *keyEnd = key;
+            while (*keyEnd != '\0' && !isspace((unsigned char)*keyEnd)) keyEnd++;
+            const char *text = keyEnd;
+            if (*keyEnd != '\0') {
+                *keyEnd = '\0';
+                text = keyEnd + 1;
+            }
+            SetpointSegment segment;
+            if (!parseSetpointSegment(key, text, &segment, &samples)) {
+                result = ERROR_INVALID_PARAMETER;
+                break;
+            }
+            if (!reserveSetpointArray((void**)&profile->segments, &segmentCapacity, profile->segmentCount + 1,
+                                      sizeof(SetpointSegment))) {
+                result = ERROR_NULL_POINTER;
+                break;
+            }
+            segment.firstSample = profile->sampleCount;
+            profile->segments[profile->segmentCount++] = segment;
+            last = &profile->segments[profile->segmentCount - 1];
+            if (segment.type != SETPOINT_TRAJECTORY) continue;
+        }
+
+        int appended = appendSetpointSamples(profile, &sampleCapacity, samples);
+        if (appended <= 0) {
+            result = appended < 0 ? ERROR_NULL_POINTER : ERROR_INVALID_PARAMETER;
+            break;
+        }
+        last->sampleCount = profile->sampleCount - last->firstSample;
+    }
+    fclose(file);
+
+    // Every trajectory needs a sample; the segments must form a time line
+    for (int k = 0; result == ERROR_SUCCESS && k < profile->segmentCount; k++) {
+        if (profile->segments[k].type == SETPOINT_TRAJECTORY && profile->segments[k].sampleCount < 1) {
+            result = ERROR_INVALID_PARAMETER;
+            lineNumber = 0;  // Not tied to one line
+        }
+    }
+    if (result == ERROR_SUCCESS && !linkSetpointSegments(profile->segments, profile->segmentCount)) {
+        result = ERROR_INVALID_PARAMETER;
+        lineNumber = 0;
+    }
+    if (result != ERROR_SUCCESS) {
+        freeSetpointProfile(profile);
+        if (result == ERROR_INVALID_PARAMETER && errorLine != NULL) *errorLine = lineNumber;
+    }
+    return result;
+}
+
+void freeSetpointProfile(SetpointProfile *profile) {
+    if (profile == NULL) return;
+    if (profile->owned) {
+        free(profile->segments);
+        free(profile->samples);
+    }
+    memset(profile, 0, sizeof(*profile));
+}
+
+void initSetpointCursor(SetpointCursor *cursor, const SetpointProfile *profile) {
+    if (cursor == NULL) return;
+    cursor->profile = profile;
+    cursor->segment = 0;
+}
+
+// Value of a segment at time t (t >= segment start)
+static double evaluateSetpointSegment(const SetpointProfile *profile, const SetpointSegment *segment, double t) {
+    double elapsed = t - segment->start;
+    switch (segment->type) {
+    case SETPOINT_RAMP: {
+        double progress = elapsed * segment->rate;
+        return segment->value + segment->delta * (progress < 1.0 ? progress : 1.0);
+    }
+    case SETPOINT_SINE:
+        return segment->value + segment->delta * sin(segment->rate * elapsed + segment->phase);
+    case SETPOINT_TRAJECTORY: {
+        // Direct index into the samples: no search
+        const double *samples = profile->samples + segment->firstSample;
+        double position = elapsed * segment->rate;
+        int last = segment->sampleCount - 1;
+        if (position >= (double)last) return samples[last];
+        int k = (int)position;
+        return samples[k] + (samples[k + 1] - samples[k]) * (position - (double)k);
+    }
+    case SETPOINT_HOLD:
+    default:
+        return segment->value;
+    }
+}
+
+double advanceSetpointCursor(SetpointCursor *cursor, double t) {
+    const SetpointProfile *profile = cursor->profile;
+    const SetpointSegment *segments = profile->segments;
+    int k = cursor->segment;
+    if (t < segments[k].start) k = 0;
+    while (t >= segments[k].end) k++;  // The last segment never ends
+    cursor->segment = k;
+    return evaluateSetpointSegment(profile, &segments[k], t < 0.0 ? 0.0 : t);
+}
+
+double getSetpointHoldEnd(const SetpointCursor *cursor, double t) {
+    const SetpointSegment *segment = &cursor->profile->segments[cursor->segment];
+    switch (segment->type) {
+    case SETPOINT_HOLD:
+        return segment->end;
+    case SETPOINT_RAMP:
+        return (t - segment->start) * segment->rate >= 1.0 ? segment->end : t;
+    case SETPOINT_TRAJECTORY:
+        return (t - segment->start) * segment->rate >= (double)(segment->sampleCount - 1) ? segment->end : t;
+    case SETPOINT_SINE:
+    default:
+        return segment->delta == 0.0 ? segment->end : t;
+    }
+}
+
+double getSetpointSegmentEnd(const SetpointCursor *cursor) {
+    return cursor->profile->segments[cursor->segment].end;
+}
@@ -0,0 +1,95 @@
+#ifndef SETPOINTPROFILE_H
+#define SETPOINTPROFILE_H
+
+#include "errorcode.h"
+
+// Setpoint profiles: a time line of segments evaluated by a cursor, loadable from a text file
+// One segment per line, "<type> <start> <arguments>", '#' starts a comment:
+//   hold       0    70                 # constant 70 from t = 0 s
+//   ramp       12   20 90 6            # 20 -> 90 over 6 s, then 90 until the next segment
+//   sine       24   50 10 8 90         # 50 + 10 sin(2 pi (t - 24) / 8 + 90 deg), phase optional
+//   trajectory 36   0.5 50 52 55 57    # samples every 0.5 s, linear in between, last one held
+//              60 62 65                # lines starting with a number add trajectory samples
+// Segments start in ascending order, the first one at t = 0; each lasts until the next one
+// starts (the last one forever). A profile is read-only once loaded, so any number of runs
+// and threads can share it; each run steps through it with its own SetpointCursor.
+
+#define SETPOINT_PROFILE_LINE_SIZE 512
+
+typedef enum {
+    SETPOINT_HOLD = 0,     // Constant value
+    SETPOINT_RAMP,         // Linear from value to value + delta over 1 / rate s, then held
+    SETPOINT_SINE,         // value + delta * sin(rate * (t - start) + phase)
+    SETPOINT_TRAJECTORY    // Recorded samples every 1 / rate s, linearly interpolated
+} SetpointSegmentType;
+
+typedef struct {
+    SetpointSegmentType type;
+    double start;          // Segment start (s)
+    double end;            // Start of the next segment (s), INFINITY for the last one
+    double value;          // hold: setpoint; ramp: start value; sine: offset
+    double delta;          // ramp: end value - start value; sine: amplitude
+    double rate;           // ramp: 1 / duration; sine: angular frequency (rad/s); trajectory: 1 / interval
+    double phase;          // sine: phase (rad)
+    int firstSample;       // trajectory: index of the first sample in the profile's sample table
+    int sampleCount;       // trajectory: number of samples (>= 1)
+} SetpointSegment;
+
+// Constant segment for built-in profiles (end is filled in by finishSetpointProfile)
+#define SETPOINT_HOLD_SEGMENT(start, value) { SETPOINT_HOLD, (start), 0.0, (value), 0.0, 0.0, 0.0, 0, 0 }
+
+typedef struct {
+    SetpointSegment *segments;
+    int segmentCount;
+    double *samples;       // Trajectory samples of every trajectory segment
+    int sampleCount;
+    int owned;             // Arrays allocated by loadSetpointProfile (released by freeSetpointProfile)
+} SetpointProfile;
+
+// Position of one run in a profile
+typedef struct {
+    const SetpointProfile *profile;
+    int segment;           // Active segment
+} SetpointCursor;
+
+// Wrap a segment array (e.g. a static built-in profile) and fill in the segment ends
+// Parameters:
+//   profile: profile to initialize (not owning the array)
+//   segments: segments in ascending start order, the first at t = 0
+//   count: number of segments (> 0)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER or ERROR_INVALID_PARAMETER (starts out of order)
+ErrorCode finishSetpointProfile(SetpointProfile *profile, SetpointSegment *segments, int count);
+
+// Load a profile from a profile file
+// Parameters:
+//   path: profile file
+//   profile: receives the profile (release with freeSetpointProfile)
+//   errorLine: optional, receives the offending line number on ERROR_INVALID_PARAMETER (else 0)
+// Returns: ERROR_SUCCESS, ERROR_NULL_POINTER (also out of memory), ERROR_CALLBACK_FAILED (file
+//          cannot be read) or ERROR_INVALID_PARAMETER (unknown type, wrong argument count,
+//          non-positive duration/period/interval, starts out of order or not starting at 0)
+ErrorCode loadSetpointProfile(const char *path, SetpointProfile *profile, int *errorLine);
+
+// Release the arrays of a loaded profile (no-op for profiles wrapping a caller array)
+void freeSetpointProfile(SetpointProfile *profile);
+
+// Start a cursor at t = 0
+void initSetpointCursor(SetpointCursor *cursor, const SetpointProfile *profile);
+
+// Setpoint at time t
+// Moving forward in time costs O(1) per call (the cursor steps over the segments that ended);
+// a time before the active segment rewinds the cursor to the start (resumed and forked runs).
+// Parameters:
+//   cursor: initialized cursor
+//   t: time (s)
+// Returns: the setpoint
+double advanceSetpointCursor(SetpointCursor *cursor, double t);
+
+// End of the constant stretch the cursor is in at time t (after advanceSetpointCursor(t))
+// Returns: the time the setpoint next changes (INFINITY if never), or t while it is changing
+double getSetpointHoldEnd(const SetpointCursor *cursor, double t);
+
+// End of the active segment (s), INFINITY for the last one
+double getSetpointSegmentEnd(const SetpointCursor *cursor);
+
+#endif // SETPOINTPROFILE_H
@@ -0,0 +1,54 @@
+#include "stopcriteria.h"
+#include <math.h>
+#include <stddef.h>
+
+void resetStopMonitor(StopMonitor *monitor) {
+    if (monitor == NULL) return;
+    monitor->settledFor = 0.0;
+    monitor->saturatedFor = 0.0;
+    monitor->previousOutput = 0.0;
+    monitor->hasPrevious = 0;
+}
+
+StopReason updateStopMonitor(StopMonitor *monitor, const StopCriteria *criteria,
+                             double error, double output, double control, double dt) {
+    if (monitor == NULL || criteria == NULL || dt <= 0.0) return STOP_NONE;
+
+    if (criteria->divergenceLimit > 0.0 && fabs(error) > criteria->divergenceLimit) {
+        return STOP_DIVERGED;
+    }
+
+    if (criteria->saturationLimit > 0.0 && criteria->saturationTime > 0.0) {
+        if (fabs(control) >= criteria->saturationLimit) {
+            monitor->saturatedFor += dt;
+            if (monitor->saturatedFor >= criteria->saturationTime) return STOP_SATURATED;
+        } else {
+            monitor->saturatedFor = 0.0;
+        }
+    }
+
+    if (criteria->settleTolerance > 0.0 && criteria->settleTime > 0.0) {
+        // At rest needs a previous output to estimate the rate
+        double rate = monitor->hasPrevious ? fabs(output - monitor->previousOutput) / dt : INFINITY;
+        int atRest = criteria->restRate <= 0.0 || rate <= criteria->restRate;
+        if (fabs(error) <= criteria->settleTolerance && atRest) {
+            monitor->settledFor += dt;
+        } else {
+            monitor->settledFor = 0.0;
+        }
+        monitor->previousOutput = output;
+        monitor->hasPrevious = 1;
+        if (monitor->settledFor >= criteria->settleTime) return STOP_SETTLED;
+    }
+    return STOP_NONE;
+}
+
+const char* getStopReasonName(StopReason reason) {
+    switch (reason) {
+    case STOP_SETTLED:   return "settled";
+    case STOP_DIVERGED:  return "diverged";
+    case STOP_SATURATED: return "saturated";
+    case STOP_NONE:
+    default:             return "none";
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef STOPCRITERIA_H
+#define STOPCRITERIA_H
+
+// Early-termination criteria for closed-loop runs (plant-agnostic, like the controllers)
+// updateStopMonitor() is called once per step with the control error, the plant output and
+// the control signal; it reports when the run can stop:
+//   settled:   |error| <= settleTolerance and |d output / dt| <= restRate for settleTime seconds
+//   diverged:  |error| > divergenceLimit
+//   saturated: |control| >= saturationLimit for saturationTime seconds (unrecoverable streak)
+
+typedef enum {
+    STOP_NONE = 0,    // Keep running
+    STOP_SETTLED,     // Plant settled at the setpoint and at rest
+    STOP_DIVERGED,    // Error beyond the divergence limit
+    STOP_SATURATED    // Control signal saturated for too long
+} StopReason;
+
+// Criteria; a limit <= 0 disables the corresponding check
+typedef struct {
+    double settleTolerance;   // Settled band around the setpoint (output units)
+    double settleTime;        // Time the plant must stay settled (s)
+    double restRate;          // Maximum |d output / dt| counted as at rest (output units/s)
+    double divergenceLimit;   // |error| above this stops the run
+    double saturationLimit;   // |control| at or above this counts as saturated
+    double saturationTime;    // Saturation streak that stops the run (s)
+} StopCriteria;
+
+// Running state of the criteria for one simulation
+typedef struct {
+    double settledFor;        // Consecutive time settled (s)
+    double saturatedFor;      // Consecutive time saturated (s)
+    double previousOutput;
+    int hasPrevious;
+} StopMonitor;
+
+// Reset the monitor (start of a run, or after the setpoint changed)
+void resetStopMonitor(StopMonitor *monitor);
+
+// Update the monitor with one step
+// Parameters:
+//   monitor: monitor state
+//   criteria: stop criteria
+//   error: control error (setpoint - output)
+//   output: plant output after the step
+//   control: control signal applied in the step
+//   dt: time step (s)
+// Returns: STOP_NONE, or the criterion that fired
+StopReason updateStopMonitor(StopMonitor *monitor, const StopCriteria *criteria,
+                             double error, double output, double control, double dt);
+
+// Name of a stop reason ("none", "settled", "diverged", "saturated")
+const char* getStopReasonName(StopReason reason);
+
+#endif // STOPCRITERIA_H
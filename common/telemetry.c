@@ -0,0 +1,227 @@
+#include "telemetry.h"
+#include "threads.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TELEMETRY_CACHE_LINE 64
+
+struct TelemetryChannel {
+    // Producer-owned counters (own cache line so pushes don't bounce the consumer's line)
+    size_t head;                              // Samples pushed
+    size_t dropped;                           // Samples dropped on a full ring
+    size_t closed;                            // Set once by closeTelemetryChannel (release)
+    char padProducer[TELEMETRY_CACHE_LINE - 3 * sizeof(size_t)];
+    // Consumer-owned counter
+    size_t tail;                              // Samples drained by the viewer
+    char padConsumer[TELEMETRY_CACHE_LINE - sizeof(size_t)];
+    TelemetrySample ring[TELEMETRY_RING_CAPACITY];
+
+    // Viewer thread only
+    char name[TELEMETRY_NAME_SIZE];
+    int valueCount;
+    TelemetrySample history[TELEMETRY_HISTORY_POINTS];
+    int historyCount;
+    size_t historyStride;                     // Keep one sample out of historyStride
+    size_t samplesSeen;
+    struct TelemetryChannel *next;            // Link in the pending or active list
+};
+
+static struct {
+    ThreadMutex lock;                         // Protects pending
+    TelemetryChannel *pending;                // Opened since the last frame
+    ThreadHandle thread;
+    int running;
+    size_t stopRequested;                     // Atomic flag set by stopTelemetryViewer
+    long frameIntervalMs;
+    TelemetryFrameCallback frame;
+    void *context;
+} telemetryViewer;
+
+// Add a drained sample to the display history, halving the resolution when it is full
+static void addHistorySample(TelemetryChannel *channel, const TelemetrySample *sample) {
+    size_t index = channel->samplesSeen++;
+    if (index % channel->historyStride != 0) return;
+
+    if (channel->historyCount == TELEMETRY_HISTORY_POINTS) {
+        for (int i = 0; i < TELEMETRY_HISTORY_POINTS / 2; i++) {
+            channel->history[i] = channel->history[2 * i];
+        }
+        channel->historyCount = TELEMETRY_HISTORY_POINTS / 2;
+        channel->historyStride *= 2;
+        if (index % channel->historyStride != 0) return;
+    }
+    channel->history[channel->historyCount++] = *sample;
+}
+
+// Move every queued sample of a channel into its history
+static void drainChannel(TelemetryChannel *channel) {
+    size_t head = atomicLoadAcquire(&channel->head);
+    size_t tail = channel->tail;
+    for (; tail != head; tail++) {
+        addHistorySample(channel, &channel->ring[tail & (TELEMETRY_RING_CAPACITY - 1)]);
+    }
+    atomicStoreRelease(&channel->tail, tail);
+}
+
+// One frame: adopt new channels, drain all rings, call the frame callback, drop finished channels
+static void renderTelemetryFrame(TelemetryChannel **active, TelemetryView **views, int *viewCapacity) {
+    threadMutexLock(&telemetryViewer.lock);
+    TelemetryChannel *adopted = telemetryViewer.pending;
+    telemetryViewer.pending = NULL;
+    threadMutexUnlock(&telemetryViewer.lock);
+
+    // Keep channels in opening order (pending is a stack)
+    while (adopted) {
+        TelemetryChannel *channel = adopted;
+        adopted = channel->next;
+        TelemetryChannel **link = active;
+        while (*link) link = &(*link)->next;
+        channel->next = NULL;
+        *link = channel;
+    }
+
+    int count = 0;
+    for (TelemetryChannel *channel = *active; channel; channel = channel->next) count++;
+    if (count > *viewCapacity) {
+        TelemetryView *grown = (TelemetryView*)realloc(*views, (size_t)count * sizeof(TelemetryView));
+        if (grown == NULL) return;  // Skip this frame, retry on the next one
+        *views = grown;
+        *viewCapacity = count;
+    }
+
+    int index = 0;
+    for (TelemetryChannel *channel = *active; channel; channel = channel->next, index++) {
+        // Read closed before draining: once it is seen, every pushed sample is visible
+        int finished = atomicLoadAcquire(&channel->closed) != 0;
+        drainChannel(channel);
+
+        TelemetryView *view = &(*views)[index];
+        view->name = channel->name;
+        view->valueCount = channel->valueCount;
+        view->history = channel->history;
+        view->historyCount = channel->historyCount;
+        view->finished = finished;
+        view->dropped = (long)atomicLoadRelaxed(&channel->dropped);
+    }
+
+    if (count > 0) {
+        telemetryViewer.frame(telemetryViewer.context, *views, count);
+    }
+
+    // Finished channels have been shown for the last time
+    index = 0;
+    for (TelemetryChannel **link = active; *link; index++) {
+        TelemetryChannel *channel = *link;
+        if ((*views)[index].finished) {
+            *link = channel->next;
+            free(channel);
+        } else {
+            link = &channel->next;
+        }
+    }
+}
+
+static ThreadReturn THREAD_CALL telemetryViewerMain(void *arg) {
+    (void)arg;
+    TelemetryChannel *active = NULL;
+    TelemetryView *views = NULL;
+    int viewCapacity = 0;
+
+    for (;;) {
+        int stopping = atomicLoadAcquire(&telemetryViewer.stopRequested) != 0;
+        renderTelemetryFrame(&active, &views, &viewCapacity);
+        if (stopping) break;  // The final frame included every sample
+        // Fixed frame rate: a slow callback delays frames, never the producers
+        threadSleepMs(telemetryViewer.frameIntervalMs);
+    }
+
+    while (active) {
+        TelemetryChannel *channel = active;
+        active = channel->next;
+        free(channel);
+    }
+    free(views);
+    return THREAD_RETURN_VALUE;
+}
+
+ErrorCode startTelemetryViewer(double frameRate, TelemetryFrameCallback frame, void *context) {
+    if (frame == NULL) return ERROR_NULL_POINTER;
+    if (frameRate <= 0.0) return ERROR_INVALID_PARAMETER;
+    if (telemetryViewer.running) return ERROR_INVALID_PARAMETER;
+
+    threadMutexInit(&telemetryViewer.lock);
+    telemetryViewer.pending = NULL;
+    telemetryViewer.stopRequested = 0;
+    telemetryViewer.frameIntervalMs = (long)(1000.0 / frameRate);
+    if (telemetryViewer.frameIntervalMs < 1) telemetryViewer.frameIntervalMs = 1;
+    telemetryViewer.frame = frame;
+    telemetryViewer.context = context;
+    if (!threadCreate(&telemetryViewer.thread, telemetryViewerMain, NULL)) {
+        threadMutexDestroy(&telemetryViewer.lock);
+        return ERROR_CALLBACK_FAILED;
+    }
+    telemetryViewer.running = 1;
+    return ERROR_SUCCESS;
+}
+
+void stopTelemetryViewer(void) {
+    if (!telemetryViewer.running) return;
+
+    atomicStoreRelease(&telemetryViewer.stopRequested, (size_t)1);
+    threadJoin(telemetryViewer.thread);
+
+    // Channels opened after the final frame were never adopted
+    while (telemetryViewer.pending) {
+        TelemetryChannel *channel = telemetryViewer.pending;
+        telemetryViewer.pending = channel->next;
+        free(channel);
+    }
+    threadMutexDestroy(&telemetryViewer.lock);
+    telemetryViewer.running = 0;
+}
+
+int isTelemetryViewerRunning(void) {
+    return telemetryViewer.running;
+}
+
+ErrorCode openTelemetryChannel(const char *name, int valueCount, TelemetryChannel **channel) {
+    if (name == NULL || channel == NULL) return ERROR_NULL_POINTER;
+    *channel = NULL;
+    if (!telemetryViewer.running) return ERROR_INVALID_PARAMETER;
+    if (valueCount < 1 || valueCount > TELEMETRY_MAX_VALUES) return ERROR_INVALID_PARAMETER;
+
+    TelemetryChannel *c = (TelemetryChannel*)calloc(1, sizeof(TelemetryChannel));
+    if (c == NULL) return ERROR_NULL_POINTER;
+    strncpy(c->name, name, TELEMETRY_NAME_SIZE - 1);
+    c->valueCount = valueCount;
+    c->historyStride = 1;
+
+    threadMutexLock(&telemetryViewer.lock);
+    c->next = telemetryViewer.pending;
+    telemetryViewer.pending = c;
+    threadMutexUnlock(&telemetryViewer.lock);
+
+    *channel = c;
+    return ERROR_SUCCESS;
+}
+
+int pushTelemetrySample(TelemetryChannel *channel, double time, const double *values) {
+    if (channel == NULL || values == NULL) return 0;
+
+    size_t head = channel->head;  // Only this thread writes head
+    if (head - atomicLoadAcquire(&channel->tail) == TELEMETRY_RING_CAPACITY) {
+        atomicStoreRelaxed(&channel->dropped, channel->dropped + 1);
+        return 0;
+    }
+
+    TelemetrySample *slot = &channel->ring[head & (TELEMETRY_RING_CAPACITY - 1)];
+    slot->time = time;
+    memcpy(slot->values, values, (size_t)channel->valueCount * sizeof(double));
+    atomicStoreRelease(&channel->head, head + 1);
+    return 1;
+}
+
+void closeTelemetryChannel(TelemetryChannel *channel) {
+    if (channel == NULL) return;
+    atomicStoreRelease(&channel->closed, (size_t)1);
+}
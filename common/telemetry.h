@@ -0,0 +1,72 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "errorcode.h"
+
+// Live telemetry: one lock-free single-producer/single-consumer ring per simulation
+// The simulation thread pushes samples without waiting (a full ring drops the sample).
+// One viewer thread drains every ring at a fixed frame rate, decimates the samples into a
+// bounded per-channel history and hands the histories to a frame callback (for example a
+// gnuplot pipe). The control loop never waits for the viewer.
+
+#define TELEMETRY_MAX_VALUES 8         // Values per sample (besides time)
+#define TELEMETRY_RING_CAPACITY 4096   // Samples per ring (power of two)
+#define TELEMETRY_HISTORY_POINTS 512   // Decimated samples kept per channel for display
+#define TELEMETRY_NAME_SIZE 64
+
+typedef struct {
+    double time;
+    double values[TELEMETRY_MAX_VALUES];
+} TelemetrySample;
+
+typedef struct TelemetryChannel TelemetryChannel;
+
+// Snapshot of one channel passed to the frame callback
+typedef struct {
+    const char *name;
+    int valueCount;
+    const TelemetrySample *history;  // Decimated samples covering the whole run so far
+    int historyCount;
+    int finished;                    // Producer closed the channel (this is its last frame)
+    long dropped;                    // Samples dropped because the ring was full
+} TelemetryView;
+
+// Frame callback, called on the viewer thread once per frame with every open channel
+typedef void (*TelemetryFrameCallback)(void *context, const TelemetryView *views, int viewCount);
+
+// Start the viewer thread
+// Parameters:
+//   frameRate: frames per second (> 0)
+//   frame: callback receiving the channel snapshots
+//   context: passed to the callback
+// Returns: ErrorCode
+ErrorCode startTelemetryViewer(double frameRate, TelemetryFrameCallback frame, void *context);
+
+// Render a final frame and stop the viewer thread
+// Channels still open are freed; all producers must have stopped pushing.
+void stopTelemetryViewer(void);
+
+// Check if the viewer thread is running
+int isTelemetryViewerRunning(void);
+
+// Create a channel and register it with the viewer (shown from the next frame)
+// Parameters:
+//   name: channel name (truncated to TELEMETRY_NAME_SIZE - 1 characters)
+//   valueCount: values per sample (1 to TELEMETRY_MAX_VALUES)
+//   channel: pointer to store the new channel
+// Returns: ErrorCode (ERROR_INVALID_PARAMETER if the viewer is not running)
+ErrorCode openTelemetryChannel(const char *name, int valueCount, TelemetryChannel **channel);
+
+// Push one sample (producer thread only, wait-free)
+// Parameters:
+//   channel: open channel
+//   time: sample time
+//   values: valueCount values
+// Returns: 1 if queued, 0 if dropped because the viewer is behind
+int pushTelemetrySample(TelemetryChannel *channel, double time, const double *values);
+
+// Mark the channel finished (producer thread only)
+// The viewer shows it one last time and frees it; the handle must not be used afterwards.
+void closeTelemetryChannel(TelemetryChannel *channel);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,212 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // pthread_setaffinity_np, sched_getaffinity, CPU_SET
+#endif
+
+#include "threads.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+#define THREAD_MAX_CPUS 1024        // CPUs with a known node (others report node 0)
+#define THREAD_MAX_NODE_IDS 256     // Node directories probed on Linux
+
+static THREAD_LOCAL int threadNumaNode;
+
+// CPU -> dense node index (nodes without CPUs are skipped), filled once
+static struct {
+    unsigned char cpuNode[THREAD_MAX_CPUS];
+    int nodeCount;
+} topology;
+
+#ifdef _WIN32
+static INIT_ONCE topologyOnce = INIT_ONCE_STATIC_INIT;
+#else
+static pthread_once_t topologyOnce = PTHREAD_ONCE_INIT;
+#endif
+
+#ifdef __linux__
+// Mark the CPUs of a cpulist ("0-3,8-11") as belonging to node; returns the CPU count
+static int parseNodeCpuList(FILE *file, int node) {
+    int cpus = 0;
+    int first, last;
+    char separator;
+    while (fscanf(file, "%d", &first) == 1) {
+        last = first;
+        if (fscanf(file, "%c", &separator) == 1 && separator == '-') {
+            if (fscanf(file, "%d", &last) != 1) break;
+            if (fscanf(file, "%c", &separator) != 1) separator = '\n';
+        }
+        for (int cpu = first; cpu <= last; cpu++) {
+            if (cpu >= 0 && cpu < THREAD_MAX_CPUS) topology.cpuNode[cpu] = (unsigned char)node;
+            cpus++;
+        }
+        if (separator != ',') break;
+    }
+    return cpus;
+}
+#endif
+
+static void loadTopology(void) {
+    int nodes = 0;
+#if defined(_WIN32)
+    ULONG highest = 0;
+    if (GetNumaHighestNodeNumber(&highest) && highest > 0) {
+        // Dense index of every node that owns a CPU, in node-number order
+        int dense[256];
+        for (int n = 0; n < 256; n++) dense[n] = -1;
+        for (int cpu = 0; cpu < THREAD_MAX_CPUS && cpu < 64; cpu++) {
+            UCHAR node = 0;
+            if (GetNumaProcessorNode((UCHAR)cpu, &node) && node != 0xFF) {
+                if (dense[node] < 0) dense[node] = 0;
+            }
+        }
+        for (int n = 0; n < 256; n++) {
+            if (dense[n] == 0) dense[n] = nodes++;
+        }
+        for (int cpu = 0; cpu < 64; cpu++) {
+            UCHAR node = 0;
+            if (GetNumaProcessorNode((UCHAR)cpu, &node) && node != 0xFF) {
+                topology.cpuNode[cpu] = (unsigned char)dense[node];
+            }
+        }
+    }
+#elif defined(__linux__)
+    for (int id = 0; id < THREAD_MAX_NODE_IDS && nodes < 255; id++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+        FILE *file = fopen(path, "r");
+        if (file == NULL) continue;
+        if (parseNodeCpuList(file, nodes) > 0) nodes++;
+        fclose(file);
+    }
+#endif
+    topology.nodeCount = nodes > 0 ? nodes : 1;
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK loadTopologyOnce(PINIT_ONCE once, PVOID parameter, PVOID *context) {
+    (void)once;
+    (void)parameter;
+    (void)context;
+    loadTopology();
+    return TRUE;
+}
+#endif
+
+static void ensureTopology(void) {
+#ifdef _WIN32
+    InitOnceExecuteOnce(&topologyOnce, loadTopologyOnce, NULL, NULL);
+#else
+    pthread_once(&topologyOnce, loadTopology);
+#endif
+}
+
+int getNumaNodeCount(void) {
+    ensureTopology();
+    return topology.nodeCount;
+}
+
+int getCpuNumaNode(int cpu) {
+    ensureTopology();
+    return (cpu >= 0 && cpu < THREAD_MAX_CPUS) ? topology.cpuNode[cpu] : 0;
+}
+
+// CPUs the process may run on, in ascending order; returns their number (0 if unknown)
+static int getAllowedCpus(int *cpus, int capacity) {
+    int count = 0;
+#if defined(_WIN32)
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) return 0;
+    for (int cpu = 0; cpu < (int)(sizeof(DWORD_PTR) * 8) && count < capacity; cpu++) {
+        if (processMask & ((DWORD_PTR)1 << cpu)) cpus[count++] = cpu;
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && count < capacity; cpu++) {
+        if (CPU_ISSET(cpu, &set)) cpus[count++] = cpu;
+    }
+#else
+    (void)cpus;
+    (void)capacity;
+#endif
+    return count;
+}
+
+int getSpreadCpuPlacement(int count, int *cpus, int *nodes) {
+    if (count <= 0 || cpus == NULL || nodes == NULL) return 0;
+    int *allowed = (int*)malloc(THREAD_MAX_CPUS * sizeof(int));
+    if (allowed == NULL) return 0;
+    int allowedCount = getAllowedCpus(allowed, THREAD_MAX_CPUS);
+    if (allowedCount == 0) {
+        free(allowed);
+        return 0;
+    }
+
+    // Allowed CPUs of every node (nodes folded like the hints, empty ones skipped)
+    int perNode[THREAD_MAX_NUMA_NODES] = {0}, usedNodes[THREAD_MAX_NUMA_NODES];
+    int usedCount = 0;
+    for (int k = 0; k < allowedCount; k++) perNode[getCpuNumaNode(allowed[k]) % THREAD_MAX_NUMA_NODES]++;
+    for (int n = 0; n < THREAD_MAX_NUMA_NODES; n++) {
+        if (perNode[n] > 0) usedNodes[usedCount++] = n;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int node = usedNodes[i % usedCount];
+        int rank = (i / usedCount) % perNode[node];  // rank-th allowed CPU of the node
+        for (int k = 0; k < allowedCount; k++) {
+            if (getCpuNumaNode(allowed[k]) % THREAD_MAX_NUMA_NODES == node && rank-- == 0) {
+                cpus[i] = allowed[k];
+                break;
+            }
+        }
+        nodes[i] = node;
+    }
+    free(allowed);
+    return 1;
+}
+
+int threadSetAffinity(ThreadHandle thread, int cpu) {
+    if (cpu < 0) return 0;
+#if defined(_WIN32)
+    if (cpu >= (int)(sizeof(DWORD_PTR) * 8)) return 0;
+    return SetThreadAffinityMask(thread, (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE) return 0;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+#else
+    (void)thread;
+    return 0;  // No thread affinity API
+#endif
+}
+
+int pinCurrentThread(int cpu) {
+#ifdef _WIN32
+    int pinned = threadSetAffinity(GetCurrentThread(), cpu);
+#else
+    int pinned = threadSetAffinity(pthread_self(), cpu);
+#endif
+    if (pinned) setThreadNumaNode(getCpuNumaNode(cpu));
+    return pinned;
+}
+
+int getThreadNumaNode(void) {
+    return threadNumaNode;
+}
+
+void setThreadNumaNode(int node) {
+    threadNumaNode = node >= 0 ? node % THREAD_MAX_NUMA_NODES : 0;
+}
@@ -0,0 +1,140 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+// Portable threading primitives shared by the common modules
+// (Win32 critical sections / condition variables, pthreads elsewhere), plus the CPU
+// topology, affinity and per-thread NUMA node hints of threads.c
+
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+typedef CRITICAL_SECTION ThreadMutex;
+typedef CONDITION_VARIABLE ThreadCond;
+typedef HANDLE ThreadHandle;
+typedef unsigned ThreadReturn;
+#define THREAD_CALL __stdcall
+#define THREAD_RETURN_VALUE 0
+#define threadMutexInit(m)      InitializeCriticalSection(m)
+#define threadMutexDestroy(m)   DeleteCriticalSection(m)
+#define threadMutexLock(m)      EnterCriticalSection(m)
+#define threadMutexUnlock(m)    LeaveCriticalSection(m)
+#define threadCondInit(c)       InitializeConditionVariable(c)
+#define threadCondDestroy(c)    ((void)(c))
+#define threadCondWait(c, m)    SleepConditionVariableCS((c), (m), INFINITE)
+#define threadCondSignal(c)     WakeConditionVariable(c)
+#define threadCondBroadcast(c)  WakeAllConditionVariable(c)
+#define threadSleepMs(ms)       Sleep((DWORD)(ms))
+#else
+#include <pthread.h>
+#include <time.h>
+typedef pthread_mutex_t ThreadMutex;
+typedef pthread_cond_t ThreadCond;
+typedef pthread_t ThreadHandle;
+typedef void *ThreadReturn;
+#define THREAD_CALL
+#define THREAD_RETURN_VALUE NULL
+#define threadMutexInit(m)      pthread_mutex_init((m), NULL)
+#define threadMutexDestroy(m)   pthread_mutex_destroy(m)
+#define threadMutexLock(m)      pthread_mutex_lock(m)
+#define threadMutexUnlock(m)    pthread_mutex_unlock(m)
+#define threadCondInit(c)       pthread_cond_init((c), NULL)
+#define threadCondDestroy(c)    pthread_cond_destroy(c)
+#define threadCondWait(c, m)    pthread_cond_wait((c), (m))
+#define threadCondSignal(c)     pthread_cond_signal(c)
+#define threadCondBroadcast(c)  pthread_cond_broadcast(c)
+#define threadSleepMs(ms)       threadNanosleep(ms)
+
+static inline void threadNanosleep(long ms) {
+    struct timespec delay = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&delay, NULL);
+}
+#endif
+
+// Acquire/release atomics on size_t counters (lock-free producer/consumer handoff)
+#if defined(__GNUC__) || defined(__clang__)
+#define atomicLoadAcquire(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define atomicLoadRelaxed(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define atomicStoreRelease(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define atomicStoreRelaxed(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#else
+// MSVC on x86/x64: aligned loads/stores are atomic and ordered; only stop compiler reordering
+#include <intrin.h>
+static inline size_t atomicLoadAcquireSize(const volatile size_t *p) {
+    size_t v = *p;
+    _ReadWriteBarrier();
+    return v;
+}
+static inline void atomicStoreReleaseSize(volatile size_t *p, size_t v) {
+    _ReadWriteBarrier();
+    *p = v;
+}
+#define atomicLoadAcquire(p)      atomicLoadAcquireSize(p)
+#define atomicLoadRelaxed(p)      (*(const volatile size_t*)(p))
+#define atomicStoreRelease(p, v)  atomicStoreReleaseSize((p), (v))
+#define atomicStoreRelaxed(p, v)  (*(volatile size_t*)(p) = (v))
+#endif
+
+// Thread entry point: ThreadReturn THREAD_CALL entry(void *arg) { ...; return THREAD_RETURN_VALUE; }
+typedef ThreadReturn (THREAD_CALL *ThreadEntry)(void *arg);
+
+// Start a thread
+// Returns: 1 on success, 0 on failure
+static inline int threadCreate(ThreadHandle *thread, ThreadEntry entry, void *arg) {
+#ifdef _WIN32
+    *thread = (HANDLE)_beginthreadex(NULL, 0, entry, arg, 0, NULL);
+    return *thread != NULL;
+#else
+    return pthread_create(thread, NULL, entry, arg) == 0;
+#endif
+}
+
+// Wait for a thread to finish and release its handle
+static inline void threadJoin(ThreadHandle thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+// ===== CPU topology and placement (threads.c) =====
+// NUMA nodes come from /sys/devices/system/node on Linux and GetNumaProcessorNode on Windows;
+// without that information every CPU is on node 0. Allocators that keep per-node state
+// (objectpool.h) select it with the node hint of the calling thread, so memory first touched
+// by a pinned worker is handed back to the workers of the same node.
+
+#define THREAD_MAX_NUMA_NODES 8   // Nodes beyond are folded onto these (node % 8)
+
+// Number of NUMA nodes with CPUs (at least 1)
+int getNumaNodeCount(void);
+
+// NUMA node of a CPU (0 if unknown)
+int getCpuNumaNode(int cpu);
+
+// Spread `count` workers over the CPUs the process may run on: worker i goes to node
+// i % nodes, taking the CPUs of each node in turn (wrapping when there are more workers)
+// Parameters:
+//   count: number of workers
+//   cpus: receives the CPU of each worker
+//   nodes: receives the NUMA node of each worker
+// Returns: 1, or 0 when the CPU set cannot be queried (cpus and nodes untouched)
+int getSpreadCpuPlacement(int count, int *cpus, int *nodes);
+
+// Restrict a thread to one CPU
+// Returns: 1 on success, 0 on failure (no affinity API, CPU out of range, no permission)
+int threadSetAffinity(ThreadHandle thread, int cpu);
+
+// Restrict the calling thread to one CPU and set its node hint to the CPU's node
+// Returns: 1 on success, 0 on failure (the node hint is left unchanged)
+int pinCurrentThread(int cpu);
+
+// Node hint of the calling thread (0 until set; at most THREAD_MAX_NUMA_NODES - 1)
+int getThreadNumaNode(void);
+
+// Set the node hint of the calling thread (pool workers placed on a node)
+void setThreadNumaNode(int node);
+
+#endif // THREADS_H
@@ -0,0 +1,656 @@
+#include "tracewriter.h"
+#include "threads.h"
+#include "objectpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Fixed part of the binary header (magic, sizes, row count)
+#define TRACE_HEADER_FIXED_SIZE 32
+#define TRACE_ROW_COUNT_OFFSET 24
+
+// Packed traces (TRACE_FORMAT_PACKED): fixed header and the fields patched at close
+#define TRACE_PACKED_MAGIC "ACSTRZ1"
+#define TRACE_PACKED_HEADER_FIXED_SIZE 48
+#define TRACE_PACKED_BLOCK_COUNT_OFFSET 20
+#define TRACE_PACKED_MAX_BYTES (4 * TRACE_CHUNK_ROWS * TRACE_MAX_COLUMNS)  // Planes of a full chunk
+#define TRACE_ANIMATION_INITIAL_FRAMES 256
+#define TRACE_ANIMATION_TOLERANCE 1e-6     // Fraction of the frame interval a row may come early
+
+// stdio buffer of each trace file, owned by the writer so fopen does not allocate one
+#define TRACE_IO_BUFFER_SIZE 65536
+
+// Block of rows handed from a simulation thread to the writer thread
+typedef struct TraceChunk {
+    struct TraceChunk *next;    // Link in the writer-thread queue or the owner's free list
+    TraceWriter *owner;
+    double *values;             // TRACE_CHUNK_ROWS * columnCount values, row-major
+    int rows;                   // Rows filled
+    int isLast;                 // Close the file after writing this chunk
+} TraceChunk;
+
+struct TraceWriter {
+    FILE *file;
+    TraceFormat format;
+    int columnCount;
+    long rowCount;                            // Rows appended
+    TraceChunk chunks[TRACE_CHUNKS_PER_WRITER];
+    double *block;                            // Values of all chunks, kept when the writer is recycled
+    size_t blockValues;                       // Capacity of block
+    char ioBuffer[TRACE_IO_BUFFER_SIZE];      // Full buffering of file
+    TraceChunk *current;                      // Chunk being filled (simulation thread only)
+    ThreadMutex lock;                         // Protects the fields below
+    ThreadCond chunkReturned;                 // Signaled when the writer thread is done with a chunk
+    TraceChunk *freeChunks;                   // Chunks ready to be filled again
+    int finished;                             // Last chunk written and file closed
+    int ioFailed;                             // A write to the file failed
+    // Packed traces
+    long blockCount;                          // Blocks written (writer thread only)
+    double frameInterval;                     // Animation stream: seconds per frame (0: none)
+    double frameStart;                        // Time of the first frame
+    long nextFrame;                           // Index of the next frame time
+    float *frames;                            // Animation rows, kept when the writer is recycled
+    size_t frameCapacity;                     // Rows that fit in frames
+    size_t frameCount;                        // Rows recorded (simulation thread until the last chunk)
+    float lastRow[TRACE_MAX_COLUMNS];         // Latest row, ends the stream if it is not a frame
+    int lastRowIsFrame;
+};
+
+// Background writer thread shared by all traces
+static struct {
+    ThreadMutex lock;
+    ThreadCond workAvailable;
+    TraceChunk *head;           // FIFO of chunks waiting to be written
+    TraceChunk *tail;
+    ThreadHandle thread;
+    int running;
+    int stopRequested;
+} traceService;
+
+// Closed writers and their chunk blocks, reused by the next openTraceWriter
+static ObjectPool writerPool;
+
+static void freeWriterBlock(void *writer) {
+    free(((TraceWriter*)writer)->block);
+    free(((TraceWriter*)writer)->frames);
+}
+
+static void putU32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void putU64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static size_t traceValueSize(TraceFormat format) {
+    return format == TRACE_FORMAT_BINARY_F32 ? sizeof(float) : sizeof(double);
+}
+
+// Zero-byte suppression: set bit i of bitmap (LSB first) for every nonzero in[i] and pack those
+// bytes into out; returns their number. Branchless, every byte is stored and kept or overwritten.
+static size_t suppressZeroBytes(const unsigned char *in, size_t count, unsigned char *bitmap, unsigned char *out) {
+    size_t kept = 0;
+    memset(bitmap, 0, (count + 7) / 8);
+    for (size_t i = 0; i < count; i++) {
+        unsigned int nonzero = in[i] != 0;
+        bitmap[i >> 3] |= (unsigned char)(nonzero << (i & 7));
+        out[kept] = in[i];
+        kept += nonzero;
+    }
+    return kept;
+}
+
+// Write one chunk as a packed block (runs on the writer thread, so static buffers are enough)
+static int writePackedChunk(TraceWriter *writer, const TraceChunk *chunk) {
+    static unsigned char planes[TRACE_PACKED_MAX_BYTES];
+    static unsigned char planeBytes[TRACE_PACKED_MAX_BYTES];
+    static unsigned char bitmap[TRACE_PACKED_MAX_BYTES / 8];
+    static unsigned char header[8 + TRACE_PACKED_MAX_BYTES / 64 + TRACE_PACKED_MAX_BYTES / 8];
+    size_t rows = (size_t)chunk->rows;
+    size_t columns = (size_t)writer->columnCount;
+    if (rows == 0) return 1;
+
+    // Zigzag delta-of-delta of the float32 bits down each column, split into byte planes
+    for (size_t c = 0; c < columns; c++) {
+        uint32_t previous = 0, previousDelta = 0;
+        unsigned char *plane = planes + c * 4 * rows;
+        for (size_t r = 0; r < rows; r++) {
+            float value = (float)chunk->values[r * columns + c];
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            uint32_t delta = bits - previous;
+            uint32_t change = delta - previousDelta;
+            uint32_t code = (change << 1) ^ (0u - (change >> 31));
+            previous = bits;
+            previousDelta = delta;
+            plane[r] = (unsigned char)code;
+            plane[rows + r] = (unsigned char)(code >> 8);
+            plane[2 * rows + r] = (unsigned char)(code >> 16);
+            plane[3 * rows + r] = (unsigned char)(code >> 24);
+        }
+    }
+
+    // Payload: bitmap2, nonzero bytes of bitmap1, nonzero plane bytes
+    size_t planeCount = 4 * rows * columns;
+    size_t bitmapSize = (planeCount + 7) / 8;
+    size_t bitmap2Size = (bitmapSize + 7) / 8;
+    size_t keptPlanes = suppressZeroBytes(planes, planeCount, bitmap, planeBytes);
+    size_t keptBitmap = suppressZeroBytes(bitmap, bitmapSize, header + 8, header + 8 + bitmap2Size);
+    size_t headerSize = 8 + bitmap2Size + keptBitmap;
+    putU32(header, (uint32_t)rows);
+    putU32(header + 4, (uint32_t)(bitmap2Size + keptBitmap + keptPlanes));
+    writer->blockCount++;
+    return fwrite(header, 1, headerSize, writer->file) == headerSize &&
+           fwrite(planeBytes, 1, keptPlanes, writer->file) == keptPlanes;
+}
+
+// Write the rows of one chunk (runs on the writer thread)
+static int writeChunk(TraceWriter *writer, const TraceChunk *chunk) {
+    size_t count = (size_t)chunk->rows * (size_t)writer->columnCount;
+    if (count == 0) return 1;
+
+    switch (writer->format) {
+    case TRACE_FORMAT_BINARY_F64:
+        return fwrite(chunk->values, sizeof(double), count, writer->file) == count;
+    case TRACE_FORMAT_BINARY_F32: {
+        // Only the writer thread converts, so one static buffer is enough
+        static float converted[TRACE_CHUNK_ROWS * TRACE_MAX_COLUMNS];
+        for (size_t i = 0; i < count; i++) converted[i] = (float)chunk->values[i];
+        return fwrite(converted, sizeof(float), count, writer->file) == count;
+    }
+    case TRACE_FORMAT_PACKED:
+        return writePackedChunk(writer, chunk);
+    case TRACE_FORMAT_CSV:
+    default:
+        for (int r = 0; r < chunk->rows; r++) {
+            const double *row = chunk->values + (size_t)r * (size_t)writer->columnCount;
+            for (int c = 0; c < writer->columnCount; c++) {
+                if (fprintf(writer->file, c == 0 ? "%.6f" : ",%.6f", row[c]) < 0) return 0;
+            }
+            if (fputc('\n', writer->file) == EOF) return 0;
+        }
+        return 1;
+    }
+}
+
+// Append the animation stream and patch the block/row counts and stream position (packed traces)
+static int finishPackedTrace(TraceWriter *writer) {
+    uint64_t animationOffset = 0;
+    size_t values = writer->frameCount * (size_t)writer->columnCount;
+    if (writer->frameCount > 0) {
+        long position = ftell(writer->file);
+        if (position < 0 || fwrite(writer->frames, sizeof(float), values, writer->file) != values) return 0;
+        animationOffset = (uint64_t)position;
+    }
+
+    float interval = writer->frameCount > 0 ? (float)writer->frameInterval : 0.0f;
+    uint32_t intervalBits;
+    memcpy(&intervalBits, &interval, sizeof(intervalBits));
+    unsigned char fields[TRACE_PACKED_HEADER_FIXED_SIZE - TRACE_PACKED_BLOCK_COUNT_OFFSET];
+    putU32(fields, (uint32_t)writer->blockCount);
+    putU64(fields + 4, (uint64_t)writer->rowCount);
+    putU64(fields + 12, animationOffset);
+    putU32(fields + 20, (uint32_t)writer->frameCount);
+    putU32(fields + 24, intervalBits);
+    return fseek(writer->file, TRACE_PACKED_BLOCK_COUNT_OFFSET, SEEK_SET) == 0 &&
+           fwrite(fields, 1, sizeof(fields), writer->file) == sizeof(fields);
+}
+
+// Patch the row count into the header and close the file (runs on the writer thread)
+static int finishTraceFile(TraceWriter *writer) {
+    int ok = 1;
+    if (writer->format == TRACE_FORMAT_PACKED) {
+        ok = finishPackedTrace(writer);
+    } else if (writer->format != TRACE_FORMAT_CSV) {
+        unsigned char rowCount[8];
+        putU64(rowCount, (uint64_t)writer->rowCount);
+        ok = fseek(writer->file, TRACE_ROW_COUNT_OFFSET, SEEK_SET) == 0 &&
+             fwrite(rowCount, 1, sizeof(rowCount), writer->file) == sizeof(rowCount);
+    }
+    if (fclose(writer->file) != 0) ok = 0;
+    writer->file = NULL;
+    return ok;
+}
+
+static ThreadReturn THREAD_CALL traceWriterMain(void *arg) {
+    (void)arg;
+    for (;;) {
+        threadMutexLock(&traceService.lock);
+        while (traceService.head == NULL && !traceService.stopRequested) {
+            threadCondWait(&traceService.workAvailable, &traceService.lock);
+        }
+        TraceChunk *chunk = traceService.head;
+        if (chunk == NULL) {
+            threadMutexUnlock(&traceService.lock);
+            break;  // Stop requested and queue drained
+        }
+        traceService.head = chunk->next;
+        if (traceService.head == NULL) traceService.tail = NULL;
+        threadMutexUnlock(&traceService.lock);
+
+        TraceWriter *writer = chunk->owner;
+        int ok = writeChunk(writer, chunk);
+        if (chunk->isLast && !finishTraceFile(writer)) ok = 0;
+
+        // Hand the chunk back; after `finished` is set the owner may free the writer,
+        // so nothing touches it once the lock is released
+        threadMutexLock(&writer->lock);
+        if (!ok) writer->ioFailed = 1;
+        if (chunk->isLast) {
+            writer->finished = 1;
+        } else {
+            chunk->rows = 0;
+            chunk->next = writer->freeChunks;
+            writer->freeChunks = chunk;
+        }
+        threadCondSignal(&writer->chunkReturned);
+        threadMutexUnlock(&writer->lock);
+    }
+    return THREAD_RETURN_VALUE;
+}
+
+static void submitChunk(TraceChunk *chunk) {
+    chunk->next = NULL;
+    threadMutexLock(&traceService.lock);
+    if (traceService.tail) {
+        traceService.tail->next = chunk;
+    } else {
+        traceService.head = chunk;
+    }
+    traceService.tail = chunk;
+    threadCondSignal(&traceService.workAvailable);
+    threadMutexUnlock(&traceService.lock);
+}
+
+ErrorCode startTraceWriterThread(void) {
+    if (traceService.running) return ERROR_SUCCESS;
+
+    threadMutexInit(&traceService.lock);
+    threadCondInit(&traceService.workAvailable);
+    traceService.head = NULL;
+    traceService.tail = NULL;
+    traceService.stopRequested = 0;
+    if (!threadCreate(&traceService.thread, traceWriterMain, NULL)) {
+        threadCondDestroy(&traceService.workAvailable);
+        threadMutexDestroy(&traceService.lock);
+        return ERROR_CALLBACK_FAILED;
+    }
+    initObjectPool(&writerPool, sizeof(TraceWriter));
+    traceService.running = 1;
+    return ERROR_SUCCESS;
+}
+
+void stopTraceWriterThread(void) {
+    if (!traceService.running) return;
+
+    threadMutexLock(&traceService.lock);
+    traceService.stopRequested = 1;
+    threadCondBroadcast(&traceService.workAvailable);
+    threadMutexUnlock(&traceService.lock);
+
+    threadJoin(traceService.thread);
+    threadCondDestroy(&traceService.workAvailable);
+    threadMutexDestroy(&traceService.lock);
+    releaseObjectPool(&writerPool, freeWriterBlock);
+    traceService.running = 0;
+}
+
+const char* getTraceFileExtension(TraceFormat format) {
+    if (format == TRACE_FORMAT_CSV) return ".csv";
+    return format == TRACE_FORMAT_PACKED ? ".trz" : ".trc";
+}
+
+ErrorCode parseTraceFormat(const char *name, TraceFormat *format) {
+    if (name == NULL || format == NULL) return ERROR_NULL_POINTER;
+
+    if (strcmp(name, "csv") == 0) {
+        *format = TRACE_FORMAT_CSV;
+    } else if (strcmp(name, "f64") == 0) {
+        *format = TRACE_FORMAT_BINARY_F64;
+    } else if (strcmp(name, "f32") == 0) {
+        *format = TRACE_FORMAT_BINARY_F32;
+    } else if (strcmp(name, "packed") == 0) {
+        *format = TRACE_FORMAT_PACKED;
+    } else {
+        return ERROR_INVALID_PARAMETER;
+    }
+    return ERROR_SUCCESS;
+}
+
+// Binary header of a trace (row count 0 until closed); returns its size
+static size_t buildBinaryHeader(TraceFormat format, int columnCount, const char *const *columnNames,
+                                unsigned char *header) {
+    size_t headerSize = TRACE_HEADER_FIXED_SIZE + (size_t)columnCount * TRACE_COLUMN_NAME_SIZE;
+    memset(header, 0, headerSize);
+    memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    putU32(header + 8, (uint32_t)headerSize);
+    putU32(header + 12, (uint32_t)columnCount);
+    putU32(header + 16, (uint32_t)traceValueSize(format));
+    for (int c = 0; c < columnCount; c++) {
+        memcpy(header + TRACE_HEADER_FIXED_SIZE + (size_t)c * TRACE_COLUMN_NAME_SIZE,
+               columnNames[c], strlen(columnNames[c]));
+    }
+    return headerSize;
+}
+
+// Packed header with the counts of an empty trace
+static size_t buildPackedHeader(int columnCount, const char *const *columnNames, unsigned char *header) {
+    size_t headerSize = TRACE_PACKED_HEADER_FIXED_SIZE + (size_t)columnCount * TRACE_COLUMN_NAME_SIZE;
+    memset(header, 0, headerSize);
+    memcpy(header, TRACE_PACKED_MAGIC, sizeof(TRACE_PACKED_MAGIC));
+    putU32(header + 8, (uint32_t)headerSize);
+    putU32(header + 12, (uint32_t)columnCount);
+    putU32(header + 16, TRACE_CHUNK_ROWS);
+    for (int c = 0; c < columnCount; c++) {
+        memcpy(header + TRACE_PACKED_HEADER_FIXED_SIZE + (size_t)c * TRACE_COLUMN_NAME_SIZE,
+               columnNames[c], strlen(columnNames[c]));
+    }
+    return headerSize;
+}
+
+// Write the CSV header line or the binary header
+static int writeTraceHeader(TraceWriter *writer, const char *const *columnNames) {
+    if (writer->format == TRACE_FORMAT_CSV) {
+        for (int c = 0; c < writer->columnCount; c++) {
+            if (fprintf(writer->file, c == 0 ? "%s" : ",%s", columnNames[c]) < 0) return 0;
+        }
+        return fputc('\n', writer->file) != EOF;
+    }
+    if (writer->format == TRACE_FORMAT_PACKED) {
+        unsigned char header[TRACE_PACKED_HEADER_FIXED_SIZE + TRACE_MAX_COLUMNS * TRACE_COLUMN_NAME_SIZE];
+        size_t headerSize = buildPackedHeader(writer->columnCount, columnNames, header);
+        return fwrite(header, 1, headerSize, writer->file) == headerSize;
+    }
+
+    unsigned char header[TRACE_HEADER_FIXED_SIZE + TRACE_MAX_COLUMNS * TRACE_COLUMN_NAME_SIZE];
+    size_t headerSize = buildBinaryHeader(writer->format, writer->columnCount, columnNames, header);
+    return fwrite(header, 1, headerSize, writer->file) == headerSize;
+}
+
+// Arguments shared by openTraceWriter and reopenTraceWriter
+static ErrorCode checkTraceLayout(TraceFormat format, int columnCount, const char *const *columnNames) {
+    if (!traceService.running) return ERROR_INVALID_PARAMETER;
+    if (columnCount < 1 || columnCount > TRACE_MAX_COLUMNS) return ERROR_INVALID_PARAMETER;
+    if (format != TRACE_FORMAT_CSV && format != TRACE_FORMAT_BINARY_F64 &&
+        format != TRACE_FORMAT_BINARY_F32 && format != TRACE_FORMAT_PACKED) {
+        return ERROR_INVALID_PARAMETER;
+    }
+    for (int c = 0; c < columnCount; c++) {
+        if (columnNames[c] == NULL) return ERROR_NULL_POINTER;
+        if (strlen(columnNames[c]) >= TRACE_COLUMN_NAME_SIZE) return ERROR_INVALID_PARAMETER;
+    }
+    return ERROR_SUCCESS;
+}
+
+// Take a writer with chunk storage for columnCount columns
+// A recycled writer keeps its block; it only grows for a trace with more columns
+static TraceWriter* takeTraceWriter(int columnCount) {
+    TraceWriter *w = (TraceWriter*)takePoolObject(&writerPool);
+    if (w == NULL) return NULL;
+
+    size_t chunkValues = (size_t)TRACE_CHUNK_ROWS * (size_t)columnCount;
+    if (w->blockValues < chunkValues * TRACE_CHUNKS_PER_WRITER) {
+        free(w->block);
+        w->blockValues = 0;
+        w->block = (double*)malloc(chunkValues * TRACE_CHUNKS_PER_WRITER * sizeof(double));
+        if (w->block == NULL) {
+            returnPoolObject(&writerPool, w);
+            return NULL;
+        }
+        w->blockValues = chunkValues * TRACE_CHUNKS_PER_WRITER;
+    }
+    return w;
+}
+
+// Reset the state of a writer whose file is open and positioned after rowCount rows
+static void startTraceWriter(TraceWriter *w, TraceFormat format, int columnCount, long rowCount) {
+    size_t chunkValues = (size_t)TRACE_CHUNK_ROWS * (size_t)columnCount;
+    setvbuf(w->file, w->ioBuffer, _IOFBF, sizeof(w->ioBuffer));
+    w->format = format;
+    w->columnCount = columnCount;
+    w->rowCount = rowCount;
+    w->freeChunks = NULL;
+    w->finished = 0;
+    w->ioFailed = 0;
+    w->blockCount = 0;
+    w->frameInterval = 0.0;
+    w->frameCount = 0;
+    w->lastRowIsFrame = 0;
+
+    // The first chunk is filled right away, the others wait on the free list
+    for (int k = 0; k < TRACE_CHUNKS_PER_WRITER; k++) {
+        w->chunks[k].next = NULL;
+        w->chunks[k].owner = w;
+        w->chunks[k].values = w->block + chunkValues * (size_t)k;
+        w->chunks[k].rows = 0;
+        w->chunks[k].isLast = 0;
+        if (k > 0) {
+            w->chunks[k].next = w->freeChunks;
+            w->freeChunks = &w->chunks[k];
+        }
+    }
+    w->current = &w->chunks[0];
+    threadMutexInit(&w->lock);
+    threadCondInit(&w->chunkReturned);
+}
+
+ErrorCode openTraceWriter(const char *path, TraceFormat format, int columnCount,
+                          const char *const *columnNames, TraceWriter **writer) {
+    if (path == NULL || columnNames == NULL || writer == NULL) return ERROR_NULL_POINTER;
+    *writer = NULL;
+    ErrorCode err = checkTraceLayout(format, columnCount, columnNames);
+    if (err != ERROR_SUCCESS) return err;
+
+    TraceWriter *w = takeTraceWriter(columnCount);
+    if (w == NULL) return ERROR_NULL_POINTER;
+    w->file = fopen(path, format == TRACE_FORMAT_CSV ? "w" : "wb");
+    if (w->file == NULL) {
+        returnPoolObject(&writerPool, w);
+        return ERROR_CALLBACK_FAILED;
+    }
+    startTraceWriter(w, format, columnCount, 0);
+
+    if (!writeTraceHeader(w, columnNames)) {
+        fclose(w->file);
+        threadCondDestroy(&w->chunkReturned);
+        threadMutexDestroy(&w->lock);
+        returnPoolObject(&writerPool, w);
+        return ERROR_CALLBACK_FAILED;
+    }
+
+    *writer = w;
+    return ERROR_SUCCESS;
+}
+
+// Cut the file after `size` bytes (the rows past the resume cursor)
+static int truncateTraceFile(FILE *file, long size) {
+    if (fflush(file) != 0) return 0;
+#ifdef _WIN32
+    return _chsize_s(_fileno(file), size) == 0;
+#else
+    return ftruncate(fileno(file), (off_t)size) == 0;
+#endif
+}
+
+ErrorCode reopenTraceWriter(const char *path, TraceFormat format, int columnCount,
+                            const char *const *columnNames, long rows, TraceWriter **writer) {
+    if (path == NULL || columnNames == NULL || writer == NULL) return ERROR_NULL_POINTER;
+    *writer = NULL;
+    ErrorCode err = checkTraceLayout(format, columnCount, columnNames);
+    if (err != ERROR_SUCCESS) return err;
+    if (format == TRACE_FORMAT_CSV || format == TRACE_FORMAT_PACKED || rows < 0) return ERROR_INVALID_PARAMETER;
+
+    TraceWriter *w = takeTraceWriter(columnCount);
+    if (w == NULL) return ERROR_NULL_POINTER;
+    w->file = fopen(path, "r+b");
+    if (w->file == NULL) {
+        returnPoolObject(&writerPool, w);
+        return ERROR_CALLBACK_FAILED;
+    }
+
+    // Same header apart from the row count, and at least `rows` complete rows on disk
+    unsigned char expected[TRACE_HEADER_FIXED_SIZE + TRACE_MAX_COLUMNS * TRACE_COLUMN_NAME_SIZE];
+    unsigned char found[sizeof(expected)];
+    size_t headerSize = buildBinaryHeader(format, columnCount, columnNames, expected);
+    long rowEnd = (long)headerSize + rows * (long)((size_t)columnCount * traceValueSize(format));
+    err = ERROR_INVALID_PARAMETER;
+    if (fread(found, 1, headerSize, w->file) == headerSize &&
+        memcmp(found, expected, TRACE_ROW_COUNT_OFFSET) == 0 &&
+        memcmp(found + TRACE_HEADER_FIXED_SIZE, expected + TRACE_HEADER_FIXED_SIZE,
+               headerSize - TRACE_HEADER_FIXED_SIZE) == 0 &&
+        fseek(w->file, 0, SEEK_END) == 0 && ftell(w->file) >= rowEnd) {
+        // Back to the row count 0 of an open trace, drop the rows after the cursor
+        unsigned char zero[8] = {0};
+        err = fseek(w->file, TRACE_ROW_COUNT_OFFSET, SEEK_SET) == 0 &&
+              fwrite(zero, 1, sizeof(zero), w->file) == sizeof(zero) &&
+              truncateTraceFile(w->file, rowEnd) && fseek(w->file, rowEnd, SEEK_SET) == 0
+              ? ERROR_SUCCESS : ERROR_CALLBACK_FAILED;
+    }
+    if (err != ERROR_SUCCESS) {
+        fclose(w->file);
+        returnPoolObject(&writerPool, w);
+        return err;
+    }
+    startTraceWriter(w, format, columnCount, rows);
+
+    *writer = w;
+    return ERROR_SUCCESS;
+}
+
+ErrorCode setTraceAnimationRate(TraceWriter *writer, double framesPerSecond) {
+    if (writer == NULL) return ERROR_NULL_POINTER;
+    if (writer->format != TRACE_FORMAT_PACKED || writer->rowCount > 0 || !(framesPerSecond >= 0.0)) {
+        return ERROR_INVALID_PARAMETER;
+    }
+    writer->frameInterval = framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0;
+    return ERROR_SUCCESS;
+}
+
+// Add the latest row to the animation stream (simulation thread)
+// Without memory for more frames the stream is dropped; the trace itself stays complete.
+static void addAnimationFrame(TraceWriter *writer) {
+    size_t columns = (size_t)writer->columnCount;
+    if (writer->frameCount == writer->frameCapacity) {
+        size_t capacity = writer->frameCapacity > 0 ? 2 * writer->frameCapacity : TRACE_ANIMATION_INITIAL_FRAMES;
+        float *grown = (float*)realloc(writer->frames, capacity * TRACE_MAX_COLUMNS * sizeof(float));
+        if (grown == NULL) {
+            writer->frameInterval = 0.0;
+            writer->frameCount = 0;
+            return;
+        }
+        writer->frames = grown;
+        writer->frameCapacity = capacity;
+    }
+    memcpy(writer->frames + writer->frameCount * columns, writer->lastRow, columns * sizeof(float));
+    writer->frameCount++;
+    writer->lastRowIsFrame = 1;
+}
+
+// Keep a row every frameInterval seconds of the first column
+static void recordAnimationRow(TraceWriter *writer, const double *values) {
+    for (int c = 0; c < writer->columnCount; c++) writer->lastRow[c] = (float)values[c];
+    writer->lastRowIsFrame = 0;
+    if (writer->frameCount == 0) {
+        writer->frameStart = values[0];
+        writer->nextFrame = 0;
+    }
+    // Frame times are start + k * interval (no drift), less a rounding margin so a row time
+    // summed from dt still hits its frame; rows sparser than frames skip some
+    double time = values[0] + TRACE_ANIMATION_TOLERANCE * writer->frameInterval;
+    if (time < writer->frameStart + (double)writer->nextFrame * writer->frameInterval) return;
+    while (writer->frameStart + (double)writer->nextFrame * writer->frameInterval <= time) {
+        writer->nextFrame++;
+    }
+    addAnimationFrame(writer);
+}
+
+ErrorCode appendTraceRow(TraceWriter *writer, const double *values) {
+    if (writer == NULL || values == NULL) return ERROR_NULL_POINTER;
+    if (writer->frameInterval > 0.0) recordAnimationRow(writer, values);
+
+    TraceChunk *chunk = writer->current;
+    memcpy(chunk->values + (size_t)chunk->rows * (size_t)writer->columnCount, values,
+           (size_t)writer->columnCount * sizeof(double));
+    chunk->rows++;
+    writer->rowCount++;
+
+    if (chunk->rows == TRACE_CHUNK_ROWS) {
+        submitChunk(chunk);
+
+        // Take the next free chunk, waiting only if the writer thread has all of them
+        threadMutexLock(&writer->lock);
+        while (writer->freeChunks == NULL) {
+            threadCondWait(&writer->chunkReturned, &writer->lock);
+        }
+        writer->current = writer->freeChunks;
+        writer->freeChunks = writer->current->next;
+        threadMutexUnlock(&writer->lock);
+    }
+    return ERROR_SUCCESS;
+}
+
+long getTraceRowCount(const TraceWriter *writer) {
+    return writer ? writer->rowCount : 0;
+}
+
+ErrorCode flushTraceWriter(TraceWriter *writer) {
+    if (writer == NULL) return ERROR_NULL_POINTER;
+
+    if (writer->current->rows > 0) {
+        submitChunk(writer->current);
+        writer->current = NULL;
+    }
+
+    // Wait until the writer thread has returned every chunk of this trace
+    threadMutexLock(&writer->lock);
+    for (;;) {
+        int idle = writer->current != NULL;
+        for (const TraceChunk *chunk = writer->freeChunks; chunk != NULL; chunk = chunk->next) idle++;
+        if (idle == TRACE_CHUNKS_PER_WRITER) break;
+        threadCondWait(&writer->chunkReturned, &writer->lock);
+    }
+    if (writer->current == NULL) {
+        writer->current = writer->freeChunks;
+        writer->freeChunks = writer->current->next;
+    }
+    int failed = writer->ioFailed;
+    threadMutexUnlock(&writer->lock);
+
+    // No chunk in flight: the writer thread does not touch the file until the next submit
+    if (fflush(writer->file) != 0) failed = 1;
+    return failed ? ERROR_CALLBACK_FAILED : ERROR_SUCCESS;
+}
+
+ErrorCode closeTraceWriter(TraceWriter *writer) {
+    if (writer == NULL) return ERROR_NULL_POINTER;
+
+    // The stream ends on the last row; from the last submit on only the writer thread reads it
+    if (writer->frameInterval > 0.0 && writer->rowCount > 0 && !writer->lastRowIsFrame) {
+        addAnimationFrame(writer);
+    }
+
+    // The last (possibly empty) chunk also finalizes the header and closes the file
+    writer->current->isLast = 1;
+    submitChunk(writer->current);
+    writer->current = NULL;
+
+    threadMutexLock(&writer->lock);
+    while (!writer->finished) {
+        threadCondWait(&writer->chunkReturned, &writer->lock);
+    }
+    int failed = writer->ioFailed;
+    threadMutexUnlock(&writer->lock);
+
+    threadCondDestroy(&writer->chunkReturned);
+    threadMutexDestroy(&writer->lock);
+    returnPoolObject(&writerPool, writer);
+    return failed ? ERROR_CALLBACK_FAILED : ERROR_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#ifndef TRACEWRITER_H
+#define TRACEWRITER_H
+
+#include "errorcode.h"
+
+// Streaming simulation trace recorder
+// Rows are collected in fixed-size chunks; full chunks are handed to one background
+// writer thread (shared by all open traces) that formats and writes them while the
+// simulation keeps running. Memory per trace is constant (TRACE_CHUNKS_PER_WRITER chunks)
+// and the run length is unbounded. Closed writers are recycled with their chunks, so a
+// batch that opens one trace per run stops allocating once the pool is warm.
+//
+// Binary file layout (TRACE_FORMAT_BINARY_F64 / TRACE_FORMAT_BINARY_F32), little-endian:
+//   offset  0: char     magic[8]      "ACSTRC1\0"
+//   offset  8: uint32   headerSize    bytes before the first row (32 + 32 * columnCount)
+//   offset 12: uint32   columnCount
+//   offset 16: uint32   valueSize     8 (float64) or 4 (float32)
+//   offset 20: uint32   reserved      0
+//   offset 24: uint64   rowCount      patched when the trace is closed (0 while writing)
+//   offset 32: char     names[columnCount][32]  NUL-padded column names
+//   then rowCount rows of columnCount values each (row-major records)
+// The row records map directly onto a NumPy structured dtype (see scripts/trace_io.py).
+//
+// Packed layout (TRACE_FORMAT_PACKED, .trz), little-endian, for archival and animation:
+//   offset  0: char     magic[8]        "ACSTRZ1\0"
+//   offset  8: uint32   headerSize      bytes before the first block (48 + 32 * columnCount)
+//   offset 12: uint32   columnCount
+//   offset 16: uint32   blockRows       TRACE_CHUNK_ROWS (rows per block, the last may be shorter)
+//   offset 20: uint32   blockCount      patched when the trace is closed (0 while writing)
+//   offset 24: uint64   rowCount        patched when the trace is closed (0 while writing)
+//   offset 32: uint64   animationOffset file offset of the animation stream (0: none)
+//   offset 40: uint32   animationFrames frames in the animation stream
+//   offset 44: float32  animationInterval seconds between frames
+//   offset 48: char     names[columnCount][32]
+//   then blockCount blocks: uint32 rows, uint32 payloadSize, payload
+//   then the animation stream: animationFrames raw float32 rows (memory-mappable)
+// A block stores the float32 bits of each column as zigzag-coded second differences
+// (unsigned 32-bit arithmetic; bits and first difference are 0 before the first row of the
+// block, so blocks decode on their own): code = zz((v[r] - v[r-1]) - (v[r-1] - v[r-2])),
+// zz(d) = (d << 1) ^ -(d >> 31). Smooth signals give small codes with zero high bytes. The codes
+// are byte-shuffled into 4 planes per column (plane b holds byte b of every row: plane-major,
+// column-major), and compressed by
+// zero-byte suppression applied twice: the payload is bitmap2, the nonzero bytes of bitmap1,
+// the nonzero bytes of the planes, where bitmap1 has bit i (LSB first) set for every nonzero
+// plane byte i and bitmap2 does the same for bitmap1. Every size follows from rows and the
+// bitmap popcounts, and decoding is a few vectorized NumPy operations.
+// The animation stream holds a row every animationInterval seconds of the first column (time),
+// starting at the first row, plus the last row: viewers redraw from it without decoding blocks.
+
+#define TRACE_MAGIC "ACSTRC1"
+#define TRACE_COLUMN_NAME_SIZE 32    // Bytes per column name in the header (including NUL)
+#define TRACE_MAX_COLUMNS 16
+#define TRACE_CHUNK_ROWS 1024        // Rows buffered before a chunk is handed to the writer thread
+#define TRACE_CHUNKS_PER_WRITER 3    // Chunks owned by each trace (one filling, the rest in flight)
+
+// Output format of a trace
+typedef enum {
+    TRACE_FORMAT_CSV = 0,        // Text, one "%.6f" row per line with a header line
+    TRACE_FORMAT_BINARY_F64,     // Binary header + raw float64 rows
+    TRACE_FORMAT_BINARY_F32,     // Binary header + raw float32 rows
+    TRACE_FORMAT_PACKED          // float32, delta-coded, zero-suppressed blocks + animation stream (.trz)
+} TraceFormat;
+
+typedef struct TraceWriter TraceWriter;
+
+// Start the background writer thread (call once before opening traces)
+// Returns: ErrorCode
+ErrorCode startTraceWriterThread(void);
+
+// Stop the background writer thread and free the recycled writers
+// All traces must have been closed.
+void stopTraceWriterThread(void);
+
+// File extension for a trace format (".csv", ".trc" or ".trz")
+const char* getTraceFileExtension(TraceFormat format);
+
+// Parse a format name ("csv", "f64", "f32", "packed")
+// Parameters:
+//   name: format name
+//   format: pointer to store the format
+// Returns: ErrorCode (ERROR_INVALID_PARAMETER for unknown names)
+ErrorCode parseTraceFormat(const char *name, TraceFormat *format);
+
+// Create a trace file and write its header
+// Parameters:
+//   path: output file path
+//   format: output format
+//   columnCount: number of values per row (1 to TRACE_MAX_COLUMNS)
+//   columnNames: column names (at most TRACE_COLUMN_NAME_SIZE - 1 characters each)
+//   writer: pointer to store the new trace writer
+// Returns: ErrorCode
+ErrorCode openTraceWriter(const char *path, TraceFormat format, int columnCount,
+                          const char *const *columnNames, TraceWriter **writer);
+
+// Reopen a binary trace to continue it after its first `rows` rows (resuming a run)
+// The header must match format and columns. Rows after the cursor are dropped and the
+// row count is patched again when the trace is closed. CSV and packed traces cannot be reopened.
+// Parameters:
+//   path: trace file written by openTraceWriter
+//   format: TRACE_FORMAT_BINARY_F64 or TRACE_FORMAT_BINARY_F32
+//   columnCount, columnNames: as openTraceWriter
+//   rows: rows to keep (at most the complete rows in the file)
+//   writer: pointer to store the trace writer
+// Returns: ErrorCode (ERROR_INVALID_PARAMETER if the file does not match or is too short,
+//          ERROR_CALLBACK_FAILED if it cannot be opened or cut)
+ErrorCode reopenTraceWriter(const char *path, TraceFormat format, int columnCount,
+                            const char *const *columnNames, long rows, TraceWriter **writer);
+
+// Record the animation stream of a packed trace (call before the first row)
+// Parameters:
+//   writer: open trace writer (TRACE_FORMAT_PACKED)
+//   framesPerSecond: frames per second of the first column (time); 0 = no animation stream
+// Returns: ErrorCode (ERROR_INVALID_PARAMETER for other formats, rows already appended or a
+//          negative rate)
+ErrorCode setTraceAnimationRate(TraceWriter *writer, double framesPerSecond);
+
+// Append one row (columnCount values)
+// Only blocks when every chunk of this trace is still waiting to be written.
+// Parameters:
+//   writer: open trace writer
+//   values: row values
+// Returns: ErrorCode
+ErrorCode appendTraceRow(TraceWriter *writer, const double *values);
+
+// Number of rows appended so far
+long getTraceRowCount(const TraceWriter *writer);
+
+// Write every row appended so far to the file (before a checkpoint records the row count)
+// Blocks until the rows in flight are written; the trace stays open.
+// Parameters:
+//   writer: open trace writer
+// Returns: ErrorCode (ERROR_CALLBACK_FAILED if any write failed)
+ErrorCode flushTraceWriter(TraceWriter *writer);
+
+// Flush the remaining rows, finalize the header and close the file
+// Blocks until the file is complete; the writer is recycled even on error.
+// Parameters:
+//   writer: open trace writer
+// Returns: ErrorCode (ERROR_CALLBACK_FAILED if any write failed)
+ErrorCode closeTraceWriter(TraceWriter *writer);
+
+#endif // TRACEWRITER_H